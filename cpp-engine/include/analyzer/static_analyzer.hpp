@@ -10,6 +10,8 @@
 #include <unordered_map>
 #include <nlohmann/json.hpp>
 
+#include "utils/process_supervisor.hpp"
+
 namespace cpp_mastery {
 
 /**
@@ -26,15 +28,6 @@ struct AnalysisIssue {
     nlohmann::json metadata;
 };
 
-/**
- * @brief Process execution result for external tools
- */
-struct ProcessResult {
-    int exit_code = -1;
-    std::string stdout;
-    std::string stderr;
-};
-
 /**
  * @brief Result of static analysis operation
  */
@@ -258,20 +251,6 @@ private:
      */
     ProcessResult executeProcess(const std::vector<std::string>& args, int timeout_seconds);
     
-    /**
-     * @brief Generate unique session ID
-     * 
-     * @return std::string Unique session identifier
-     */
-    std::string generateSessionId();
-    
-    /**
-     * @brief Clean up temporary files for a session
-     * 
-     * @param session_dir Session directory to clean up
-     */
-    void cleanupSession(const std::string& session_dir);
-    
     /**
      * @brief Count line number at given position in text
      * 
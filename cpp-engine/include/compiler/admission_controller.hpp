@@ -0,0 +1,211 @@
+// File: cpp-engine/include/compiler/admission_controller.hpp
+// Extension: .hpp
+
+#pragma once
+
+#include <string>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <array>
+#include <chrono>
+#include <unordered_map>
+#include <condition_variable>
+#include <nlohmann/json.hpp>
+
+#include "utils/cancellation_token.hpp"
+
+namespace cpp_mastery {
+
+/**
+ * @brief Priority lane a request is queued in
+ */
+enum class AdmissionLane {
+    INTERACTIVE,    // a user is waiting on the response
+    BATCH,          // judging and other bulk work
+    BACKGROUND      // speculative work such as prewarming; only uses idle slots
+};
+
+/**
+ * @brief Parse a lane name ("interactive", "batch" or "background")
+ *
+ * @param name Lane name from a request
+ * @return AdmissionLane Matching lane, INTERACTIVE for anything else
+ */
+AdmissionLane admissionLaneFromString(const std::string& name);
+
+/**
+ * @brief Limits the admission controller enforces
+ */
+struct AdmissionPolicy {
+    size_t max_concurrent = 10;         // requests compiling or running at once
+    size_t max_queued = 100;            // waiting requests across all lanes
+    std::chrono::milliseconds queue_timeout{30000};
+    int interactive_weight = 4;         // interactive grants per batch grant while both wait
+    size_t max_background = 1;          // background tickets held at once
+    std::map<std::string, int> client_weights;  // client id -> round-robin weight, default 1
+};
+
+class AdmissionController;
+
+/**
+ * @brief Permission to compile or run; gives the slot back when destroyed
+ */
+class AdmissionTicket {
+public:
+    AdmissionTicket() = default;
+    ~AdmissionTicket() { release(); }
+
+    AdmissionTicket(const AdmissionTicket&) = delete;
+    AdmissionTicket& operator=(const AdmissionTicket&) = delete;
+    AdmissionTicket(AdmissionTicket&& other) noexcept
+        : controller_(other.controller_), lane_(other.lane_), granted_at_(other.granted_at_), id_(other.id_) {
+        other.controller_ = nullptr;
+    }
+    AdmissionTicket& operator=(AdmissionTicket&& other) noexcept;
+
+    bool valid() const { return controller_ != nullptr; }
+    void release();
+
+private:
+    friend class AdmissionController;
+    AdmissionTicket(AdmissionController* controller, AdmissionLane lane, uint64_t id)
+        : controller_(controller), lane_(lane), granted_at_(std::chrono::steady_clock::now()), id_(id) {}
+
+    AdmissionController* controller_ = nullptr;
+    AdmissionLane lane_ = AdmissionLane::INTERACTIVE;
+    std::chrono::steady_clock::time_point granted_at_;
+    uint64_t id_ = 0;
+};
+
+/**
+ * @brief Outcome of asking for admission
+ */
+struct Admission {
+    AdmissionTicket ticket;             // valid when admitted
+    std::chrono::seconds retry_after{0};
+    std::string reason;                 // why the request was turned away
+
+    bool admitted() const { return ticket.valid(); }
+};
+
+/**
+ * @brief Bounded, fair admission queue in front of compilation and execution
+ *
+ * At most max_concurrent requests hold a ticket. Everyone else waits in one
+ * of two lanes; within a lane each client (API key or address) has its own
+ * FIFO and clients are served weighted round robin, so one client flooding
+ * the queue only delays itself. When both lanes wait, the interactive lane
+ * gets interactive_weight grants for every batch grant. A request is turned
+ * away when the queue is full or it waited longer than queue_timeout; the
+ * caller answers 429 with the suggested Retry-After.
+ *
+ * The background lane is served only while the other two are empty, with
+ * at most max_background tickets out at once. When an interactive or batch
+ * request has to queue, a running background ticket admitted with a
+ * cancellation token is cancelled to make room, so speculative work never
+ * delays a real request by more than the time its processes take to die.
+ */
+class AdmissionController {
+public:
+    /**
+     * @brief Get the server-wide controller, configured from Config
+     *
+     * @return AdmissionController& Reference to the controller
+     */
+    static AdmissionController& getInstance();
+
+    /**
+     * @brief Construct a controller
+     *
+     * @param policy Limits to enforce
+     */
+    explicit AdmissionController(AdmissionPolicy policy);
+
+    AdmissionController(const AdmissionController&) = delete;
+    AdmissionController& operator=(const AdmissionController&) = delete;
+
+    /**
+     * @brief Wait for a slot
+     *
+     * @param client_id Fairness key, e.g. "key:<api key>" or "ip:<address>"
+     * @param lane Lane to queue in
+     * @param cancellation Gives up the place in the queue when cancelled; for
+     *                     the background lane also how the ticket is preempted
+     * @return Admission Ticket, or the reason and a Retry-After hint
+     */
+    Admission admit(const std::string& client_id, AdmissionLane lane,
+                    std::shared_ptr<CancellationToken> cancellation = nullptr);
+
+    /**
+     * @brief Get queue depth, wait-time histograms and counters
+     *
+     * @return nlohmann::json Controller statistics
+     */
+    nlohmann::json getStatistics() const;
+
+private:
+    friend class AdmissionTicket;
+
+    struct Waiter {
+        std::string client_id;
+        std::shared_ptr<CancellationToken> cancellation;
+        uint64_t ticket_id = 0;
+        bool granted = false;
+        bool cancelled = false;
+        std::condition_variable granted_cv;
+    };
+
+    struct ClientQueue {
+        std::deque<std::shared_ptr<Waiter>> waiters;
+        int credits = 0;    // grants left in this client's round-robin turn
+    };
+
+    struct Lane {
+        std::unordered_map<std::string, ClientQueue> clients;
+        std::deque<std::string> rotation;   // clients with waiters, next turn first
+        size_t queued = 0;
+    };
+
+    void release(AdmissionLane lane, std::chrono::steady_clock::time_point granted_at, uint64_t id);
+    void dispatch();
+    bool backgroundAllowed() const;
+    uint64_t grant(size_t lane, const std::shared_ptr<CancellationToken>& cancellation);
+    std::shared_ptr<CancellationToken> pickPreemptionLocked();
+    std::shared_ptr<Waiter> popNext(Lane& lane);
+    void removeWaiter(Lane& lane, const std::shared_ptr<Waiter>& waiter);
+    int clientWeight(const std::string& client_id) const;
+    std::chrono::seconds retryAfter() const;
+    void recordWait(AdmissionLane lane, std::chrono::steady_clock::duration wait);
+
+    // Static members for singleton pattern
+    static std::unique_ptr<AdmissionController> instance_;
+    static std::mutex instance_mutex_;
+
+    const AdmissionPolicy policy_;
+
+    mutable std::mutex mutex_;
+    std::array<Lane, 3> lanes_;
+    size_t running_ = 0;
+    std::array<size_t, 3> running_by_lane_{};
+    uint64_t next_ticket_id_ = 1;
+    std::map<uint64_t, std::shared_ptr<CancellationToken>> preemptible_;    // running background tickets by id
+    int interactive_streak_ = 0;        // interactive grants since the last batch grant
+    double service_time_ms_ = 0.0;      // moving average of ticket hold time
+
+    // Histograms; bucket i counts values <= its bound, the last bucket the rest
+    static constexpr std::array<long, 9> kWaitBucketsMs{1, 5, 10, 50, 100, 500, 1000, 5000, 30000};
+    static constexpr std::array<long, 8> kDepthBuckets{0, 1, 2, 4, 8, 16, 32, 64};
+    std::array<std::array<uint64_t, kWaitBucketsMs.size() + 1>, 3> wait_histogram_{};
+    std::array<uint64_t, kDepthBuckets.size() + 1> depth_histogram_{};
+
+    std::array<uint64_t, 3> admitted_{};
+    std::array<uint64_t, 3> rejected_full_{};
+    std::array<uint64_t, 3> rejected_timeout_{};
+    std::array<uint64_t, 3> cancelled_{};
+    uint64_t preempted_ = 0;
+    size_t max_queued_seen_ = 0;
+};
+
+} // namespace cpp_mastery
@@ -0,0 +1,139 @@
+// File: cpp-engine/include/compiler/compilation_cache.hpp
+// Extension: .hpp
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <filesystem>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+#include "compiler/execution_engine.hpp"
+#include "utils/config.hpp"
+
+namespace cpp_mastery {
+
+/**
+ * @brief Inputs that determine the output of a compilation
+ *
+ * Two requests with equal keys produce the same executable and diagnostics,
+ * so the cache can serve one from the other without invoking the compiler.
+ */
+struct CompilationKey {
+    std::string code;
+    std::string compiler_path;
+    std::string compiler_version;
+    std::string standard;
+    std::string optimization;
+    bool debug_info = false;
+    std::vector<std::string> extra_flags;
+    std::string pch;
+    std::string harness;    // HarnessBuild::digest, empty without a harness
+};
+
+/**
+ * @brief Content-addressed cache of compiled executables and diagnostics
+ *
+ * Entries live under <cache_directory>/compilation/<xx>/<digest>/ and hold the
+ * executable (for successful builds) plus a result.json with the compiler
+ * diagnostics. Entries are evicted when older than cache_ttl_hours or, least
+ * recently used first, when the cache grows beyond max_cache_size_mb.
+ */
+class CompilationCache {
+public:
+    /**
+     * @brief Construct a cache from the cache configuration
+     *
+     * @param config Cache configuration (directory, size limit, TTL)
+     */
+    explicit CompilationCache(const CacheConfig& config);
+
+    /**
+     * @brief Create the cache directory and index existing entries
+     *
+     * @return true if the cache is usable
+     * @return false if the cache directory could not be prepared
+     */
+    bool initialize();
+
+    /**
+     * @brief Compute the content address for a compilation
+     *
+     * @param key Compilation inputs
+     * @return std::string Hex SHA-256 digest of the canonical key
+     */
+    static std::string computeKey(const CompilationKey& key);
+
+    /**
+     * @brief Hex SHA-256 digest of arbitrary data
+     *
+     * @param data Data to hash
+     * @return std::string 64-character lowercase hex digest
+     */
+    static std::string sha256Hex(const std::string& data);
+
+    /**
+     * @brief Look up a cached compilation and materialize it into a session
+     *
+     * The cached executable is hard-linked (or copied across filesystems) to
+     * output_file so the caller may delete its session directory freely.
+     *
+     * @param digest Key returned by computeKey()
+     * @param output_file Where the cached executable should appear
+     * @return std::optional<CompilationResult> Cached result, or nullopt on miss
+     */
+    std::optional<CompilationResult> lookup(const std::string& digest, const std::string& output_file);
+
+    /**
+     * @brief Store a compilation result
+     *
+     * @param digest Key returned by computeKey()
+     * @param result Compilation result; executable_path is copied when successful
+     */
+    void store(const std::string& digest, const CompilationResult& result);
+
+    /**
+     * @brief Get cache statistics for the metrics endpoint
+     *
+     * @return nlohmann::json Hit/miss counters and size information
+     */
+    nlohmann::json getStatistics() const;
+
+private:
+    struct Entry {
+        uintmax_t size_bytes = 0;
+        std::chrono::system_clock::time_point created;
+        std::chrono::system_clock::time_point last_access;
+    };
+
+    std::filesystem::path entryDirectory(const std::string& digest) const;
+    bool isExpired(const Entry& entry, std::chrono::system_clock::time_point now) const;
+    void loadIndex();
+    void evictIfNeeded();
+
+    // Drops an entry from the index; called with index_mutex_ held. The
+    // returned directory is deleted with deleteEntryDirectory() after the
+    // lock is released, so lookups never wait on disk I/O.
+    std::filesystem::path detachEntry(const std::string& digest);
+    void deleteEntryDirectory(const std::filesystem::path& entry_dir);
+
+    std::filesystem::path root_;
+    uintmax_t max_size_bytes_;
+    std::chrono::hours ttl_;
+
+    mutable std::mutex index_mutex_;
+    std::unordered_map<std::string, Entry> index_;
+    uintmax_t total_size_bytes_ = 0;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> stores_{0};
+    std::atomic<uint64_t> evictions_{0};
+};
+
+} // namespace cpp_mastery
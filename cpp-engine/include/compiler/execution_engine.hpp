@@ -7,20 +7,138 @@
 #include <vector>
 #include <memory>
 #include <mutex>
+#include <map>
+#include <unordered_map>
+#include <functional>
+#include <string_view>
+#include <atomic>
+#include <future>
+#include <optional>
 #include <nlohmann/json.hpp>
 
+#include "utils/process_supervisor.hpp"
+
 namespace cpp_mastery {
 
+class CompilationCache;
+class PchPool;
+struct PchToolchain;
+class HarnessRegistry;
+class InProcessCompiler;
+struct HarnessBuild;
+struct HarnessFile;
+class SandboxPool;
+class WasmRuntime;
+struct ExecutionConfig;
+
+/**
+ * @brief Where the time of one compile() went, in milliseconds
+ *
+ * Phases that did not run for a request (e.g. compile and link on a cache
+ * hit) stay at zero. Preprocessing, compiling and assembling happen in one
+ * compiler run and are reported together as compile.
+ */
+struct CompilePhaseTimes {
+    double setup_ms = 0;            // options, session directory, PCH selection, cache key
+    double harness_ms = 0;          // finding, or on first use building, exercise harness objects
+    double cache_lookup_ms = 0;
+    double coalesced_wait_ms = 0;   // waiting on an identical in-flight compile
+    double write_source_ms = 0;
+    double compile_ms = 0;          // source to object
+    double link_ms = 0;             // object to executable
+    double cache_store_ms = 0;
+};
+
 /**
  * @brief Result of code compilation
  */
 struct CompilationResult {
     bool success = false;
-    std::string executable_path;
+    std::string executable_path;    // file in a leased workspace, or /proc/<pid>/fd/<n> for a memory workspace
     long compilation_time_ms = 0;
     std::vector<std::string> warnings;
     std::vector<std::string> errors;
     std::string compiler_output;
+    bool cache_hit = false;
+    CompilePhaseTimes phases;
+    std::string linker;             // linker used, "default" for the toolchain's own
+};
+
+/**
+ * @brief One compiler diagnostic
+ */
+struct Diagnostic {
+    std::string severity;   // error, warning or note ("fatal error" is reported as error)
+    std::string file;       // empty for the submission itself, else the header it points into
+    int line = 0;
+    int column = 0;
+    std::string message;
+    std::string option;     // flag that enabled a warning, e.g. -Wunused-variable
+};
+
+/**
+ * @brief Result of a syntax-only check
+ */
+struct SyntaxCheckResult {
+    bool success = false;   // no errors
+    std::vector<Diagnostic> diagnostics;
+    size_t error_count = 0;
+    size_t warning_count = 0;
+    bool truncated = false; // the compiler stopped at max_errors
+    bool pch_used = false;
+    long check_time_ms = 0;
+    std::string error_message;  // set when the compiler could not be run
+};
+
+/**
+ * @brief How a program run ended
+ */
+enum class ExecutionStatus {
+    OK,                     // exited with status 0
+    COMPILATION_ERROR,
+    RUNTIME_ERROR,          // non-zero exit or fatal signal
+    TIME_LIMIT_EXCEEDED,    // execution_timeout (wall clock)
+    CPU_LIMIT_EXCEEDED,     // max_cpu_time
+    MEMORY_LIMIT_EXCEEDED,  // max_memory_mb
+    OUTPUT_LIMIT_EXCEEDED,  // max_output_size
+    CANCELLED,              // cancellation token fired
+    INTERNAL_ERROR
+};
+
+/**
+ * @brief Convert an execution status to its API name
+ *
+ * @param status Status to convert
+ * @return std::string e.g. "time_limit_exceeded"
+ */
+std::string executionStatusToString(ExecutionStatus status);
+
+/**
+ * @brief Tier settings of a tiered execution, from options.tiered
+ *
+ * A tiered execution answers with a build at the fast level and, once it
+ * ran successfully, rebuilds at the optimized level and runs that too to
+ * report optimized timings.
+ */
+struct TierPolicy {
+    bool enabled = false;
+    std::string fast = "O0";        // level of the build whose output is returned
+    std::string optimized = "O2";   // level of the follow-up build that is timed
+};
+
+/**
+ * @brief Follow-up run of a tiered execution at the optimized level
+ */
+struct OptimizedTierResult {
+    std::string optimization;
+    bool success = false;
+    ExecutionStatus status = ExecutionStatus::INTERNAL_ERROR;
+    long compilation_time_ms = 0;
+    long execution_time_ms = 0;
+    long cpu_time_ms = 0;
+    long memory_usage_kb = 0;
+    bool output_matches = false;    // same stdout as the fast build
+    std::string error_message;
 };
 
 /**
@@ -28,24 +146,46 @@ struct CompilationResult {
  */
 struct ExecutionResult {
     bool success = false;
+    ExecutionStatus status = ExecutionStatus::INTERNAL_ERROR;
     int exit_code = 0;
+    int term_signal = 0;
     std::string stdout;
     std::string stderr;
-    long execution_time_ms = 0;
-    long memory_usage_kb = 0;
+    long execution_time_ms = 0;     // the program alone, fork to exit
+    long memory_usage_kb = 0;       // peak RSS
     long cpu_time_ms = 0;
+    long user_time_ms = 0;
+    long system_time_ms = 0;
+    long voluntary_context_switches = 0;
+    long involuntary_context_switches = 0;
+    long io_read_bytes = 0;
+    long io_write_bytes = 0;
     std::string error_message;
+    std::optional<OptimizedTierResult> optimized;   // tiered executions whose fast run succeeded and whose tier was admitted
+    long compilation_time_ms = 0;   // compile and link, or bitcode generation for JIT runs
+    std::string mode = "native";    // native or jit
+    std::string jit_fallback;       // why a requested JIT run took the native path
 };
 
 /**
- * @brief Process execution result
+ * @brief Progress callbacks for a streamed execution
+ *
+ * Both run on engine or supervisor threads and must not block.
  */
-struct ProcessResult {
-    int exit_code = -1;
-    std::string stdout;
-    std::string stderr;
-    long memory_usage_kb = 0;
-    long cpu_time_ms = 0;
+struct ExecutionObserver {
+    // Called once compilation finished, successful or not
+    std::function<void(const CompilationResult&)> on_compiled;
+    
+    // Program output as it arrives; when set, ExecutionResult::stdout and
+    // stderr stay empty
+    OutputCallback on_output;
+    
+    // Tiered executions only: the fast build's result, before the optimized
+    // build is waited for and run
+    std::function<void(const ExecutionResult&)> on_fast_result;
+    
+    // Tiered executions only: admission fairness key for the optimized tier
+    std::string client_id;
 };
 
 /**
@@ -70,6 +210,11 @@ public:
     ExecutionEngine(const ExecutionEngine&) = delete;
     ExecutionEngine& operator=(const ExecutionEngine&) = delete;
     
+    /**
+     * @brief Destructor
+     */
+    ~ExecutionEngine();
+    
     /**
      * @brief Initialize the execution engine
      * 
@@ -91,11 +236,50 @@ public:
     /**
      * @brief Compile C++ source code
      * 
+     * Identical requests are served from the compilation cache when
+     * CacheConfig::enable_compilation_cache is set; pass {"cache": false}
+     * in options to force a fresh compile. With the cache on, identical
+     * requests that arrive while the first is still compiling wait for it
+     * instead of starting their own compiler. Each of them takes its own
+     * executable from the cache, so without the cache (disabled,
+     * unavailable, or {"cache": false}) every request compiles.
+     * 
+     * With options.harness set to a registered harness id, the code may
+     * include the harness headers and is linked with the harness's
+     * prebuilt objects; only the submission itself is compiled.
+     * 
+     * options.compiler (default CompilerConfig::default_compiler) may be
+     * "clang-inprocess" to compile and link with the Clang libraries
+     * linked into the engine instead of starting clang++.
+     * 
      * @param code C++ source code to compile
-     * @param options Compilation options (compiler, flags, optimization, etc.)
+     * @param options Compilation options (compiler, flags, optimization, cache, harness, etc.)
+     * @param cancellation Kills the compiler and fails the compile when cancelled
      * @return CompilationResult Result of compilation including errors and warnings
      */
-    CompilationResult compile(const std::string& code, const nlohmann::json& options = nlohmann::json{});
+    CompilationResult compile(const std::string& code, const nlohmann::json& options = nlohmann::json{},
+                              std::shared_ptr<CancellationToken> cancellation = nullptr);
+    
+    /**
+     * @brief Check C++ source code without generating code
+     * 
+     * Runs only the compiler frontend (-fsyntax-only) on the code piped to
+     * its stdin, with the O0 precompiled header when the includes allow it,
+     * and stops after options.max_errors errors (default 10).
+     * 
+     * @param code C++ source code to check
+     * @param options Compiler, standard, flags, max_errors, pch
+     * @return SyntaxCheckResult Structured diagnostics
+     */
+    SyntaxCheckResult checkSyntax(const std::string& code, const nlohmann::json& options = nlohmann::json{});
+    
+    /**
+     * @brief Parse GCC/Clang text diagnostics
+     * 
+     * @param compiler_output Compiler stderr
+     * @return std::vector<Diagnostic> Diagnostics in the order they were reported
+     */
+    static std::vector<Diagnostic> parseDiagnostics(const std::string& compiler_output);
     
     /**
      * @brief Execute C++ code (compile and run)
@@ -106,6 +290,137 @@ public:
      * @return ExecutionResult Result of execution including output and metrics
      */
     ExecutionResult execute(const std::string& code, const std::string& input = "", const nlohmann::json& options = nlohmann::json{});
+    
+    /**
+     * @brief Execute C++ code, reporting progress while it runs
+     * 
+     * With options.tiered (true, or {"fast": "O0", "optimized": "O2"}) the
+     * optimized build is compiled alongside the fast one. The fast build's
+     * result is reported first; the optimized binary is then run with the
+     * same input and its timings are added as ExecutionResult::optimized.
+     * The optimized build and run hold an admission ticket of their own,
+     * taken on the batch lane for observer.client_id; when it is refused the
+     * tier is dropped and ExecutionResult::optimized stays empty. The call
+     * returns after the optimized run, so callers that answer with the fast
+     * result take it from observer.on_fast_result.
+     * 
+     * With options.jit (default ExecutionConfig::enable_jit) a small,
+     * unstreamed snippet is compiled to LLVM bitcode in-process and run by
+     * the ORC JIT in a sandbox slot, with no object file, link or exec.
+     * Anything the JIT path cannot take (custom flags, harnesses, a module
+     * that does not link, Clang rejecting the code) silently takes the
+     * normal compile-and-run path; ExecutionResult::jit_fallback says why.
+     * 
+     * @param code C++ source code to execute
+     * @param input Standard input for the program
+     * @param options Execution options (compiler, flags, limits, etc.)
+     * @param observer Receives compile diagnostics and output chunks
+     * @param cancellation Kills the compiler or program when cancelled
+     * @return ExecutionResult Final status and resource usage
+     */
+    ExecutionResult execute(const std::string& code, const std::string& input, const nlohmann::json& options,
+                            const ExecutionObserver& observer,
+                            std::shared_ptr<CancellationToken> cancellation = nullptr);
+    
+    /**
+     * @brief Run an already compiled program
+     * 
+     * Lets callers that run one executable many times (such as the judge)
+     * compile once. Uses the sandbox when ExecutionConfig::sandbox_enabled.
+     * 
+     * @param executable_path Executable from a successful compile()
+     * @param input Standard input for the program
+     * @param limits Limits to run under
+     * @param on_output Receives output as it arrives, or null to collect it
+     * @param cancellation Kills the program when cancelled
+     * @return ProcessResult Result of the program
+     */
+    ProcessResult runExecutable(const std::string& executable_path, std::string_view input,
+                                const ExecutionConfig& limits, const OutputCallback& on_output = nullptr,
+                                std::shared_ptr<CancellationToken> cancellation = nullptr);
+    
+    /**
+     * @brief Free the workspace of a compile() result
+     * 
+     * Closes the memfds of a memory workspace or hands the session
+     * directory back to the WorkspaceManager.
+     * 
+     * @param compilation Result whose executable is no longer needed
+     */
+    void releaseCompilation(const CompilationResult& compilation);
+    
+    /**
+     * @brief Register or replace an exercise harness
+     * 
+     * Stores the files and compiles the sources for every available
+     * compiler at the configured standard, for the configured optimization
+     * level and O0, before the harness becomes current. Other toolchains
+     * are built on first use. A harness that fails to build is not
+     * registered and the previous version stays current.
+     * 
+     * @param id Harness id; letters, digits, '-', '_' and '.'
+     * @param headers Headers submissions may include
+     * @param sources Sources linked with every submission; one defines main()
+     * @return nlohmann::json {success, id, digest, builds, compiler_output}
+     * @throws std::invalid_argument on a bad id or file name, or no sources
+     */
+    nlohmann::json registerHarness(const std::string& id, const std::vector<HarnessFile>& headers,
+                                   const std::vector<HarnessFile>& sources);
+    
+    /**
+     * @brief Remove an exercise harness
+     * 
+     * @param id Harness id
+     * @return true if it was registered
+     */
+    bool removeHarness(const std::string& id);
+    
+    /**
+     * @brief List registered exercise harnesses
+     * 
+     * @return nlohmann::json Array of harness descriptions
+     */
+    nlohmann::json listHarnesses() const;
+    
+    /**
+     * @brief Read the tier policy from execution options
+     * 
+     * @param options Execution options; "tiered" is true, false or an object
+     * @return TierPolicy Policy, disabled when "tiered" is absent or false
+     */
+    static TierPolicy tierPolicyFrom(const nlohmann::json& options);
+    
+    /**
+     * @brief Pick the linker passed to -fuse-ld for a compiler
+     * 
+     * Honours CompilerConfig::linker; "auto" tries mold, then lld. A
+     * candidate is only used after it linked a trivial program into a memfd,
+     * as memory workspaces do, and the program ran.
+     * 
+     * @param compiler_path Compiler driver to link with
+     * @return std::string Linker name, or empty for the driver's default
+     */
+    static std::string selectLinker(const std::string& compiler_path);
+    
+    /**
+     * @brief Work out which limit, if any, ended a run
+     *
+     * Memory is blamed on kernel evidence: an OOM kill, a signal with peak
+     * RSS near the limit, or a SIGABRT whose stderr names std::bad_alloc,
+     * which is how an allocation refused under RLIMIT_AS ends.
+     *
+     * @param result Result of the program
+     * @param config Limits the program ran under
+     * @return ExecutionStatus Status to report
+     */
+    static ExecutionStatus classifyExit(const ProcessResult& result, const ExecutionConfig& config);
+    
+    /**
+     * @brief Get execution engine metrics
+     * 
+     * @return nlohmann::json Metrics including compilation cache statistics
+     */
+    nlohmann::json getMetrics() const;
 
 private:
     /**
@@ -126,6 +441,72 @@ private:
      */
     bool validateCompilers();
     
+    /**
+     * @brief Query a compiler's version banner
+     * 
+     * @param compiler_path Path to the compiler binary
+     * @return std::string First line of `compiler --version`, or empty on failure
+     */
+    std::string queryCompilerVersion(const std::string& compiler_path);
+    
+    /**
+     * @brief Build precompiled headers for every available toolchain
+     * 
+     * Covers each available compiler at the configured standard, for both the
+     * configured optimization level and O0.
+     */
+    void initializePchPool();
+    
+    /**
+     * @brief Toolchains PCHs and harness objects are prepared for up front
+     * 
+     * @return std::vector<PchToolchain> Each available compiler at the configured
+     *         standard, for the configured optimization level and O0
+     */
+    std::vector<PchToolchain> defaultToolchains() const;
+    
+    /**
+     * @brief Get a harness's objects for the toolchain of a compile
+     * 
+     * @param id Harness id
+     * @param digest Harness content digest
+     * @param compiler Compiler to use (g++, clang++)
+     * @param standard C++ standard
+     * @param optimization Optimization level
+     * @param debug_info Include debug information
+     * @param extra_flags User flags; those affecting compilation select the objects
+     * @return HarnessBuild Objects, or the compiler output of a failed build
+     */
+    HarnessBuild buildHarness(const std::string& id, const std::string& digest, const std::string& compiler,
+                              const std::string& standard, const std::string& optimization, bool debug_info,
+                              const std::vector<std::string>& extra_flags);
+    
+    /**
+     * @brief Select the sandbox backend from ExecutionConfig::sandbox_backend
+     * 
+     * Tries the WebAssembly runtime first when configured, then the native
+     * sandbox, then Docker, and otherwise runs programs directly.
+     */
+    void initializeSandbox();
+    
+    /**
+     * @brief Start the WebAssembly runtime and check the wasi-sdk compiler
+     * 
+     * @return true if programs can be built for and run under wasm32-wasi
+     */
+    bool initializeWasm();
+    
+    /**
+     * @brief Compiler driver for a compiler name
+     * 
+     * Under the wasm backend every name builds for wasm32-wasi with
+     * CompilerConfig::wasi_clang_path.
+     * 
+     * @param compiler Compiler name (g++, clang++, clang-inprocess)
+     * @return std::string Path of the driver
+     */
+    std::string compilerPath(const std::string& compiler) const;
+    
     /**
      * @brief Initialize Docker sandbox environment
      * 
@@ -149,16 +530,34 @@ private:
      */
     std::string generateSessionId();
     
+    /**
+     * @brief Add one compile's phase times to the metrics totals
+     * 
+     * @param phases Phase times of the compile
+     */
+    void recordPhases(const CompilePhaseTimes& phases);
+    
+    /**
+     * @brief Add one execution's compile-plus-run time to the per-mode totals
+     * 
+     * @param mode native, jit, or jit_fallback for time spent before falling back
+     * @param ms Milliseconds
+     */
+    void recordExecutionMode(const std::string& mode, double ms);
+    
     /**
      * @brief Build compilation command with specified options
      * 
+     * Compiles to an object only; buildLinkCommand() produces the executable.
+     * 
      * @param source_file Path to source file
-     * @param output_file Path to output executable
+     * @param output_file Path to output object file
      * @param compiler Compiler to use (g++, clang++)
      * @param standard C++ standard (c++11, c++14, c++17, c++20, etc.)
      * @param optimization Optimization level (O0, O1, O2, O3, Os)
      * @param debug_info Include debug information
      * @param extra_flags Additional compiler flags
+     * @param pch_header Precompiled header to force-include (empty for none)
      * @return std::vector<std::string> Command line arguments
      */
     std::vector<std::string> buildCompileCommand(
@@ -168,7 +567,26 @@ private:
         const std::string& standard,
         const std::string& optimization,
         bool debug_info,
-        const std::vector<std::string>& extra_flags
+        const std::vector<std::string>& extra_flags,
+        const std::string& pch_header = ""
+    );
+    
+    /**
+     * @brief Build the link command for a compiled object
+     * 
+     * @param object_file Object produced by the compile step
+     * @param output_file Path to output executable
+     * @param compiler_path Compiler driver to link with
+     * @param extra_flags User flags; only those relevant to linking are passed
+     * @param extra_objects Further objects, such as a harness's, linked after object_file
+     * @return std::vector<std::string> Command line arguments
+     */
+    std::vector<std::string> buildLinkCommand(
+        const std::string& object_file,
+        const std::string& output_file,
+        const std::string& compiler_path,
+        const std::vector<std::string>& extra_flags,
+        const std::vector<std::string>& extra_objects = {}
     );
     
     /**
@@ -176,29 +594,82 @@ private:
      * 
      * @param args Command line arguments
      * @param timeout_seconds Maximum execution time in seconds
+     * @param input Bytes delivered on the process's stdin
+     * @param cancellation Kills the process when cancelled
      * @return ProcessResult Result of process execution
      */
-    ProcessResult executeProcess(const std::vector<std::string>& args, int timeout_seconds);
+    ProcessResult executeProcess(const std::vector<std::string>& args, int timeout_seconds, std::string_view input = {},
+                                 std::shared_ptr<CancellationToken> cancellation = nullptr);
     
     /**
-     * @brief Execute program in Docker sandbox
+     * @brief Execute program with the selected sandbox backend
      * 
      * @param executable_path Path to compiled executable
      * @param input Standard input for the program
-     * @param options Execution options
+     * @param limits Limits to run under
+     * @param on_output Receives output as it arrives, or null to collect it
+     * @param cancellation Kills the program when cancelled
      * @return ProcessResult Result of sandboxed execution
      */
-    ProcessResult executeInSandbox(const std::string& executable_path, const std::string& input, const nlohmann::json& options);
+    ProcessResult executeInSandbox(const std::string& executable_path, std::string_view input, const ExecutionConfig& limits,
+                                   const OutputCallback& on_output, std::shared_ptr<CancellationToken> cancellation);
     
     /**
      * @brief Execute program directly (without sandbox)
      * 
      * @param executable_path Path to compiled executable
      * @param input Standard input for the program
-     * @param options Execution options
+     * @param limits Limits to run under
+     * @param on_output Receives output as it arrives, or null to collect it
+     * @param cancellation Kills the program when cancelled
      * @return ProcessResult Result of direct execution
      */
-    ProcessResult executeDirectly(const std::string& executable_path, const std::string& input, const nlohmann::json& options);
+    ProcessResult executeDirectly(const std::string& executable_path, std::string_view input, const ExecutionConfig& limits,
+                                  const OutputCallback& on_output, std::shared_ptr<CancellationToken> cancellation);
+    
+    /**
+     * @brief Try to run a snippet through the ORC JIT in a sandbox slot
+     * 
+     * @param code C++ source code
+     * @param input Standard input for the program
+     * @param options Execution options
+     * @param observer Streamed executions are not taken
+     * @param cancellation Kills the program when cancelled
+     * @param fallback_reason Set when nothing ran
+     * @return std::optional<ExecutionResult> Result, or nullopt to take the normal path
+     */
+    std::optional<ExecutionResult> executeJit(const std::string& code, const std::string& input,
+                                              const nlohmann::json& options, const ExecutionObserver& observer,
+                                              std::shared_ptr<CancellationToken> cancellation,
+                                              std::string& fallback_reason);
+    
+    /**
+     * @brief Fill an execution result from a finished run
+     * 
+     * Classifies the exit, copies output and resource usage, and marks
+     * truncated output unless it was streamed.
+     * 
+     * @param run Result of the program
+     * @param streamed Output went to an observer rather than the result
+     * @param result Execution result to fill
+     */
+    void applyRunResult(ProcessResult& run, bool streamed, ExecutionResult& result);
+    
+    /**
+     * @brief Build and run the optimized tier of a tiered execution
+     * 
+     * @param build Compile started alongside the fast build, empty when not admitted
+     * @param input Standard input for the program
+     * @param fast_stdout Output of the fast build, compared against
+     * @param policy Tier levels
+     * @param cancellation Kills the program when cancelled
+     * @return std::optional<OptimizedTierResult> Timings of the optimized run;
+     *         empty when the build was not admitted
+     */
+    std::optional<OptimizedTierResult> runOptimizedTier(std::future<std::optional<CompilationResult>>& build,
+                                                        std::string_view input, std::string_view fast_stdout,
+                                                        const TierPolicy& policy,
+                                                        std::shared_ptr<CancellationToken> cancellation);
     
     /**
      * @brief Parse compiler output for warnings and errors
@@ -209,13 +680,6 @@ private:
      */
     void parseCompilerMessages(const std::string& compiler_output, std::vector<std::string>& warnings, std::vector<std::string>& errors);
     
-    /**
-     * @brief Clean up temporary files for a session
-     * 
-     * @param session_dir Session directory to clean up
-     */
-    void cleanupSession(const std::string& session_dir);
-    
     // Static members for singleton pattern
     static std::unique_ptr<ExecutionEngine> instance_;
     static std::mutex mutex_;
@@ -223,6 +687,63 @@ private:
     // Initialization state
     bool initialized_;
     
+    // Compilation cache (null when disabled)
+    std::unique_ptr<CompilationCache> cache_;
+    
+    // Precompiled headers for common include prefixes (null when disabled)
+    std::unique_ptr<PchPool> pch_pool_;
+    
+    // Exercise harnesses and their prebuilt objects
+    std::unique_ptr<HarnessRegistry> harnesses_;
+    
+    // Clang frontend, codegen and linker run in this process (null without clang++)
+    std::unique_ptr<InProcessCompiler> in_process_;
+    
+    // Sandbox backend in use: native, docker, wasm or none
+    std::string sandbox_backend_ = "none";
+    
+    // Warm native sandbox slots (null unless the native backend is in use)
+    std::unique_ptr<SandboxPool> sandbox_pool_;
+    
+    // Embedded WASI runtime (null unless the wasm backend is in use)
+    std::unique_ptr<WasmRuntime> wasm_;
+    
+    // Compiler path -> version banner, filled by validateCompilers()
+    std::unordered_map<std::string, std::string> compiler_versions_;
+    
+    // Compiler path -> -fuse-ld value (empty for the default), filled by validateCompilers()
+    std::unordered_map<std::string, std::string> linkers_;
+    
+    // Per-phase compile time totals for the metrics endpoint
+    struct PhaseTotals {
+        uint64_t count = 0;
+        double total_ms = 0;
+        double max_ms = 0;
+    };
+    mutable std::mutex phase_mutex_;
+    std::map<std::string, PhaseTotals> phase_totals_;
+    std::map<std::string, PhaseTotals> execution_mode_totals_;   // also under phase_mutex_
+    
+    // Compilations in progress by cache key; identical requests wait on the
+    // first one. An empty result means the leader gave up without one.
+    class InFlightCompile;
+    using CompileFlight = std::shared_future<std::optional<CompilationResult>>;
+    mutable std::mutex in_flight_mutex_;
+    std::unordered_map<std::string, CompileFlight> in_flight_;
+    std::atomic<uint64_t> coalesced_compiles_{0};
+    std::atomic<uint64_t> abandoned_flights_{0};
+    std::atomic<uint64_t> flight_wait_timeouts_{0};
+    
+    // Successful compilations whose files live in memfds, by executable
+    // path, until releaseCompilation(). The byte count covers reservations
+    // of compiles in progress too.
+    class MemoryWorkspace;
+    std::atomic<size_t> memory_workspace_bytes_{0};
+    mutable std::mutex workspace_mutex_;
+    std::unordered_map<std::string, std::unique_ptr<MemoryWorkspace>> memory_workspaces_;
+    std::atomic<uint64_t> memory_workspaces_created_{0};
+    std::atomic<uint64_t> memory_workspace_fallbacks_{0};
+    
     // Thread safety
     mutable std::mutex engine_mutex_;
 };
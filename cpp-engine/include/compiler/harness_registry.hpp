@@ -0,0 +1,186 @@
+// File: cpp-engine/include/compiler/harness_registry.hpp
+// Extension: .hpp
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <future>
+#include <optional>
+#include <functional>
+#include <filesystem>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+#include "compiler/execution_engine.hpp"
+
+namespace cpp_mastery {
+
+/**
+ * @brief One file of an exercise harness
+ */
+struct HarnessFile {
+    std::string name;       // plain file name, e.g. "tests.cpp"
+    std::string content;
+};
+
+/**
+ * @brief Harness object files for one toolchain
+ */
+struct HarnessBuild {
+    bool success = false;
+    std::string include_directory;      // holds the harness headers; passed to the user TU with -I
+    std::vector<std::string> objects;   // linked after the user's object
+    std::string digest;                 // harness content and toolchain; part of the compile cache key
+    std::string compiler_output;        // diagnostics of a failed build
+    bool built = false;                 // this call compiled the harness rather than reusing objects
+};
+
+/**
+ * @brief Registered exercise harnesses and their prebuilt object files
+ *
+ * A harness is the test driver and helper code shared by every submission
+ * to one exercise: headers the submission may include and sources linked
+ * with it. Its files are stored once under <root>/<id>/<content digest>/
+ * and each source is compiled once per toolchain key into
+ * <root>/<id>/<content digest>/obj-<toolchain key>/, so a submission only
+ * compiles its own translation unit and links. Directories are written
+ * under a temporary name and renamed into place, and are reused across
+ * restarts; the compiler version is part of the toolchain key.
+ */
+class HarnessRegistry {
+public:
+    using ProcessRunner = std::function<ProcessResult(const std::vector<std::string>&, int)>;
+
+    /**
+     * @brief Builds the command compiling one harness source to an object
+     *
+     * Arguments are the source, the object and the harness include directory.
+     */
+    using CommandBuilder = std::function<std::vector<std::string>(const std::string&, const std::string&, const std::string&)>;
+
+    /**
+     * @brief Construct a registry
+     *
+     * @param root Directory holding harness files and objects
+     * @param runner Function used to run the compiler
+     * @param build_timeout_seconds Timeout for compiling a single harness source
+     */
+    HarnessRegistry(std::filesystem::path root, ProcessRunner runner, int build_timeout_seconds);
+
+    /**
+     * @brief Load the harnesses registered before a restart
+     */
+    void initialize();
+
+    /**
+     * @brief Store a harness's files without making it current
+     *
+     * @param id Harness id; letters, digits, '-', '_' and '.'
+     * @param headers Headers the submission may include
+     * @param sources Sources compiled and linked with the submission
+     * @return std::string Content digest, for build() and activate()
+     * @throws std::invalid_argument on a bad id or file name, or no sources
+     */
+    std::string stage(const std::string& id, const std::vector<HarnessFile>& headers, const std::vector<HarnessFile>& sources);
+
+    /**
+     * @brief Make a staged harness the one submissions are built against
+     *
+     * Earlier versions stay on disk until remove(), so compiles already
+     * linking against them are not disturbed.
+     *
+     * @param id Harness id
+     * @param digest Digest returned by stage()
+     */
+    void activate(const std::string& id, const std::string& digest);
+
+    /**
+     * @brief Content digest of the current version of a harness
+     *
+     * @param id Harness id
+     * @return std::optional<std::string> Digest, or nullopt if not registered
+     */
+    std::optional<std::string> current(const std::string& id) const;
+
+    /**
+     * @brief Header directory of the current version of a harness
+     *
+     * @param id Harness id
+     * @return std::optional<std::string> Directory, or nullopt if not registered
+     */
+    std::optional<std::string> includeDirectory(const std::string& id) const;
+
+    /**
+     * @brief Remove a harness and its objects
+     *
+     * @param id Harness id
+     * @return true if it was registered
+     */
+    bool remove(const std::string& id);
+
+    /**
+     * @brief Get a harness's objects for a toolchain, compiling them on first use
+     *
+     * Concurrent calls for the same harness and toolchain share one build.
+     * Failed builds are not kept, so the next call tries again.
+     *
+     * @param id Harness id
+     * @param digest Content digest from stage() or current()
+     * @param toolchain_key Identifies the compiler, its version and the flags
+     * @param command Compile command for one source
+     * @return HarnessBuild Objects, or the compiler output of a failed build
+     */
+    HarnessBuild build(const std::string& id, const std::string& digest, const std::string& toolchain_key,
+                       const CommandBuilder& command);
+
+    /**
+     * @brief List registered harnesses
+     *
+     * @return nlohmann::json Array of {id, digest, headers, sources, toolchains}
+     */
+    nlohmann::json list() const;
+
+    /**
+     * @brief Get harness build statistics
+     *
+     * @return nlohmann::json Registered harnesses, builds and reuse counters
+     */
+    nlohmann::json getStatistics() const;
+
+    /**
+     * @brief Whether a harness id or file name is safe to use as a path component
+     *
+     * @param name Id or file name
+     * @return true if it only has letters, digits, '-', '_' and '.', and is not "." or ".."
+     */
+    static bool validName(const std::string& name);
+
+private:
+    struct Registration {
+        std::string digest;
+        std::vector<std::string> headers;
+        std::vector<std::string> sources;
+    };
+
+    HarnessBuild compileObjects(const std::filesystem::path& content_dir, const std::string& toolchain_key,
+                                const std::vector<std::string>& sources, const CommandBuilder& command);
+    std::filesystem::path contentDirectory(const std::string& id, const std::string& digest) const;
+    static std::vector<std::string> listFiles(const std::filesystem::path& directory);
+
+    std::filesystem::path root_;
+    ProcessRunner runner_;
+    int build_timeout_seconds_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Registration> harnesses_;
+    std::unordered_map<std::string, std::shared_future<HarnessBuild>> builds_;   // by content directory + toolchain key
+
+    std::atomic<uint64_t> builds_run_{0};
+    std::atomic<uint64_t> build_failures_{0};
+    std::atomic<uint64_t> reuses_{0};
+};
+
+} // namespace cpp_mastery
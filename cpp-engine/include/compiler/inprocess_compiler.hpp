@@ -0,0 +1,130 @@
+// File: cpp-engine/include/compiler/inprocess_compiler.hpp
+// Extension: .hpp
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <nlohmann/json.hpp>
+
+#include "utils/process_supervisor.hpp"
+#include "utils/cancellation_token.hpp"
+
+namespace cpp_mastery {
+
+/**
+ * @brief Compiles and links with the Clang libraries linked into the engine
+ *
+ * Takes the same driver command lines the external backend runs, but
+ * instead of starting clang++ (which starts cc1, and then the linker) it
+ * lets the Clang driver plan the jobs in-process. The cc1 job runs
+ * the frontend and code generation on its own thread with a large stack,
+ * reading the submission from an in-memory file layered over the real
+ * file system and emitting the object into memory. The link job runs
+ * through LLD in-process when the engine was built with it (HAVE_LLD) and
+ * the driver picked ld.lld; otherwise the driver's linker command is
+ * started directly, skipping the driver process. Should LLD exit rather
+ * than return (a fatal error, say from a -Wl flag), the exit is caught, that
+ * link is retried with the external linker and LLD is not used again.
+ *
+ * A compile cannot be interrupted once the frontend is running, so
+ * cancellation and the compile timeout are only checked between steps.
+ * Crashes inside Clang are caught and reported as a failed compile.
+ */
+class InProcessCompiler {
+public:
+    // CompilerConfig::default_compiler or options.compiler value selecting this backend
+    static constexpr const char* kName = "clang-inprocess";
+
+    // Name the submission is compiled under; pass it as the source in the command line
+    static constexpr const char* kSourceName = "main.cpp";
+
+    using ProcessRunner = std::function<ProcessResult(const std::vector<std::string>&, int, std::shared_ptr<CancellationToken>)>;
+
+    /**
+     * @brief Construct the backend
+     *
+     * @param clang_path Path of the clang++ binary; the driver finds its
+     *                   resource directory (builtin headers) relative to it
+     * @param runner Runs the linker when it cannot be run in-process
+     */
+    InProcessCompiler(std::string clang_path, ProcessRunner runner);
+
+    InProcessCompiler(const InProcessCompiler&) = delete;
+    InProcessCompiler& operator=(const InProcessCompiler&) = delete;
+
+    /**
+     * @brief Compile one translation unit to an object file
+     *
+     * @param args Driver command line with "-c", kSourceName as the input and "-o object_file"
+     * @param code Source of kSourceName
+     * @param object_file Where the object is written
+     * @param cancellation Checked before the frontend starts
+     * @return ProcessResult exit_code 0 on success, 1 on compile errors, -1
+     *         when Clang crashed; diagnostics in stderr
+     */
+    ProcessResult compile(const std::vector<std::string>& args, std::string_view code, const std::string& object_file,
+                          const std::shared_ptr<CancellationToken>& cancellation);
+
+    /**
+     * @brief Compile one translation unit to LLVM bitcode in memory
+     *
+     * @param args Driver command line with "-c", "-emit-llvm" and kSourceName as the input
+     * @param code Source of kSourceName
+     * @param bitcode Receives the module on success
+     * @param cancellation Checked before the frontend starts
+     * @return ProcessResult As for compile()
+     */
+    ProcessResult compileToBitcode(const std::vector<std::string>& args, std::string_view code, std::string& bitcode,
+                                   const std::shared_ptr<CancellationToken>& cancellation);
+
+    /**
+     * @brief Link objects into an executable
+     *
+     * @param args Driver command line with the objects and "-o executable"
+     * @param timeout_seconds Limit for an external linker
+     * @param cancellation Checked before linking; kills an external linker
+     * @return ProcessResult Result of the link
+     */
+    ProcessResult link(const std::vector<std::string>& args, int timeout_seconds,
+                       std::shared_ptr<CancellationToken> cancellation);
+
+    /**
+     * @brief Version of the linked Clang libraries
+     *
+     * @return std::string Full Clang version string
+     */
+    static std::string version();
+
+    /**
+     * @brief Get compile and link counters for the metrics endpoint
+     *
+     * @return nlohmann::json Counters
+     */
+    nlohmann::json getStatistics() const;
+
+private:
+    ProcessResult emit(const std::vector<std::string>& args, std::string_view code, bool bitcode, std::string& output,
+                       const std::shared_ptr<CancellationToken>& cancellation);
+
+    std::string clang_path_;
+    ProcessRunner runner_;
+
+    // LLD keeps its state in globals, so links run one at a time
+    std::mutex link_mutex_;
+    // Cleared once LLD exited instead of returning, leaving those globals unusable
+    std::atomic<bool> lld_usable_{true};
+
+    std::atomic<uint64_t> compiles_{0};
+    std::atomic<uint64_t> failed_compiles_{0};
+    std::atomic<uint64_t> crashes_{0};
+    std::atomic<uint64_t> in_process_links_{0};
+    std::atomic<uint64_t> external_links_{0};
+};
+
+} // namespace cpp_mastery
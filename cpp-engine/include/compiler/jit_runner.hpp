@@ -0,0 +1,45 @@
+// File: cpp-engine/include/compiler/jit_runner.hpp
+// Extension: .hpp
+
+#pragma once
+
+namespace cpp_mastery {
+
+/**
+ * @brief Runs an LLVM bitcode module's main() through the ORC JIT
+ *
+ * Used inside sandbox slot workers: the slot forks, applies the sandbox
+ * restrictions and then calls run() instead of fexecve()ing an executable.
+ * The module is linked against the symbols already loaded in the process
+ * (libstdc++, libc, libm), so nothing touches the file system.
+ */
+class JitRunner {
+public:
+    // Sole byte written to the status descriptor once main() resolved; anything else is an error message
+    static constexpr char kStarted = 'S';
+
+    // Exit code of a worker whose module never started
+    static constexpr int kNotStarted = 126;
+
+    /**
+     * @brief Register the native target; call once before forking workers
+     */
+    static void initialize();
+
+    /**
+     * @brief Load, link and run a module
+     *
+     * Reads the bitcode from bitcode_fd to EOF and links it. If that fails,
+     * the error is written to status_fd and nothing of the module runs.
+     * Otherwise kStarted is written, then static constructors, main() and
+     * static destructors run and stdio is flushed. Meant for a forked child
+     * that _exit()s with the result.
+     *
+     * @param bitcode_fd Descriptor the module is read from; closed on return
+     * @param status_fd Descriptor for the start report; closed on return
+     * @return int main()'s return value, or kNotStarted
+     */
+    static int run(int bitcode_fd, int status_fd);
+};
+
+} // namespace cpp_mastery
@@ -0,0 +1,240 @@
+// File: cpp-engine/include/compiler/job_manager.hpp
+// Extension: .hpp
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <unordered_map>
+#include <condition_variable>
+#include <nlohmann/json.hpp>
+
+#include "utils/cancellation_token.hpp"
+
+namespace cpp_mastery {
+
+/**
+ * @brief Lifecycle of an asynchronous job
+ */
+enum class JobState {
+    QUEUED,         // submitted, waiting for admission
+    RUNNING,
+    SUCCEEDED,      // the work finished; its result may still report a failed compile or run
+    FAILED,         // the work could not be done, e.g. the queue turned it away
+    CANCELLED
+};
+
+/**
+ * @brief Convert a job state to its API name
+ *
+ * @param state State to convert
+ * @return std::string e.g. "running"
+ */
+std::string jobStateToString(JobState state);
+
+/**
+ * @brief One submitted compile, execute or analyze request
+ *
+ * Progress is recorded as an append-only list of events, each numbered by
+ * its position, so a client can poll, stream, or reconnect and resume from
+ * the last event it saw. Thread-safe.
+ */
+class Job {
+public:
+    Job(std::string id, std::string kind);
+
+    Job(const Job&) = delete;
+    Job& operator=(const Job&) = delete;
+
+    const std::string& id() const { return id_; }
+    const std::string& kind() const { return kind_; }
+
+    /**
+     * @brief Token the work passes down to admission and the processes it starts
+     */
+    const std::shared_ptr<CancellationToken>& cancellation() const { return cancellation_; }
+
+    /**
+     * @brief Record that the work was admitted and started
+     */
+    void markRunning();
+
+    /**
+     * @brief Append a progress event
+     *
+     * @param event Event object; "seq" is added
+     */
+    void emit(nlohmann::json event);
+
+    /**
+     * @brief Record the outcome and wake everyone waiting on events
+     *
+     * Only the first call has an effect.
+     *
+     * @param state SUCCEEDED, FAILED or CANCELLED
+     * @param result Result object, or null
+     * @param error Reason for FAILED or CANCELLED
+     */
+    void finish(JobState state, nlohmann::json result, const std::string& error = "");
+
+    /**
+     * @brief Whether finish() was called
+     */
+    bool finished() const;
+
+    /**
+     * @brief Wait for events at or after a position
+     *
+     * @param from Sequence number of the first event wanted
+     * @param timeout Longest to wait when there are none yet
+     * @param events Receives the events, in order
+     * @return false once the job finished and no events remain from that position
+     */
+    bool waitForEvents(size_t from, std::chrono::milliseconds timeout, std::vector<nlohmann::json>& events) const;
+
+    /**
+     * @brief Current state, timestamps and, once finished, the result
+     *
+     * @return nlohmann::json Job status for the poll endpoint
+     */
+    nlohmann::json snapshot() const;
+
+    /**
+     * @brief When finish() was called; only meaningful once finished()
+     */
+    std::chrono::steady_clock::time_point finishedAt() const;
+
+private:
+    void emitLocked(nlohmann::json event);
+
+    const std::string id_;
+    const std::string kind_;
+    const std::shared_ptr<CancellationToken> cancellation_ = std::make_shared<CancellationToken>();
+
+    mutable std::mutex mutex_;
+    mutable std::condition_variable changed_;
+    JobState state_ = JobState::QUEUED;
+    std::vector<nlohmann::json> events_;
+    nlohmann::json result_;
+    std::string error_;
+    std::chrono::system_clock::time_point created_at_;
+    std::chrono::system_clock::time_point started_at_;
+    std::chrono::system_clock::time_point finished_at_;
+    std::chrono::steady_clock::time_point finished_steady_;
+};
+
+/**
+ * @brief Job manager settings
+ */
+struct JobPolicy {
+    size_t max_active = 110;                    // queued or running jobs before submit() refuses
+    std::chrono::seconds result_ttl{300};       // how long finished jobs stay available
+};
+
+/**
+ * @brief Runs submitted requests in the background and keeps their results
+ *
+ * submit() returns at once with a job whose id the client polls, streams
+ * or cancels. Each job runs on its own thread; the work is expected to
+ * queue for admission and start processes with the job's cancellation
+ * token, so cancelling kills the compiler or program immediately and gives
+ * back its admission slot. Finished jobs are dropped result_ttl after they
+ * finish, checked whenever the table is used.
+ */
+class JobManager {
+public:
+    /**
+     * @brief Work done by a job; returns the result object
+     *
+     * Throwing fails the job with the exception's message.
+     */
+    using Work = std::function<nlohmann::json(Job&)>;
+
+    /**
+     * @brief Get the server-wide manager, configured from ServerConfig
+     *
+     * @return JobManager& Reference to the manager
+     */
+    static JobManager& getInstance();
+
+    /**
+     * @brief Construct a manager; getInstance() is the normal entry point
+     *
+     * @param policy Limits and result TTL
+     */
+    explicit JobManager(JobPolicy policy);
+
+    /**
+     * @brief Destructor; cancels unfinished jobs and waits for their threads
+     */
+    ~JobManager();
+
+    JobManager(const JobManager&) = delete;
+    JobManager& operator=(const JobManager&) = delete;
+
+    /**
+     * @brief Start a job
+     *
+     * @param kind Request type, e.g. "execute"
+     * @param work Work to run on the job's thread
+     * @param supersede_key When set, the previous job submitted with the same
+     *                      key is cancelled, e.g. an older draft of one session
+     * @return std::shared_ptr<Job> The job, or null when max_active jobs are unfinished
+     */
+    std::shared_ptr<Job> submit(const std::string& kind, Work work, const std::string& supersede_key = "");
+
+    /**
+     * @brief Look up a job that has not expired
+     *
+     * @param id Job id from submit()
+     * @return std::shared_ptr<Job> The job, or null
+     */
+    std::shared_ptr<Job> find(const std::string& id);
+
+    /**
+     * @brief Cancel a job; finished jobs are left as they are
+     *
+     * @param id Job id from submit()
+     * @param forget Also drop the job from the table
+     * @return std::shared_ptr<Job> The job, or null if unknown
+     */
+    std::shared_ptr<Job> cancel(const std::string& id, bool forget = false);
+
+    /**
+     * @brief Get job counts for the metrics endpoint
+     *
+     * @return nlohmann::json Active and retained jobs and lifetime counters
+     */
+    nlohmann::json getStatistics();
+
+private:
+    void run(const std::shared_ptr<Job>& job, const Work& work);
+    void sweepLocked();
+    static std::string generateId();
+
+    static std::unique_ptr<JobManager> instance_;
+    static std::mutex instance_mutex_;
+
+    const JobPolicy policy_;
+
+    std::mutex mutex_;
+    std::condition_variable idle_;
+    std::unordered_map<std::string, std::shared_ptr<Job>> jobs_;
+    std::unordered_map<std::string, std::weak_ptr<Job>> latest_by_key_;
+    size_t active_ = 0;
+
+    std::atomic<uint64_t> submitted_{0};
+    std::atomic<uint64_t> rejected_{0};
+    std::atomic<uint64_t> succeeded_{0};
+    std::atomic<uint64_t> failed_{0};
+    std::atomic<uint64_t> cancelled_{0};
+    std::atomic<uint64_t> superseded_{0};
+    std::atomic<uint64_t> expired_{0};
+};
+
+} // namespace cpp_mastery
@@ -0,0 +1,228 @@
+// File: cpp-engine/include/compiler/judge.hpp
+// Extension: .hpp
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <string_view>
+#include <nlohmann/json.hpp>
+
+#include "compiler/execution_engine.hpp"
+#include "utils/config.hpp"
+
+namespace cpp_mastery {
+
+/**
+ * @brief Outcome of one test case
+ */
+enum class Verdict {
+    ACCEPTED,               // AC
+    WRONG_ANSWER,           // WA
+    TIME_LIMIT_EXCEEDED,    // TLE, wall clock or CPU time
+    MEMORY_LIMIT_EXCEEDED,  // MLE
+    OUTPUT_LIMIT_EXCEEDED,  // OLE
+    RUNTIME_ERROR,          // RE
+    COMPILATION_ERROR,      // CE, reported for the submission as a whole
+    SKIPPED,                // not run after an earlier failure
+    INTERNAL_ERROR          // IE
+};
+
+/**
+ * @brief Convert a verdict to its short name
+ *
+ * @param verdict Verdict to convert
+ * @return std::string e.g. "AC", "WA"
+ */
+std::string verdictToString(Verdict verdict);
+
+/**
+ * @brief Compares program output with the expected output as it arrives
+ *
+ * Neither side is buffered: EXACT compares byte by byte, TOKENS compares
+ * whitespace-separated tokens against the expected text in place. A
+ * mismatch is detected at the first differing byte or token.
+ */
+class OutputComparator {
+public:
+    enum class Mode {
+        EXACT,      // byte for byte
+        TOKENS      // whitespace-separated tokens; spacing and line breaks ignored
+    };
+
+    /**
+     * @brief Construct a comparator
+     *
+     * @param expected Expected output; must outlive the comparator
+     * @param mode Comparison mode
+     */
+    OutputComparator(std::string_view expected, Mode mode);
+
+    /**
+     * @brief Compare the next chunk of output
+     *
+     * @param chunk Bytes the program just wrote
+     */
+    void feed(std::string_view chunk);
+
+    /**
+     * @brief Finish after the program's output ended
+     *
+     * @return true if the whole output matched
+     */
+    bool finish();
+
+    /**
+     * @brief Whether a difference has already been seen
+     */
+    bool mismatched() const { return mismatch_offset_.has_value(); }
+
+    /**
+     * @brief Byte offset in the program output of the first difference
+     */
+    std::optional<size_t> mismatchOffset() const { return mismatch_offset_; }
+
+    /**
+     * @brief Parse a mode name ("exact" or "tokens")
+     *
+     * @param name Mode name from a request
+     * @return Mode Matching mode, TOKENS for anything else
+     */
+    static Mode modeFromString(const std::string& name);
+
+private:
+    void feedExact(std::string_view chunk);
+    void feedTokens(std::string_view chunk);
+    void endToken();
+    void skipExpectedSpace();
+
+    std::string_view expected_;
+    Mode mode_;
+    size_t expected_pos_ = 0;   // start of the expected token being matched in TOKENS mode
+    size_t actual_pos_ = 0;
+    bool in_token_ = false;
+    size_t token_length_ = 0;   // bytes of the current output token matched so far
+    size_t token_start_ = 0;
+    std::optional<size_t> mismatch_offset_;
+};
+
+/**
+ * @brief One test case submitted for judging
+ */
+struct JudgeCase {
+    std::string input;
+    std::string expected_output;
+    nlohmann::json limits = nlohmann::json::object();  // ExecutionConfig overrides; may only tighten
+};
+
+/**
+ * @brief Options for a judge run
+ */
+struct JudgeOptions {
+    OutputComparator::Mode mode = OutputComparator::Mode::TOKENS;
+    bool stop_on_first_failure = false;
+    size_t parallelism = 0;     // concurrent cases; 0 or anything above sandbox_pool_max uses sandbox_pool_max
+    std::string client_id;      // admission fairness key for the workers beyond the first
+    nlohmann::json compile_options = nlohmann::json::object();
+};
+
+/**
+ * @brief Result of one test case
+ */
+struct CaseResult {
+    Verdict verdict = Verdict::SKIPPED;
+    ExecutionStatus status = ExecutionStatus::INTERNAL_ERROR;
+    int exit_code = 0;
+    int term_signal = 0;
+    long time_ms = 0;
+    long cpu_time_ms = 0;
+    long memory_kb = 0;
+    std::optional<size_t> mismatch_offset;
+    std::string output_preview;     // first bytes of stdout
+    std::string stderr_preview;     // first bytes of stderr
+};
+
+/**
+ * @brief Result of judging a submission
+ */
+struct JudgeResult {
+    CompilationResult compilation;
+    std::vector<CaseResult> cases;
+    Verdict verdict = Verdict::INTERNAL_ERROR;  // first non-AC verdict in case order, or AC
+    size_t passed = 0;
+    long total_time_ms = 0;
+    std::string error_message;
+};
+
+/**
+ * @brief Runs a submission against many test cases
+ *
+ * Compiles once, then fans the cases out over up to `parallelism` workers,
+ * never more than sandbox_pool_max. The caller's admission ticket covers
+ * the first worker; each further one queues for its own ticket in the batch
+ * lane before it takes a case, so a run cannot exceed the server's
+ * concurrency limit.
+ * Each worker pulls the next case, runs the executable through the
+ * execution engine's sandbox path with that case's limits, and streams
+ * stdout into an OutputComparator. Only short previews of the output are
+ * kept. With stop_on_first_failure, workers stop taking cases after the
+ * first non-AC verdict and the remaining ones are reported as SKIPPED.
+ */
+class Judge {
+public:
+    /**
+     * @brief Construct a judge
+     *
+     * @param engine Engine used to compile and run
+     */
+    explicit Judge(ExecutionEngine& engine);
+
+    /**
+     * @brief Judge a submission
+     *
+     * @param code C++ source code
+     * @param cases Test cases
+     * @param options Comparison, parallelism and compile options
+     * @return JudgeResult Compilation result and per-case verdicts
+     */
+    JudgeResult judge(const std::string& code, const std::vector<JudgeCase>& cases, const JudgeOptions& options);
+
+    /**
+     * @brief Apply per-case limit overrides on top of the configured limits
+     *
+     * Accepts execution_timeout, max_memory_mb, max_cpu_time and
+     * max_output_size; values above the configured ones are clamped.
+     *
+     * @param base Configured limits
+     * @param overrides Requested limits
+     * @return ExecutionConfig Limits for the case
+     */
+    static ExecutionConfig effectiveLimits(const ExecutionConfig& base, const nlohmann::json& overrides);
+
+    /**
+     * @brief Number of workers a run uses
+     *
+     * @param requested Client's parallelism; 0 uses pool_max
+     * @param case_count Number of cases
+     * @param pool_max Configured sandbox_pool_max, the server-side cap
+     * @return size_t At least 1, at most pool_max and case_count
+     */
+    static size_t workerCount(size_t requested, size_t case_count, int pool_max);
+
+    /**
+     * @brief Map an execution status and comparison to a verdict
+     *
+     * @param status How the run ended
+     * @param output_matched Whether the output matched
+     * @return Verdict Verdict for the case
+     */
+    static Verdict verdictFor(ExecutionStatus status, bool output_matched);
+
+private:
+    CaseResult runCase(const std::string& executable_path, const JudgeCase& test_case, const JudgeOptions& options);
+
+    ExecutionEngine& engine_;
+};
+
+} // namespace cpp_mastery
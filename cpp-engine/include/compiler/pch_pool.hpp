@@ -0,0 +1,121 @@
+// File: cpp-engine/include/compiler/pch_pool.hpp
+// Extension: .hpp
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <functional>
+#include <filesystem>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+#include "compiler/execution_engine.hpp"
+
+namespace cpp_mastery {
+
+/**
+ * @brief Compiler configuration a precompiled header is only valid for
+ */
+struct PchToolchain {
+    std::string compiler_path;
+    bool is_clang = false;
+    std::string standard;
+    std::string optimization;
+};
+
+/**
+ * @brief Pool of precompiled headers for common standard-library prefixes
+ *
+ * Keeps one PCH per (include set, compiler, standard, optimization) under
+ * <root>/<compiler>-<standard>-<optimization>/. A submission whose leading
+ * #include <...> lines are a subset of an include set is compiled with
+ * `-include <set header>`, which both GCC (.gch) and Clang (.pch) resolve to
+ * the precompiled file. Each toolchain directory carries a stamp of the
+ * compiler binary (size, mtime, version) and is rebuilt when it changes.
+ */
+class PchPool {
+public:
+    using ProcessRunner = std::function<ProcessResult(const std::vector<std::string>&, int)>;
+
+    /**
+     * @brief Construct a PCH pool
+     *
+     * @param root Directory holding the precompiled headers
+     * @param runner Function used to run the compiler
+     * @param build_timeout_seconds Timeout for building a single PCH
+     */
+    PchPool(std::filesystem::path root, ProcessRunner runner, int build_timeout_seconds);
+
+    /**
+     * @brief Build (or validate existing) PCHs for the given toolchains
+     *
+     * @param toolchains Toolchain combinations to prepare
+     * @param compiler_versions Compiler path -> version banner
+     */
+    void initialize(const std::vector<PchToolchain>& toolchains,
+                    const std::unordered_map<std::string, std::string>& compiler_versions);
+
+    /**
+     * @brief Find the PCH header to inject for a submission
+     *
+     * @param code Submission source code
+     * @param toolchain Toolchain the submission is compiled with
+     * @return std::optional<std::string> Path to pass to -include, or nullopt
+     */
+    std::optional<std::string> select(const std::string& code, const PchToolchain& toolchain);
+
+    /**
+     * @brief Extract the <...> headers included before the first line of code
+     *
+     * Scanning stops at the first line that is not blank, a comment or a
+     * system #include, so a #define ahead of the includes disables PCH use.
+     *
+     * @param code Submission source code
+     * @return std::vector<std::string> Header names in the leading include block
+     */
+    static std::vector<std::string> leadingSystemIncludes(const std::string& code);
+
+    /**
+     * @brief Get PCH usage statistics
+     *
+     * @return nlohmann::json Per-set usage counters and readiness
+     */
+    nlohmann::json getStatistics() const;
+
+private:
+    struct IncludeSet {
+        std::string name;
+        std::vector<std::string> headers;
+    };
+
+    struct ToolchainState {
+        PchToolchain toolchain;
+        std::filesystem::path directory;
+        std::string stamp;
+        std::vector<std::string> ready_sets;
+        std::chrono::steady_clock::time_point last_checked;
+    };
+
+    static const std::vector<IncludeSet>& includeSets();
+    static std::string toolchainId(const PchToolchain& toolchain);
+    std::string compilerStamp(const PchToolchain& toolchain) const;
+    void buildToolchain(ToolchainState& state);
+    bool buildSet(const ToolchainState& state, const IncludeSet& set);
+
+    std::filesystem::path root_;
+    ProcessRunner runner_;
+    int build_timeout_seconds_;
+    std::unordered_map<std::string, std::string> compiler_versions_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, ToolchainState> toolchains_;
+    std::unordered_map<std::string, uint64_t> uses_;
+    std::atomic<uint64_t> misses_{0};
+};
+
+} // namespace cpp_mastery
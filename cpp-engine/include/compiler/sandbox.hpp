@@ -0,0 +1,265 @@
+// File: cpp-engine/include/compiler/sandbox.hpp
+// Extension: .hpp
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <string_view>
+#include <sys/types.h>
+#include <linux/filter.h>
+#include <nlohmann/json.hpp>
+
+#include "utils/process_supervisor.hpp"
+
+namespace cpp_mastery {
+
+struct ExecutionConfig;
+
+/**
+ * @brief Resource limits applied to one sandboxed run
+ */
+struct SandboxLimits {
+    size_t memory_bytes = 0;
+    int cpu_time_seconds = 0;
+    int max_processes = 64;
+    size_t max_file_size_bytes = 16 * 1024 * 1024;
+    int max_open_files = 64;
+    size_t max_output_bytes = 0;    // stdout/stderr kept per stream, 0 for all
+};
+
+/**
+ * @brief Counters read from a cgroup v2 leaf
+ *
+ * Unlike rusage these include processes the program never waited for.
+ * Fields the kernel does not provide (memory.peak needs 5.19) stay zero.
+ */
+struct CgroupUsage {
+    long peak_memory_kb = 0;
+    long user_time_ms = 0;
+    long system_time_ms = 0;
+    long io_read_bytes = 0;
+    long io_write_bytes = 0;
+    long oom_kills = 0;
+};
+
+/**
+ * @brief Native Linux sandbox for running untrusted programs
+ *
+ * Each run goes through the process supervisor with a pre-exec hook that:
+ * - joins a fresh cgroup v2 leaf (memory.max, memory.swap.max, pids.max, cpu.max)
+ * - drops to an unprivileged uid when the server runs as root
+ * - unshares user, mount, network, IPC, UTS and PID namespaces
+ * - builds a tmpfs root with read-only binds of the configured rootfs,
+ *   a private /tmp, /proc and a minimal /dev, then pivot_root()s into it
+ * - applies rlimits, PR_SET_NO_NEW_PRIVS and a seccomp-bpf denylist
+ * - fexecve()s the program from a descriptor opened before isolation
+ *
+ * Every step runs after fork() in a multithreaded server, so the child side
+ * only uses raw system calls on data prepared by the parent (see Plan).
+ * When cgroups are unavailable the limits fall back to rlimits; when the
+ * kernel refuses namespaces the sandbox reports itself unavailable and the
+ * engine falls back to another backend.
+ */
+class Sandbox {
+public:
+    /**
+     * @brief Get the singleton instance of the sandbox
+     *
+     * @return Sandbox& Reference to the sandbox
+     */
+    static Sandbox& getInstance();
+
+    // Delete copy constructor and assignment operator
+    Sandbox(const Sandbox&) = delete;
+    Sandbox& operator=(const Sandbox&) = delete;
+
+    /**
+     * @brief Probe kernel support and prepare the cgroup hierarchy
+     *
+     * @param config Execution configuration (rootfs, cgroup root)
+     * @return true if programs can be run in the sandbox
+     * @return false if namespaces are unavailable on this host
+     */
+    bool initialize(const ExecutionConfig& config);
+
+    /**
+     * @brief Check whether initialize() succeeded
+     */
+    bool isAvailable() const { return available_; }
+
+    /**
+     * @brief Run a program in a fresh sandbox
+     *
+     * @param args Host path of the executable followed by its arguments
+     * @param limits Resource limits for this run
+     * @param timeout Wall-clock limit
+     * @param input Bytes delivered on the program's stdin
+     * @param on_output Receives output as it arrives instead of the result
+     * @param cancellation Kills the program when cancelled
+     * @return ProcessResult Result of the sandboxed program
+     */
+    ProcessResult run(const std::vector<std::string>& args, const SandboxLimits& limits,
+                      std::chrono::milliseconds timeout, std::string_view input = {},
+                      OutputCallback on_output = nullptr,
+                      std::shared_ptr<CancellationToken> cancellation = nullptr);
+
+    /**
+     * @brief Derive per-run limits from the execution configuration
+     *
+     * @param config Execution configuration
+     * @return SandboxLimits Limits for max_memory_mb and max_cpu_time
+     */
+    static SandboxLimits limitsFromConfig(const ExecutionConfig& config);
+
+    /**
+     * @brief Get sandbox capabilities and counters for the metrics endpoint
+     *
+     * @return nlohmann::json Backend status
+     */
+    nlohmann::json getStatus() const;
+
+    /**
+     * @brief Everything the isolated child needs, prepared before fork()
+     */
+    struct Plan {
+        struct RootEntry {
+            std::string source;       // host path to bind, or symlink target
+            std::string target;       // path under the staging root
+            bool is_symlink = false;
+        };
+
+        std::string cgroup_procs;     // <leaf>/cgroup.procs, empty without cgroups
+        bool drop_privileges = false;
+        uid_t run_uid = 0;
+        gid_t run_gid = 0;
+        std::string uid_map;
+        std::string gid_map;
+        std::string staging_root;
+        std::vector<RootEntry> root_entries;
+        std::string tmp_target;
+        std::string proc_target;
+        std::string dev_target;
+        std::vector<std::string> device_targets;
+        std::vector<std::string> device_sources;
+        std::string tmp_mount_options;
+        SandboxLimits limits;
+        bool rlimit_memory = false;
+        std::vector<sock_filter> seccomp_filter;
+        int executable_fd = -1;
+        std::vector<char*> argv;
+        std::vector<char*> envp;
+    };
+
+    /**
+     * @brief Child side, part one: cgroup, credentials, namespaces and root
+     *
+     * Forks once more so the program becomes PID 1 of the new PID namespace;
+     * the intermediate process waits and mirrors its exit status, and never
+     * returns. Async-signal-safe.
+     *
+     * @return true in the isolated grandchild, false if isolation failed
+     */
+    static bool enterIsolation(const Plan& plan);
+
+    /**
+     * @brief Apply CPU, memory, file size, descriptor and core rlimits
+     *
+     * Also used for unsandboxed runs. Async-signal-safe.
+     *
+     * @param limits Limits for the run
+     * @param rlimit_memory Whether memory is capped with RLIMIT_AS
+     */
+    static void applyResourceLimits(const SandboxLimits& limits, bool rlimit_memory);
+
+    /**
+     * @brief Child side, part two: rlimits, no_new_privs and seccomp
+     *
+     * Async-signal-safe.
+     *
+     * @return true if every restriction was applied
+     */
+    static bool applyRestrictions(const Plan& plan);
+
+    /**
+     * @brief Fill the parts of a plan that do not depend on the program
+     *
+     * @param limits Limits for the run
+     * @param cgroup_leaf Cgroup directory for the run, empty for none
+     * @return Plan Plan without executable_fd/argv
+     */
+    Plan makePlan(const SandboxLimits& limits, const std::string& cgroup_leaf) const;
+
+    /**
+     * @brief Build the subset of a plan applyRestrictions() reads
+     *
+     * Used by sandbox pool slots, which are already isolated and only need
+     * per-run restrictions.
+     *
+     * @param limits Limits for the run
+     * @param rlimit_memory Whether memory must be capped with RLIMIT_AS
+     * @return Plan Plan with limits, seccomp filter, tmpfs options and environment
+     */
+    static Plan restrictionPlan(const SandboxLimits& limits, bool rlimit_memory);
+
+    /**
+     * @brief Check whether runs get a cgroup leaf
+     */
+    bool cgroupsAvailable() const { return cgroups_available_; }
+
+    /**
+     * @brief Create and configure a cgroup leaf for one run or pool slot
+     *
+     * @param limits Limits to write into the leaf
+     * @return std::optional<std::string> Leaf directory, or nullopt without cgroups
+     */
+    std::optional<std::string> createCgroup(const SandboxLimits& limits);
+
+    /**
+     * @brief Read memory.peak, cpu.stat, io.stat and memory.events of a leaf
+     *
+     * @param leaf Directory returned by createCgroup()
+     * @return CgroupUsage Counters accumulated since the leaf was created
+     */
+    static CgroupUsage readCgroupUsage(const std::string& leaf);
+
+    /**
+     * @brief Remove a cgroup leaf once its processes are gone
+     *
+     * @param leaf Directory returned by createCgroup()
+     */
+    void removeCgroup(const std::string& leaf);
+
+private:
+    /**
+     * @brief Private constructor for singleton pattern
+     */
+    Sandbox() = default;
+
+    bool setupCgroups(const std::string& cgroup_root);
+    static std::vector<sock_filter> buildSeccompFilter();
+
+    // Static members for singleton pattern
+    static std::unique_ptr<Sandbox> instance_;
+    static std::mutex mutex_;
+
+    bool available_ = false;
+    bool cgroups_available_ = false;
+    bool seccomp_available_ = false;
+    std::string unavailable_reason_;
+    std::string rootfs_;
+    std::string cgroup_root_;
+    std::vector<Plan::RootEntry> root_entries_;
+    std::vector<sock_filter> seccomp_filter_;
+
+    std::atomic<uint64_t> runs_{0};
+    std::atomic<uint64_t> setup_failures_{0};
+    std::atomic<uint64_t> cgroup_sequence_{0};
+};
+
+} // namespace cpp_mastery
@@ -0,0 +1,172 @@
+// File: cpp-engine/include/compiler/sandbox_pool.hpp
+// Extension: .hpp
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <optional>
+#include <string_view>
+#include <condition_variable>
+#include <nlohmann/json.hpp>
+
+#include "compiler/sandbox.hpp"
+#include "utils/process_supervisor.hpp"
+
+namespace cpp_mastery {
+
+/**
+ * @brief Pool of pre-initialized native sandbox slots
+ *
+ * A slot is a long-lived helper process (this binary re-executed with
+ * --sandbox-slot) that has already joined its cgroup, entered fresh
+ * namespaces and pivoted into the read-only root with a private tmpfs /tmp.
+ * It then waits on a SOCK_SEQPACKET control socket. A run only sends the
+ * limits plus the executable, stdin, stdout and stderr descriptors; the slot
+ * forks, applies rlimits/seccomp, fexecve()s the program and replies with its
+ * exit status and rusage. Afterwards it kills every leftover process in its
+ * PID namespace and replaces /tmp with an empty tmpfs before taking the next
+ * request. For runBitcode() the forked child runs the module through the
+ * ORC JIT instead of executing a file (see JitRunner).
+ *
+ * The pool keeps at least min_slots warm, grows on demand up to max_slots and
+ * retires idle slots when a moving average of busy slots says they are not
+ * needed. Slots are also recycled after a fixed number of runs.
+ */
+class SandboxPool {
+public:
+    // First argument that turns the server binary into a slot helper
+    static constexpr const char* kSlotFlag = "--sandbox-slot";
+
+    // Descriptor the helper finds its control socket on
+    static constexpr int kControlFd = 3;
+
+    /**
+     * @brief Construct a pool on top of an initialized native sandbox
+     *
+     * @param sandbox Sandbox providing plans and cgroups
+     * @param min_slots Slots kept warm even when idle
+     * @param max_slots Upper bound on concurrent slots
+     */
+    SandboxPool(Sandbox& sandbox, size_t min_slots, size_t max_slots);
+
+    /**
+     * @brief Destructor; shuts every slot down
+     */
+    ~SandboxPool();
+
+    SandboxPool(const SandboxPool&) = delete;
+    SandboxPool& operator=(const SandboxPool&) = delete;
+
+    /**
+     * @brief Start the initial slots
+     *
+     * @param limits Limits the slots' cgroups are created with
+     * @return true if at least one slot came up
+     */
+    bool initialize(const SandboxLimits& limits);
+
+    /**
+     * @brief Run a program in a warm slot
+     *
+     * Falls back to Sandbox::run() when no slot can be started.
+     *
+     * @param executable_path Host path of the executable
+     * @param input Bytes delivered on the program's stdin
+     * @param limits Resource limits for this run
+     * @param timeout Wall-clock limit
+     * @param on_output Receives output as it arrives instead of the result
+     * @param cancellation Kills the program, and with it the slot, when cancelled
+     * @return ProcessResult Result of the program
+     */
+    ProcessResult run(const std::string& executable_path, std::string_view input,
+                      const SandboxLimits& limits, std::chrono::milliseconds timeout,
+                      OutputCallback on_output = nullptr,
+                      std::shared_ptr<CancellationToken> cancellation = nullptr);
+
+    /**
+     * @brief Run an LLVM bitcode module's main() in a warm slot through the JIT
+     *
+     * The wall-clock and CPU limits cover JIT code generation as well as
+     * the program.
+     *
+     * @param bitcode Module compiled for this host
+     * @param input Bytes delivered on the program's stdin
+     * @param limits Resource limits for this run
+     * @param timeout Wall-clock limit
+     * @param on_output Receives output as it arrives instead of the result
+     * @param cancellation Kills the program, and with it the slot, when cancelled
+     * @param unsupported_reason Set when nothing ran
+     * @return std::optional<ProcessResult> Result of the program, or nullopt
+     *         when no slot was available or the module could not be linked
+     */
+    std::optional<ProcessResult> runBitcode(std::string_view bitcode, std::string_view input,
+                                            const SandboxLimits& limits, std::chrono::milliseconds timeout,
+                                            OutputCallback on_output, std::shared_ptr<CancellationToken> cancellation,
+                                            std::string& unsupported_reason);
+
+    /**
+     * @brief Get occupancy and wait statistics for the metrics endpoint
+     *
+     * @return nlohmann::json Pool statistics
+     */
+    nlohmann::json getStatistics() const;
+
+    /**
+     * @brief Entry point of a slot helper process
+     *
+     * Called from main() when argv[1] is kSlotFlag. Serves requests on
+     * kControlFd until the control socket is closed.
+     *
+     * @return int Process exit code
+     */
+    static int runSlot();
+
+private:
+    struct Slot;
+
+    std::optional<ProcessResult> dispatch(const std::shared_ptr<Slot>& slot, UniqueFd payload, bool jit,
+                                          std::string_view input, const SandboxLimits& limits,
+                                          std::chrono::milliseconds timeout, OutputCallback on_output,
+                                          std::shared_ptr<CancellationToken> cancellation, std::string* jit_error);
+    std::shared_ptr<Slot> startSlot();
+    std::shared_ptr<Slot> acquire();
+    void release(std::shared_ptr<Slot> slot, bool healthy);
+    void retire(const std::shared_ptr<Slot>& slot);
+    void replenish();
+    size_t targetIdleSlots() const;
+
+    Sandbox& sandbox_;
+    size_t min_slots_;
+    size_t max_slots_;
+    SandboxLimits slot_limits_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable slot_available_;
+    std::vector<std::shared_ptr<Slot>> idle_;
+    size_t total_slots_ = 0;
+    size_t busy_slots_ = 0;
+    double busy_average_ = 0.0;
+    bool shutting_down_ = false;
+
+    // Slot shutdowns and replacements run off the request path
+    std::vector<std::future<void>> maintenance_;
+
+    std::atomic<uint64_t> runs_{0};
+    std::atomic<uint64_t> acquisitions_{0};
+    std::atomic<uint64_t> fallbacks_{0};
+    std::atomic<uint64_t> jit_runs_{0};
+    std::atomic<uint64_t> jit_unsupported_{0};
+    std::atomic<uint64_t> slots_started_{0};
+    std::atomic<uint64_t> slots_retired_{0};
+    std::atomic<uint64_t> start_failures_{0};
+    std::atomic<uint64_t> total_wait_us_{0};
+    std::atomic<uint64_t> max_wait_us_{0};
+};
+
+} // namespace cpp_mastery
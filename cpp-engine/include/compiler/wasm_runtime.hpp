@@ -0,0 +1,114 @@
+// File: cpp-engine/include/compiler/wasm_runtime.hpp
+// Extension: .hpp
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+
+#include "utils/process_supervisor.hpp"
+#include "utils/cancellation_token.hpp"
+
+namespace cpp_mastery {
+
+struct ExecutionConfig;
+
+/**
+ * @brief Limits of one WebAssembly run
+ */
+struct WasmLimits {
+    size_t memory_bytes = 0;        // linear memory cap, 0 for the runtime default
+    uint64_t fuel = 0;              // instructions (roughly) before an out-of-fuel trap, 0 for none
+    std::chrono::milliseconds timeout{0};   // wall-clock deadline, 0 for none
+    size_t max_output_bytes = 0;    // stdout/stderr kept per stream, 0 for all
+};
+
+/**
+ * @brief Runs wasm32-wasi programs in an embedded Wasmtime runtime
+ *
+ * Programs built with the wasi-sdk toolchain run inside the server process
+ * on a fixed pool of worker threads. Isolation comes from the runtime: a
+ * module can only reach its own linear memory and the WASI calls it is
+ * given, which here are argv, stdin, stdout and stderr, with no preopened
+ * directories. No namespaces, cgroups or fork are involved.
+ *
+ * Modules are compiled to native code once and kept in an LRU keyed by
+ * the SHA-256 of their bytes, so a cached module only pays for a fresh
+ * store and instance (microseconds). Memory is capped through the store
+ * limiter, CPU through fuel and wall time through epoch interruption
+ * driven by a ticker thread, which also notices cancellation.
+ *
+ * Output is collected into memory and handed to on_output in one piece
+ * after the run, so streaming observers see it at the end.
+ *
+ * Needs the engine to be built with Wasmtime (HAVE_WASMTIME); without it
+ * initialize() fails and the engine keeps its other backends.
+ */
+class WasmRuntime {
+public:
+    /**
+     * @brief Construct the runtime
+     *
+     * @param workers Threads running modules; more runs queue
+     * @param module_cache_size Compiled modules kept
+     */
+    WasmRuntime(size_t workers, size_t module_cache_size = 64);
+    ~WasmRuntime();
+
+    WasmRuntime(const WasmRuntime&) = delete;
+    WasmRuntime& operator=(const WasmRuntime&) = delete;
+
+    /**
+     * @brief Create the engine and linker and start the workers
+     *
+     * @return true if the runtime is usable
+     */
+    bool initialize();
+
+    /**
+     * @brief Run a module's _start
+     *
+     * Blocks until a worker has run the program. A WASI proc_exit() gives
+     * the exit code; traps are reported like the signals a native program
+     * would have died of (out of fuel as SIGXCPU, out-of-bounds accesses and
+     * stack overflow as SIGSEGV, unreachable as SIGABRT, arithmetic traps as
+     * SIGFPE) with the trap message in stderr.
+     *
+     * @param module_path .wasm file produced by the wasi toolchain
+     * @param input Bytes on the program's stdin
+     * @param limits Limits to run under
+     * @param on_output Receives the collected output after the run, or null
+     * @param cancellation Interrupts the program when cancelled
+     * @return ProcessResult Result of the run; memory_usage_kb is the final linear memory size
+     */
+    ProcessResult run(const std::string& module_path, std::string_view input, const WasmLimits& limits,
+                      const OutputCallback& on_output, std::shared_ptr<CancellationToken> cancellation);
+
+    /**
+     * @brief Get run, trap and module cache counters
+     *
+     * @return nlohmann::json Counters and instantiation times
+     */
+    nlohmann::json getStatistics() const;
+
+    /**
+     * @brief Derive WebAssembly limits from the execution configuration
+     *
+     * Memory from max_memory_mb, fuel from max_cpu_time times
+     * wasm_fuel_per_second, the deadline from execution_timeout.
+     *
+     * @param config Execution configuration
+     * @return WasmLimits Limits
+     */
+    static WasmLimits limitsFromConfig(const ExecutionConfig& config);
+
+private:
+    struct State;
+    std::unique_ptr<State> state_;
+};
+
+} // namespace cpp_mastery
@@ -9,10 +9,24 @@
 #include <mutex>
 #include <random>
 #include <chrono>
+#include <cstdint>
 #include <nlohmann/json.hpp>
 
 namespace cpp_mastery {
 
+class PreambleCache;
+
+/**
+ * @brief One token of a lexed source; offsets, lengths and columns count bytes
+ */
+struct SourceToken {
+    const char* kind;   // keyword, identifier, number, string, char, comment, directive, punctuation or unknown
+    uint32_t offset;
+    uint32_t length;
+    uint32_t line;      // from 1
+    uint32_t column;    // from 1
+};
+
 /**
  * @brief Result of AST parsing operation
  */
@@ -46,6 +60,8 @@ public:
     ASTParser(const ASTParser&) = delete;
     ASTParser& operator=(const ASTParser&) = delete;
     
+    ~ASTParser();
+    
     /**
      * @brief Initialize the AST parser
      * 
@@ -67,12 +83,40 @@ public:
     /**
      * @brief Parse C++ source code into AST
      * 
+     * The code is parsed from memory. Its leading #include block is served
+     * from the preamble cache when an earlier parse had the same one, so
+     * only the rest of the code is parsed; the AST lists the declarations
+     * of the code itself, not those of the headers it includes.
+     * 
      * @param code C++ source code to parse
      * @param include_tokens Whether to include token information
      * @return ParseResult Result containing AST JSON and metadata
      */
     ParseResult parse(const std::string& code, bool include_tokens = false);
     
+    /**
+     * @brief Split source code into tokens for syntax highlighting
+     * 
+     * Lexes with Clang's lexer in raw mode, without preprocessing or
+     * semantic analysis, so it needs no headers and does not require
+     * initialize(). Comments are kept, a directive such as "#include" is
+     * one token and so is an <header> name after it. Tokens are plain
+     * structs so lexing allocates next to nothing; tokensToJson() builds the
+     * API form.
+     * 
+     * @param code Source code to tokenize
+     * @return std::vector<SourceToken> Tokens in source order
+     */
+    std::vector<SourceToken> generateTokens(const std::string& code) const;
+    
+    /**
+     * @brief Convert tokens to their API form
+     * 
+     * @param tokens Tokens from generateTokens()
+     * @return nlohmann::json Array of [kind, offset, length, line, column] arrays
+     */
+    static nlohmann::json tokensToJson(const std::vector<SourceToken>& tokens);
+    
     /**
      * @brief Validate C++ syntax without full parsing
      * 
@@ -89,27 +133,19 @@ public:
      * @return nlohmann::json Statistics including complexity metrics
      */
     static nlohmann::json getASTStatistics(const nlohmann::json& ast);
-
-private:
-    /**
-     * @brief Private constructor for singleton pattern
-     */
-    ASTParser();
     
     /**
-     * @brief Generate tokens from source code
+     * @brief Get preamble cache statistics for the metrics endpoint
      * 
-     * @param code Source code to tokenize
-     * @return nlohmann::json Array of tokens with positions
+     * @return nlohmann::json Preamble hits, builds, evictions and bytes held
      */
-    nlohmann::json generateTokens(const std::string& code);
-    
+    nlohmann::json getStatistics() const;
+
+private:
     /**
-     * @brief Generate unique session ID for temporary files
-     * 
-     * @return std::string Unique session identifier
+     * @brief Private constructor for singleton pattern
      */
-    std::string generateSessionId();
+    ASTParser();
     
     // Static members for singleton pattern
     static std::unique_ptr<ASTParser> instance_;
@@ -118,6 +154,9 @@ private:
     // Initialization state
     bool initialized_;
     
+    // Parsed #include blocks shared between parses (created by initialize())
+    std::unique_ptr<PreambleCache> preambles_;
+    
     // Thread safety
     mutable std::mutex parser_mutex_;
 };
@@ -0,0 +1,110 @@
+// File: cpp-engine/include/parser/preamble_cache.hpp
+// Extension: .hpp
+
+#pragma once
+
+#include <string>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+#include <clang/Frontend/PrecompiledPreamble.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/VirtualFileSystem.h>
+
+namespace clang {
+class CompilerInvocation;
+class PCHContainerOperations;
+}
+
+namespace cpp_mastery {
+
+/**
+ * @brief In-memory Clang preambles shared by AST parses
+ *
+ * The preamble of a source file is its leading block of #include and
+ * other preprocessor lines, as Clang's ComputePreambleBounds() finds it.
+ * Lesson code mostly starts with the same few standard headers, so the
+ * parsed and serialized form of that block is kept and later parses only
+ * process what follows it. Preambles are keyed by the preamble text and
+ * the compile flags, checked against the headers on disk before reuse and
+ * evicted least recently used first once their total size exceeds the
+ * budget.
+ */
+class PreambleCache {
+public:
+    /**
+     * @brief Construct a cache
+     *
+     * @param budget_bytes Total size of kept preambles; 0 disables the cache
+     */
+    explicit PreambleCache(size_t budget_bytes);
+
+    PreambleCache(const PreambleCache&) = delete;
+    PreambleCache& operator=(const PreambleCache&) = delete;
+
+    /**
+     * @brief Get the preamble for a parse, building it on a miss
+     *
+     * Preambles with errors are not built, so their diagnostics come from
+     * the full parse.
+     *
+     * @param invocation Invocation of the parse; the main file is main_file
+     * @param main_file Source being parsed
+     * @param flags Compile flags, as part of the key
+     * @param files File system the parse reads headers from
+     * @return std::shared_ptr<const clang::PrecompiledPreamble> Preamble, or
+     *         null when the source has none, building failed or the cache is disabled
+     */
+    std::shared_ptr<const clang::PrecompiledPreamble> get(const clang::CompilerInvocation& invocation,
+                                                          const llvm::MemoryBuffer& main_file,
+                                                          const std::string& flags,
+                                                          llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> files);
+
+    /**
+     * @brief PCH container operations preambles are written with
+     *
+     * Parses that use a preamble must read it with the same operations.
+     *
+     * @return std::shared_ptr<clang::PCHContainerOperations> Operations
+     */
+    std::shared_ptr<clang::PCHContainerOperations> pchOperations() const { return pch_operations_; }
+
+    /**
+     * @brief Get hit, build and eviction counters
+     *
+     * @return nlohmann::json Counters and the bytes held
+     */
+    nlohmann::json getStatistics() const;
+
+private:
+    struct Entry {
+        std::shared_ptr<const clang::PrecompiledPreamble> preamble;
+        size_t bytes = 0;
+        std::list<std::string>::iterator position;
+    };
+
+    void insert(const std::string& key, std::shared_ptr<const clang::PrecompiledPreamble> preamble);
+    void erase(std::unordered_map<std::string, Entry>::iterator entry);
+
+    size_t budget_bytes_;
+    std::shared_ptr<clang::PCHContainerOperations> pch_operations_;
+
+    mutable std::mutex mutex_;
+    std::list<std::string> lru_;                      // keys, most recently used first
+    std::unordered_map<std::string, Entry> entries_;
+    size_t bytes_ = 0;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> stale_{0};
+    std::atomic<uint64_t> builds_{0};
+    std::atomic<uint64_t> build_failures_{0};
+    std::atomic<uint64_t> evictions_{0};
+    std::atomic<uint64_t> build_ms_total_{0};
+};
+
+} // namespace cpp_mastery
@@ -0,0 +1,125 @@
+// File: cpp-engine/include/parser/source_file_system.hpp
+// Extension: .hpp
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+#include <llvm/Support/VirtualFileSystem.h>
+
+namespace cpp_mastery {
+
+/**
+ * @brief File system Clang parses submissions against
+ *
+ * A proxy over the real file system that keeps the status and contents of
+ * system headers in memory, including the misses: an #include <vector> is
+ * looked up in every -I directory before it is found, and those probes are
+ * answered from memory after the first parse. Only absolute paths under the
+ * cached prefixes are kept; everything else goes to the real file system.
+ *
+ * An entry is trusted for revalidate_after. The next lookup stats the file
+ * once and drops the entry when its inode, size or modification time
+ * changed, or when a missing file appeared, so an upgraded header is seen
+ * within that time. Missing paths are kept up to max_missing, oldest
+ * dropped first.
+ *
+ * One instance is shared by all parser and analysis threads, so each header
+ * is held once. Each request layers its source on top with forSource().
+ */
+class SourceFileSystem : public llvm::vfs::ProxyFileSystem {
+public:
+    /**
+     * @brief Construct a caching proxy
+     *
+     * @param underlying File system to read through to
+     * @param cached_prefixes Absolute directory prefixes whose files are kept
+     * @param max_bytes Total size of kept file contents; larger files are read through
+     * @param max_missing Number of missing paths remembered
+     * @param revalidate_after Age at which an entry is checked against the file again
+     */
+    SourceFileSystem(llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> underlying,
+                     std::vector<std::string> cached_prefixes, size_t max_bytes, size_t max_missing,
+                     std::chrono::milliseconds revalidate_after);
+
+    /**
+     * @brief The process-wide instance over the real file system
+     *
+     * Caches /usr/include, /usr/local/include and /usr/lib (GCC and Clang
+     * builtin headers) and revalidates entries every two seconds.
+     *
+     * @return llvm::IntrusiveRefCntPtr<SourceFileSystem> Shared instance
+     */
+    static llvm::IntrusiveRefCntPtr<SourceFileSystem> shared();
+
+    /**
+     * @brief File system holding one in-memory source over the shared headers
+     *
+     * @param name Path the source is visible under; relative to the working directory
+     * @param code Source contents, copied
+     * @return llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> Overlay for one request
+     */
+    static llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> forSource(llvm::StringRef name, llvm::StringRef code);
+
+    llvm::ErrorOr<llvm::vfs::Status> status(const llvm::Twine& path) override;
+    llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>> openFileForRead(const llvm::Twine& path) override;
+
+    /**
+     * @brief Get cache counters for the metrics endpoint
+     *
+     * @return nlohmann::json Hits, misses, revalidations and bytes held
+     */
+    nlohmann::json getStatistics() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        llvm::vfs::Status status;
+        std::shared_ptr<const std::string> contents;    // null until read, or over the byte budget
+        Clock::time_point checked_at;
+    };
+
+    struct Missing {
+        Clock::time_point checked_at;
+        std::list<std::string>::iterator position;      // in missing_order_
+    };
+
+    bool cacheable(const std::string& path) const;
+
+    // The path's entry, revalidated when stale; sets missing for a known miss
+    std::optional<Entry> lookup(const std::string& path, bool& missing);
+    void remember(const std::string& path, const llvm::vfs::Status& status,
+                  std::shared_ptr<const std::string> contents);
+    void rememberMissing(const std::string& path);
+    void forget(std::unordered_map<std::string, Entry>::iterator entry);
+
+    std::vector<std::string> cached_prefixes_;
+    size_t max_bytes_;
+    size_t max_missing_;
+    std::chrono::milliseconds revalidate_after_;
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::unordered_map<std::string, Missing> missing_;
+    std::list<std::string> missing_order_;
+    size_t bytes_ = 0;
+
+    std::atomic<uint64_t> status_hits_{0};
+    std::atomic<uint64_t> status_misses_{0};
+    std::atomic<uint64_t> open_hits_{0};
+    std::atomic<uint64_t> open_misses_{0};
+    std::atomic<uint64_t> revalidations_{0};
+    std::atomic<uint64_t> invalidations_{0};
+};
+
+} // namespace cpp_mastery
@@ -0,0 +1,68 @@
+// File: cpp-engine/include/utils/cancellation_token.hpp
+// Extension: .hpp
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+
+namespace cpp_mastery {
+
+/**
+ * @brief Shared flag that asks running work to stop
+ *
+ * Whoever owns the work calls cancel(); the layers doing the work register
+ * callbacks that stop whatever they are waiting on, such as a process
+ * group or an admission queue slot. Passed around as a shared_ptr so it
+ * outlives whichever side finishes first.
+ */
+class CancellationToken {
+public:
+    using Callback = std::function<void()>;
+    using Registration = uint64_t;
+
+    CancellationToken() = default;
+    CancellationToken(const CancellationToken&) = delete;
+    CancellationToken& operator=(const CancellationToken&) = delete;
+
+    /**
+     * @brief Request cancellation and run the registered callbacks
+     *
+     * Callbacks run on the calling thread, outside the token's lock.
+     * Later calls do nothing.
+     */
+    void cancel();
+
+    /**
+     * @brief Whether cancel() has been called
+     */
+    bool cancelled() const { return cancelled_.load(); }
+
+    /**
+     * @brief Run a callback when the token is cancelled
+     *
+     * @param callback Must not block; runs at once if already cancelled
+     * @return Registration Handle for unregister(), or 0 if the callback already ran
+     */
+    Registration onCancel(Callback callback);
+
+    /**
+     * @brief Remove a callback that is no longer needed
+     *
+     * A callback already started by a concurrent cancel() may still be running.
+     *
+     * @param registration Handle from onCancel()
+     */
+    void unregister(Registration registration);
+
+private:
+    mutable std::mutex mutex_;
+    std::atomic<bool> cancelled_{false};
+    Registration next_registration_ = 1;
+    std::map<Registration, Callback> callbacks_;
+};
+
+} // namespace cpp_mastery
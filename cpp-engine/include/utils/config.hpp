@@ -4,9 +4,11 @@
 #pragma once
 
 #include <string>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <cstdint>
 
 // Forward declaration
 namespace nlohmann {
@@ -24,6 +26,15 @@ struct ServerConfig {
     size_t threads;
     int timeout_seconds;
     size_t max_request_size;
+    size_t max_concurrent_executions;          // compilations and runs admitted at once
+    size_t max_queued_requests;                // waiting beyond that before answering 429
+    int queue_timeout_seconds;                 // longest a request waits for admission
+    int interactive_weight;                    // interactive admissions per batch admission
+    std::map<std::string, int> client_weights; // "key:<api key>" or "ip:<address>" -> share
+    size_t max_background_compiles;            // prewarm compiles at once, only in idle slots; 0 disables prewarming
+    std::string workspace_root;                // scratch directories for compiles, analysis and parsing
+    size_t workspace_pool_size;                // clean scratch directories kept ready
+    int job_result_ttl_seconds;                // how long finished async jobs can still be fetched
 };
 
 /**
@@ -37,6 +48,11 @@ struct CompilerConfig {
     std::string optimization_level;
     int compilation_timeout;
     size_t max_binary_size;
+    bool enable_pch;
+    std::string linker;            // auto, default, or a -fuse-ld name such as mold or lld
+    std::string workspace_mode;    // memory (memfd, falling back to disk) or disk
+    int memory_workspace_budget_mb; // memfd bytes all sessions may hold before falling back to disk
+    std::string wasi_clang_path;   // wasi-sdk clang++ used for every compile under the wasm backend
 };
 
 /**
@@ -49,6 +65,15 @@ struct ExecutionConfig {
     int max_cpu_time;
     size_t max_output_size;
     std::string docker_image;
+    std::string sandbox_backend;   // native, docker, wasm or none
+    std::string sandbox_rootfs;    // directory whose system dirs are bound read-only
+    std::string cgroup_root;       // delegated cgroup v2 directory for per-run leaves
+    int sandbox_pool_min;          // warm native sandbox slots; 0 disables the pool
+    int sandbox_pool_max;          // upper bound the pool grows to under load
+    bool enable_jit;               // run small snippets through the ORC JIT in a sandbox slot
+    size_t jit_max_source_bytes;   // larger sources always take the compile-and-link path
+    int wasm_workers;              // threads running WebAssembly programs under the wasm backend
+    uint64_t wasm_fuel_per_second; // fuel granted per second of max_cpu_time
 };
 
 /**
@@ -61,6 +86,7 @@ struct AnalysisConfig {
     size_t max_file_size;
     bool enable_performance_analysis;
     bool enable_security_analysis;
+    int preamble_cache_mb;         // parsed #include blocks kept by the AST parser; 0 disables
 };
 
 /**
@@ -90,7 +116,7 @@ struct SecurityConfig {
  * @brief Cache configuration structure
  */
 struct CacheConfig {
-    bool enable_compilation_cache;
+    bool enable_compilation_cache;  // also what coalesces identical concurrent compiles
     bool enable_analysis_cache;
     std::string cache_directory;
     size_t max_cache_size_mb;
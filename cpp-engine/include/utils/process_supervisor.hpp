@@ -0,0 +1,300 @@
+// File: cpp-engine/include/utils/process_supervisor.hpp
+// Extension: .hpp
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <functional>
+#include <set>
+#include <unordered_map>
+#include <string_view>
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <nlohmann/json.hpp>
+
+#include "utils/cancellation_token.hpp"
+
+namespace cpp_mastery {
+
+/**
+ * @brief Result of running a child process
+ *
+ * Shared by the execution engine and the static analyzer. exit_code follows
+ * the shell convention: the exit status for a normal exit, 128 + signal
+ * number when the child was killed.
+ */
+struct ProcessResult {
+    int exit_code = -1;
+    std::string stdout;
+    std::string stderr;
+
+    // Resource usage of the child and everything it waited for (wait4 rusage,
+    // refined from the cgroup when the run had one)
+    long memory_usage_kb = 0;          // peak RSS
+    long cpu_time_ms = 0;              // user + system
+    long user_time_ms = 0;
+    long system_time_ms = 0;
+    long wall_time_ms = 0;             // exec to exit; fork to exit if the exec was not observed
+    long voluntary_context_switches = 0;
+    long involuntary_context_switches = 0;
+    long io_read_bytes = 0;            // block I/O, not pipes
+    long io_write_bytes = 0;
+
+    int term_signal = 0;
+    bool timed_out = false;
+    bool oom_killed = false;
+    bool output_truncated = false;
+    bool cancelled = false;            // stopped because its cancellation token fired
+};
+
+/**
+ * @brief Copy wait4() resource usage into a result
+ *
+ * @param usage Usage reported for the child
+ * @param result Result to fill
+ */
+void applyResourceUsage(const struct rusage& usage, ProcessResult& result);
+
+/**
+ * @brief Owning wrapper for a file descriptor
+ */
+class UniqueFd {
+public:
+    UniqueFd() = default;
+    explicit UniqueFd(int fd) : fd_(fd) {}
+    ~UniqueFd() { reset(); }
+
+    UniqueFd(const UniqueFd&) = delete;
+    UniqueFd& operator=(const UniqueFd&) = delete;
+    UniqueFd(UniqueFd&& other) noexcept : fd_(other.release()) {}
+    UniqueFd& operator=(UniqueFd&& other) noexcept {
+        if (this != &other) {
+            reset(other.release());
+        }
+        return *this;
+    }
+
+    int get() const { return fd_; }
+    bool valid() const { return fd_ >= 0; }
+    int release() { int fd = fd_; fd_ = -1; return fd; }
+    void reset(int fd = -1);
+
+private:
+    int fd_ = -1;
+};
+
+/**
+ * @brief Create a readable descriptor that yields the given bytes, then EOF
+ *
+ * Inputs that fit in a pipe buffer are written into a pipe up front. Larger
+ * inputs go into a sealed memfd, so the child reads them at memory speed and
+ * nobody has to feed a pipe while its output is being drained. Empty input
+ * yields /dev/null.
+ *
+ * @param data Bytes to deliver
+ * @return UniqueFd Close-on-exec descriptor positioned at the start, invalid on failure
+ */
+UniqueFd createInputFd(std::string_view data);
+
+/**
+ * @brief Receives output as it is read
+ *
+ * Called on the supervisor thread with STDOUT_FILENO or STDERR_FILENO and
+ * the bytes just read; must not block. An empty chunk marks the point where
+ * the stream hit max_output_bytes and the rest was discarded.
+ */
+using OutputCallback = std::function<void(int stream, std::string_view data)>;
+
+/**
+ * @brief What to run and how to supervise it
+ */
+struct ProcessOptions {
+    std::vector<std::string> args;
+
+    // Wall-clock deadline, counted from a successful exec; zero disables it
+    std::chrono::milliseconds timeout{0};
+
+    // Directory to run in; empty keeps the server's working directory
+    std::string working_directory;
+
+    // Bytes kept per stream. The process group is killed once a stream goes
+    // past it, and the rest is drained and discarded. Zero keeps everything.
+    size_t max_output_bytes = 0;
+
+    // When set, output goes here as it arrives instead of into the result
+    OutputCallback on_output;
+
+    // Delivered on the child's stdin; must stay valid until spawn() returns
+    std::string_view stdin_data;
+
+    // Descriptors passed to the child as 3, 4, ... (all others are closed on exec)
+    std::vector<int> inherit_fds;
+
+    // Runs in the child between fork() and exec(). Must only call
+    // async-signal-safe functions; returning false aborts with exit code 126.
+    std::function<bool()> pre_exec;
+
+    // Cancelling kills the process group at once; a token that is already
+    // cancelled keeps the child from starting at all
+    std::shared_ptr<CancellationToken> cancellation;
+};
+
+/**
+ * @brief A program started outside the supervisor whose output and completion it should track
+ *
+ * Used when the program is a child of a helper process (such as a sandbox
+ * slot) rather than of the server. Completion is signalled by one record
+ * arriving on status_fd, or by status_fd reaching EOF if the helper dies.
+ */
+struct AttachOptions {
+    UniqueFd stdout_fd;
+    UniqueFd stderr_fd;
+    UniqueFd status_fd;
+    std::chrono::milliseconds timeout{0};
+    size_t max_output_bytes = 0;
+    OutputCallback on_output;
+
+    // Parses the completion record into the result; runs on the supervisor thread
+    std::function<void(const std::string& record, ProcessResult& result)> on_status;
+
+    // Asked to stop the program when the deadline passes, the run is
+    // cancelled or its output goes past max_output_bytes; runs on the
+    // supervisor thread
+    std::function<void()> on_timeout;
+
+    std::shared_ptr<CancellationToken> cancellation;
+};
+
+/**
+ * @brief Event-driven supervisor for child processes
+ *
+ * A single thread multiplexes every running child with epoll: stdout and
+ * stderr are drained while the child runs, exits are observed through a
+ * pidfd, and all deadlines share one timerfd armed for the earliest of them.
+ * Each child leads its own process group so a timeout kills everything it
+ * spawned. Nothing here touches process-wide signal state, so any number of
+ * threads may run children concurrently.
+ *
+ * On kernels without pidfd_open (< 5.3) exits are detected by polling
+ * waitpid() every few milliseconds instead.
+ */
+class ProcessSupervisor {
+public:
+    /**
+     * @brief Get the singleton instance, starting the supervisor thread on first use
+     *
+     * @return ProcessSupervisor& Reference to the supervisor
+     */
+    static ProcessSupervisor& getInstance();
+
+    // Delete copy constructor and assignment operator
+    ProcessSupervisor(const ProcessSupervisor&) = delete;
+    ProcessSupervisor& operator=(const ProcessSupervisor&) = delete;
+
+    /**
+     * @brief Destructor; kills remaining children and stops the thread
+     */
+    ~ProcessSupervisor();
+
+    /**
+     * @brief Start a child and return immediately
+     *
+     * @param options Command and supervision options
+     * @param pid Receives the child's pid, which is also its process group id
+     * @return std::future<ProcessResult> Ready once the child has exited and its output is drained
+     */
+    std::future<ProcessResult> spawn(const ProcessOptions& options, pid_t* pid = nullptr);
+
+    /**
+     * @brief Track a program running under some other process
+     *
+     * @param options Output pipes, completion channel and deadline
+     * @return std::future<ProcessResult> Ready once the record arrived and output is drained
+     */
+    std::future<ProcessResult> attach(AttachOptions options);
+
+    /**
+     * @brief Start a child and wait for it
+     *
+     * @param options Command and supervision options
+     * @return ProcessResult Result of the child
+     */
+    ProcessResult run(const ProcessOptions& options);
+
+    /**
+     * @brief Get supervisor statistics for the metrics endpoint
+     *
+     * @return nlohmann::json Running and lifetime counters
+     */
+    nlohmann::json getStatistics() const;
+
+private:
+    struct Child;
+    using ChildId = uint64_t;
+
+    /**
+     * @brief Private constructor for singleton pattern
+     */
+    ProcessSupervisor();
+
+    void eventLoop();
+    void enqueue(std::unique_ptr<Child> child);
+    void adoptPending();
+    void watch(int fd, ChildId id, int kind);
+    void drain(Child& child, int kind);
+    void closeStream(Child& child, int kind);
+    void readStatus(Child& child);
+    void reap(Child& child);
+    void markExecuted(Child& child);
+    void markExited(Child& child);
+    void expireDeadlines();
+    void stop(Child& child);
+    void requestCancel(ChildId id, uint64_t serial);
+    void watchCancellation(Child& child, std::shared_ptr<CancellationToken> cancellation);
+    void armTimer();
+    void finishIfDone(ChildId id);
+
+    // Static members for singleton pattern
+    static std::unique_ptr<ProcessSupervisor> instance_;
+    static std::mutex mutex_;
+
+    UniqueFd epoll_fd_;
+    UniqueFd wakeup_fd_;
+    UniqueFd timer_fd_;
+    bool have_pidfd_ = true;
+
+    // Handed from spawn() and cancellation callbacks to the supervisor thread
+    std::mutex pending_mutex_;
+    std::vector<std::unique_ptr<Child>> pending_;
+    std::vector<std::pair<ChildId, uint64_t>> cancel_requests_;    // (id, serial)
+
+    // Owned by the supervisor thread
+    std::unordered_map<ChildId, std::unique_ptr<Child>> children_;
+    std::set<std::pair<std::chrono::steady_clock::time_point, ChildId>> deadlines_;
+    size_t polled_children_ = 0;
+
+    std::atomic<bool> running_{true};
+    std::thread thread_;
+
+    // Attached programs have no pid of ours; their ids start above any pid
+    std::atomic<ChildId> next_attached_id_{ChildId{1} << 32};
+
+    std::atomic<uint64_t> spawned_{0};
+    std::atomic<uint64_t> attached_{0};
+    std::atomic<uint64_t> spawn_failures_{0};
+    std::atomic<uint64_t> timeouts_{0};
+    std::atomic<uint64_t> cancellations_{0};
+
+    // Pids are reused, so cancellation requests also name the child's serial
+    std::atomic<uint64_t> next_serial_{1};
+    std::atomic<size_t> active_{0};
+};
+
+} // namespace cpp_mastery
@@ -0,0 +1,185 @@
+// File: cpp-engine/include/utils/workspace_manager.hpp
+// Extension: .hpp
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_set>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <nlohmann/json.hpp>
+
+namespace cpp_mastery {
+
+class WorkspaceManager;
+
+/**
+ * @brief Workspace manager settings
+ */
+struct WorkspacePolicy {
+    std::string root = "temp";      // parent of every process's workspaces
+    size_t pool_size = 8;           // clean directories kept ready
+};
+
+/**
+ * @brief A scratch directory leased from the WorkspaceManager
+ *
+ * Move-only. The directory goes back to the manager when the lease is
+ * destroyed or released, unless detach() handed it to the caller.
+ */
+class Workspace {
+public:
+    Workspace() = default;
+    ~Workspace() { release(); }
+
+    Workspace(Workspace&& other) noexcept
+        : manager_(other.manager_), path_(std::move(other.path_)) {
+        other.manager_ = nullptr;
+    }
+    Workspace& operator=(Workspace&& other) noexcept;
+
+    Workspace(const Workspace&) = delete;
+    Workspace& operator=(const Workspace&) = delete;
+
+    /**
+     * @brief Whether this lease holds a directory
+     */
+    bool valid() const { return manager_ != nullptr; }
+
+    /**
+     * @brief Directory path, relative to the working directory
+     */
+    const std::string& path() const { return path_; }
+
+    /**
+     * @brief Path of a file inside the workspace
+     *
+     * @param name File name
+     * @return std::string path()/name
+     */
+    std::string file(const std::string& name) const { return path_ + "/" + name; }
+
+    /**
+     * @brief Keep the directory leased after this object goes away
+     *
+     * The caller must later pass the path to WorkspaceManager::release().
+     *
+     * @return std::string Directory path
+     */
+    std::string detach();
+
+    /**
+     * @brief Return the directory to the manager now
+     */
+    void release();
+
+private:
+    friend class WorkspaceManager;
+    Workspace(WorkspaceManager* manager, std::string path)
+        : manager_(manager), path_(std::move(path)) {}
+
+    WorkspaceManager* manager_ = nullptr;
+    std::string path_;
+};
+
+/**
+ * @brief Hands out scratch directories and cleans them up off the request path
+ *
+ * Every directory lives under <root>/ws-<pid>. acquire() takes one from a
+ * pool of clean directories, creating one only when the pool is empty.
+ * Returned directories are queued for a background thread that empties
+ * them and puts them back in the pool, or deletes them once the pool is
+ * full, so request threads never wait on remove_all. At startup, ws-*
+ * directories of processes that no longer exist and anything else left
+ * under the root are handed to the same thread for deletion.
+ */
+class WorkspaceManager {
+public:
+    /**
+     * @brief Get the singleton instance configured from ServerConfig
+     *
+     * @return WorkspaceManager& Reference to the manager
+     */
+    static WorkspaceManager& getInstance();
+
+    /**
+     * @brief Construct a manager; getInstance() is the normal entry point
+     *
+     * Reaps orphaned directories and starts the cleanup thread.
+     *
+     * @param policy Root directory and pool size
+     */
+    explicit WorkspaceManager(WorkspacePolicy policy);
+
+    /**
+     * @brief Destructor; stops the cleanup thread and removes this process's directories
+     */
+    ~WorkspaceManager();
+
+    WorkspaceManager(const WorkspaceManager&) = delete;
+    WorkspaceManager& operator=(const WorkspaceManager&) = delete;
+
+    /**
+     * @brief Lease an empty directory
+     *
+     * @return Workspace Lease on the directory
+     * @throws std::runtime_error if no directory could be created
+     */
+    Workspace acquire();
+
+    /**
+     * @brief Return a directory detached from its lease
+     *
+     * Paths this manager did not hand out are ignored.
+     *
+     * @param path Directory path from Workspace::detach()
+     */
+    void release(const std::string& path);
+
+    /**
+     * @brief Queue directories left under the root by dead processes for deletion
+     *
+     * @return size_t Number of entries queued
+     */
+    size_t reapOrphans();
+
+    /**
+     * @brief Get pool statistics for the metrics endpoint
+     *
+     * @return nlohmann::json Pool sizes and lifetime counters
+     */
+    nlohmann::json getStatistics() const;
+
+private:
+    void cleanupLoop();
+    std::string createDirectory();
+
+    static std::unique_ptr<WorkspaceManager> instance_;
+    static std::mutex instance_mutex_;
+
+    WorkspacePolicy policy_;
+    std::string instance_dir_;      // <root>/ws-<pid>
+
+    mutable std::mutex mutex_;
+    std::condition_variable work_available_;
+    std::vector<std::string> idle_;             // clean and ready to lease
+    std::unordered_set<std::string> leased_;
+    std::deque<std::string> returned_;          // to be emptied and recycled
+    std::deque<std::string> doomed_;            // to be deleted outright
+    bool stopping_ = false;
+    std::thread thread_;
+
+    std::atomic<uint64_t> next_id_{0};
+    std::atomic<uint64_t> acquired_{0};
+    std::atomic<uint64_t> pool_misses_{0};
+    std::atomic<uint64_t> recycled_{0};
+    std::atomic<uint64_t> discarded_{0};
+    std::atomic<uint64_t> orphans_reaped_{0};
+};
+
+} // namespace cpp_mastery
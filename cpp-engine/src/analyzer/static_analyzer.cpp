@@ -4,6 +4,7 @@
 #include "analyzer/static_analyzer.hpp"
 #include "utils/logger.hpp"
 #include "utils/config.hpp"
+#include "utils/workspace_manager.hpp"
 
 #include <clang/StaticAnalyzer/Core/PathSensitive/AnalysisManager.h>
 #include <clang/StaticAnalyzer/Frontend/AnalysisConsumer.h>
@@ -14,12 +15,44 @@
 
 #include <fstream>
 #include <filesystem>
+#include <optional>
 #include <regex>
 #include <cstdlib>
+#include <cerrno>
 #include <sstream>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
 namespace cpp_mastery {
 
+namespace {
+
+// Sealed in-memory copy of the source for the external tools; unlike
+// createInputFd() it is never a pipe, since the tools stat and reread it
+UniqueFd createSourceFd(const std::string& code) {
+    UniqueFd file(memfd_create("source.cpp", MFD_CLOEXEC | MFD_ALLOW_SEALING));
+    if (!file.valid()) {
+        return UniqueFd();
+    }
+    size_t written = 0;
+    while (written < code.size()) {
+        ssize_t count = write(file.get(), code.data() + written, code.size() - written);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return UniqueFd();
+        }
+        written += static_cast<size_t>(count);
+    }
+    fcntl(file.get(), F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+    return file;
+}
+
+} // namespace
+
 // Initialize static members
 std::unique_ptr<StaticAnalyzer> StaticAnalyzer::instance_ = nullptr;
 std::mutex StaticAnalyzer::mutex_;
@@ -90,20 +123,24 @@ StaticAnalysisResult StaticAnalyzer::analyze(const std::string& code, const std:
     auto start_time = std::chrono::high_resolution_clock::now();
     
     try {
-        // Generate unique session ID
-        std::string session_id = generateSessionId();
-        std::string work_dir = "temp/" + session_id;
-        std::filesystem::create_directories(work_dir);
-        
-        // Write source code to file
-        std::string source_file = work_dir + "/source.cpp";
-        std::ofstream file(source_file);
-        if (!file.is_open()) {
-            result.error_message = "Failed to create source file";
-            return result;
+        // The tools read the code from a sealed memfd; a scratch file is
+        // only written when memfds are unavailable
+        std::string source_file;
+        UniqueFd source_fd = createSourceFd(code);
+        std::optional<Workspace> workspace;
+        if (source_fd.valid()) {
+            source_file = "/proc/" + std::to_string(getpid()) + "/fd/" + std::to_string(source_fd.get());
+        } else {
+            workspace.emplace(WorkspaceManager::getInstance().acquire());
+            source_file = workspace->file("source.cpp");
+            std::ofstream file(source_file);
+            if (!file.is_open()) {
+                result.error_message = "Failed to create source file";
+                return result;
+            }
+            file << code;
+            file.close();
         }
-        file << code;
-        file.close();
         
         // Run different analysis types
         if (analysis_type == "full" || analysis_type == "clang-tidy") {
@@ -126,15 +163,19 @@ StaticAnalysisResult StaticAnalyzer::analyze(const std::string& code, const std:
             runPerformanceAnalysis(code, result);
         }
         
+        // Report the submission under one stable name whichever path the tools saw
+        for (auto& issue : result.issues) {
+            if (issue.file == source_file) {
+                issue.file = "source.cpp";
+            }
+        }
+        
         auto end_time = std::chrono::high_resolution_clock::now();
         result.analysis_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
         
         result.success = true;
         result.analysis_type = analysis_type;
         
-        // Clean up temporary files
-        cleanupSession(work_dir);
-        
         logger.info("Static analysis completed: " + analysis_type, "StaticAnalyzer");
         return result;
         
@@ -161,6 +202,7 @@ void StaticAnalyzer::runClangTidyAnalysis(const std::string& source_file, Static
             "-checks=*,-fuchsia-*,-llvm-header-guard,-google-readability-todo",
             "--format-style=llvm",
             "--",
+            "-xc++",
             "-std=c++20"
         };
         
@@ -192,6 +234,7 @@ void StaticAnalyzer::runCppcheckAnalysis(const std::string& source_file, StaticA
         std::vector<std::string> args = {
             config.getAnalysisConfig().cppcheck_path,
             "--enable=all",
+            "--language=c++",
             "--std=c++20",
             "--platform=unix64",
             "--output-format=gcc",
@@ -593,35 +636,17 @@ ProcessResult StaticAnalyzer::executeProcess(const std::vector<std::string>& arg
         return result;
     }
     
-    // This is a simplified implementation
-    // In a full implementation, you would use proper process execution
-    // with timeout handling, similar to the execution engine
+    ProcessOptions process_options;
+    process_options.args = args;
+    process_options.timeout = std::chrono::seconds(timeout_seconds);
     
-    result.exit_code = 0; // Simulate successful execution
-    return result;
-}
-
-std::string StaticAnalyzer::generateSessionId() {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<> dis(0, 15);
+    result = ProcessSupervisor::getInstance().run(process_options);
     
-    std::string session_id;
-    for (int i = 0; i < 8; ++i) {
-        session_id += "0123456789abcdef"[dis(gen)];
+    if (result.timed_out) {
+        Logger::getInstance().warning(args[0] + " timed out after " + std::to_string(timeout_seconds) + "s", "StaticAnalyzer");
     }
     
-    return session_id;
-}
-
-void StaticAnalyzer::cleanupSession(const std::string& session_dir) {
-    try {
-        if (std::filesystem::exists(session_dir)) {
-            std::filesystem::remove_all(session_dir);
-        }
-    } catch (const std::exception& e) {
-        Logger::getInstance().warning("Failed to cleanup analysis session: " + std::string(e.what()), "StaticAnalyzer");
-    }
+    return result;
 }
 
 int StaticAnalyzer::countLines(const std::string& text, size_t position) {
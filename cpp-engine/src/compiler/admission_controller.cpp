@@ -0,0 +1,352 @@
+// File: cpp-engine/src/compiler/admission_controller.cpp
+// Extension: .cpp
+
+#include "compiler/admission_controller.hpp"
+#include "utils/config.hpp"
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace cpp_mastery {
+
+std::unique_ptr<AdmissionController> AdmissionController::instance_ = nullptr;
+std::mutex AdmissionController::instance_mutex_;
+
+namespace {
+
+constexpr size_t kInteractive = static_cast<size_t>(AdmissionLane::INTERACTIVE);
+constexpr size_t kBatch = static_cast<size_t>(AdmissionLane::BATCH);
+constexpr size_t kBackground = static_cast<size_t>(AdmissionLane::BACKGROUND);
+
+// Weight of the newest sample in the service-time moving average
+constexpr double kServiceTimeAlpha = 0.1;
+
+// Retry-After bounds in seconds
+constexpr long kMinRetryAfter = 1;
+constexpr long kMaxRetryAfter = 60;
+
+const char* laneName(size_t lane) {
+    return lane == kBackground ? "background" : lane == kBatch ? "batch" : "interactive";
+}
+
+template <size_t N>
+nlohmann::json histogramToJson(const std::array<long, N>& bounds, const std::array<uint64_t, N + 1>& counts) {
+    nlohmann::json buckets = nlohmann::json::array();
+    for (size_t i = 0; i < N; ++i) {
+        buckets.push_back({{"le", bounds[i]}, {"count", counts[i]}});
+    }
+    buckets.push_back({{"le", "+Inf"}, {"count", counts[N]}});
+    return buckets;
+}
+
+template <size_t N>
+size_t bucketFor(const std::array<long, N>& bounds, long value) {
+    return std::lower_bound(bounds.begin(), bounds.end(), value) - bounds.begin();
+}
+
+} // namespace
+
+AdmissionLane admissionLaneFromString(const std::string& name) {
+    if (name == "batch") {
+        return AdmissionLane::BATCH;
+    }
+    return name == "background" ? AdmissionLane::BACKGROUND : AdmissionLane::INTERACTIVE;
+}
+
+AdmissionTicket& AdmissionTicket::operator=(AdmissionTicket&& other) noexcept {
+    if (this != &other) {
+        release();
+        controller_ = other.controller_;
+        lane_ = other.lane_;
+        granted_at_ = other.granted_at_;
+        id_ = other.id_;
+        other.controller_ = nullptr;
+    }
+    return *this;
+}
+
+void AdmissionTicket::release() {
+    if (controller_) {
+        controller_->release(lane_, granted_at_, id_);
+        controller_ = nullptr;
+    }
+}
+
+AdmissionController& AdmissionController::getInstance() {
+    std::lock_guard<std::mutex> lock(instance_mutex_);
+    if (!instance_) {
+        const auto& config = Config::getInstance().getServerConfig();
+
+        AdmissionPolicy policy;
+        policy.max_concurrent = std::max<size_t>(1, config.max_concurrent_executions);
+        policy.max_queued = config.max_queued_requests;
+        policy.queue_timeout = std::chrono::seconds(config.queue_timeout_seconds);
+        policy.interactive_weight = std::max(1, config.interactive_weight);
+        policy.client_weights = config.client_weights;
+        policy.max_background = config.max_background_compiles;
+
+        instance_ = std::make_unique<AdmissionController>(std::move(policy));
+    }
+    return *instance_;
+}
+
+AdmissionController::AdmissionController(AdmissionPolicy policy)
+    : policy_(std::move(policy)) {
+    Logger::getInstance().info("Admission control: " + std::to_string(policy_.max_concurrent) +
+                               " concurrent, " + std::to_string(policy_.max_queued) + " queued, " +
+                               std::to_string(policy_.max_background) + " background", "Admission");
+}
+
+Admission AdmissionController::admit(const std::string& client_id, AdmissionLane lane_id,
+                                     std::shared_ptr<CancellationToken> cancellation) {
+    size_t index = static_cast<size_t>(lane_id);
+    auto now = std::chrono::steady_clock::now();
+
+    if (cancellation && cancellation->cancelled()) {
+        return Admission{AdmissionTicket(), std::chrono::seconds(0), "Cancelled"};
+    }
+
+    // Registered before taking the lock: the callback takes it too, and
+    // runs right away if the token fires in between
+    auto waiter = std::make_shared<Waiter>();
+    waiter->client_id = client_id;
+    if (index == kBackground) {
+        waiter->cancellation = cancellation;
+    }
+    CancellationToken::Registration registration = 0;
+    if (cancellation) {
+        registration = cancellation->onCancel([this, waiter]() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            waiter->cancelled = true;
+            waiter->granted_cv.notify_one();
+        });
+    }
+    struct Unregister {
+        CancellationToken* token;
+        CancellationToken::Registration registration;
+        ~Unregister() {
+            if (token) {
+                token->unregister(registration);
+            }
+        }
+    } unregister{cancellation.get(), registration};
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    size_t queued = lanes_[kInteractive].queued + lanes_[kBatch].queued + lanes_[kBackground].queued;
+    depth_histogram_[bucketFor(kDepthBuckets, static_cast<long>(queued))]++;
+
+    // A free slot means nobody is waiting; dispatch() fills slots as they open
+    if (running_ < policy_.max_concurrent && (index != kBackground || backgroundAllowed())) {
+        uint64_t id = grant(index, waiter->cancellation);
+        admitted_[index]++;
+        recordWait(lane_id, std::chrono::steady_clock::duration::zero());
+        return Admission{AdmissionTicket(this, lane_id, id), std::chrono::seconds(0), ""};
+    }
+
+    if (queued >= policy_.max_queued) {
+        rejected_full_[index]++;
+        return Admission{AdmissionTicket(), retryAfter(), "Execution queue is full"};
+    }
+
+    Lane& lane = lanes_[index];
+    ClientQueue& client = lane.clients[client_id];
+    if (client.waiters.empty()) {
+        client.credits = clientWeight(client_id);
+        lane.rotation.push_back(client_id);
+    }
+    client.waiters.push_back(waiter);
+    lane.queued++;
+    max_queued_seen_ = std::max(max_queued_seen_, queued + 1);
+
+    // Make room by stopping speculative work; its ticket comes back through release()
+    if (index != kBackground) {
+        if (auto victim = pickPreemptionLocked()) {
+            lock.unlock();
+            victim->cancel();
+            lock.lock();
+        }
+    }
+
+    waiter->granted_cv.wait_until(lock, now + policy_.queue_timeout,
+                                  [&waiter] { return waiter->granted || waiter->cancelled; });
+    if (!waiter->granted && waiter->cancelled) {
+        removeWaiter(lane, waiter);
+        cancelled_[index]++;
+        return Admission{AdmissionTicket(), std::chrono::seconds(0), "Cancelled"};
+    }
+    if (!waiter->granted) {
+        removeWaiter(lane, waiter);
+        rejected_timeout_[index]++;
+        return Admission{AdmissionTicket(), retryAfter(), "Timed out waiting in the execution queue"};
+    }
+
+    // dispatch() already counted us as running
+    admitted_[index]++;
+    recordWait(lane_id, std::chrono::steady_clock::now() - now);
+    return Admission{AdmissionTicket(this, lane_id, waiter->ticket_id), std::chrono::seconds(0), ""};
+}
+
+void AdmissionController::release(AdmissionLane lane, std::chrono::steady_clock::time_point granted_at, uint64_t id) {
+    double held_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - granted_at).count();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_--;
+    running_by_lane_[static_cast<size_t>(lane)]--;
+    preemptible_.erase(id);
+    // Background work is cut short by design and would skew Retry-After
+    if (lane != AdmissionLane::BACKGROUND) {
+        service_time_ms_ = service_time_ms_ == 0.0
+            ? held_ms
+            : service_time_ms_ + kServiceTimeAlpha * (held_ms - service_time_ms_);
+    }
+    dispatch();
+}
+
+void AdmissionController::dispatch() {
+    while (running_ < policy_.max_concurrent) {
+        bool interactive_waiting = lanes_[kInteractive].queued > 0;
+        bool batch_waiting = lanes_[kBatch].queued > 0;
+        if (!interactive_waiting && !batch_waiting) {
+            if (lanes_[kBackground].queued == 0 || !backgroundAllowed()) {
+                return;
+            }
+            std::shared_ptr<Waiter> waiter = popNext(lanes_[kBackground]);
+            waiter->ticket_id = grant(kBackground, waiter->cancellation);
+            waiter->granted = true;
+            waiter->granted_cv.notify_one();
+            continue;
+        }
+
+        // Interactive first, but batch gets every (weight + 1)th slot while both wait
+        size_t index;
+        if (interactive_waiting && (!batch_waiting || interactive_streak_ < policy_.interactive_weight)) {
+            index = kInteractive;
+            interactive_streak_++;
+        } else {
+            index = kBatch;
+            interactive_streak_ = 0;
+        }
+
+        std::shared_ptr<Waiter> waiter = popNext(lanes_[index]);
+        waiter->ticket_id = grant(index, nullptr);
+        waiter->granted = true;
+        waiter->granted_cv.notify_one();
+    }
+}
+
+bool AdmissionController::backgroundAllowed() const {
+    return lanes_[kInteractive].queued == 0 && lanes_[kBatch].queued == 0 &&
+           running_by_lane_[kBackground] < policy_.max_background;
+}
+
+uint64_t AdmissionController::grant(size_t lane, const std::shared_ptr<CancellationToken>& cancellation) {
+    uint64_t id = next_ticket_id_++;
+    running_++;
+    running_by_lane_[lane]++;
+    if (lane == kBackground && cancellation) {
+        preemptible_.emplace(id, cancellation);
+    }
+    return id;
+}
+
+std::shared_ptr<CancellationToken> AdmissionController::pickPreemptionLocked() {
+    if (preemptible_.empty()) {
+        return nullptr;
+    }
+    // The newest has made the least progress
+    auto newest = std::prev(preemptible_.end());
+    std::shared_ptr<CancellationToken> victim = std::move(newest->second);
+    preemptible_.erase(newest);
+    preempted_++;
+    return victim;
+}
+
+std::shared_ptr<AdmissionController::Waiter> AdmissionController::popNext(Lane& lane) {
+    const std::string client_id = lane.rotation.front();
+    ClientQueue& client = lane.clients[client_id];
+
+    std::shared_ptr<Waiter> waiter = client.waiters.front();
+    client.waiters.pop_front();
+    lane.queued--;
+
+    if (client.waiters.empty()) {
+        lane.rotation.pop_front();
+        lane.clients.erase(client_id);
+    } else if (--client.credits <= 0) {
+        // Turn used up; go to the back of the rotation with a fresh allowance
+        client.credits = clientWeight(client_id);
+        lane.rotation.pop_front();
+        lane.rotation.push_back(client_id);
+    }
+
+    return waiter;
+}
+
+void AdmissionController::removeWaiter(Lane& lane, const std::shared_ptr<Waiter>& waiter) {
+    auto it = lane.clients.find(waiter->client_id);
+    if (it == lane.clients.end()) {
+        return;
+    }
+
+    auto& waiters = it->second.waiters;
+    waiters.erase(std::remove(waiters.begin(), waiters.end(), waiter), waiters.end());
+    lane.queued--;
+
+    if (waiters.empty()) {
+        lane.rotation.erase(std::remove(lane.rotation.begin(), lane.rotation.end(), waiter->client_id),
+                            lane.rotation.end());
+        lane.clients.erase(it);
+    }
+}
+
+int AdmissionController::clientWeight(const std::string& client_id) const {
+    auto it = policy_.client_weights.find(client_id);
+    return it != policy_.client_weights.end() ? std::max(1, it->second) : 1;
+}
+
+std::chrono::seconds AdmissionController::retryAfter() const {
+    // Time for everyone ahead of us to be served at the observed rate
+    size_t queued = lanes_[kInteractive].queued + lanes_[kBatch].queued + lanes_[kBackground].queued;
+    double service_ms = service_time_ms_ > 0.0 ? service_time_ms_ : 1000.0;
+    double seconds = std::ceil((queued + 1) * service_ms / policy_.max_concurrent / 1000.0);
+    return std::chrono::seconds(std::clamp(static_cast<long>(seconds), kMinRetryAfter, kMaxRetryAfter));
+}
+
+void AdmissionController::recordWait(AdmissionLane lane, std::chrono::steady_clock::duration wait) {
+    long wait_ms = std::chrono::duration_cast<std::chrono::milliseconds>(wait).count();
+    wait_histogram_[static_cast<size_t>(lane)][bucketFor(kWaitBucketsMs, wait_ms)]++;
+}
+
+nlohmann::json AdmissionController::getStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    nlohmann::json lanes = nlohmann::json::object();
+    for (size_t i : {kInteractive, kBatch, kBackground}) {
+        lanes[laneName(i)] = {
+            {"running", running_by_lane_[i]},
+            {"queued", lanes_[i].queued},
+            {"clients_waiting", lanes_[i].rotation.size()},
+            {"admitted", admitted_[i]},
+            {"rejected_queue_full", rejected_full_[i]},
+            {"rejected_timeout", rejected_timeout_[i]},
+            {"cancelled", cancelled_[i]},
+            {"wait_ms_histogram", histogramToJson(kWaitBucketsMs, wait_histogram_[i])}
+        };
+    }
+
+    return nlohmann::json{
+        {"max_concurrent", policy_.max_concurrent},
+        {"max_queued", policy_.max_queued},
+        {"max_background", policy_.max_background},
+        {"preempted", preempted_},
+        {"running", running_},
+        {"max_queued_seen", max_queued_seen_},
+        {"service_time_ms", service_time_ms_},
+        {"queue_depth_histogram", histogramToJson(kDepthBuckets, depth_histogram_)},
+        {"lanes", lanes}
+    };
+}
+
+} // namespace cpp_mastery
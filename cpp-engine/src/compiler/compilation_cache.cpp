@@ -0,0 +1,407 @@
+// File: cpp-engine/src/compiler/compilation_cache.cpp
+// Extension: .cpp
+
+#include "compiler/compilation_cache.hpp"
+#include "utils/logger.hpp"
+
+#include <array>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <random>
+#include <algorithm>
+
+namespace cpp_mastery {
+
+namespace {
+
+constexpr std::array<uint32_t, 64> kSha256RoundConstants = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+inline uint32_t rotateRight(uint32_t value, int bits) {
+    return (value >> bits) | (value << (32 - bits));
+}
+
+// Length-prefix each field so that ("ab", "c") and ("a", "bc") hash differently
+void appendField(std::string& material, const std::string& field) {
+    material += std::to_string(field.size());
+    material += ':';
+    material += field;
+    material += ';';
+}
+
+long long toEpochSeconds(std::chrono::system_clock::time_point tp) {
+    return std::chrono::duration_cast<std::chrono::seconds>(tp.time_since_epoch()).count();
+}
+
+} // namespace
+
+CompilationCache::CompilationCache(const CacheConfig& config)
+    : root_(std::filesystem::path(config.cache_directory) / "compilation"),
+      max_size_bytes_(static_cast<uintmax_t>(config.max_cache_size_mb) * 1024 * 1024),
+      ttl_(config.cache_ttl_hours) {
+}
+
+bool CompilationCache::initialize() {
+    auto& logger = Logger::getInstance();
+
+    try {
+        std::filesystem::create_directories(root_);
+        loadIndex();
+        evictIfNeeded();
+
+        logger.info("Compilation cache ready: " + std::to_string(index_.size()) + " entries, " +
+                    std::to_string(total_size_bytes_ / (1024 * 1024)) + "MB", "CompilationCache");
+        return true;
+
+    } catch (const std::exception& e) {
+        logger.error("Failed to initialize compilation cache: " + std::string(e.what()), "CompilationCache");
+        return false;
+    }
+}
+
+std::string CompilationCache::computeKey(const CompilationKey& key) {
+    std::string material;
+    material.reserve(key.code.size() + 256);
+
+    appendField(material, "v1");
+    appendField(material, key.compiler_path);
+    appendField(material, key.compiler_version);
+    appendField(material, key.standard);
+    appendField(material, key.optimization);
+    appendField(material, key.debug_info ? "g" : "");
+    for (const auto& flag : key.extra_flags) {
+        appendField(material, flag);
+    }
+    appendField(material, key.pch);
+    if (!key.harness.empty()) {
+        appendField(material, "harness:" + key.harness);
+    }
+    appendField(material, key.code);
+
+    return sha256Hex(material);
+}
+
+std::string CompilationCache::sha256Hex(const std::string& data) {
+    std::array<uint32_t, 8> state = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+
+    // Pad: 0x80, zeros up to 56 mod 64, then the 64-bit big-endian bit length
+    std::string message = data;
+    uint64_t bit_length = static_cast<uint64_t>(data.size()) * 8;
+    message.push_back(static_cast<char>(0x80));
+    while (message.size() % 64 != 56) {
+        message.push_back('\0');
+    }
+    for (int i = 7; i >= 0; --i) {
+        message.push_back(static_cast<char>((bit_length >> (i * 8)) & 0xff));
+    }
+
+    std::array<uint32_t, 64> w{};
+    for (size_t chunk = 0; chunk < message.size(); chunk += 64) {
+        for (size_t i = 0; i < 16; ++i) {
+            const auto* p = reinterpret_cast<const unsigned char*>(message.data() + chunk + i * 4);
+            w[i] = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+        }
+        for (size_t i = 16; i < 64; ++i) {
+            uint32_t s0 = rotateRight(w[i - 15], 7) ^ rotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotateRight(w[i - 2], 17) ^ rotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+        for (size_t i = 0; i < 64; ++i) {
+            uint32_t s1 = rotateRight(e, 6) ^ rotateRight(e, 11) ^ rotateRight(e, 25);
+            uint32_t choice = (e & f) ^ (~e & g);
+            uint32_t temp1 = h + s1 + choice + kSha256RoundConstants[i] + w[i];
+            uint32_t s0 = rotateRight(a, 2) ^ rotateRight(a, 13) ^ rotateRight(a, 22);
+            uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+            uint32_t temp2 = s0 + majority;
+
+            h = g; g = f; f = e; e = d + temp1;
+            d = c; c = b; b = a; a = temp1 + temp2;
+        }
+
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+
+    std::ostringstream hex;
+    hex << std::hex << std::setfill('0');
+    for (uint32_t word : state) {
+        hex << std::setw(8) << word;
+    }
+    return hex.str();
+}
+
+std::optional<CompilationResult> CompilationCache::lookup(const std::string& digest, const std::string& output_file) {
+    auto now = std::chrono::system_clock::now();
+    std::filesystem::path expired;
+
+    {
+        std::lock_guard<std::mutex> lock(index_mutex_);
+        auto it = index_.find(digest);
+        if (it == index_.end()) {
+            misses_++;
+            return std::nullopt;
+        }
+        if (!isExpired(it->second, now)) {
+            it->second.last_access = now;
+        } else {
+            expired = detachEntry(digest);
+        }
+    }
+    if (!expired.empty()) {
+        deleteEntryDirectory(expired);
+        misses_++;
+        return std::nullopt;
+    }
+
+    try {
+        std::filesystem::path entry_dir = entryDirectory(digest);
+
+        std::ifstream file(entry_dir / "result.json");
+        if (!file.is_open()) {
+            misses_++;
+            return std::nullopt;
+        }
+        nlohmann::json stored;
+        file >> stored;
+
+        CompilationResult result;
+        result.success = stored.value("success", false);
+        result.warnings = stored.value("warnings", std::vector<std::string>{});
+        result.errors = stored.value("errors", std::vector<std::string>{});
+        result.compiler_output = stored.value("compiler_output", "");
+        result.cache_hit = true;
+
+        if (result.success) {
+            // Hard link is O(1) and lets the session delete its copy independently
+            std::error_code ec;
+            std::filesystem::create_hard_link(entry_dir / "program", output_file, ec);
+            if (ec) {
+                std::filesystem::copy_file(entry_dir / "program", output_file,
+                                           std::filesystem::copy_options::overwrite_existing, ec);
+            }
+            if (ec) {
+                // Evicted between the index check and the link; treat as a miss
+                misses_++;
+                return std::nullopt;
+            }
+            result.executable_path = output_file;
+        }
+
+        hits_++;
+        return result;
+
+    } catch (const std::exception& e) {
+        Logger::getInstance().warning("Corrupt cache entry " + digest + ": " + e.what(), "CompilationCache");
+        std::filesystem::path corrupt;
+        {
+            std::lock_guard<std::mutex> lock(index_mutex_);
+            corrupt = detachEntry(digest);
+        }
+        deleteEntryDirectory(corrupt);
+        misses_++;
+        return std::nullopt;
+    }
+}
+
+void CompilationCache::store(const std::string& digest, const CompilationResult& result) {
+    auto& logger = Logger::getInstance();
+
+    std::filesystem::path entry_dir = entryDirectory(digest);
+    std::filesystem::path staging_dir = entry_dir;
+    staging_dir += ".tmp-" + std::to_string(std::random_device{}());
+
+    try {
+        std::filesystem::create_directories(staging_dir);
+
+        auto now = std::chrono::system_clock::now();
+        nlohmann::json stored = {
+            {"success", result.success},
+            {"warnings", result.warnings},
+            {"errors", result.errors},
+            {"compiler_output", result.compiler_output},
+            {"created_at", toEpochSeconds(now)}
+        };
+
+        {
+            std::ofstream file(staging_dir / "result.json");
+            if (!file.is_open()) {
+                throw std::runtime_error("cannot write result.json");
+            }
+            file << stored.dump();
+        }
+
+        if (result.success) {
+            std::filesystem::copy_file(result.executable_path, staging_dir / "program");
+        }
+
+        uintmax_t size_bytes = 0;
+        for (const auto& file : std::filesystem::directory_iterator(staging_dir)) {
+            size_bytes += file.file_size();
+        }
+
+        // Publish atomically; a concurrent store of the same digest wins the race harmlessly
+        std::error_code ec;
+        std::filesystem::rename(staging_dir, entry_dir, ec);
+        if (ec) {
+            std::filesystem::remove_all(staging_dir, ec);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(index_mutex_);
+            index_[digest] = Entry{size_bytes, now, now};
+            total_size_bytes_ += size_bytes;
+        }
+        stores_++;
+
+        evictIfNeeded();
+
+    } catch (const std::exception& e) {
+        std::error_code ec;
+        std::filesystem::remove_all(staging_dir, ec);
+        logger.warning("Failed to store compilation in cache: " + std::string(e.what()), "CompilationCache");
+    }
+}
+
+nlohmann::json CompilationCache::getStatistics() const {
+    std::lock_guard<std::mutex> lock(index_mutex_);
+
+    uint64_t hits = hits_.load();
+    uint64_t misses = misses_.load();
+    double hit_ratio = (hits + misses) > 0 ? static_cast<double>(hits) / static_cast<double>(hits + misses) : 0.0;
+
+    return nlohmann::json{
+        {"enabled", true},
+        {"hits", hits},
+        {"misses", misses},
+        {"hit_ratio", hit_ratio},
+        {"stores", stores_.load()},
+        {"evictions", evictions_.load()},
+        {"entries", index_.size()},
+        {"size_bytes", total_size_bytes_},
+        {"max_size_bytes", max_size_bytes_}
+    };
+}
+
+std::filesystem::path CompilationCache::entryDirectory(const std::string& digest) const {
+    return root_ / digest.substr(0, 2) / digest;
+}
+
+bool CompilationCache::isExpired(const Entry& entry, std::chrono::system_clock::time_point now) const {
+    return ttl_.count() > 0 && now - entry.created > ttl_;
+}
+
+void CompilationCache::loadIndex() {
+    std::lock_guard<std::mutex> lock(index_mutex_);
+    index_.clear();
+    total_size_bytes_ = 0;
+
+    for (const auto& shard : std::filesystem::directory_iterator(root_)) {
+        if (!shard.is_directory()) {
+            continue;
+        }
+        for (const auto& entry_dir : std::filesystem::directory_iterator(shard.path())) {
+            std::string name = entry_dir.path().filename().string();
+
+            // Leftovers from interrupted stores
+            if (name.find(".tmp-") != std::string::npos) {
+                std::error_code ec;
+                std::filesystem::remove_all(entry_dir.path(), ec);
+                continue;
+            }
+
+            std::error_code ec;
+            auto result_file = entry_dir.path() / "result.json";
+            auto mtime = std::filesystem::last_write_time(result_file, ec);
+            if (ec) {
+                std::filesystem::remove_all(entry_dir.path(), ec);
+                continue;
+            }
+
+            Entry entry;
+            for (const auto& file : std::filesystem::directory_iterator(entry_dir.path())) {
+                entry.size_bytes += file.file_size();
+            }
+            entry.created = std::chrono::file_clock::to_sys(mtime);
+            entry.last_access = entry.created;
+
+            index_[name] = entry;
+            total_size_bytes_ += entry.size_bytes;
+        }
+    }
+}
+
+void CompilationCache::evictIfNeeded() {
+    auto now = std::chrono::system_clock::now();
+    std::vector<std::filesystem::path> victims;
+
+    {
+        std::lock_guard<std::mutex> lock(index_mutex_);
+
+        std::vector<std::pair<std::chrono::system_clock::time_point, std::string>> by_access;
+        for (const auto& [digest, entry] : index_) {
+            if (isExpired(entry, now)) {
+                victims.push_back(entryDirectory(digest));
+            } else {
+                by_access.emplace_back(entry.last_access, digest);
+            }
+        }
+        for (const auto& dir : victims) {
+            std::string digest = dir.filename().string();
+            total_size_bytes_ -= index_[digest].size_bytes;
+            index_.erase(digest);
+        }
+
+        // Evict least recently used down to 90% so a full cache does not evict on every store
+        if (total_size_bytes_ > max_size_bytes_) {
+            uintmax_t target = max_size_bytes_ / 10 * 9;
+            std::sort(by_access.begin(), by_access.end());
+            for (const auto& [last_access, digest] : by_access) {
+                if (total_size_bytes_ <= target) {
+                    break;
+                }
+                victims.push_back(entryDirectory(digest));
+                total_size_bytes_ -= index_[digest].size_bytes;
+                index_.erase(digest);
+            }
+        }
+    }
+
+    // Filesystem work happens outside the index lock
+    for (const auto& dir : victims) {
+        deleteEntryDirectory(dir);
+    }
+}
+
+std::filesystem::path CompilationCache::detachEntry(const std::string& digest) {
+    auto it = index_.find(digest);
+    if (it != index_.end()) {
+        total_size_bytes_ -= it->second.size_bytes;
+        index_.erase(it);
+    }
+    return entryDirectory(digest);
+}
+
+void CompilationCache::deleteEntryDirectory(const std::filesystem::path& entry_dir) {
+    std::error_code ec;
+    std::filesystem::remove_all(entry_dir, ec);
+    evictions_++;
+}
+
+} // namespace cpp_mastery
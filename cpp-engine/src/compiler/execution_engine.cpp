@@ -2,22 +2,262 @@
 // Extension: .cpp
 
 #include "compiler/execution_engine.hpp"
+#include "compiler/admission_controller.hpp"
+#include "compiler/compilation_cache.hpp"
+#include "compiler/pch_pool.hpp"
+#include "compiler/harness_registry.hpp"
+#include "compiler/inprocess_compiler.hpp"
+#include "compiler/sandbox.hpp"
+#include "compiler/sandbox_pool.hpp"
+#include "compiler/wasm_runtime.hpp"
 #include "utils/logger.hpp"
 #include "utils/config.hpp"
+#include "utils/workspace_manager.hpp"
 #include <filesystem>
 #include <fstream>
 #include <sstream>
 #include <chrono>
 #include <random>
 #include <regex>
-#include <cstdlib>
-#include <sys/wait.h>
-#include <sys/resource.h>
+#include <csignal>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
-#include <signal.h>
 
 namespace cpp_mastery {
 
+std::string executionStatusToString(ExecutionStatus status) {
+    switch (status) {
+        case ExecutionStatus::OK: return "ok";
+        case ExecutionStatus::COMPILATION_ERROR: return "compilation_error";
+        case ExecutionStatus::RUNTIME_ERROR: return "runtime_error";
+        case ExecutionStatus::TIME_LIMIT_EXCEEDED: return "time_limit_exceeded";
+        case ExecutionStatus::CPU_LIMIT_EXCEEDED: return "cpu_limit_exceeded";
+        case ExecutionStatus::MEMORY_LIMIT_EXCEEDED: return "memory_limit_exceeded";
+        case ExecutionStatus::OUTPUT_LIMIT_EXCEEDED: return "output_limit_exceeded";
+        case ExecutionStatus::CANCELLED: return "cancelled";
+        case ExecutionStatus::INTERNAL_ERROR: return "internal_error";
+    }
+    return "internal_error";
+}
+
+namespace {
+
+// How long a coalesced request waits beyond the compile timeout before
+// giving up on the leader
+constexpr std::chrono::seconds kFlightWaitGrace{5};
+
+// How often a coalesced waiter checks whether it was cancelled
+constexpr std::chrono::milliseconds kFlightWaitSlice{50};
+
+// Compiler names that take clang_path and Clang's flag spellings
+bool isClang(const std::string& compiler) {
+    return compiler == "clang++" || compiler == InProcessCompiler::kName;
+}
+
+// Errors reported by a syntax check unless the request asks otherwise
+constexpr int kDefaultMaxErrors = 10;
+
+// Budget held by a memory workspace until its executable's size is known
+constexpr size_t kMemoryWorkspaceReserve = 8 * 1024 * 1024;
+
+// Path through which other processes can open one of our descriptors;
+// /proc/self would name the opener's own table
+std::string fdPath(int fd) {
+    static const std::string prefix = "/proc/" + std::to_string(getpid()) + "/fd/";
+    return prefix + std::to_string(fd);
+}
+
+// Fast linkers tried in order when CompilerConfig::linker is "auto"
+const std::vector<std::string> kFastLinkers = {"mold", "lld"};
+
+// Whether `compiler_path -fuse-ld=<linker>` can write an executable into a
+// memfd reached through fdPath(), as memory workspaces have it do, and the
+// result runs
+bool linksIntoMemory(const std::string& compiler_path, const std::string& linker) {
+    UniqueFd executable(memfd_create("linker-probe", MFD_CLOEXEC));
+    if (!executable.valid()) {
+        return false;
+    }
+
+    ProcessOptions link;
+    link.args = {compiler_path, "-fuse-ld=" + linker, "-x", "c++", "-", "-o", fdPath(executable.get())};
+    link.timeout = std::chrono::seconds(30);
+    link.stdin_data = "int main() { return 0; }\n";
+    if (ProcessSupervisor::getInstance().run(link).exit_code != 0) {
+        return false;
+    }
+
+    // exec refuses a file that is open for writing
+    UniqueFd readonly(open(fdPath(executable.get()).c_str(), O_RDONLY | O_CLOEXEC));
+    if (!readonly.valid() || dup3(readonly.get(), executable.get(), O_CLOEXEC) == -1) {
+        return false;
+    }
+
+    ProcessOptions run;
+    run.args = {fdPath(executable.get())};
+    run.timeout = std::chrono::seconds(10);
+    return ProcessSupervisor::getInstance().run(run).exit_code == 0;
+}
+
+// Which step of a split compile + link a user flag belongs to
+enum class FlagStage { COMPILE, LINK, BOTH };
+
+FlagStage flagStage(const std::string& flag) {
+    auto starts_with = [&flag](const char* prefix) { return flag.rfind(prefix, 0) == 0; };
+    
+    if (starts_with("-l") || starts_with("-L") || starts_with("-Wl,") || starts_with("-Xlinker") ||
+        starts_with("-static") || starts_with("-rdynamic") || starts_with("-fuse-ld=") ||
+        starts_with("-nostdlib") || flag == "-shared") {
+        return FlagStage::LINK;
+    }
+    if (starts_with("-I") || starts_with("-D") || starts_with("-U") || starts_with("-W") ||
+        starts_with("-isystem") || starts_with("-include") || starts_with("-std=") ||
+        starts_with("-pedantic") || flag == "-x") {
+        return FlagStage::COMPILE;
+    }
+    // -f*, -m*, -g, -O*, -pthread and the like go to both
+    return FlagStage::BOTH;
+}
+
+bool takesSeparateValue(const std::string& flag) {
+    return flag == "-I" || flag == "-D" || flag == "-U" || flag == "-L" || flag == "-l" ||
+           flag == "-isystem" || flag == "-include" || flag == "-x" || flag == "-Xlinker";
+}
+
+std::vector<std::string> flagsForStage(const std::vector<std::string>& flags, FlagStage stage) {
+    std::vector<std::string> selected;
+    for (size_t i = 0; i < flags.size(); ++i) {
+        FlagStage flag_stage = flagStage(flags[i]);
+        bool keep = (flag_stage == FlagStage::BOTH || flag_stage == stage);
+        if (keep) {
+            selected.push_back(flags[i]);
+        }
+        if (takesSeparateValue(flags[i]) && i + 1 < flags.size()) {
+            ++i;
+            if (keep) {
+                selected.push_back(flags[i]);
+            }
+        }
+    }
+    return selected;
+}
+
+std::vector<std::string> compileFlags(const std::vector<std::string>& flags) {
+    return flagsForStage(flags, FlagStage::COMPILE);
+}
+
+std::vector<std::string> linkFlags(const std::vector<std::string>& flags) {
+    return flagsForStage(flags, FlagStage::LINK);
+}
+
+} // namespace
+
+/**
+ * @brief Leader's claim on a cache key while it compiles
+ *
+ * Registered on construction. complete() hands the result to every waiter;
+ * if the leader leaves without calling it (error, timeout, exception) the
+ * waiters get an empty result and one of them takes over.
+ */
+class ExecutionEngine::InFlightCompile {
+public:
+    // Caller holds in_flight_mutex_
+    InFlightCompile(ExecutionEngine& engine, std::string key)
+        : engine_(engine), key_(std::move(key)) {
+        engine_.in_flight_.emplace(key_, promise_.get_future().share());
+    }
+
+    ~InFlightCompile() {
+        if (!done_) {
+            engine_.abandoned_flights_++;
+            finish(std::nullopt);
+        }
+    }
+
+    InFlightCompile(const InFlightCompile&) = delete;
+    InFlightCompile& operator=(const InFlightCompile&) = delete;
+
+    void complete(const CompilationResult& result) {
+        finish(result);
+    }
+
+private:
+    void finish(std::optional<CompilationResult> result) {
+        {
+            // Later arrivals go to the cache instead of this flight
+            std::lock_guard<std::mutex> lock(engine_.in_flight_mutex_);
+            engine_.in_flight_.erase(key_);
+        }
+        done_ = true;
+        promise_.set_value(std::move(result));
+    }
+
+    ExecutionEngine& engine_;
+    std::string key_;
+    std::promise<std::optional<CompilationResult>> promise_;
+    bool done_ = false;
+};
+
+// A session's object file and executable held in memfds, so nothing reaches
+// the filesystem. The compiler, linker and sandbox reach them through
+// fdPath(); the sandbox then fexecve()s the descriptor it opened.
+class ExecutionEngine::MemoryWorkspace {
+public:
+    explicit MemoryWorkspace(ExecutionEngine& engine) : engine_(engine) {}
+
+    ~MemoryWorkspace() {
+        engine_.memory_workspace_bytes_ -= charged_;
+    }
+
+    MemoryWorkspace(const MemoryWorkspace&) = delete;
+    MemoryWorkspace& operator=(const MemoryWorkspace&) = delete;
+
+    // Reserve budget and create the memfds; false means use a directory instead
+    bool open(size_t budget_bytes) {
+        size_t used = engine_.memory_workspace_bytes_.load();
+        do {
+            if (used + kMemoryWorkspaceReserve > budget_bytes) {
+                return false;
+            }
+        } while (!engine_.memory_workspace_bytes_.compare_exchange_weak(used, used + kMemoryWorkspaceReserve));
+        charged_ = kMemoryWorkspaceReserve;
+
+        object_.reset(memfd_create("main.o", MFD_CLOEXEC));
+        executable_.reset(memfd_create("main", MFD_CLOEXEC));
+        return object_.valid() && executable_.valid();
+    }
+
+    std::string objectPath() const { return fdPath(object_.get()); }
+    std::string executablePath() const { return fdPath(executable_.get()); }
+
+    // Called once the executable is complete: drops the object, charges the
+    // executable's real size, and swaps our writable descriptor for a
+    // read-only one at the same number so exec never sees a writer
+    void seal() {
+        object_.reset();
+
+        struct stat st{};
+        size_t bytes = fstat(executable_.get(), &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+        engine_.memory_workspace_bytes_ += bytes;
+        engine_.memory_workspace_bytes_ -= charged_;
+        charged_ = bytes;
+
+        UniqueFd readonly(::open(executablePath().c_str(), O_RDONLY | O_CLOEXEC));
+        if (readonly.valid()) {
+            dup3(readonly.get(), executable_.get(), O_CLOEXEC);
+        }
+    }
+
+private:
+    ExecutionEngine& engine_;
+    UniqueFd object_;
+    UniqueFd executable_;
+    size_t charged_ = 0;
+};
+
 // Initialize static members
 std::unique_ptr<ExecutionEngine> ExecutionEngine::instance_ = nullptr;
 std::mutex ExecutionEngine::mutex_;
@@ -26,6 +266,8 @@ ExecutionEngine::ExecutionEngine()
     : initialized_(false) {
 }
 
+ExecutionEngine::~ExecutionEngine() = default;
+
 ExecutionEngine& ExecutionEngine::getInstance() {
     std::lock_guard<std::mutex> lock(mutex_);
     if (instance_ == nullptr) {
@@ -56,14 +298,46 @@ bool ExecutionEngine::initialize() {
             return false;
         }
         
-        // Initialize Docker if sandbox is enabled
-        if (config.getExecutionConfig().sandbox_enabled) {
-            if (!initializeDocker()) {
-                logger.warning("Docker initialization failed, disabling sandbox", "ExecutionEngine");
-                // Continue without sandbox for development
+        // Set up the compilation cache
+        if (config.getCacheConfig().enable_compilation_cache) {
+            cache_ = std::make_unique<CompilationCache>(config.getCacheConfig());
+            if (!cache_->initialize()) {
+                logger.warning("Compilation cache unavailable, continuing without it", "ExecutionEngine");
+                cache_.reset();
             }
         }
         
+        // Precompile common standard-library prefixes
+        if (config.getCompilerConfig().enable_pch) {
+            initializePchPool();
+        }
+        
+        // Load exercise harnesses registered before a restart
+        harnesses_ = std::make_unique<HarnessRegistry>(
+            std::filesystem::path(config.getCacheConfig().cache_directory) / "harness",
+            [this](const std::vector<std::string>& args, int timeout_seconds) {
+                return executeProcess(args, timeout_seconds);
+            },
+            config.getCompilerConfig().compilation_timeout
+        );
+        harnesses_->initialize();
+        
+        // Compile in-process when clang-inprocess is asked for
+        if (std::filesystem::exists(config.getCompilerConfig().clang_path)) {
+            in_process_ = std::make_unique<InProcessCompiler>(
+                config.getCompilerConfig().clang_path,
+                [this](const std::vector<std::string>& args, int timeout_seconds, std::shared_ptr<CancellationToken> token) {
+                    return executeProcess(args, timeout_seconds, {}, std::move(token));
+                }
+            );
+            logger.info("In-process compiler: " + InProcessCompiler::version(), "ExecutionEngine");
+        }
+        
+        // Pick a sandbox backend if sandbox is enabled
+        if (config.getExecutionConfig().sandbox_enabled) {
+            initializeSandbox();
+        }
+        
         // Test compilation with a simple program
         if (!testCompilation()) {
             logger.error("Test compilation failed", "ExecutionEngine");
@@ -80,7 +354,8 @@ bool ExecutionEngine::initialize() {
     }
 }
 
-CompilationResult ExecutionEngine::compile(const std::string& code, const nlohmann::json& options) {
+CompilationResult ExecutionEngine::compile(const std::string& code, const nlohmann::json& options,
+                                           std::shared_ptr<CancellationToken> cancellation) {
     auto& logger = Logger::getInstance();
     auto& config = Config::getInstance();
     
@@ -89,24 +364,15 @@ CompilationResult ExecutionEngine::compile(const std::string& code, const nlohma
     
     auto start_time = std::chrono::high_resolution_clock::now();
     
+    // Each lap() charges the time since the previous one to a phase
+    auto phase_start = start_time;
+    auto lap = [&phase_start](double& phase_ms) {
+        auto now = std::chrono::high_resolution_clock::now();
+        phase_ms = std::chrono::duration<double, std::milli>(now - phase_start).count();
+        phase_start = now;
+    };
+    
     try {
-        // Generate unique session ID
-        std::string session_id = generateSessionId();
-        std::string work_dir = "temp/" + session_id;
-        
-        // Create working directory
-        std::filesystem::create_directories(work_dir);
-        
-        // Write source code to file
-        std::string source_file = work_dir + "/main.cpp";
-        std::ofstream file(source_file);
-        if (!file.is_open()) {
-            result.errors.push_back("Failed to create source file");
-            return result;
-        }
-        file << code;
-        file.close();
-        
         // Parse compilation options
         std::string compiler = options.value("compiler", config.getCompilerConfig().default_compiler);
         std::string standard = options.value("standard", config.getCompilerConfig().cpp_standard);
@@ -120,22 +386,248 @@ CompilationResult ExecutionEngine::compile(const std::string& code, const nlohma
             }
         }
         
-        // Build compilation command
-        std::vector<std::string> compile_args = buildCompileCommand(
-            source_file, work_dir + "/main", compiler, standard, optimization, debug_info, extra_flags
-        );
+        // Generate unique session ID
+        std::string session_id = generateSessionId();
+        std::string source_file = "-";
+        std::string object_file;
+        std::string executable_file;
         
-        // Execute compilation
-        ProcessResult compile_result = executeProcess(compile_args, config.getCompilerConfig().compilation_timeout);
+        // Keep the session in memfds while the budget allows; the source goes
+        // to the compiler on stdin. Docker bind-mounts the executable, so it
+        // always gets a directory.
+        std::unique_ptr<MemoryWorkspace> memory;
+        if (config.getCompilerConfig().workspace_mode == "memory" && sandbox_backend_ != "docker") {
+            memory = std::make_unique<MemoryWorkspace>(*this);
+            size_t budget = static_cast<size_t>(config.getCompilerConfig().memory_workspace_budget_mb) * 1024 * 1024;
+            if (memory->open(budget)) {
+                object_file = memory->objectPath();
+                executable_file = memory->executablePath();
+                memory_workspaces_created_++;
+            } else {
+                memory.reset();
+                memory_workspace_fallbacks_++;
+            }
+        }
         
-        auto end_time = std::chrono::high_resolution_clock::now();
-        result.compilation_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        // Otherwise lease a directory from the pool
+        Workspace workspace;
+        if (!memory) {
+            workspace = WorkspaceManager::getInstance().acquire();
+            source_file = workspace.file("main.cpp");
+            object_file = workspace.file("main.o");
+            executable_file = workspace.file("main");
+        }
+        
+        // Successful results keep their workspace until releaseCompilation()
+        auto keep = [this, &memory, &workspace](const CompilationResult& kept) {
+            if (!kept.success) {
+                return;
+            }
+            if (memory) {
+                memory->seal();
+                std::lock_guard<std::mutex> lock(workspace_mutex_);
+                memory_workspaces_.emplace(kept.executable_path, std::move(memory));
+            } else {
+                workspace.detach();
+            }
+        };
+        
+        std::string compiler_path = compilerPath(compiler);
+        bool wasm = (sandbox_backend_ == "wasm");
+        
+        // The in-process backend reads the source from memory and starts
+        // neither the driver nor cc1; it only targets the host
+        bool in_process = in_process_ && compiler == InProcessCompiler::kName && !wasm;
+        
+        // An exercise harness is compiled once per toolchain; only the
+        // submission is compiled below and then linked with its objects
+        std::optional<HarnessBuild> harness;
+        if (options.contains("harness")) {
+            std::string harness_id = options["harness"].get<std::string>();
+            auto digest = harnesses_ ? harnesses_->current(harness_id) : std::nullopt;
+            if (!digest) {
+                result.errors.push_back("Unknown harness: " + harness_id);
+                return result;
+            }
+            harness = buildHarness(harness_id, *digest, compiler, standard, optimization, debug_info, extra_flags);
+            lap(result.phases.harness_ms);
+            if (!harness->success) {
+                result.compiler_output = harness->compiler_output;
+                result.errors.push_back("Harness " + harness_id + " failed to compile");
+                return result;
+            }
+        }
+        
+        // A PCH is only valid for the exact flags it was built with, so
+        // submissions with debug info or custom flags compile without one.
+        // The linked Clang may not match the clang++ that built the pool,
+        // and the pool holds no wasm32-wasi headers.
+        std::string pch_header;
+        if (pch_pool_ && !in_process && !wasm && !debug_info && extra_flags.empty() && options.value("pch", true)) {
+            PchToolchain toolchain{compiler_path, isClang(compiler), standard, optimization};
+            pch_header = pch_pool_->select(code, toolchain).value_or("");
+        }
+        
+        // Serve identical compilations from the cache without forking the compiler
+        std::string cache_key;
+        if (cache_ && options.value("cache", true)) {
+            CompilationKey key;
+            key.code = code;
+            if (in_process) {
+                key.compiler_path = InProcessCompiler::kName;
+                key.compiler_version = InProcessCompiler::version();
+            } else {
+                key.compiler_path = compiler_path;
+                auto version = compiler_versions_.find(key.compiler_path);
+                key.compiler_version = (version != compiler_versions_.end()) ? version->second : "";
+            }
+            key.standard = standard;
+            key.optimization = optimization;
+            key.debug_info = debug_info;
+            key.extra_flags = extra_flags;
+            key.pch = pch_header;
+            key.harness = harness ? harness->digest : "";
+            cache_key = CompilationCache::computeKey(key);
+            lap(result.phases.setup_ms);
+            
+            auto cached = cache_->lookup(cache_key, executable_file);
+            lap(result.phases.cache_lookup_ms);
+            if (cached) {
+                auto end_time = std::chrono::high_resolution_clock::now();
+                cached->compilation_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+                cached->phases = result.phases;
+                recordPhases(cached->phases);
+                keep(*cached);
+                logger.info("Compilation cache hit for session: " + session_id, "ExecutionEngine");
+                return *cached;
+            }
+        } else {
+            lap(result.phases.setup_ms);
+        }
         
+        // Single flight: the first request for a key compiles, identical ones
+        // arriving meanwhile wait and then take the result from the cache,
+        // which is why there is no flight without a cache key
+        std::optional<InFlightCompile> flight;
+        if (!cache_key.empty()) {
+            auto wait_limit = std::chrono::seconds(config.getCompilerConfig().compilation_timeout) + kFlightWaitGrace;
+            while (!flight) {
+                CompileFlight pending;
+                {
+                    std::lock_guard<std::mutex> lock(in_flight_mutex_);
+                    auto it = in_flight_.find(cache_key);
+                    if (it == in_flight_.end()) {
+                        flight.emplace(*this, cache_key);
+                        break;
+                    }
+                    pending = it->second;
+                }
+                
+                // Waited on in slices so a cancelled request stops waiting
+                auto wait_deadline = std::chrono::steady_clock::now() + wait_limit;
+                while (pending.wait_for(kFlightWaitSlice) != std::future_status::ready &&
+                       std::chrono::steady_clock::now() < wait_deadline &&
+                       !(cancellation && cancellation->cancelled())) {
+                }
+                if (cancellation && cancellation->cancelled()) {
+                    result.errors.push_back("Compilation cancelled");
+                    return result;
+                }
+                if (pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                    // Leader is stuck; compile on our own rather than fail
+                    flight_wait_timeouts_++;
+                    break;
+                }
+                
+                std::optional<CompilationResult> shared = pending.get();
+                if (!shared) {
+                    continue;  // leader gave up; try to take over
+                }
+                
+                auto end_time = std::chrono::high_resolution_clock::now();
+                long waited_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+                if (!shared->success) {
+                    coalesced_compiles_++;
+                    lap(result.phases.coalesced_wait_ms);
+                    shared->compilation_time_ms = waited_ms;
+                    shared->phases = result.phases;
+                    recordPhases(shared->phases);
+                    return *shared;
+                }
+                // Each request needs its own executable; the cache hands out links
+                if (auto cached = cache_->lookup(cache_key, executable_file)) {
+                    coalesced_compiles_++;
+                    lap(result.phases.coalesced_wait_ms);
+                    cached->compilation_time_ms = waited_ms;
+                    cached->phases = result.phases;
+                    recordPhases(cached->phases);
+                    keep(*cached);
+                    logger.info("Coalesced compilation for session: " + session_id, "ExecutionEngine");
+                    return *cached;
+                }
+                break;  // not cached after all; compile ourselves
+            }
+        }
+        
+        // Also a request that waited and then compiled itself; zero when nothing was in flight
+        lap(result.phases.coalesced_wait_ms);
+        
+        // Write source code to file
+        if (!memory && !in_process) {
+            std::ofstream file(source_file);
+            if (!file.is_open()) {
+                result.errors.push_back("Failed to create source file");
+                return result;
+            }
+            file << code;
+            file.close();
+        }
+        lap(result.phases.write_source_ms);
+        
+        // Compile to an object, then link separately so link time is visible
+        std::vector<std::string> source_flags = extra_flags;
+        if (harness) {
+            source_flags.push_back("-I");
+            source_flags.push_back(harness->include_directory);
+        }
+        ProcessResult compile_result;
+        if (in_process) {
+            std::vector<std::string> compile_args = buildCompileCommand(
+                InProcessCompiler::kSourceName, object_file, compiler, standard, optimization, debug_info, source_flags
+            );
+            compile_result = in_process_->compile(compile_args, code, object_file, cancellation);
+        } else {
+            std::vector<std::string> compile_args = buildCompileCommand(
+                source_file, object_file, compiler, standard, optimization, debug_info, source_flags, pch_header
+            );
+            compile_result = executeProcess(compile_args, config.getCompilerConfig().compilation_timeout,
+                                            memory ? std::string_view(code) : std::string_view(),
+                                            cancellation);
+        }
+        lap(result.phases.compile_ms);
         result.compiler_output = compile_result.stderr + compile_result.stdout;
         
+        if (compile_result.exit_code == 0) {
+            auto linker = linkers_.find(compiler_path);
+            result.linker = (linker != linkers_.end() && !linker->second.empty()) ? linker->second : "default";
+            
+            int remaining = config.getCompilerConfig().compilation_timeout -
+                static_cast<int>(std::chrono::duration_cast<std::chrono::seconds>(phase_start - start_time).count());
+            std::vector<std::string> link_args = buildLinkCommand(object_file, executable_file, compiler_path, extra_flags,
+                                                                  harness ? harness->objects : std::vector<std::string>{});
+            compile_result = in_process ? in_process_->link(link_args, std::max(1, remaining), cancellation)
+                                        : executeProcess(link_args, std::max(1, remaining), {}, cancellation);
+            lap(result.phases.link_ms);
+            result.compiler_output += compile_result.stderr + compile_result.stdout;
+            
+        }
+        
+        auto end_time = std::chrono::high_resolution_clock::now();
+        result.compilation_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        
         if (compile_result.exit_code == 0) {
             result.success = true;
-            result.executable_path = work_dir + "/main";
+            result.executable_path = executable_file;
             
             // Parse warnings from compiler output
             parseCompilerMessages(result.compiler_output, result.warnings, result.errors);
@@ -144,10 +636,25 @@ CompilationResult ExecutionEngine::compile(const std::string& code, const nlohma
         } else {
             result.success = false;
             parseCompilerMessages(result.compiler_output, result.warnings, result.errors);
+            if (compile_result.cancelled) {
+                result.errors.push_back("Compilation cancelled");
+            }
             
             logger.info("Compilation failed for session: " + session_id, "ExecutionEngine");
         }
         
+        // Only cache deterministic outcomes: a clean build or ordinary compile errors,
+        // never timeouts or a compiler that failed to start
+        if (!cache_key.empty() && (compile_result.exit_code == 0 || compile_result.exit_code == 1)) {
+            cache_->store(cache_key, result);
+            lap(result.phases.cache_store_ms);
+            if (flight) {
+                flight->complete(result);
+            }
+        }
+        
+        recordPhases(result.phases);
+        keep(result);
         return result;
         
     } catch (const std::exception& e) {
@@ -157,19 +664,230 @@ CompilationResult ExecutionEngine::compile(const std::string& code, const nlohma
     }
 }
 
+SyntaxCheckResult ExecutionEngine::checkSyntax(const std::string& code, const nlohmann::json& options) {
+    auto& config = Config::getInstance();
+    const auto& compiler_config = config.getCompilerConfig();
+    
+    SyntaxCheckResult result;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    
+    try {
+        std::string compiler = options.value("compiler", compiler_config.default_compiler);
+        std::string standard = options.value("standard", compiler_config.cpp_standard);
+        int max_errors = std::max(1, options.value("max_errors", kDefaultMaxErrors));
+        std::vector<std::string> extra_flags;
+        if (options.contains("flags") && options["flags"].is_array()) {
+            for (const auto& flag : options["flags"]) {
+                extra_flags.push_back(flag.get<std::string>());
+            }
+        }
+        
+        bool is_clang = isClang(compiler);
+        std::string compiler_path = is_clang ? compiler_config.clang_path : compiler_config.compiler_path;
+        
+        // The O0 headers match a frontend-only run; custom flags may not
+        std::string pch_header;
+        if (pch_pool_ && extra_flags.empty() && options.value("pch", true)) {
+            PchToolchain toolchain{compiler_path, is_clang, standard, "O0"};
+            pch_header = pch_pool_->select(code, toolchain).value_or("");
+        }
+        result.pch_used = !pch_header.empty();
+        
+        std::vector<std::string> args = {
+            compiler_path,
+            "-std=" + standard,
+            "-O0",
+            "-fsyntax-only",
+            "-Wall",
+            "-Wextra",
+            "-pedantic",
+            "-fdiagnostics-color=never",
+            is_clang ? "-fno-caret-diagnostics" : "-fno-diagnostics-show-caret",
+            is_clang ? "-ferror-limit=" + std::to_string(max_errors) : "-fmax-errors=" + std::to_string(max_errors)
+        };
+        args.insert(args.end(), extra_flags.begin(), extra_flags.end());
+        if (options.contains("harness")) {
+            std::string harness_id = options["harness"].get<std::string>();
+            auto include_directory = harnesses_ ? harnesses_->includeDirectory(harness_id) : std::nullopt;
+            if (!include_directory) {
+                result.error_message = "Unknown harness: " + harness_id;
+                return result;
+            }
+            args.push_back("-I");
+            args.push_back(*include_directory);
+        }
+        if (!pch_header.empty()) {
+            args.push_back("-include");
+            args.push_back(pch_header);
+        }
+        
+        // Source on stdin: no session directory, no files to clean up
+        args.push_back("-x");
+        args.push_back("c++");
+        args.push_back("-");
+        
+        ProcessResult check = executeProcess(args, compiler_config.compilation_timeout, code);
+        
+        if (check.timed_out || check.exit_code > 1) {
+            result.error_message = check.timed_out ? "Syntax check timed out" : "Compiler failed: " + check.stderr;
+        }
+        
+        result.truncated = check.stderr.find("-fmax-errors=") != std::string::npos ||
+                           check.stderr.find("too many errors emitted") != std::string::npos;
+        
+        for (auto& diagnostic : parseDiagnostics(check.stderr)) {
+            if (diagnostic.severity == "error") {
+                result.error_count++;
+            } else if (diagnostic.severity == "warning") {
+                result.warning_count++;
+            }
+            result.diagnostics.push_back(std::move(diagnostic));
+        }
+        
+        result.success = check.exit_code == 0 && result.error_message.empty();
+    } catch (const std::exception& e) {
+        result.error_message = "Internal syntax check error: " + std::string(e.what());
+        Logger::getInstance().error("Syntax check exception: " + std::string(e.what()), "ExecutionEngine");
+    }
+    
+    auto end_time = std::chrono::high_resolution_clock::now();
+    result.check_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+    return result;
+}
+
+std::vector<Diagnostic> ExecutionEngine::parseDiagnostics(const std::string& compiler_output) {
+    // file:line:column: severity: message [-Wflag]
+    static const std::regex pattern(R"(^(.*?):(\d+):(\d+): (fatal error|error|warning|note): (.*?)(?: \[(-W[^\]]+|-f[^\]]+)\])?$)");
+    
+    std::vector<Diagnostic> diagnostics;
+    std::istringstream stream(compiler_output);
+    std::string line;
+    std::smatch match;
+    
+    while (std::getline(stream, line)) {
+        if (!std::regex_match(line, match, pattern)) {
+            continue;
+        }
+        Diagnostic diagnostic;
+        diagnostic.file = match[1].str();
+        if (diagnostic.file == "<stdin>") {
+            diagnostic.file.clear();
+        }
+        diagnostic.line = std::stoi(match[2].str());
+        diagnostic.column = std::stoi(match[3].str());
+        diagnostic.severity = match[4].str() == "fatal error" ? "error" : match[4].str();
+        diagnostic.message = match[5].str();
+        diagnostic.option = match[6].str();
+        diagnostics.push_back(std::move(diagnostic));
+    }
+    
+    return diagnostics;
+}
+
 ExecutionResult ExecutionEngine::execute(const std::string& code, const std::string& input, const nlohmann::json& options) {
+    return execute(code, input, options, ExecutionObserver{});
+}
+
+ExecutionResult ExecutionEngine::execute(const std::string& code, const std::string& input, const nlohmann::json& options,
+                                         const ExecutionObserver& observer,
+                                         std::shared_ptr<CancellationToken> cancellation) {
     auto& logger = Logger::getInstance();
     auto& config = Config::getInstance();
     
+    // Tiered: start the optimized build now and answer with the fast one first
+    TierPolicy tiers = tierPolicyFrom(options);
+    if (tiers.enabled) {
+        nlohmann::json fast_options = options;
+        fast_options.erase("tiered");
+        fast_options["optimization"] = tiers.fast;
+        nlohmann::json optimized_options = fast_options;
+        optimized_options["optimization"] = tiers.optimized;
+        
+        // A token of its own, so the follow-up can be dropped without touching the request
+        auto tier_cancellation = std::make_shared<CancellationToken>();
+        CancellationToken::Registration link = 0;
+        if (cancellation) {
+            link = cancellation->onCancel([tier_cancellation]() { tier_cancellation->cancel(); });
+        }
+        // A second compiler and run, so a ticket of its own; refused, the tier is dropped
+        auto tier_ticket = std::make_shared<AdmissionTicket>();
+        auto build = std::async(std::launch::async, [this, &code, optimized_options, tier_cancellation, tier_ticket,
+                                                     client_id = observer.client_id]() -> std::optional<CompilationResult> {
+            auto admission = AdmissionController::getInstance().admit(client_id, AdmissionLane::BATCH, tier_cancellation);
+            if (!admission.admitted()) {
+                Logger::getInstance().info("Optimized tier dropped: " + admission.reason, "ExecutionEngine");
+                return std::nullopt;
+            }
+            *tier_ticket = std::move(admission.ticket);
+            return compile(code, optimized_options, tier_cancellation);
+        });
+        
+        // Streamed output never reaches the result, so keep a copy to compare against
+        auto fast_stdout = std::make_shared<std::string>();
+        ExecutionObserver fast_observer = observer;
+        if (observer.on_output) {
+            fast_observer.on_output = [fast_stdout, forward = observer.on_output](int fd, std::string_view data) {
+                if (fd == STDOUT_FILENO) {
+                    fast_stdout->append(data);
+                }
+                forward(fd, data);
+            };
+        }
+        
+        ExecutionResult result = execute(code, input, fast_options, fast_observer, cancellation);
+        if (observer.on_fast_result) {
+            observer.on_fast_result(result);
+        }
+        if (result.success) {
+            result.optimized = runOptimizedTier(build, input, observer.on_output ? *fast_stdout : result.stdout,
+                                                tiers, tier_cancellation);
+        } else {
+            tier_cancellation->cancel();
+            if (auto compilation = build.get()) {
+                releaseCompilation(*compilation);
+            }
+        }
+        if (cancellation) {
+            cancellation->unregister(link);
+        }
+        return result;
+    }
+    
+    // Small snippets can skip the object file, link and exec
+    std::string jit_fallback;
+    if (options.value("jit", config.getExecutionConfig().enable_jit)) {
+        auto jit_start = std::chrono::high_resolution_clock::now();
+        auto jitted = executeJit(code, input, options, observer, cancellation, jit_fallback);
+        double jit_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - jit_start).count();
+        if (jitted) {
+            recordExecutionMode("jit", jit_ms);
+            return *jitted;
+        }
+        recordExecutionMode("jit_fallback", jit_ms);
+        logger.info("JIT run not possible, compiling: " + jit_fallback, "ExecutionEngine");
+    }
+    
     ExecutionResult result;
     result.success = false;
+    result.jit_fallback = jit_fallback;
     
     try {
         // First compile the code
-        CompilationResult compile_result = compile(code, options);
+        CompilationResult compile_result = compile(code, options, cancellation);
+        result.compilation_time_ms = compile_result.compilation_time_ms;
+        if (observer.on_compiled) {
+            observer.on_compiled(compile_result);
+        }
+        
+        if (!compile_result.success && cancellation && cancellation->cancelled()) {
+            result.status = ExecutionStatus::CANCELLED;
+            result.error_message = "Cancelled during compilation";
+            return result;
+        }
         
         if (!compile_result.success) {
             result.success = false;
+            result.status = ExecutionStatus::COMPILATION_ERROR;
             result.error_message = "Compilation failed";
             // Copy compilation errors
             for (const auto& error : compile_result.errors) {
@@ -179,31 +897,13 @@ ExecutionResult ExecutionEngine::execute(const std::string& code, const std::str
         }
         
         // Execute the compiled program
-        auto start_time = std::chrono::high_resolution_clock::now();
-        
-        ProcessResult exec_result;
-        if (config.getExecutionConfig().sandbox_enabled) {
-            exec_result = executeInSandbox(compile_result.executable_path, input, options);
-        } else {
-            exec_result = executeDirectly(compile_result.executable_path, input, options);
-        }
-        
-        auto end_time = std::chrono::high_resolution_clock::now();
-        result.execution_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-        
-        result.success = (exec_result.exit_code == 0);
-        result.exit_code = exec_result.exit_code;
-        result.stdout = exec_result.stdout;
-        result.stderr = exec_result.stderr;
-        result.memory_usage_kb = exec_result.memory_usage_kb;
-        result.cpu_time_ms = exec_result.cpu_time_ms;
-        
-        if (!result.success && result.stderr.empty()) {
-            result.error_message = "Program exited with code " + std::to_string(result.exit_code);
-        }
+        ProcessResult exec_result = runExecutable(compile_result.executable_path, input,
+                                                  config.getExecutionConfig(), observer.on_output, cancellation);
+        applyRunResult(exec_result, static_cast<bool>(observer.on_output), result);
+        recordExecutionMode("native", static_cast<double>(result.compilation_time_ms + result.execution_time_ms));
         
         // Clean up temporary files
-        cleanupSession(std::filesystem::path(compile_result.executable_path).parent_path().string());
+        releaseCompilation(compile_result);
         
         logger.info("Execution completed with exit code: " + std::to_string(result.exit_code), "ExecutionEngine");
         
@@ -216,6 +916,290 @@ ExecutionResult ExecutionEngine::execute(const std::string& code, const std::str
     }
 }
 
+void ExecutionEngine::applyRunResult(ProcessResult& run, bool streamed, ExecutionResult& result) {
+    const auto& execution_config = Config::getInstance().getExecutionConfig();
+    
+    // Collected output is capped per stream; say so where it was cut
+    if (run.output_truncated && !streamed) {
+        size_t limit = execution_config.max_output_size;
+        std::string marker = "\n[output truncated after " + std::to_string(limit) + " bytes]\n";
+        if (run.stdout.size() >= limit) {
+            run.stdout += marker;
+        }
+        if (run.stderr.size() >= limit) {
+            run.stderr += marker;
+        }
+    }
+    
+    result.status = classifyExit(run, execution_config);
+    result.success = (result.status == ExecutionStatus::OK);
+    result.exit_code = run.exit_code;
+    result.term_signal = run.term_signal;
+    result.stdout = std::move(run.stdout);
+    result.stderr = std::move(run.stderr);
+    result.execution_time_ms = run.wall_time_ms;
+    result.memory_usage_kb = run.memory_usage_kb;
+    result.cpu_time_ms = run.cpu_time_ms;
+    result.user_time_ms = run.user_time_ms;
+    result.system_time_ms = run.system_time_ms;
+    result.voluntary_context_switches = run.voluntary_context_switches;
+    result.involuntary_context_switches = run.involuntary_context_switches;
+    result.io_read_bytes = run.io_read_bytes;
+    result.io_write_bytes = run.io_write_bytes;
+    
+    switch (result.status) {
+        case ExecutionStatus::TIME_LIMIT_EXCEEDED:
+            result.error_message = "Time limit exceeded (" + std::to_string(execution_config.execution_timeout) + "s)";
+            break;
+        case ExecutionStatus::CPU_LIMIT_EXCEEDED:
+            result.error_message = "CPU time limit exceeded (" + std::to_string(execution_config.max_cpu_time) + "s)";
+            break;
+        case ExecutionStatus::MEMORY_LIMIT_EXCEEDED:
+            result.error_message = "Memory limit exceeded (" + std::to_string(execution_config.max_memory_mb) + "MB)";
+            break;
+        case ExecutionStatus::OUTPUT_LIMIT_EXCEEDED:
+            result.error_message = "Output limit exceeded (" + std::to_string(execution_config.max_output_size) + " bytes)";
+            break;
+        case ExecutionStatus::CANCELLED:
+            result.error_message = "Cancelled";
+            break;
+        case ExecutionStatus::RUNTIME_ERROR:
+            if (result.stderr.empty()) {
+                result.error_message = "Program exited with code " + std::to_string(result.exit_code);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+std::optional<ExecutionResult> ExecutionEngine::executeJit(const std::string& code, const std::string& input,
+                                                           const nlohmann::json& options, const ExecutionObserver& observer,
+                                                           std::shared_ptr<CancellationToken> cancellation,
+                                                           std::string& fallback_reason) {
+    const auto& config = Config::getInstance();
+    const auto& execution_config = config.getExecutionConfig();
+    
+    if (!in_process_) {
+        fallback_reason = "In-process compiler unavailable";
+        return std::nullopt;
+    }
+    if (sandbox_backend_ != "native" || !sandbox_pool_) {
+        fallback_reason = "JIT runs need the native sandbox pool";
+        return std::nullopt;
+    }
+    if (code.size() > execution_config.jit_max_source_bytes) {
+        fallback_reason = "Source larger than " + std::to_string(execution_config.jit_max_source_bytes) + " bytes";
+        return std::nullopt;
+    }
+    if (options.contains("harness") || (options.contains("flags") && !options["flags"].empty())) {
+        fallback_reason = "Harnesses and custom flags need the compile-and-link path";
+        return std::nullopt;
+    }
+    // A fallback after the compiled event or streamed output would report twice
+    if (observer.on_compiled || observer.on_output) {
+        fallback_reason = "Streamed executions are not run through the JIT";
+        return std::nullopt;
+    }
+    
+    auto start_time = std::chrono::high_resolution_clock::now();
+    std::string standard = options.value("standard", config.getCompilerConfig().cpp_standard);
+    std::string optimization = options.value("optimization", config.getCompilerConfig().optimization_level);
+    std::vector<std::string> args = buildCompileCommand(InProcessCompiler::kSourceName, "main.bc", InProcessCompiler::kName,
+                                                        standard, optimization, false, {"-emit-llvm"});
+    std::string bitcode;
+    ProcessResult compiled = in_process_->compileToBitcode(args, code, bitcode, cancellation);
+    auto compiled_time = std::chrono::high_resolution_clock::now();
+    if (compiled.exit_code != 0) {
+        // The configured compiler may accept what Clang does not, and reports errors the usual way
+        fallback_reason = compiled.cancelled ? "Cancelled during compilation" : "Clang did not compile the snippet";
+        return std::nullopt;
+    }
+    
+    auto run = sandbox_pool_->runBitcode(bitcode, input, Sandbox::limitsFromConfig(execution_config),
+                                         std::chrono::seconds(execution_config.execution_timeout), nullptr,
+                                         std::move(cancellation), fallback_reason);
+    if (!run) {
+        return std::nullopt;
+    }
+    
+    ExecutionResult result;
+    result.mode = "jit";
+    result.compilation_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(compiled_time - start_time).count();
+    applyRunResult(*run, false, result);
+    Logger::getInstance().info("JIT execution completed with exit code: " + std::to_string(result.exit_code), "ExecutionEngine");
+    return result;
+}
+
+TierPolicy ExecutionEngine::tierPolicyFrom(const nlohmann::json& options) {
+    TierPolicy policy;
+    if (!options.contains("tiered")) {
+        return policy;
+    }
+    
+    const auto& tiered = options["tiered"];
+    if (tiered.is_boolean()) {
+        policy.enabled = tiered.get<bool>();
+    } else if (tiered.is_object()) {
+        policy.enabled = tiered.value("enabled", true);
+        policy.fast = tiered.value("fast", policy.fast);
+        policy.optimized = tiered.value("optimized", policy.optimized);
+    }
+    return policy;
+}
+
+std::optional<OptimizedTierResult> ExecutionEngine::runOptimizedTier(std::future<std::optional<CompilationResult>>& build,
+                                                                     std::string_view input, std::string_view fast_stdout,
+                                                                     const TierPolicy& policy,
+                                                                     std::shared_ptr<CancellationToken> cancellation) {
+    const auto& execution_config = Config::getInstance().getExecutionConfig();
+    
+    std::optional<CompilationResult> admitted = build.get();
+    if (!admitted) {
+        return std::nullopt;
+    }
+    CompilationResult& compilation = *admitted;
+    
+    OptimizedTierResult tier;
+    tier.optimization = policy.optimized;
+    tier.compilation_time_ms = compilation.compilation_time_ms;
+    if (!compilation.success) {
+        tier.status = cancellation->cancelled() ? ExecutionStatus::CANCELLED : ExecutionStatus::COMPILATION_ERROR;
+        tier.error_message = "Optimized build failed";
+        for (const auto& error : compilation.errors) {
+            tier.error_message += "\n" + error;
+        }
+        return tier;
+    }
+    
+    ProcessResult run = runExecutable(compilation.executable_path, input, execution_config, nullptr, cancellation);
+    releaseCompilation(compilation);
+    
+    tier.status = classifyExit(run, execution_config);
+    tier.success = (tier.status == ExecutionStatus::OK);
+    tier.execution_time_ms = run.wall_time_ms;
+    tier.cpu_time_ms = run.cpu_time_ms;
+    tier.memory_usage_kb = run.memory_usage_kb;
+    // Differences usually mean undefined behaviour that optimization exposed
+    tier.output_matches = !run.output_truncated && run.stdout == fast_stdout;
+    if (!tier.success) {
+        tier.error_message = "Optimized run ended with " + executionStatusToString(tier.status);
+    }
+    return tier;
+}
+
+nlohmann::json ExecutionEngine::registerHarness(const std::string& id, const std::vector<HarnessFile>& headers,
+                                                const std::vector<HarnessFile>& sources) {
+    if (!harnesses_) {
+        throw std::runtime_error("Execution engine is not initialized");
+    }
+    std::string digest = harnesses_->stage(id, headers, sources);
+    
+    // Build for the toolchains most submissions use before any submission
+    // can link against this version
+    std::vector<PchToolchain> toolchains = defaultToolchains();
+    std::vector<std::future<HarnessBuild>> builds;
+    for (const auto& toolchain : toolchains) {
+        std::string compiler = toolchain.is_clang ? "clang++" : "g++";
+        builds.push_back(std::async(std::launch::async, [this, &id, &digest, compiler, toolchain]() {
+            return buildHarness(id, digest, compiler, toolchain.standard, toolchain.optimization, false, {});
+        }));
+    }
+    
+    nlohmann::json response = {{"id", id}, {"digest", digest}, {"builds", nlohmann::json::array()}};
+    bool success = true;
+    std::string compiler_output;
+    for (size_t i = 0; i < builds.size(); ++i) {
+        HarnessBuild build = builds[i].get();
+        response["builds"].push_back({
+            {"compiler", std::filesystem::path(toolchains[i].compiler_path).filename().string()},
+            {"standard", toolchains[i].standard},
+            {"optimization", toolchains[i].optimization},
+            {"success", build.success},
+            {"built", build.built}
+        });
+        if (!build.success) {
+            success = false;
+            compiler_output += build.compiler_output;
+        }
+    }
+    
+    if (success) {
+        harnesses_->activate(id, digest);
+    }
+    response["success"] = success;
+    if (!compiler_output.empty()) {
+        response["compiler_output"] = compiler_output;
+    }
+    return response;
+}
+
+bool ExecutionEngine::removeHarness(const std::string& id) {
+    return harnesses_ && harnesses_->remove(id);
+}
+
+nlohmann::json ExecutionEngine::listHarnesses() const {
+    return harnesses_ ? harnesses_->list() : nlohmann::json::array();
+}
+
+nlohmann::json ExecutionEngine::getMetrics() const {
+    nlohmann::json metrics;
+    metrics["compilation_cache"] = cache_ ? cache_->getStatistics() : nlohmann::json{{"enabled", false}};
+    metrics["pch"] = pch_pool_ ? pch_pool_->getStatistics() : nlohmann::json{{"enabled", false}};
+    metrics["harnesses"] = harnesses_ ? harnesses_->getStatistics() : nlohmann::json{{"enabled", false}};
+    metrics["in_process_compiler"] = in_process_ ? in_process_->getStatistics() : nlohmann::json{{"enabled", false}};
+    metrics["process_supervisor"] = ProcessSupervisor::getInstance().getStatistics();
+    metrics["sandbox"] = Sandbox::getInstance().getStatus();
+    metrics["sandbox"]["backend"] = sandbox_backend_;
+    metrics["sandbox_pool"] = sandbox_pool_ ? sandbox_pool_->getStatistics() : nlohmann::json{{"enabled", false}};
+    metrics["wasm"] = wasm_ ? wasm_->getStatistics() : nlohmann::json{{"enabled", false}};
+    {
+        std::lock_guard<std::mutex> lock(phase_mutex_);
+        nlohmann::json phases = nlohmann::json::object();
+        for (const auto& [name, totals] : phase_totals_) {
+            phases[name] = {
+                {"count", totals.count},
+                {"total_ms", totals.total_ms},
+                {"average_ms", totals.total_ms / totals.count},
+                {"max_ms", totals.max_ms}
+            };
+        }
+        metrics["compile_phases"] = phases;
+        
+        nlohmann::json modes = nlohmann::json::object();
+        for (const auto& [name, totals] : execution_mode_totals_) {
+            modes[name] = {
+                {"count", totals.count},
+                {"total_ms", totals.total_ms},
+                {"average_ms", totals.total_ms / totals.count},
+                {"max_ms", totals.max_ms}
+            };
+        }
+        metrics["execution_modes"] = modes;
+    }
+    metrics["linkers"] = linkers_;
+    {
+        std::lock_guard<std::mutex> lock(in_flight_mutex_);
+        metrics["compile_coalescing"] = {
+            {"in_flight", in_flight_.size()},
+            {"coalesced", coalesced_compiles_.load()},
+            {"abandoned", abandoned_flights_.load()},
+            {"wait_timeouts", flight_wait_timeouts_.load()}
+        };
+    }
+    {
+        std::lock_guard<std::mutex> lock(workspace_mutex_);
+        metrics["memory_workspaces"] = {
+            {"mode", Config::getInstance().getCompilerConfig().workspace_mode},
+            {"active", memory_workspaces_.size()},
+            {"bytes", memory_workspace_bytes_.load()},
+            {"created", memory_workspaces_created_.load()},
+            {"disk_fallbacks", memory_workspace_fallbacks_.load()}
+        };
+    }
+    return metrics;
+}
+
 void ExecutionEngine::createDirectories() {
     std::vector<std::string> directories = {
         "temp",
@@ -240,14 +1224,242 @@ bool ExecutionEngine::validateCompilers() {
         return false;
     }
     
+    compiler_versions_[config.getCompilerConfig().compiler_path] = queryCompilerVersion(config.getCompilerConfig().compiler_path);
+    
     // Check clang++
     if (!std::filesystem::exists(config.getCompilerConfig().clang_path)) {
         logger.warning("Clang++ not found: " + config.getCompilerConfig().clang_path, "ExecutionEngine");
+    } else {
+        compiler_versions_[config.getCompilerConfig().clang_path] = queryCompilerVersion(config.getCompilerConfig().clang_path);
+    }
+    
+    for (const auto& [compiler_path, version] : compiler_versions_) {
+        linkers_[compiler_path] = selectLinker(compiler_path);
     }
     
     return true;
 }
 
+std::string ExecutionEngine::selectLinker(const std::string& compiler_path) {
+    auto& logger = Logger::getInstance();
+    std::string requested = Config::getInstance().getCompilerConfig().linker;
+    
+    if (requested.empty() || requested == "default") {
+        return "";
+    }
+    std::vector<std::string> candidates = (requested == "auto") ? kFastLinkers : std::vector<std::string>{requested};
+    
+    // The driver knows where to find each candidate
+    std::string selected;
+    for (const auto& candidate : candidates) {
+        if (linksIntoMemory(compiler_path, candidate)) {
+            selected = candidate;
+            break;
+        }
+    }
+    
+    if (selected.empty()) {
+        if (requested != "auto") {
+            logger.warning("Linker '" + requested + "' unusable with " + compiler_path + ", using the default", "ExecutionEngine");
+        }
+        logger.info("Linking with the default linker for " + compiler_path, "ExecutionEngine");
+    } else {
+        logger.info("Linking with " + selected + " for " + compiler_path, "ExecutionEngine");
+    }
+    return selected;
+}
+
+void ExecutionEngine::recordExecutionMode(const std::string& mode, double ms) {
+    std::lock_guard<std::mutex> lock(phase_mutex_);
+    PhaseTotals& totals = execution_mode_totals_[mode];
+    totals.count++;
+    totals.total_ms += ms;
+    totals.max_ms = std::max(totals.max_ms, ms);
+}
+
+void ExecutionEngine::recordPhases(const CompilePhaseTimes& phases) {
+    std::pair<const char*, double> samples[] = {
+        {"setup", phases.setup_ms},
+        {"harness", phases.harness_ms},
+        {"cache_lookup", phases.cache_lookup_ms},
+        {"coalesced_wait", phases.coalesced_wait_ms},
+        {"write_source", phases.write_source_ms},
+        {"compile", phases.compile_ms},
+        {"link", phases.link_ms},
+        {"cache_store", phases.cache_store_ms}
+    };
+    
+    std::lock_guard<std::mutex> lock(phase_mutex_);
+    for (const auto& [name, ms] : samples) {
+        // Phases that did not happen for this request stay at zero
+        if (ms <= 0.0) {
+            continue;
+        }
+        PhaseTotals& totals = phase_totals_[name];
+        totals.count++;
+        totals.total_ms += ms;
+        totals.max_ms = std::max(totals.max_ms, ms);
+    }
+}
+
+std::string ExecutionEngine::queryCompilerVersion(const std::string& compiler_path) {
+    ProcessResult version_result = executeProcess({compiler_path, "--version"}, 5);
+    if (version_result.exit_code != 0) {
+        Logger::getInstance().warning("Could not query version of " + compiler_path, "ExecutionEngine");
+        return "";
+    }
+    
+    std::string version = version_result.stdout.substr(0, version_result.stdout.find('\n'));
+    Logger::getInstance().info("Compiler " + compiler_path + ": " + version, "ExecutionEngine");
+    return version;
+}
+
+std::vector<PchToolchain> ExecutionEngine::defaultToolchains() const {
+    const auto& compiler_config = Config::getInstance().getCompilerConfig();
+    
+    std::vector<std::string> optimizations = {compiler_config.optimization_level};
+    if (compiler_config.optimization_level != "O0") {
+        optimizations.push_back("O0");
+    }
+    
+    std::vector<PchToolchain> toolchains;
+    
+    // Under the wasm backend every compile uses the wasi-sdk toolchain
+    if (sandbox_backend_ == "wasm") {
+        for (const auto& optimization : optimizations) {
+            toolchains.push_back({compiler_config.wasi_clang_path, true, compiler_config.cpp_standard, optimization});
+        }
+        return toolchains;
+    }
+    
+    for (const auto& [compiler_path, version] : compiler_versions_) {
+        if (compiler_path == compiler_config.wasi_clang_path) {
+            continue;
+        }
+        bool is_clang = (compiler_path == compiler_config.clang_path);
+        for (const auto& optimization : optimizations) {
+            toolchains.push_back({compiler_path, is_clang, compiler_config.cpp_standard, optimization});
+        }
+    }
+    return toolchains;
+}
+
+void ExecutionEngine::initializePchPool() {
+    auto& config = Config::getInstance();
+    const auto& compiler_config = config.getCompilerConfig();
+    
+    std::vector<PchToolchain> toolchains = defaultToolchains();
+    
+    pch_pool_ = std::make_unique<PchPool>(
+        std::filesystem::path(config.getCacheConfig().cache_directory) / "pch",
+        [this](const std::vector<std::string>& args, int timeout_seconds) {
+            return executeProcess(args, timeout_seconds);
+        },
+        compiler_config.compilation_timeout
+    );
+    pch_pool_->initialize(toolchains, compiler_versions_);
+}
+
+HarnessBuild ExecutionEngine::buildHarness(const std::string& id, const std::string& digest, const std::string& compiler,
+                                          const std::string& standard, const std::string& optimization, bool debug_info,
+                                          const std::vector<std::string>& extra_flags) {
+    std::string compiler_path = compilerPath(compiler);
+    auto version = compiler_versions_.find(compiler_path);
+    std::vector<std::string> flags = compileFlags(extra_flags);
+    
+    // Objects serve every compile whose translation-unit flags match; link
+    // flags such as -l do not change them
+    std::string material = compiler_path + "\n" + (version != compiler_versions_.end() ? version->second : "") + "\n" +
+                           standard + "\n" + optimization + "\n" + (debug_info ? "g" : "") + "\n";
+    for (const auto& flag : flags) {
+        material += flag + "\n";
+    }
+    std::string toolchain_key = CompilationCache::sha256Hex(material).substr(0, 16);
+    
+    return harnesses_->build(id, digest, toolchain_key,
+        [&](const std::string& source, const std::string& object, const std::string& include_directory) {
+            std::vector<std::string> source_flags = flags;
+            source_flags.push_back("-I");
+            source_flags.push_back(include_directory);
+            return buildCompileCommand(source, object, compiler, standard, optimization, debug_info, source_flags);
+        });
+}
+
+void ExecutionEngine::initializeSandbox() {
+    auto& logger = Logger::getInstance();
+    const auto& execution_config = Config::getInstance().getExecutionConfig();
+    const std::string& backend = execution_config.sandbox_backend;
+    
+    if (backend == "wasm") {
+        if (initializeWasm()) {
+            sandbox_backend_ = "wasm";
+            return;
+        }
+        logger.warning("WebAssembly runtime unavailable, trying the native sandbox", "ExecutionEngine");
+    }
+    
+    if (backend == "native" || backend == "wasm") {
+        if (Sandbox::getInstance().initialize(execution_config)) {
+            sandbox_backend_ = "native";
+            if (execution_config.sandbox_pool_max > 0) {
+                sandbox_pool_ = std::make_unique<SandboxPool>(
+                    Sandbox::getInstance(),
+                    static_cast<size_t>(execution_config.sandbox_pool_min),
+                    static_cast<size_t>(execution_config.sandbox_pool_max)
+                );
+                if (!sandbox_pool_->initialize(Sandbox::limitsFromConfig(execution_config)) &&
+                    execution_config.sandbox_pool_min > 0) {
+                    logger.warning("Sandbox pool unavailable, every run builds a fresh sandbox", "ExecutionEngine");
+                    sandbox_pool_.reset();
+                }
+            }
+            return;
+        }
+        logger.warning("Native sandbox unavailable, trying Docker", "ExecutionEngine");
+    }
+    
+    if (backend == "native" || backend == "docker" || backend == "wasm") {
+        if (initializeDocker()) {
+            sandbox_backend_ = "docker";
+            return;
+        }
+    }
+    
+    // Continue without sandbox for development
+    logger.warning("No sandbox backend available, programs will run unsandboxed", "ExecutionEngine");
+    sandbox_backend_ = "none";
+}
+
+bool ExecutionEngine::initializeWasm() {
+    auto& logger = Logger::getInstance();
+    const auto& config = Config::getInstance();
+    const std::string& wasi_clang = config.getCompilerConfig().wasi_clang_path;
+    
+    if (!std::filesystem::exists(wasi_clang)) {
+        logger.warning("wasi-sdk clang++ not found: " + wasi_clang, "ExecutionEngine");
+        return false;
+    }
+    
+    auto runtime = std::make_unique<WasmRuntime>(static_cast<size_t>(config.getExecutionConfig().wasm_workers));
+    if (!runtime->initialize()) {
+        return false;
+    }
+    
+    // Joins the compile cache key and harness toolchain keys like the host compilers;
+    // wasm-ld is the only linker, so linkers_ gets no entry
+    compiler_versions_[wasi_clang] = queryCompilerVersion(wasi_clang);
+    wasm_ = std::move(runtime);
+    return true;
+}
+
+std::string ExecutionEngine::compilerPath(const std::string& compiler) const {
+    const auto& compiler_config = Config::getInstance().getCompilerConfig();
+    if (sandbox_backend_ == "wasm") {
+        return compiler_config.wasi_clang_path;
+    }
+    return isClang(compiler) ? compiler_config.clang_path : compiler_config.compiler_path;
+}
+
 bool ExecutionEngine::initializeDocker() {
     auto& logger = Logger::getInstance();
     
@@ -293,8 +1505,10 @@ int main() {
 }
 )";
         
-        nlohmann::json options;
+        // Bypass the cache so a broken toolchain cannot hide behind old entries
+        nlohmann::json options = {{"cache", false}};
         CompilationResult result = compile(test_code, options);
+        releaseCompilation(result);
         
         if (!result.success) {
             logger.error("Test compilation failed", "ExecutionEngine");
@@ -330,18 +1544,13 @@ std::vector<std::string> ExecutionEngine::buildCompileCommand(
     const std::string& standard,
     const std::string& optimization,
     bool debug_info,
-    const std::vector<std::string>& extra_flags) {
-    
-    auto& config = Config::getInstance();
+    const std::vector<std::string>& extra_flags,
+    const std::string& pch_header) {
     
     std::vector<std::string> args;
     
     // Compiler path
-    if (compiler == "clang++") {
-        args.push_back(config.getCompilerConfig().clang_path);
-    } else {
-        args.push_back(config.getCompilerConfig().compiler_path);
-    }
+    args.push_back(compilerPath(compiler));
     
     // Standard
     args.push_back("-std=" + standard);
@@ -360,11 +1569,24 @@ std::vector<std::string> ExecutionEngine::buildCompileCommand(
     args.push_back("-pedantic");
     
     // Extra flags
-    for (const auto& flag : extra_flags) {
+    for (const auto& flag : compileFlags(extra_flags)) {
         args.push_back(flag);
     }
     
-    // Source and output
+    // Precompiled header; the compiler picks up the adjacent .gch/.pch
+    if (!pch_header.empty()) {
+        args.push_back("-include");
+        args.push_back(pch_header);
+    }
+    
+    // Source and object; "-" reads the source from stdin, and -pipe keeps
+    // the intermediate assembly out of TMPDIR as well
+    args.push_back("-c");
+    if (source_file == "-") {
+        args.push_back("-pipe");
+        args.push_back("-x");
+        args.push_back("c++");
+    }
     args.push_back(source_file);
     args.push_back("-o");
     args.push_back(output_file);
@@ -372,120 +1594,183 @@ std::vector<std::string> ExecutionEngine::buildCompileCommand(
     return args;
 }
 
-ProcessResult ExecutionEngine::executeProcess(const std::vector<std::string>& args, int timeout_seconds) {
-    ProcessResult result;
-    result.exit_code = -1;
+std::vector<std::string> ExecutionEngine::buildLinkCommand(
+    const std::string& object_file,
+    const std::string& output_file,
+    const std::string& compiler_path,
+    const std::vector<std::string>& extra_flags,
+    const std::vector<std::string>& extra_objects) {
     
-    if (args.empty()) {
-        return result;
+    std::vector<std::string> args = {compiler_path};
+    
+    auto linker = linkers_.find(compiler_path);
+    if (linker != linkers_.end() && !linker->second.empty()) {
+        args.push_back("-fuse-ld=" + linker->second);
     }
     
-    // Convert args to char* array
-    std::vector<char*> c_args;
-    for (const auto& arg : args) {
-        c_args.push_back(const_cast<char*>(arg.c_str()));
+    // Driver flags such as -pthread or -fsanitize= matter to both steps
+    for (const auto& flag : linkFlags(extra_flags)) {
+        args.push_back(flag);
     }
-    c_args.push_back(nullptr);
     
-    int stdout_pipe[2], stderr_pipe[2];
+    args.push_back(object_file);
+    args.insert(args.end(), extra_objects.begin(), extra_objects.end());
+    args.push_back("-o");
+    args.push_back(output_file);
     
-    if (pipe(stdout_pipe) == -1 || pipe(stderr_pipe) == -1) {
-        return result;
-    }
+    return args;
+}
+
+ProcessResult ExecutionEngine::executeProcess(const std::vector<std::string>& args, int timeout_seconds, std::string_view input,
+                                              std::shared_ptr<CancellationToken> cancellation) {
+    ProcessOptions process_options;
+    process_options.args = args;
+    process_options.timeout = std::chrono::seconds(timeout_seconds);
+    process_options.stdin_data = input;
+    process_options.cancellation = std::move(cancellation);
     
-    pid_t pid = fork();
-    if (pid == -1) {
-        close(stdout_pipe[0]); close(stdout_pipe[1]);
-        close(stderr_pipe[0]); close(stderr_pipe[1]);
-        return result;
+    return ProcessSupervisor::getInstance().run(process_options);
+}
+
+ProcessResult ExecutionEngine::runExecutable(const std::string& executable_path, std::string_view input,
+                                            const ExecutionConfig& limits, const OutputCallback& on_output,
+                                            std::shared_ptr<CancellationToken> cancellation) {
+    if (Config::getInstance().getExecutionConfig().sandbox_enabled) {
+        return executeInSandbox(executable_path, input, limits, on_output, std::move(cancellation));
+    }
+    return executeDirectly(executable_path, input, limits, on_output, std::move(cancellation));
+}
+
+void ExecutionEngine::releaseCompilation(const CompilationResult& compilation) {
+    if (compilation.executable_path.empty()) {
+        return;
     }
     
-    if (pid == 0) {
-        // Child process
-        close(stdout_pipe[0]);
-        close(stderr_pipe[0]);
-        
-        dup2(stdout_pipe[1], STDOUT_FILENO);
-        dup2(stderr_pipe[1], STDERR_FILENO);
-        
-        close(stdout_pipe[1]);
-        close(stderr_pipe[1]);
-        
-        execvp(c_args[0], c_args.data());
-        exit(127); // execvp failed
-    } else {
-        // Parent process
-        close(stdout_pipe[1]);
-        close(stderr_pipe[1]);
-        
-        // Set alarm for timeout
-        alarm(timeout_seconds);
-        
-        int status;
-        pid_t wait_result = waitpid(pid, &status, 0);
-        
-        alarm(0); // Cancel alarm
-        
-        if (wait_result == -1) {
-            // Timeout or other error
-            kill(pid, SIGTERM);
-            waitpid(pid, nullptr, 0);
-            result.exit_code = -1;
-        } else {
-            result.exit_code = WEXITSTATUS(status);
-        }
-        
-        // Read output
-        char buffer[4096];
-        ssize_t bytes_read;
-        
-        while ((bytes_read = read(stdout_pipe[0], buffer, sizeof(buffer) - 1)) > 0) {
-            buffer[bytes_read] = '\0';
-            result.stdout += buffer;
+    {
+        std::lock_guard<std::mutex> lock(workspace_mutex_);
+        if (memory_workspaces_.erase(compilation.executable_path) > 0) {
+            return;
         }
-        
-        while ((bytes_read = read(stderr_pipe[0], buffer, sizeof(buffer) - 1)) > 0) {
-            buffer[bytes_read] = '\0';
-            result.stderr += buffer;
-        }
-        
-        close(stdout_pipe[0]);
-        close(stderr_pipe[0]);
     }
     
-    return result;
+    // Emptied and recycled in the background; unknown paths are ignored
+    WorkspaceManager::getInstance().release(std::filesystem::path(compilation.executable_path).parent_path().string());
 }
 
-ProcessResult ExecutionEngine::executeInSandbox(const std::string& executable_path, const std::string& input, const nlohmann::json& options) {
-    auto& config = Config::getInstance();
+ProcessResult ExecutionEngine::executeInSandbox(const std::string& executable_path, std::string_view input,
+                                               const ExecutionConfig& execution_config, const OutputCallback& on_output,
+                                               std::shared_ptr<CancellationToken> cancellation) {
+    std::string absolute_path = std::filesystem::absolute(executable_path).string();
     
-    std::vector<std::string> docker_args = {
-        "docker", "run", "--rm", "-i",
-        "--memory=" + std::to_string(config.getExecutionConfig().max_memory_mb) + "m",
-        "--cpus=" + std::to_string(config.getExecutionConfig().max_cpu_time),
-        "--network=none",
-        "--user=nobody",
-        "-v", std::filesystem::absolute(executable_path) + ":/app/program:ro",
-        config.getExecutionConfig().docker_image,
-        "/app/program"
-    };
+    // The executable is a wasm32-wasi module; the runtime is the sandbox
+    if (sandbox_backend_ == "wasm") {
+        return wasm_->run(
+            absolute_path,
+            input,
+            WasmRuntime::limitsFromConfig(execution_config),
+            on_output,
+            std::move(cancellation)
+        );
+    }
     
-    // TODO: Implement proper Docker execution with input handling
-    // For now, fall back to direct execution
-    return executeDirectly(executable_path, input, options);
+    if (sandbox_backend_ == "native" && sandbox_pool_) {
+        return sandbox_pool_->run(
+            absolute_path,
+            input,
+            Sandbox::limitsFromConfig(execution_config),
+            std::chrono::seconds(execution_config.execution_timeout),
+            on_output,
+            std::move(cancellation)
+        );
+    }
+    
+    if (sandbox_backend_ == "native") {
+        return Sandbox::getInstance().run(
+            {absolute_path},
+            Sandbox::limitsFromConfig(execution_config),
+            std::chrono::seconds(execution_config.execution_timeout),
+            input,
+            on_output,
+            std::move(cancellation)
+        );
+    }
+    
+    if (sandbox_backend_ == "docker") {
+        std::vector<std::string> docker_args = {
+            "docker", "run", "--rm", "-i",
+            "--memory=" + std::to_string(execution_config.max_memory_mb) + "m",
+            "--cpus=" + std::to_string(execution_config.max_cpu_time),
+            "--network=none",
+            "--user=nobody",
+            "-v", absolute_path + ":/app/program:ro",
+            execution_config.docker_image,
+            "/app/program"
+        };
+        ProcessOptions process_options;
+        process_options.args = docker_args;
+        process_options.timeout = std::chrono::seconds(execution_config.execution_timeout);
+        process_options.stdin_data = input;
+        process_options.max_output_bytes = execution_config.max_output_size;
+        process_options.on_output = on_output;
+        process_options.cancellation = std::move(cancellation);
+        return ProcessSupervisor::getInstance().run(process_options);
+    }
+    
+    return executeDirectly(executable_path, input, execution_config, on_output, std::move(cancellation));
 }
 
-ProcessResult ExecutionEngine::executeDirectly(const std::string& executable_path, const std::string& input, const nlohmann::json& options) {
-    auto& config = Config::getInstance();
+ProcessResult ExecutionEngine::executeDirectly(const std::string& executable_path, std::string_view input,
+                                              const ExecutionConfig& execution_config, const OutputCallback& on_output,
+                                              std::shared_ptr<CancellationToken> cancellation) {
+    SandboxLimits limits = Sandbox::limitsFromConfig(execution_config);
     
-    std::vector<std::string> args = {executable_path};
+    ProcessOptions process_options;
+    process_options.args = {executable_path};
+    process_options.timeout = std::chrono::seconds(execution_config.execution_timeout);
+    process_options.stdin_data = input;
+    process_options.max_output_bytes = limits.max_output_bytes;
+    process_options.on_output = on_output;
+    process_options.cancellation = std::move(cancellation);
     
-    ProcessResult result = executeProcess(args, config.getExecutionConfig().execution_timeout);
+    // Unsandboxed runs still get the configured CPU, memory and file size limits
+    process_options.pre_exec = [limits]() {
+        Sandbox::applyResourceLimits(limits, true);
+        return true;
+    };
     
-    // TODO: Implement proper input handling and resource monitoring
-    // This is a simplified implementation
+    return ProcessSupervisor::getInstance().run(process_options);
+}
+
+ExecutionStatus ExecutionEngine::classifyExit(const ProcessResult& result, const ExecutionConfig& config) {
+    long memory_limit_kb = static_cast<long>(config.max_memory_mb) * 1024;
     
-    return result;
+    if (result.cancelled) {
+        return ExecutionStatus::CANCELLED;
+    }
+    if (result.timed_out) {
+        return ExecutionStatus::TIME_LIMIT_EXCEEDED;
+    }
+    if (result.output_truncated || result.term_signal == SIGXFSZ) {
+        return ExecutionStatus::OUTPUT_LIMIT_EXCEEDED;
+    }
+    if (result.oom_killed) {
+        return ExecutionStatus::MEMORY_LIMIT_EXCEEDED;
+    }
+    // RLIMIT_CPU sends SIGXCPU at the soft limit and SIGKILL at the hard one
+    if (result.term_signal == SIGXCPU ||
+        (result.term_signal == SIGKILL && config.max_cpu_time > 0 && result.cpu_time_ms >= config.max_cpu_time * 1000L)) {
+        return ExecutionStatus::CPU_LIMIT_EXCEEDED;
+    }
+    if (result.exit_code == 0) {
+        return ExecutionStatus::OK;
+    }
+    // Under RLIMIT_AS the program sees failed allocations rather than an OOM kill;
+    // an uncaught bad_alloc aborts. The text alone is whatever the program printed.
+    if ((result.term_signal == SIGABRT && result.stderr.find("std::bad_alloc") != std::string::npos) ||
+        (result.term_signal != 0 && memory_limit_kb > 0 && result.memory_usage_kb >= memory_limit_kb * 9 / 10)) {
+        return ExecutionStatus::MEMORY_LIMIT_EXCEEDED;
+    }
+    return ExecutionStatus::RUNTIME_ERROR;
 }
 
 void ExecutionEngine::parseCompilerMessages(const std::string& compiler_output, std::vector<std::string>& warnings, std::vector<std::string>& errors) {
@@ -501,14 +1786,4 @@ void ExecutionEngine::parseCompilerMessages(const std::string& compiler_output,
     }
 }
 
-void ExecutionEngine::cleanupSession(const std::string& session_dir) {
-    try {
-        if (std::filesystem::exists(session_dir)) {
-            std::filesystem::remove_all(session_dir);
-        }
-    } catch (const std::exception& e) {
-        Logger::getInstance().warning("Failed to cleanup session: " + std::string(e.what()), "ExecutionEngine");
-    }
-}
-
 } // namespace cpp_mastery
\ No newline at end of file
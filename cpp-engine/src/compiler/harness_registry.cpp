@@ -0,0 +1,377 @@
+// File: cpp-engine/src/compiler/harness_registry.cpp
+// Extension: .cpp
+
+#include "compiler/harness_registry.hpp"
+#include "compiler/compilation_cache.hpp"
+#include "utils/logger.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <cctype>
+#include <algorithm>
+#include <stdexcept>
+
+namespace cpp_mastery {
+
+namespace {
+
+// Length of the content digest used as a directory name
+constexpr size_t kDigestLength = 32;
+
+void appendField(std::string& material, const std::string& field) {
+    material += std::to_string(field.size());
+    material += ':';
+    material += field;
+    material += ';';
+}
+
+std::string stagingSuffix() {
+    return ".tmp-" + std::to_string(std::random_device{}());
+}
+
+void writeFile(const std::filesystem::path& path, const std::string& content) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to write " + path.string());
+    }
+    file << content;
+}
+
+std::vector<HarnessFile> sortedByName(std::vector<HarnessFile> files, const char* kind) {
+    std::sort(files.begin(), files.end(), [](const HarnessFile& a, const HarnessFile& b) { return a.name < b.name; });
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (!HarnessRegistry::validName(files[i].name)) {
+            throw std::invalid_argument(std::string("Invalid harness ") + kind + " name: " + files[i].name);
+        }
+        if (i > 0 && files[i].name == files[i - 1].name) {
+            throw std::invalid_argument(std::string("Duplicate harness ") + kind + ": " + files[i].name);
+        }
+    }
+    return files;
+}
+
+} // namespace
+
+HarnessRegistry::HarnessRegistry(std::filesystem::path root, ProcessRunner runner, int build_timeout_seconds)
+    : root_(std::move(root)), runner_(std::move(runner)), build_timeout_seconds_(build_timeout_seconds) {
+}
+
+void HarnessRegistry::initialize() {
+    auto& logger = Logger::getInstance();
+
+    std::error_code ec;
+    std::filesystem::create_directories(root_, ec);
+    if (ec) {
+        logger.warning("Failed to create harness directory " + root_.string() + ": " + ec.message(), "HarnessRegistry");
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : std::filesystem::directory_iterator(root_, ec)) {
+        std::string id = entry.path().filename().string();
+        if (!entry.is_directory() || !validName(id)) {
+            continue;
+        }
+
+        std::ifstream file(entry.path() / "current");
+        std::string digest;
+        std::getline(file, digest);
+        auto content_dir = contentDirectory(id, digest);
+        if (!validName(digest) || !std::filesystem::is_directory(content_dir)) {
+            continue;
+        }
+        harnesses_[id] = {digest, listFiles(content_dir / "include"), listFiles(content_dir / "src")};
+    }
+
+    logger.info("Loaded " + std::to_string(harnesses_.size()) + " exercise harnesses", "HarnessRegistry");
+}
+
+std::string HarnessRegistry::stage(const std::string& id, const std::vector<HarnessFile>& headers,
+                                   const std::vector<HarnessFile>& sources) {
+    if (!validName(id)) {
+        throw std::invalid_argument("Invalid harness id: " + id);
+    }
+    if (sources.empty()) {
+        throw std::invalid_argument("A harness needs at least one source file");
+    }
+    std::vector<HarnessFile> sorted_headers = sortedByName(headers, "header");
+    std::vector<HarnessFile> sorted_sources = sortedByName(sources, "source");
+
+    std::string material;
+    appendField(material, "v1");
+    for (const auto& [files, kind] : {std::pair{&sorted_headers, "include"}, std::pair{&sorted_sources, "src"}}) {
+        appendField(material, kind);
+        for (const auto& file : *files) {
+            appendField(material, file.name);
+            appendField(material, file.content);
+        }
+    }
+    std::string digest = CompilationCache::sha256Hex(material).substr(0, kDigestLength);
+
+    // Content-addressed, so an existing directory already holds these files
+    auto content_dir = contentDirectory(id, digest);
+    if (std::filesystem::is_directory(content_dir)) {
+        return digest;
+    }
+
+    auto staging = content_dir;
+    staging += stagingSuffix();
+    std::error_code ec;
+    try {
+        std::filesystem::create_directories(staging / "include");
+        std::filesystem::create_directories(staging / "src");
+        for (const auto& header : sorted_headers) {
+            writeFile(staging / "include" / header.name, header.content);
+        }
+        for (const auto& source : sorted_sources) {
+            writeFile(staging / "src" / source.name, source.content);
+        }
+    } catch (const std::exception&) {
+        std::filesystem::remove_all(staging, ec);
+        throw;
+    }
+
+    std::filesystem::rename(staging, content_dir, ec);
+    if (ec) {
+        // Lost a race with an identical registration
+        std::filesystem::remove_all(staging, ec);
+    }
+    return digest;
+}
+
+void HarnessRegistry::activate(const std::string& id, const std::string& digest) {
+    auto content_dir = contentDirectory(id, digest);
+
+    // Written aside and renamed so a restart never reads half a digest
+    auto pointer = root_ / id / "current";
+    auto staging = pointer;
+    staging += stagingSuffix();
+    writeFile(staging, digest + "\n");
+    std::filesystem::rename(staging, pointer);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    harnesses_[id] = {digest, listFiles(content_dir / "include"), listFiles(content_dir / "src")};
+    Logger::getInstance().info("Registered harness " + id + " (" + digest + ")", "HarnessRegistry");
+}
+
+std::optional<std::string> HarnessRegistry::current(const std::string& id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = harnesses_.find(id);
+    if (it == harnesses_.end()) {
+        return std::nullopt;
+    }
+    return it->second.digest;
+}
+
+std::optional<std::string> HarnessRegistry::includeDirectory(const std::string& id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = harnesses_.find(id);
+    if (it == harnesses_.end()) {
+        return std::nullopt;
+    }
+    return (contentDirectory(id, it->second.digest) / "include").string();
+}
+
+bool HarnessRegistry::remove(const std::string& id) {
+    if (!validName(id)) {
+        return false;
+    }
+
+    bool found = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        found = harnesses_.erase(id) > 0;
+        std::string prefix = (root_ / id).string() + "/";
+        for (auto it = builds_.begin(); it != builds_.end();) {
+            it = (it->first.rfind(prefix, 0) == 0) ? builds_.erase(it) : std::next(it);
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::remove_all(root_ / id, ec);
+    if (found) {
+        Logger::getInstance().info("Removed harness " + id, "HarnessRegistry");
+    }
+    return found;
+}
+
+HarnessBuild HarnessRegistry::build(const std::string& id, const std::string& digest, const std::string& toolchain_key,
+                                    const CommandBuilder& command) {
+    auto content_dir = contentDirectory(id, digest);
+    std::string key = content_dir.string() + "/" + toolchain_key;
+
+    // The first caller for a key builds; the rest wait for its objects
+    std::promise<HarnessBuild> promise;
+    std::shared_future<HarnessBuild> pending;
+    bool leader = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = builds_.find(key);
+        if (it != builds_.end()) {
+            pending = it->second;
+        } else {
+            pending = promise.get_future().share();
+            builds_.emplace(key, pending);
+            leader = true;
+        }
+    }
+
+    if (!leader) {
+        HarnessBuild shared = pending.get();
+        shared.built = false;
+        if (shared.success) {
+            reuses_++;
+        }
+        return shared;
+    }
+
+    HarnessBuild result;
+    try {
+        if (!std::filesystem::is_directory(content_dir / "src")) {
+            throw std::runtime_error("Harness " + id + " is not registered");
+        }
+        result = compileObjects(content_dir, toolchain_key, listFiles(content_dir / "src"), command);
+    } catch (const std::exception& e) {
+        result.success = false;
+        result.compiler_output = e.what();
+    }
+
+    if (!result.success) {
+        build_failures_++;
+        std::lock_guard<std::mutex> lock(mutex_);
+        builds_.erase(key);
+    }
+    promise.set_value(result);
+    return result;
+}
+
+HarnessBuild HarnessRegistry::compileObjects(const std::filesystem::path& content_dir, const std::string& toolchain_key,
+                                             const std::vector<std::string>& sources, const CommandBuilder& command) {
+    HarnessBuild result;
+    result.include_directory = (content_dir / "include").string();
+    result.digest = content_dir.filename().string() + "-" + toolchain_key;
+
+    auto object_dir = content_dir / ("obj-" + toolchain_key);
+    for (const auto& source : sources) {
+        result.objects.push_back((object_dir / (source + ".o")).string());
+    }
+
+    // Built by an earlier run of the server
+    if (std::filesystem::is_directory(object_dir)) {
+        reuses_++;
+        result.success = true;
+        return result;
+    }
+
+    auto staging = object_dir;
+    staging += stagingSuffix();
+    std::filesystem::create_directories(staging);
+
+    // Sources are independent, so compile them in parallel
+    auto start_time = std::chrono::steady_clock::now();
+    std::vector<std::future<ProcessResult>> compiles;
+    for (const auto& source : sources) {
+        std::vector<std::string> args = command((content_dir / "src" / source).string(),
+                                                (staging / (source + ".o")).string(),
+                                                result.include_directory);
+        compiles.push_back(std::async(std::launch::async, [this, args = std::move(args)]() {
+            return runner_(args, build_timeout_seconds_);
+        }));
+    }
+
+    bool failed = false;
+    for (size_t i = 0; i < compiles.size(); ++i) {
+        ProcessResult compiled = compiles[i].get();
+        if (compiled.exit_code != 0) {
+            failed = true;
+            result.compiler_output += sources[i] + ":\n" + compiled.stderr + compiled.stdout;
+        }
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time).count();
+
+    std::error_code ec;
+    if (failed) {
+        std::filesystem::remove_all(staging, ec);
+        Logger::getInstance().warning("Harness build failed in " + content_dir.string() + ": " +
+                                      result.compiler_output.substr(0, 500), "HarnessRegistry");
+        return result;
+    }
+
+    std::filesystem::rename(staging, object_dir, ec);
+    if (ec) {
+        std::filesystem::remove_all(staging, ec);
+        if (!std::filesystem::is_directory(object_dir)) {
+            result.compiler_output = "Failed to store harness objects in " + object_dir.string();
+            return result;
+        }
+    }
+
+    builds_run_++;
+    result.success = true;
+    result.built = true;
+    Logger::getInstance().info("Built harness " + object_dir.string() + " in " + std::to_string(elapsed) + "ms", "HarnessRegistry");
+    return result;
+}
+
+nlohmann::json HarnessRegistry::list() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    nlohmann::json harnesses = nlohmann::json::array();
+    for (const auto& [id, registration] : harnesses_) {
+        size_t toolchains = 0;
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(contentDirectory(id, registration.digest), ec)) {
+            std::string name = entry.path().filename().string();
+            if (name.rfind("obj-", 0) == 0 && name.find(".tmp-") == std::string::npos) {
+                toolchains++;
+            }
+        }
+        harnesses.push_back({
+            {"id", id},
+            {"digest", registration.digest},
+            {"headers", registration.headers},
+            {"sources", registration.sources},
+            {"toolchains", toolchains}
+        });
+    }
+    return harnesses;
+}
+
+nlohmann::json HarnessRegistry::getStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return nlohmann::json{
+        {"enabled", true},
+        {"harnesses", harnesses_.size()},
+        {"builds", builds_run_.load()},
+        {"build_failures", build_failures_.load()},
+        {"reuses", reuses_.load()}
+    };
+}
+
+bool HarnessRegistry::validName(const std::string& name) {
+    if (name.empty() || name.size() > 128 || name == "." || name == "..") {
+        return false;
+    }
+    return std::all_of(name.begin(), name.end(), [](char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' || c == '.';
+    });
+}
+
+std::filesystem::path HarnessRegistry::contentDirectory(const std::string& id, const std::string& digest) const {
+    return root_ / id / digest;
+}
+
+std::vector<std::string> HarnessRegistry::listFiles(const std::filesystem::path& directory) {
+    std::vector<std::string> names;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+        if (entry.is_regular_file()) {
+            names.push_back(entry.path().filename().string());
+        }
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+} // namespace cpp_mastery
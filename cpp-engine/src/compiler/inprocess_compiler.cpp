@@ -0,0 +1,303 @@
+// File: cpp-engine/src/compiler/inprocess_compiler.cpp
+// Extension: .cpp
+
+#include "compiler/inprocess_compiler.hpp"
+#include "parser/source_file_system.hpp"
+#include "utils/logger.hpp"
+
+#include <clang/Basic/Diagnostic.h>
+#include <clang/Basic/DiagnosticOptions.h>
+#include <clang/Basic/Version.h>
+#include <clang/CodeGen/CodeGenAction.h>
+#include <clang/Driver/Compilation.h>
+#include <clang/Driver/Driver.h>
+#include <clang/Driver/Job.h>
+#include <clang/Driver/Tool.h>
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/CompilerInvocation.h>
+#include <clang/Frontend/TextDiagnosticPrinter.h>
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/CrashRecoveryContext.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+#ifdef HAVE_LLD
+#include <lld/Common/Driver.h>
+#endif
+
+#include <chrono>
+#include <fstream>
+
+namespace cpp_mastery {
+
+namespace {
+
+// Stack of the frontend thread; deeply nested templates recurse far past the default
+constexpr unsigned kFrontendStackSize = 8 * 1024 * 1024;
+
+void initializeLlvm() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+        llvm::InitializeNativeTargetAsmParser();
+        llvm::CrashRecoveryContext::Enable();
+    });
+}
+
+// Driver arguments as C strings, in g++ mode whatever clang_path is called
+std::vector<const char*> driverArguments(const std::vector<std::string>& args) {
+    std::vector<const char*> argv;
+    for (size_t i = 0; i < args.size(); ++i) {
+        argv.push_back(args[i].c_str());
+        if (i == 0) {
+            argv.push_back("--driver-mode=g++");
+            argv.push_back("-fno-color-diagnostics");
+        }
+    }
+    return argv;
+}
+
+// Plans the jobs for a command line and returns the only one, or null
+const clang::driver::Command* singleJob(clang::driver::Compilation* compilation) {
+    if (!compilation || compilation->containsError() || compilation->getJobs().size() != 1) {
+        return nullptr;
+    }
+    return llvm::dyn_cast<clang::driver::Command>(&*compilation->getJobs().begin());
+}
+
+ProcessResult failure(int exit_code, std::string message) {
+    ProcessResult result;
+    result.exit_code = exit_code;
+    result.stderr = std::move(message);
+    return result;
+}
+
+} // namespace
+
+InProcessCompiler::InProcessCompiler(std::string clang_path, ProcessRunner runner)
+    : clang_path_(std::move(clang_path)), runner_(std::move(runner)) {
+}
+
+ProcessResult InProcessCompiler::compile(const std::vector<std::string>& args, std::string_view code,
+                                         const std::string& object_file,
+                                         const std::shared_ptr<CancellationToken>& cancellation) {
+    // Object code goes to memory and is copied to object_file afterwards,
+    // which may be a memfd that cannot take a rename
+    std::string object;
+    ProcessResult result = emit(args, code, false, object, cancellation);
+    if (result.exit_code != 0) {
+        return result;
+    }
+
+    std::ofstream output(object_file, std::ios::binary | std::ios::trunc);
+    output.write(object.data(), static_cast<std::streamsize>(object.size()));
+    output.close();
+    if (!output) {
+        return failure(-1, "Failed to write object file " + object_file);
+    }
+    return result;
+}
+
+ProcessResult InProcessCompiler::compileToBitcode(const std::vector<std::string>& args, std::string_view code,
+                                                  std::string& bitcode,
+                                                  const std::shared_ptr<CancellationToken>& cancellation) {
+    return emit(args, code, true, bitcode, cancellation);
+}
+
+ProcessResult InProcessCompiler::emit(const std::vector<std::string>& args, std::string_view code, bool bitcode,
+                                      std::string& output, const std::shared_ptr<CancellationToken>& cancellation) {
+    if (cancellation && cancellation->cancelled()) {
+        ProcessResult result = failure(-1, "");
+        result.cancelled = true;
+        return result;
+    }
+    initializeLlvm();
+    compiles_++;
+    auto start_time = std::chrono::steady_clock::now();
+
+    std::string diagnostics;
+    llvm::raw_string_ostream diagnostic_stream(diagnostics);
+
+    // The submission comes from memory; headers from the shared header cache underneath
+    auto files = SourceFileSystem::forSource(kSourceName, code);
+
+    // Let the driver turn the g++-style command line into the cc1 invocation
+    llvm::IntrusiveRefCntPtr<clang::DiagnosticOptions> driver_options = new clang::DiagnosticOptions();
+    clang::DiagnosticsEngine driver_diagnostics(
+        llvm::IntrusiveRefCntPtr<clang::DiagnosticIDs>(new clang::DiagnosticIDs()), &*driver_options,
+        new clang::TextDiagnosticPrinter(diagnostic_stream, &*driver_options));
+    clang::driver::Driver driver(clang_path_, llvm::sys::getDefaultTargetTriple(), driver_diagnostics,
+                                 "clang LLVM compiler", files);
+    std::vector<const char*> argv = driverArguments(args);
+    std::unique_ptr<clang::driver::Compilation> compilation(driver.BuildCompilation(argv));
+    const clang::driver::Command* cc1 = singleJob(compilation.get());
+    if (!cc1 || llvm::StringRef(cc1->getCreator().getName()) != "clang") {
+        failed_compiles_++;
+        diagnostic_stream.flush();
+        return failure(1, diagnostics.empty() ? "Unsupported command line for the in-process compiler" : diagnostics);
+    }
+
+    // cc1 arguments without the leading -cc1, as cc1_main sees them
+    llvm::ArrayRef<const char*> cc1_args = cc1->getArguments();
+    if (!cc1_args.empty() && llvm::StringRef(cc1_args.front()) == "-cc1") {
+        cc1_args = cc1_args.drop_front();
+    }
+
+    auto instance = std::make_unique<clang::CompilerInstance>();
+    bool parsed = clang::CompilerInvocation::CreateFromArgs(instance->getInvocation(), cc1_args, driver_diagnostics);
+    instance->createDiagnostics(new clang::TextDiagnosticPrinter(diagnostic_stream, &instance->getDiagnosticOpts()), true);
+    instance->setVerboseOutputStream(diagnostic_stream);
+    instance->createFileManager(files);
+
+    llvm::SmallString<0> emitted;
+    instance->setOutputStream(std::make_unique<llvm::raw_svector_ostream>(emitted));
+
+    bool succeeded = false;
+    bool survived = true;
+    std::unique_ptr<clang::FrontendAction> action;
+    if (parsed) {
+        if (bitcode) {
+            action = std::make_unique<clang::EmitBCAction>();
+        } else {
+            action = std::make_unique<clang::EmitObjAction>();
+        }
+        llvm::CrashRecoveryContext recovery;
+        survived = recovery.RunSafelyOnThread([&] { succeeded = instance->ExecuteAction(*action); }, kFrontendStackSize);
+    }
+
+    ProcessResult result;
+    result.wall_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time).count();
+
+    if (!survived) {
+        // State left behind by the crash is not safe to destroy
+        action.release();
+        instance.release();
+        crashes_++;
+        diagnostic_stream << "internal compiler error: the in-process compiler crashed\n";
+        diagnostic_stream.flush();
+        Logger::getInstance().error("In-process Clang crashed", "InProcessCompiler");
+        result.exit_code = -1;
+        result.stderr = diagnostics;
+        return result;
+    }
+
+    diagnostic_stream.flush();
+    result.stderr = diagnostics;
+    result.exit_code = (parsed && succeeded) ? 0 : 1;
+    if (result.exit_code != 0) {
+        failed_compiles_++;
+        return result;
+    }
+
+    output.assign(emitted.data(), emitted.size());
+    return result;
+}
+
+ProcessResult InProcessCompiler::link(const std::vector<std::string>& args, int timeout_seconds,
+                                      std::shared_ptr<CancellationToken> cancellation) {
+    if (cancellation && cancellation->cancelled()) {
+        ProcessResult result = failure(-1, "");
+        result.cancelled = true;
+        return result;
+    }
+    initializeLlvm();
+
+    // The driver works out the crt objects, library paths and linker to use
+    std::string diagnostics;
+    llvm::raw_string_ostream diagnostic_stream(diagnostics);
+    llvm::IntrusiveRefCntPtr<clang::DiagnosticOptions> driver_options = new clang::DiagnosticOptions();
+    clang::DiagnosticsEngine driver_diagnostics(
+        llvm::IntrusiveRefCntPtr<clang::DiagnosticIDs>(new clang::DiagnosticIDs()), &*driver_options,
+        new clang::TextDiagnosticPrinter(diagnostic_stream, &*driver_options));
+    clang::driver::Driver driver(clang_path_, llvm::sys::getDefaultTargetTriple(), driver_diagnostics);
+    std::vector<const char*> argv = driverArguments(args);
+    std::unique_ptr<clang::driver::Compilation> compilation(driver.BuildCompilation(argv));
+    const clang::driver::Command* linker = singleJob(compilation.get());
+    if (!linker) {
+        diagnostic_stream.flush();
+        return failure(1, diagnostics.empty() ? "Unsupported command line for the in-process linker" : diagnostics);
+    }
+
+    std::vector<std::string> command = {linker->getExecutable()};
+    for (const char* arg : linker->getArguments()) {
+        command.push_back(arg);
+    }
+
+#ifdef HAVE_LLD
+    if (lld_usable_ && llvm::sys::path::filename(linker->getExecutable()) == "ld.lld") {
+        // Writing the output in place works for memfd paths, which cannot be renamed over
+        command.push_back("--no-mmap-output-file");
+        // A fatal error exits the process unless it happens on this thread,
+        // inside the recovery context
+        command.push_back("--threads=1");
+        std::vector<const char*> lld_argv;
+        for (const auto& arg : command) {
+            lld_argv.push_back(arg.c_str());
+        }
+
+        auto start_time = std::chrono::steady_clock::now();
+        std::string output;
+        llvm::raw_string_ostream output_stream(output);
+        bool linked = false;
+        bool returned = false;
+        {
+            std::lock_guard<std::mutex> lock(link_mutex_);
+            // Bad -Wl flags can make LLD call exit(); this turns that into a return
+            llvm::CrashRecoveryContext recovery;
+            returned = recovery.RunSafely([&]() {
+                linked = lld::elf::link(lld_argv, output_stream, diagnostic_stream, false, false);
+            });
+        }
+
+        if (returned) {
+            in_process_links_++;
+            output_stream.flush();
+            diagnostic_stream.flush();
+            ProcessResult result;
+            result.exit_code = linked ? 0 : 1;
+            result.stdout = output;
+            result.stderr = diagnostics;
+            result.wall_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time).count();
+            return result;
+        }
+
+        // LLD's globals are left half torn down, so it is not run again; this
+        // link and later ones start the linker instead, which reports the error
+        lld_usable_ = false;
+        crashes_++;
+        Logger::getInstance().error("In-process LLD exited, linking with " + command[0] + " from now on", "InProcessCompiler");
+    }
+#endif
+
+    external_links_++;
+    return runner_(command, timeout_seconds, std::move(cancellation));
+}
+
+std::string InProcessCompiler::version() {
+    return clang::getClangFullVersion();
+}
+
+nlohmann::json InProcessCompiler::getStatistics() const {
+    return nlohmann::json{
+        {"enabled", true},
+        {"version", version()},
+        {"compiles", compiles_.load()},
+        {"failed_compiles", failed_compiles_.load()},
+        {"crashes", crashes_.load()},
+        {"in_process_links", in_process_links_.load()},
+        {"external_links", external_links_.load()},
+#ifdef HAVE_LLD
+        {"lld", lld_usable_.load()}
+#else
+        {"lld", false}
+#endif
+    };
+}
+
+} // namespace cpp_mastery
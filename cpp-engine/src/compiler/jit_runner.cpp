@@ -0,0 +1,138 @@
+// File: cpp-engine/src/compiler/jit_runner.cpp
+// Extension: .cpp
+
+#include "compiler/jit_runner.hpp"
+
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/ExecutionEngine/JITSymbol.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/TargetSelect.h>
+
+#include <string>
+#include <cerrno>
+#include <cstdio>
+#include <unistd.h>
+
+namespace cpp_mastery {
+
+namespace {
+
+bool readAll(int fd, std::string& data) {
+    char buffer[64 * 1024];
+    for (;;) {
+        ssize_t bytes = read(fd, buffer, sizeof(buffer));
+        if (bytes == 0) {
+            return true;
+        }
+        if (bytes == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data.append(buffer, static_cast<size_t>(bytes));
+    }
+}
+
+void report(int fd, const std::string& message) {
+    size_t written = 0;
+    while (written < message.size()) {
+        ssize_t bytes = write(fd, message.data() + written, message.size() - written);
+        if (bytes == -1 && errno == EINTR) {
+            continue;
+        }
+        if (bytes <= 0) {
+            return;
+        }
+        written += static_cast<size_t>(bytes);
+    }
+}
+
+} // namespace
+
+void JitRunner::initialize() {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+    llvm::InitializeNativeTargetAsmParser();
+}
+
+int JitRunner::run(int bitcode_fd, int status_fd) {
+    auto fail = [status_fd](const std::string& message) {
+        report(status_fd, message);
+        close(status_fd);
+        return kNotStarted;
+    };
+
+    std::string bitcode;
+    bool read_ok = readAll(bitcode_fd, bitcode);
+    close(bitcode_fd);
+    if (!read_ok) {
+        return fail("Cannot read the module");
+    }
+
+    auto context = std::make_unique<llvm::LLVMContext>();
+    auto module = llvm::parseBitcodeFile(llvm::MemoryBufferRef(bitcode, "main.bc"), *context);
+    if (!module) {
+        return fail("Invalid module: " + llvm::toString(module.takeError()));
+    }
+
+    auto jit = llvm::orc::LLJITBuilder().create();
+    if (!jit) {
+        return fail("Cannot create the JIT: " + llvm::toString(jit.takeError()));
+    }
+    llvm::orc::JITDylib& dylib = (*jit)->getMainJITDylib();
+
+    // Link errors such as missing symbols are reported here rather than by lookup()
+    std::string session_error;
+    (*jit)->getExecutionSession().setErrorReporter([&session_error](llvm::Error error) {
+        if (session_error.empty()) {
+            session_error = llvm::toString(std::move(error));
+        } else {
+            llvm::consumeError(std::move(error));
+        }
+    });
+
+    // Library calls resolve to the copies already loaded in this process
+    auto generator = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+        (*jit)->getDataLayout().getGlobalPrefix());
+    if (!generator) {
+        return fail("Cannot search process symbols: " + llvm::toString(generator.takeError()));
+    }
+    dylib.addGenerator(std::move(*generator));
+
+    if (auto error = (*jit)->addIRModule(llvm::orc::ThreadSafeModule(std::move(*module), std::move(context)))) {
+        return fail("Cannot add the module: " + llvm::toString(std::move(error)));
+    }
+
+    // Compiles and links the whole module, so unresolved symbols show up here
+    auto main_symbol = (*jit)->lookup("main");
+    if (!main_symbol) {
+        std::string lookup_error = llvm::toString(main_symbol.takeError());
+        return fail(session_error.empty() ? lookup_error : session_error);
+    }
+    report(status_fd, std::string(1, kStarted));
+    close(status_fd);
+
+    int exit_code = 1;
+    if (auto error = (*jit)->initialize(dylib)) {
+        std::fprintf(stderr, "jit: static initialization failed: %s\n", llvm::toString(std::move(error)).c_str());
+    } else {
+        char program_name[] = "main";
+        char* argv[] = {program_name, nullptr};
+        auto entry = llvm::jitTargetAddressToFunction<int (*)(int, char**)>(main_symbol->getAddress());
+        exit_code = entry(1, argv);
+        llvm::consumeError((*jit)->deinitialize(dylib));
+    }
+
+    // The caller _exit()s, which skips the stdio flush exit() would do
+    std::fflush(nullptr);
+    return exit_code;
+}
+
+} // namespace cpp_mastery
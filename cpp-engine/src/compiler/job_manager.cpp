@@ -0,0 +1,296 @@
+// File: cpp-engine/src/compiler/job_manager.cpp
+// Extension: .cpp
+
+#include "compiler/job_manager.hpp"
+#include "utils/config.hpp"
+#include "utils/logger.hpp"
+
+#include <random>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <stdexcept>
+
+namespace cpp_mastery {
+
+std::unique_ptr<JobManager> JobManager::instance_ = nullptr;
+std::mutex JobManager::instance_mutex_;
+
+namespace {
+
+long long epochMs(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+}
+
+} // namespace
+
+std::string jobStateToString(JobState state) {
+    switch (state) {
+        case JobState::QUEUED: return "queued";
+        case JobState::RUNNING: return "running";
+        case JobState::SUCCEEDED: return "succeeded";
+        case JobState::FAILED: return "failed";
+        case JobState::CANCELLED: return "cancelled";
+    }
+    return "unknown";
+}
+
+Job::Job(std::string id, std::string kind)
+    : id_(std::move(id)), kind_(std::move(kind)), created_at_(std::chrono::system_clock::now()) {
+    emitLocked({{"type", "state"}, {"state", jobStateToString(JobState::QUEUED)}});
+}
+
+void Job::markRunning() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (state_ != JobState::QUEUED) {
+        return;
+    }
+    state_ = JobState::RUNNING;
+    started_at_ = std::chrono::system_clock::now();
+    emitLocked({{"type", "state"}, {"state", jobStateToString(state_)}});
+}
+
+void Job::emit(nlohmann::json event) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    emitLocked(std::move(event));
+}
+
+void Job::emitLocked(nlohmann::json event) {
+    event["seq"] = events_.size();
+    events_.push_back(std::move(event));
+    changed_.notify_all();
+}
+
+void Job::finish(JobState state, nlohmann::json result, const std::string& error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (state_ == JobState::SUCCEEDED || state_ == JobState::FAILED || state_ == JobState::CANCELLED) {
+        return;
+    }
+    state_ = state;
+    result_ = std::move(result);
+    error_ = error;
+    finished_at_ = std::chrono::system_clock::now();
+    finished_steady_ = std::chrono::steady_clock::now();
+
+    nlohmann::json event = {{"type", "result"}, {"state", jobStateToString(state_)}, {"result", result_}};
+    if (!error_.empty()) {
+        event["error"] = error_;
+    }
+    emitLocked(std::move(event));
+}
+
+bool Job::finished() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return state_ == JobState::SUCCEEDED || state_ == JobState::FAILED || state_ == JobState::CANCELLED;
+}
+
+bool Job::waitForEvents(size_t from, std::chrono::milliseconds timeout, std::vector<nlohmann::json>& events) const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto done = [this] {
+        return state_ == JobState::SUCCEEDED || state_ == JobState::FAILED || state_ == JobState::CANCELLED;
+    };
+    changed_.wait_for(lock, timeout, [&] { return events_.size() > from || done(); });
+
+    events.clear();
+    for (size_t i = from; i < events_.size(); ++i) {
+        events.push_back(events_[i]);
+    }
+    return !events.empty() || !done();
+}
+
+nlohmann::json Job::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    nlohmann::json status = {
+        {"job_id", id_},
+        {"type", kind_},
+        {"state", jobStateToString(state_)},
+        {"created_at", epochMs(created_at_)},
+        {"events", events_.size()}
+    };
+    if (state_ != JobState::QUEUED) {
+        status["started_at"] = epochMs(started_at_);
+    }
+    if (finished_at_ != std::chrono::system_clock::time_point{}) {
+        status["finished_at"] = epochMs(finished_at_);
+        status["result"] = result_;
+    }
+    if (!error_.empty()) {
+        status["error"] = error_;
+    }
+    return status;
+}
+
+std::chrono::steady_clock::time_point Job::finishedAt() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return finished_steady_;
+}
+
+JobManager& JobManager::getInstance() {
+    std::lock_guard<std::mutex> lock(instance_mutex_);
+    if (!instance_) {
+        const auto& config = Config::getInstance().getServerConfig();
+
+        // Enough for every request the admission controller would hold at once
+        JobPolicy policy;
+        policy.max_active = std::max<size_t>(1, config.max_concurrent_executions + config.max_queued_requests);
+        policy.result_ttl = std::chrono::seconds(config.job_result_ttl_seconds);
+
+        instance_ = std::make_unique<JobManager>(policy);
+    }
+    return *instance_;
+}
+
+JobManager::JobManager(JobPolicy policy)
+    : policy_(policy) {
+    Logger::getInstance().info("Async jobs: " + std::to_string(policy_.max_active) + " active, results kept " +
+                               std::to_string(policy_.result_ttl.count()) + "s", "JobManager");
+}
+
+JobManager::~JobManager() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (auto& [id, job] : jobs_) {
+        job->cancellation()->cancel();
+    }
+    idle_.wait(lock, [this] { return active_ == 0; });
+}
+
+std::shared_ptr<Job> JobManager::submit(const std::string& kind, Work work, const std::string& supersede_key) {
+    std::shared_ptr<Job> job;
+    std::shared_ptr<Job> superseded;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sweepLocked();
+        if (!supersede_key.empty()) {
+            auto previous = latest_by_key_.find(supersede_key);
+            if (previous != latest_by_key_.end()) {
+                superseded = previous->second.lock();
+            }
+        }
+        // The job being replaced frees its place below once its thread ends;
+        // count it as gone already so a steady stream of drafts is not refused
+        size_t active = active_ - (superseded && !superseded->finished() ? 1 : 0);
+        if (active >= policy_.max_active) {
+            rejected_++;
+            return nullptr;
+        }
+        job = std::make_shared<Job>(generateId(), kind);
+        jobs_[job->id()] = job;
+        if (!supersede_key.empty()) {
+            latest_by_key_[supersede_key] = job;
+        }
+        active_++;
+    }
+    submitted_++;
+
+    if (superseded && !superseded->finished()) {
+        superseded_++;
+        superseded->cancellation()->cancel();
+    }
+
+    std::thread([this, job, work = std::move(work)]() {
+        run(job, work);
+    }).detach();
+    return job;
+}
+
+void JobManager::run(const std::shared_ptr<Job>& job, const Work& work) {
+    const auto& token = job->cancellation();
+    JobState state = JobState::SUCCEEDED;
+    nlohmann::json result;
+    std::string error;
+    try {
+        result = work(*job);
+    } catch (const std::exception& e) {
+        state = JobState::FAILED;
+        error = e.what();
+    }
+    // Whatever the work returned after a cancel is partial at best
+    if (token->cancelled()) {
+        state = JobState::CANCELLED;
+        error = "Cancelled";
+    }
+    job->finish(state, std::move(result), error);
+
+    switch (state) {
+        case JobState::SUCCEEDED: succeeded_++; break;
+        case JobState::FAILED: failed_++; break;
+        default: cancelled_++; break;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    active_--;
+    idle_.notify_all();
+}
+
+std::shared_ptr<Job> JobManager::find(const std::string& id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sweepLocked();
+    auto it = jobs_.find(id);
+    return it != jobs_.end() ? it->second : nullptr;
+}
+
+std::shared_ptr<Job> JobManager::cancel(const std::string& id, bool forget) {
+    std::shared_ptr<Job> job;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sweepLocked();
+        auto it = jobs_.find(id);
+        if (it == jobs_.end()) {
+            return nullptr;
+        }
+        job = it->second;
+        if (forget) {
+            jobs_.erase(it);
+        }
+    }
+
+    // Callbacks kill processes and wake admission waiters; not under our lock
+    job->cancellation()->cancel();
+    return job;
+}
+
+void JobManager::sweepLocked() {
+    auto now = std::chrono::steady_clock::now();
+    for (auto it = jobs_.begin(); it != jobs_.end();) {
+        if (it->second->finished() && now - it->second->finishedAt() > policy_.result_ttl) {
+            it = jobs_.erase(it);
+            expired_++;
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = latest_by_key_.begin(); it != latest_by_key_.end();) {
+        it = it->second.expired() ? latest_by_key_.erase(it) : std::next(it);
+    }
+}
+
+std::string JobManager::generateId() {
+    // Anyone holding the id can read or cancel the job, so draw it from the OS
+    std::random_device random;
+    std::ostringstream id;
+    id << std::hex << std::setfill('0');
+    for (int i = 0; i < 4; ++i) {
+        id << std::setw(8) << random();
+    }
+    return id.str();
+}
+
+nlohmann::json JobManager::getStatistics() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sweepLocked();
+    return nlohmann::json{
+        {"active", active_},
+        {"retained", jobs_.size()},
+        {"max_active", policy_.max_active},
+        {"result_ttl_seconds", policy_.result_ttl.count()},
+        {"submitted", submitted_.load()},
+        {"rejected", rejected_.load()},
+        {"succeeded", succeeded_.load()},
+        {"failed", failed_.load()},
+        {"cancelled", cancelled_.load()},
+        {"superseded", superseded_.load()},
+        {"expired", expired_.load()}
+    };
+}
+
+} // namespace cpp_mastery
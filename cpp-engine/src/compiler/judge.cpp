@@ -0,0 +1,310 @@
+// File: cpp-engine/src/compiler/judge.cpp
+// Extension: .cpp
+
+#include "compiler/judge.hpp"
+#include "compiler/admission_controller.hpp"
+#include "utils/cancellation_token.hpp"
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <future>
+#include <unistd.h>
+
+namespace cpp_mastery {
+
+namespace {
+
+// Bytes of stdout and stderr kept per case for display
+constexpr size_t kPreviewBytes = 1024;
+
+bool isSpace(char c) {
+    return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+void appendPreview(std::string& preview, std::string_view data) {
+    if (preview.size() < kPreviewBytes) {
+        preview.append(data.substr(0, kPreviewBytes - preview.size()));
+    }
+}
+
+template <typename T>
+void tighten(T& limit, const nlohmann::json& overrides, const char* key) {
+    if (!overrides.contains(key) || !overrides[key].is_number()) {
+        return;
+    }
+    T requested = overrides[key].get<T>();
+    if (requested <= 0) {
+        return;
+    }
+    // Zero in the configuration means unlimited
+    limit = limit > 0 ? std::min(limit, requested) : requested;
+}
+
+} // namespace
+
+std::string verdictToString(Verdict verdict) {
+    switch (verdict) {
+        case Verdict::ACCEPTED: return "AC";
+        case Verdict::WRONG_ANSWER: return "WA";
+        case Verdict::TIME_LIMIT_EXCEEDED: return "TLE";
+        case Verdict::MEMORY_LIMIT_EXCEEDED: return "MLE";
+        case Verdict::OUTPUT_LIMIT_EXCEEDED: return "OLE";
+        case Verdict::RUNTIME_ERROR: return "RE";
+        case Verdict::COMPILATION_ERROR: return "CE";
+        case Verdict::SKIPPED: return "SKIPPED";
+        case Verdict::INTERNAL_ERROR: return "IE";
+    }
+    return "IE";
+}
+
+OutputComparator::OutputComparator(std::string_view expected, Mode mode)
+    : expected_(expected), mode_(mode) {}
+
+OutputComparator::Mode OutputComparator::modeFromString(const std::string& name) {
+    return name == "exact" ? Mode::EXACT : Mode::TOKENS;
+}
+
+void OutputComparator::feed(std::string_view chunk) {
+    if (!mismatched()) {
+        if (mode_ == Mode::EXACT) {
+            feedExact(chunk);
+        } else {
+            feedTokens(chunk);
+        }
+    }
+    actual_pos_ += chunk.size();
+}
+
+void OutputComparator::feedExact(std::string_view chunk) {
+    size_t remaining = expected_.size() - expected_pos_;
+    size_t common = std::min(remaining, chunk.size());
+    auto diff = std::mismatch(chunk.begin(), chunk.begin() + common, expected_.begin() + expected_pos_);
+    size_t matched = diff.first - chunk.begin();
+
+    if (matched < chunk.size()) {
+        mismatch_offset_ = actual_pos_ + matched;
+    }
+    expected_pos_ += matched;
+}
+
+void OutputComparator::feedTokens(std::string_view chunk) {
+    for (size_t i = 0; i < chunk.size() && !mismatched(); ++i) {
+        char c = chunk[i];
+        if (isSpace(c)) {
+            if (in_token_) {
+                endToken();
+            }
+            continue;
+        }
+
+        if (!in_token_) {
+            skipExpectedSpace();
+            in_token_ = true;
+            token_length_ = 0;
+            token_start_ = actual_pos_ + i;
+        }
+
+        size_t index = expected_pos_ + token_length_;
+        if (index >= expected_.size() || isSpace(expected_[index]) || expected_[index] != c) {
+            mismatch_offset_ = token_start_;
+            return;
+        }
+        token_length_++;
+    }
+}
+
+void OutputComparator::endToken() {
+    // The output token is complete; the expected one must end here too
+    size_t index = expected_pos_ + token_length_;
+    if (index < expected_.size() && !isSpace(expected_[index])) {
+        mismatch_offset_ = token_start_;
+    }
+    expected_pos_ = index;
+    in_token_ = false;
+}
+
+void OutputComparator::skipExpectedSpace() {
+    while (expected_pos_ < expected_.size() && isSpace(expected_[expected_pos_])) {
+        expected_pos_++;
+    }
+}
+
+bool OutputComparator::finish() {
+    if (mismatched()) {
+        return false;
+    }
+
+    if (mode_ == Mode::TOKENS) {
+        if (in_token_) {
+            endToken();
+        }
+        skipExpectedSpace();
+    }
+
+    // Output ended early
+    if (!mismatched() && expected_pos_ != expected_.size()) {
+        mismatch_offset_ = actual_pos_;
+    }
+    return !mismatched();
+}
+
+Judge::Judge(ExecutionEngine& engine) : engine_(engine) {}
+
+ExecutionConfig Judge::effectiveLimits(const ExecutionConfig& base, const nlohmann::json& overrides) {
+    ExecutionConfig limits = base;
+    if (overrides.is_object()) {
+        tighten(limits.execution_timeout, overrides, "execution_timeout");
+        tighten(limits.max_memory_mb, overrides, "max_memory_mb");
+        tighten(limits.max_cpu_time, overrides, "max_cpu_time");
+        tighten(limits.max_output_size, overrides, "max_output_size");
+    }
+    return limits;
+}
+
+Verdict Judge::verdictFor(ExecutionStatus status, bool output_matched) {
+    switch (status) {
+        case ExecutionStatus::OK:
+            return output_matched ? Verdict::ACCEPTED : Verdict::WRONG_ANSWER;
+        case ExecutionStatus::TIME_LIMIT_EXCEEDED:
+        case ExecutionStatus::CPU_LIMIT_EXCEEDED:
+            return Verdict::TIME_LIMIT_EXCEEDED;
+        case ExecutionStatus::MEMORY_LIMIT_EXCEEDED:
+            return Verdict::MEMORY_LIMIT_EXCEEDED;
+        case ExecutionStatus::OUTPUT_LIMIT_EXCEEDED:
+            return Verdict::OUTPUT_LIMIT_EXCEEDED;
+        case ExecutionStatus::RUNTIME_ERROR:
+            return Verdict::RUNTIME_ERROR;
+        case ExecutionStatus::COMPILATION_ERROR:
+            return Verdict::COMPILATION_ERROR;
+        case ExecutionStatus::CANCELLED:
+        case ExecutionStatus::INTERNAL_ERROR:
+            return Verdict::INTERNAL_ERROR;
+    }
+    return Verdict::INTERNAL_ERROR;
+}
+
+JudgeResult Judge::judge(const std::string& code, const std::vector<JudgeCase>& cases, const JudgeOptions& options) {
+    auto& logger = Logger::getInstance();
+    auto start = std::chrono::steady_clock::now();
+
+    JudgeResult result;
+    result.cases.resize(cases.size());
+
+    result.compilation = engine_.compile(code, options.compile_options);
+    if (!result.compilation.success) {
+        result.verdict = Verdict::COMPILATION_ERROR;
+        result.error_message = "Compilation failed";
+        for (const auto& error : result.compilation.errors) {
+            result.error_message += "\n" + error;
+        }
+        return result;
+    }
+
+    size_t parallelism = workerCount(options.parallelism, cases.size(),
+                                     Config::getInstance().getExecutionConfig().sandbox_pool_max);
+
+    // Workers pull case indices until none are left or a failure stops the run
+    std::atomic<size_t> next_case{0};
+    std::atomic<bool> stop{false};
+    auto worker = [&]() {
+        while (!stop.load()) {
+            size_t index = next_case.fetch_add(1);
+            if (index >= cases.size()) {
+                return;
+            }
+            CaseResult case_result = runCase(result.compilation.executable_path, cases[index], options);
+            if (options.stop_on_first_failure && case_result.verdict != Verdict::ACCEPTED) {
+                stop.store(true);
+            }
+            result.cases[index] = std::move(case_result);
+        }
+    };
+
+    // The caller's ticket covers this thread; every further worker takes its
+    // own batch ticket, so a judge run never holds more slots than admission
+    // grants. Workers still queued once the cases have run out give up.
+    auto cases_taken = std::make_shared<CancellationToken>();
+    std::vector<std::future<void>> workers;
+    for (size_t i = 1; i < parallelism; ++i) {
+        workers.push_back(std::async(std::launch::async, [&, cases_taken]() {
+            auto admission = AdmissionController::getInstance().admit(options.client_id, AdmissionLane::BATCH, cases_taken);
+            if (admission.admitted()) {
+                worker();
+            }
+        }));
+    }
+    worker();
+    cases_taken->cancel();
+    for (auto& future : workers) {
+        future.get();
+    }
+
+    engine_.releaseCompilation(result.compilation);
+
+    result.verdict = Verdict::ACCEPTED;
+    for (const auto& case_result : result.cases) {
+        if (case_result.verdict == Verdict::ACCEPTED) {
+            result.passed++;
+        } else if (result.verdict == Verdict::ACCEPTED && case_result.verdict != Verdict::SKIPPED) {
+            result.verdict = case_result.verdict;
+        }
+    }
+
+    result.total_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    logger.info("Judged " + std::to_string(cases.size()) + " cases: " + verdictToString(result.verdict) +
+                " (" + std::to_string(result.passed) + " passed)", "Judge");
+    return result;
+}
+
+size_t Judge::workerCount(size_t requested, size_t case_count, int pool_max) {
+    size_t limit = static_cast<size_t>(std::max(1, pool_max));
+    size_t count = requested == 0 ? limit : std::min(requested, limit);
+    return std::max<size_t>(1, std::min(count, case_count));
+}
+
+CaseResult Judge::runCase(const std::string& executable_path, const JudgeCase& test_case, const JudgeOptions& options) {
+    CaseResult result;
+
+    try {
+        ExecutionConfig limits = effectiveLimits(Config::getInstance().getExecutionConfig(), test_case.limits);
+        OutputComparator comparator(test_case.expected_output, options.mode);
+
+        // Runs on the supervisor thread; runExecutable() returns only after the last call
+        auto on_output = [&](int stream, std::string_view data) {
+            if (stream == STDOUT_FILENO) {
+                comparator.feed(data);
+                appendPreview(result.output_preview, data);
+            } else {
+                appendPreview(result.stderr_preview, data);
+            }
+        };
+
+        ProcessResult process = engine_.runExecutable(executable_path, test_case.input, limits, on_output);
+
+        // classifyExit looks for std::bad_alloc in stderr when the run aborted
+        process.stderr = result.stderr_preview;
+
+        result.status = ExecutionEngine::classifyExit(process, limits);
+        bool matched = comparator.finish();
+        result.verdict = verdictFor(result.status, matched);
+        result.mismatch_offset = comparator.mismatchOffset();
+        result.exit_code = process.exit_code;
+        result.term_signal = process.term_signal;
+        result.time_ms = process.wall_time_ms;
+        result.cpu_time_ms = process.cpu_time_ms;
+        result.memory_kb = process.memory_usage_kb;
+    } catch (const std::exception& e) {
+        result.verdict = Verdict::INTERNAL_ERROR;
+        result.stderr_preview = e.what();
+        Logger::getInstance().error("Judge case failed: " + std::string(e.what()), "Judge");
+    }
+
+    return result;
+}
+
+} // namespace cpp_mastery
@@ -0,0 +1,312 @@
+// File: cpp-engine/src/compiler/pch_pool.cpp
+// Extension: .cpp
+
+#include "compiler/pch_pool.hpp"
+#include "utils/logger.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <future>
+#include <random>
+#include <algorithm>
+
+namespace cpp_mastery {
+
+namespace {
+
+// How often select() re-stats the compiler binary to detect upgrades
+constexpr std::chrono::seconds kStampCheckInterval{60};
+
+std::string trimLeft(const std::string& text, size_t pos) {
+    while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\r')) {
+        ++pos;
+    }
+    return text.substr(pos);
+}
+
+} // namespace
+
+PchPool::PchPool(std::filesystem::path root, ProcessRunner runner, int build_timeout_seconds)
+    : root_(std::move(root)), runner_(std::move(runner)), build_timeout_seconds_(build_timeout_seconds) {
+}
+
+const std::vector<PchPool::IncludeSet>& PchPool::includeSets() {
+    // Ordered smallest first so select() injects as little as possible
+    static const std::vector<IncludeSet> sets = {
+        {"iostream", {"iostream"}},
+        {"common", {
+            "iostream", "string", "vector", "algorithm", "map", "set", "unordered_map",
+            "unordered_set", "memory", "utility", "functional", "numeric", "iterator",
+            "array", "deque", "list", "queue", "stack", "tuple", "optional", "string_view",
+            "sstream", "iomanip", "fstream", "chrono", "limits", "random", "bitset",
+            "cmath", "cstdio", "cstdlib", "cstring", "climits", "cassert"
+        }},
+        {"stdc++", {"bits/stdc++.h"}}
+    };
+    return sets;
+}
+
+void PchPool::initialize(const std::vector<PchToolchain>& toolchains,
+                         const std::unordered_map<std::string, std::string>& compiler_versions) {
+    auto& logger = Logger::getInstance();
+    compiler_versions_ = compiler_versions;
+
+    std::vector<std::future<void>> builds;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& toolchain : toolchains) {
+            std::string id = toolchainId(toolchain);
+            if (toolchains_.count(id)) {
+                continue;
+            }
+            ToolchainState& state = toolchains_[id];
+            state.toolchain = toolchain;
+            state.directory = root_ / id;
+            state.last_checked = std::chrono::steady_clock::now();
+        }
+    }
+
+    // Toolchains are independent, so prepare them in parallel to keep startup short
+    for (auto& [id, state] : toolchains_) {
+        builds.push_back(std::async(std::launch::async, [this, &state]() { buildToolchain(state); }));
+    }
+    for (auto& build : builds) {
+        build.get();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [id, state] : toolchains_) {
+        logger.info("PCH toolchain " + id + ": " + std::to_string(state.ready_sets.size()) + " include sets ready", "PchPool");
+    }
+}
+
+std::optional<std::string> PchPool::select(const std::string& code, const PchToolchain& toolchain) {
+    std::vector<std::string> includes = leadingSystemIncludes(code);
+    if (includes.empty()) {
+        misses_++;
+        return std::nullopt;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = toolchains_.find(toolchainId(toolchain));
+    if (it == toolchains_.end()) {
+        misses_++;
+        return std::nullopt;
+    }
+    ToolchainState& state = it->second;
+
+    // Rebuild when the compiler binary changed underneath us; requests fall back
+    // to plain compilation until the rebuild is done
+    auto now = std::chrono::steady_clock::now();
+    if (now - state.last_checked > kStampCheckInterval && !state.ready_sets.empty()) {
+        state.last_checked = now;
+        if (compilerStamp(state.toolchain) != state.stamp) {
+            Logger::getInstance().info("Compiler changed, rebuilding PCHs for " + it->first, "PchPool");
+            state.ready_sets.clear();
+            lock.unlock();
+            buildToolchain(state);
+            misses_++;
+            return std::nullopt;
+        }
+    }
+
+    for (const auto& set : includeSets()) {
+        if (std::find(state.ready_sets.begin(), state.ready_sets.end(), set.name) == state.ready_sets.end()) {
+            continue;
+        }
+        bool covered = std::all_of(includes.begin(), includes.end(), [&set](const std::string& header) {
+            return std::find(set.headers.begin(), set.headers.end(), header) != set.headers.end();
+        });
+        // <bits/stdc++.h> pulls in everything, so it covers any standard header list that asked for it
+        if (!covered && set.name == "stdc++") {
+            covered = std::find(includes.begin(), includes.end(), "bits/stdc++.h") != includes.end();
+        }
+        if (covered) {
+            uses_[set.name]++;
+            return (state.directory / (set.name + ".hpp")).string();
+        }
+    }
+
+    misses_++;
+    return std::nullopt;
+}
+
+std::vector<std::string> PchPool::leadingSystemIncludes(const std::string& code) {
+    std::vector<std::string> includes;
+    std::istringstream stream(code);
+    std::string line;
+    bool in_block_comment = false;
+
+    while (std::getline(stream, line)) {
+        std::string rest = trimLeft(line, 0);
+
+        if (in_block_comment) {
+            size_t end = rest.find("*/");
+            if (end == std::string::npos) {
+                continue;
+            }
+            in_block_comment = false;
+            rest = trimLeft(rest, end + 2);
+        }
+
+        if (rest.empty() || rest.rfind("//", 0) == 0) {
+            continue;
+        }
+
+        if (rest.rfind("/*", 0) == 0) {
+            size_t end = rest.find("*/", 2);
+            if (end == std::string::npos) {
+                in_block_comment = true;
+                continue;
+            }
+            rest = trimLeft(rest, end + 2);
+            if (rest.empty()) {
+                continue;
+            }
+        }
+
+        if (rest[0] != '#') {
+            break;
+        }
+        rest = trimLeft(rest, 1);
+        if (rest.rfind("include", 0) != 0) {
+            break;
+        }
+        rest = trimLeft(rest, 7);
+        if (rest.empty() || rest[0] != '<') {
+            break;
+        }
+        size_t close = rest.find('>');
+        if (close == std::string::npos) {
+            break;
+        }
+        includes.push_back(rest.substr(1, close - 1));
+    }
+
+    return includes;
+}
+
+nlohmann::json PchPool::getStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    nlohmann::json toolchains = nlohmann::json::object();
+    for (const auto& [id, state] : toolchains_) {
+        toolchains[id] = state.ready_sets;
+    }
+
+    return nlohmann::json{
+        {"enabled", true},
+        {"uses", uses_},
+        {"misses", misses_.load()},
+        {"toolchains", toolchains}
+    };
+}
+
+std::string PchPool::toolchainId(const PchToolchain& toolchain) {
+    return std::filesystem::path(toolchain.compiler_path).filename().string() + "-" +
+           toolchain.standard + "-" + toolchain.optimization;
+}
+
+std::string PchPool::compilerStamp(const PchToolchain& toolchain) const {
+    std::error_code ec;
+    auto canonical = std::filesystem::canonical(toolchain.compiler_path, ec);
+    auto path = ec ? std::filesystem::path(toolchain.compiler_path) : canonical;
+
+    auto size = std::filesystem::file_size(path, ec);
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    auto version = compiler_versions_.find(toolchain.compiler_path);
+
+    std::ostringstream stamp;
+    stamp << path.string() << "\n"
+          << size << "\n"
+          << mtime.time_since_epoch().count() << "\n"
+          << (version != compiler_versions_.end() ? version->second : "") << "\n";
+    return stamp.str();
+}
+
+void PchPool::buildToolchain(ToolchainState& state) {
+    auto& logger = Logger::getInstance();
+
+    try {
+        std::filesystem::create_directories(state.directory);
+
+        std::string stamp = compilerStamp(state.toolchain);
+        std::string existing_stamp;
+        {
+            std::ifstream file(state.directory / "stamp");
+            std::stringstream buffer;
+            buffer << file.rdbuf();
+            existing_stamp = buffer.str();
+        }
+
+        std::vector<std::string> ready;
+        for (const auto& set : includeSets()) {
+            auto pch_file = state.directory / (set.name + (state.toolchain.is_clang ? ".hpp.pch" : ".hpp.gch"));
+            bool up_to_date = (existing_stamp == stamp) && std::filesystem::exists(pch_file);
+            if (up_to_date || buildSet(state, set)) {
+                ready.push_back(set.name);
+            }
+        }
+
+        {
+            std::ofstream file(state.directory / "stamp");
+            file << stamp;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        state.stamp = stamp;
+        state.ready_sets = ready;
+
+    } catch (const std::exception& e) {
+        logger.warning("Failed to prepare PCHs in " + state.directory.string() + ": " + e.what(), "PchPool");
+    }
+}
+
+bool PchPool::buildSet(const ToolchainState& state, const IncludeSet& set) {
+    auto& logger = Logger::getInstance();
+
+    auto header = state.directory / (set.name + ".hpp");
+    auto output = state.directory / (set.name + (state.toolchain.is_clang ? ".hpp.pch" : ".hpp.gch"));
+    auto staging = output;
+    staging += ".tmp-" + std::to_string(std::random_device{}());
+
+    {
+        std::ofstream file(header);
+        for (const auto& name : set.headers) {
+            file << "#include <" << name << ">\n";
+        }
+    }
+
+    // Must match the flags buildCompileCommand() uses, or the PCH is rejected
+    std::vector<std::string> args = {
+        state.toolchain.compiler_path,
+        "-std=" + state.toolchain.standard,
+        "-" + state.toolchain.optimization,
+        "-Wall", "-Wextra", "-pedantic",
+        "-x", "c++-header",
+        header.string(),
+        "-o", staging.string()
+    };
+
+    auto start_time = std::chrono::steady_clock::now();
+    ProcessResult result = runner_(args, build_timeout_seconds_);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time).count();
+
+    std::error_code ec;
+    if (result.exit_code != 0) {
+        std::filesystem::remove(staging, ec);
+        logger.warning("PCH build failed for " + output.string() + ": " + result.stderr.substr(0, 500), "PchPool");
+        return false;
+    }
+
+    std::filesystem::rename(staging, output, ec);
+    if (ec) {
+        std::filesystem::remove(staging, ec);
+        return false;
+    }
+
+    logger.info("Built PCH " + output.string() + " in " + std::to_string(elapsed) + "ms", "PchPool");
+    return true;
+}
+
+} // namespace cpp_mastery
@@ -0,0 +1,693 @@
+// File: cpp-engine/src/compiler/sandbox.cpp
+// Extension: .cpp
+
+#include "compiler/sandbox.hpp"
+#include "utils/config.hpp"
+#include "utils/logger.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <functional>
+#include <algorithm>
+#include <thread>
+#include <cerrno>
+#include <cstddef>
+#include <csignal>
+#include <fcntl.h>
+#include <grp.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mount.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <linux/audit.h>
+#include <linux/capability.h>
+#include <linux/securebits.h>
+#include <linux/seccomp.h>
+
+namespace cpp_mastery {
+
+namespace {
+
+// Unprivileged identity the sandbox maps to when the server runs as root
+constexpr uid_t kSandboxUid = 65534;
+constexpr gid_t kSandboxGid = 65534;
+
+// The new root is assembled on a tmpfs mounted here inside the private mount
+// namespace; the host's /tmp is never touched
+constexpr const char* kStagingRoot = "/tmp";
+
+// The program's private /tmp
+constexpr const char* kTmpMountOptions = "size=64m,nr_inodes=4096,mode=1777";
+
+const char* const kRootDirectories[] = {"bin", "sbin", "lib", "lib32", "lib64", "libx32", "usr", "etc"};
+const char* const kDevices[] = {"null", "zero", "full", "random", "urandom"};
+
+char kEnvPath[] = "PATH=/usr/local/bin:/usr/bin:/bin";
+char kEnvHome[] = "HOME=/tmp";
+char kEnvLang[] = "LANG=C.UTF-8";
+
+// ---- Async-signal-safe helpers for the child side ----
+
+void reportFailure(const char* step) {
+    int error = errno;
+    char buffer[160];
+    size_t length = 0;
+    auto append = [&](const char* text) {
+        while (*text && length < sizeof(buffer) - 1) {
+            buffer[length++] = *text++;
+        }
+    };
+
+    char digits[12];
+    int count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + error % 10);
+        error /= 10;
+    } while (error > 0 && count < 11);
+
+    append("sandbox: ");
+    append(step);
+    append(" failed (errno ");
+    while (count > 0 && length < sizeof(buffer) - 1) {
+        buffer[length++] = digits[--count];
+    }
+    append(")\n");
+    [[maybe_unused]] ssize_t written = write(STDERR_FILENO, buffer, length);
+}
+
+bool writeFile(const char* path, const std::string& data) {
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    ssize_t written = write(fd, data.data(), data.size());
+    close(fd);
+    return written == static_cast<ssize_t>(data.size());
+}
+
+// Remounting a bind read-only inside a user namespace must keep the flags
+// the kernel locked on the original mount, or it fails with EPERM
+bool remountReadOnly(const char* target) {
+    struct statvfs info {};
+    unsigned long flags = MS_BIND | MS_REMOUNT | MS_RDONLY;
+    if (statvfs(target, &info) == 0) {
+        if (info.f_flag & ST_NOSUID) flags |= MS_NOSUID;
+        if (info.f_flag & ST_NODEV) flags |= MS_NODEV;
+        if (info.f_flag & ST_NOEXEC) flags |= MS_NOEXEC;
+        if (info.f_flag & ST_NOATIME) flags |= MS_NOATIME;
+        if (info.f_flag & ST_NODIRATIME) flags |= MS_NODIRATIME;
+        if (info.f_flag & ST_RELATIME) flags |= MS_RELATIME;
+    }
+    return mount(nullptr, target, nullptr, flags, nullptr) == 0;
+}
+
+bool setLimit(int resource, rlim_t soft, rlim_t hard) {
+    struct rlimit limit { soft, hard };
+    return setrlimit(resource, &limit) == 0;
+}
+
+[[noreturn]] void mirrorExitStatus(int status) {
+    if (WIFSIGNALED(status)) {
+        struct sigaction default_action {};
+        default_action.sa_handler = SIG_DFL;
+        sigaction(WTERMSIG(status), &default_action, nullptr);
+        kill(getpid(), WTERMSIG(status));
+        _exit(128 + WTERMSIG(status));
+    }
+    _exit(WIFEXITED(status) ? WEXITSTATUS(status) : 126);
+}
+
+} // namespace
+
+// Initialize static members
+std::unique_ptr<Sandbox> Sandbox::instance_ = nullptr;
+std::mutex Sandbox::mutex_;
+
+Sandbox& Sandbox::getInstance() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (instance_ == nullptr) {
+        instance_ = std::unique_ptr<Sandbox>(new Sandbox());
+    }
+    return *instance_;
+}
+
+bool Sandbox::initialize(const ExecutionConfig& config) {
+    auto& logger = Logger::getInstance();
+
+    rootfs_ = config.sandbox_rootfs.empty() ? "/" : config.sandbox_rootfs;
+    cgroup_root_ = config.cgroup_root;
+
+    // Mirror the rootfs layout; on merged-/usr systems /bin, /lib etc. are
+    // symlinks and are recreated as such rather than bound twice
+    root_entries_.clear();
+    for (const char* name : kRootDirectories) {
+        std::filesystem::path source = std::filesystem::path(rootfs_) / name;
+        std::string target = std::string(kStagingRoot) + "/" + name;
+        std::error_code ec;
+        auto status = std::filesystem::symlink_status(source, ec);
+        if (ec) {
+            continue;
+        }
+        if (std::filesystem::is_symlink(status)) {
+            root_entries_.push_back({std::filesystem::read_symlink(source, ec).string(), target, true});
+        } else if (std::filesystem::is_directory(status)) {
+            root_entries_.push_back({source.string(), target, false});
+        }
+    }
+
+    seccomp_filter_ = buildSeccompFilter();
+    seccomp_available_ = !seccomp_filter_.empty();
+    if (!seccomp_available_) {
+        logger.warning("Seccomp filter not supported on this architecture", "Sandbox");
+    }
+
+    cgroups_available_ = setupCgroups(cgroup_root_);
+    if (!cgroups_available_) {
+        logger.warning("cgroup v2 unavailable at " + cgroup_root_ + ", limits fall back to rlimits", "Sandbox");
+    }
+
+    // Probe the whole path once; kernels or container runtimes that forbid
+    // user namespaces fail here rather than on the first request
+    available_ = true;
+    auto start_time = std::chrono::steady_clock::now();
+    ProcessResult probe = run({"/bin/true"}, limitsFromConfig(config), std::chrono::seconds(5));
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+
+    if (probe.exit_code != 0) {
+        available_ = false;
+        unavailable_reason_ = probe.stderr.empty() ? "probe exited with code " + std::to_string(probe.exit_code) : probe.stderr;
+        logger.warning("Native sandbox unavailable: " + unavailable_reason_, "Sandbox");
+        return false;
+    }
+
+    logger.info("Native sandbox ready (probe " + std::to_string(elapsed / 1000.0) + "ms, cgroups " +
+                (cgroups_available_ ? "on" : "off") + ", seccomp " + (seccomp_available_ ? "on" : "off") + ")", "Sandbox");
+    return true;
+}
+
+ProcessResult Sandbox::run(const std::vector<std::string>& args, const SandboxLimits& limits,
+                           std::chrono::milliseconds timeout, std::string_view input,
+                           OutputCallback on_output, std::shared_ptr<CancellationToken> cancellation) {
+    ProcessResult result;
+    if (!available_ || args.empty()) {
+        result.stderr = "Sandbox unavailable";
+        return result;
+    }
+
+    // Opened before isolation: the program's path does not exist inside
+    UniqueFd executable(open(args[0].c_str(), O_RDONLY | O_CLOEXEC));
+    if (!executable.valid()) {
+        result.exit_code = 127;
+        result.stderr = "Cannot open executable: " + args[0];
+        return result;
+    }
+
+    std::optional<std::string> leaf = cgroups_available_ ? createCgroup(limits) : std::nullopt;
+
+    Plan plan = makePlan(limits, leaf.value_or(""));
+    plan.executable_fd = executable.get();
+
+    std::vector<std::string> argv_storage = args;
+    argv_storage[0] = std::filesystem::path(args[0]).filename().string();
+    for (auto& arg : argv_storage) {
+        plan.argv.push_back(arg.data());
+    }
+    plan.argv.push_back(nullptr);
+
+    ProcessOptions options;
+    options.args = args;
+    options.timeout = timeout;
+    options.stdin_data = input;
+    options.max_output_bytes = limits.max_output_bytes;
+    options.on_output = std::move(on_output);
+    options.cancellation = std::move(cancellation);
+    options.pre_exec = [&plan]() {
+        if (!enterIsolation(plan) || !applyRestrictions(plan)) {
+            return false;
+        }
+        fexecve(plan.executable_fd, plan.argv.data(), plan.envp.data());
+        reportFailure("fexecve");
+        return false;
+    };
+
+    result = ProcessSupervisor::getInstance().run(options);
+    runs_++;
+    if (result.exit_code == 126) {
+        setup_failures_++;
+    }
+
+    if (leaf) {
+        // The cgroup also saw processes that escaped the program's wait()s
+        CgroupUsage usage = readCgroupUsage(*leaf);
+        result.memory_usage_kb = std::max(result.memory_usage_kb, usage.peak_memory_kb);
+        if (usage.user_time_ms + usage.system_time_ms > result.cpu_time_ms) {
+            result.user_time_ms = usage.user_time_ms;
+            result.system_time_ms = usage.system_time_ms;
+            result.cpu_time_ms = usage.user_time_ms + usage.system_time_ms;
+        }
+        result.io_read_bytes = std::max(result.io_read_bytes, usage.io_read_bytes);
+        result.io_write_bytes = std::max(result.io_write_bytes, usage.io_write_bytes);
+        result.oom_killed = usage.oom_kills > 0;
+        removeCgroup(*leaf);
+    }
+
+    return result;
+}
+
+SandboxLimits Sandbox::limitsFromConfig(const ExecutionConfig& config) {
+    SandboxLimits limits;
+    limits.memory_bytes = static_cast<size_t>(config.max_memory_mb) * 1024 * 1024;
+    limits.cpu_time_seconds = config.max_cpu_time;
+    limits.max_file_size_bytes = std::max<size_t>(config.max_output_size, limits.max_file_size_bytes);
+    limits.max_output_bytes = config.max_output_size;
+    return limits;
+}
+
+nlohmann::json Sandbox::getStatus() const {
+    nlohmann::json status = {
+        {"available", available_},
+        {"cgroups", cgroups_available_},
+        {"seccomp", seccomp_available_},
+        {"runs", runs_.load()},
+        {"setup_failures", setup_failures_.load()}
+    };
+    if (!available_ && !unavailable_reason_.empty()) {
+        status["reason"] = unavailable_reason_;
+    }
+    return status;
+}
+
+Sandbox::Plan Sandbox::restrictionPlan(const SandboxLimits& limits, bool rlimit_memory) {
+    Plan plan;
+    plan.limits = limits;
+    plan.rlimit_memory = rlimit_memory;
+    plan.tmp_mount_options = kTmpMountOptions;
+    plan.seccomp_filter = buildSeccompFilter();
+    plan.envp = {kEnvPath, kEnvHome, kEnvLang, nullptr};
+    return plan;
+}
+
+Sandbox::Plan Sandbox::makePlan(const SandboxLimits& limits, const std::string& cgroup_leaf) const {
+    Plan plan;
+    plan.limits = limits;
+    plan.rlimit_memory = cgroup_leaf.empty();
+    if (!cgroup_leaf.empty()) {
+        plan.cgroup_procs = cgroup_leaf + "/cgroup.procs";
+    }
+
+    plan.drop_privileges = (geteuid() == 0);
+    plan.run_uid = plan.drop_privileges ? kSandboxUid : geteuid();
+    plan.run_gid = plan.drop_privileges ? kSandboxGid : getegid();
+    plan.uid_map = "0 " + std::to_string(plan.run_uid) + " 1\n";
+    plan.gid_map = "0 " + std::to_string(plan.run_gid) + " 1\n";
+
+    plan.staging_root = kStagingRoot;
+    plan.root_entries = root_entries_;
+    plan.tmp_target = plan.staging_root + "/tmp";
+    plan.proc_target = plan.staging_root + "/proc";
+    plan.dev_target = plan.staging_root + "/dev";
+    for (const char* device : kDevices) {
+        plan.device_sources.push_back(std::string("/dev/") + device);
+        plan.device_targets.push_back(plan.dev_target + "/" + device);
+    }
+    plan.tmp_mount_options = kTmpMountOptions;
+
+    plan.seccomp_filter = seccomp_filter_;
+    plan.envp = {kEnvPath, kEnvHome, kEnvLang, nullptr};
+    return plan;
+}
+
+bool Sandbox::enterIsolation(const Plan& plan) {
+    // The cgroup must be joined while still in the initial namespaces, where
+    // the server has write access to the delegated hierarchy
+    if (!plan.cgroup_procs.empty() && !writeFile(plan.cgroup_procs.c_str(), "0")) {
+        reportFailure("cgroup join");
+        return false;
+    }
+
+    if (plan.drop_privileges) {
+        if (setgroups(0, nullptr) != 0 ||
+            setresgid(plan.run_gid, plan.run_gid, plan.run_gid) != 0 ||
+            setresuid(plan.run_uid, plan.run_uid, plan.run_uid) != 0) {
+            reportFailure("privilege drop");
+            return false;
+        }
+        // Changing credentials clears the dumpable flag, which makes
+        // /proc/self/uid_map unwritable below
+        prctl(PR_SET_DUMPABLE, 1);
+    }
+
+    if (unshare(CLONE_NEWUSER | CLONE_NEWNS | CLONE_NEWNET | CLONE_NEWIPC | CLONE_NEWUTS | CLONE_NEWPID) != 0) {
+        reportFailure("unshare");
+        return false;
+    }
+
+    // setgroups must be denied before an unprivileged gid_map write
+    writeFile("/proc/self/setgroups", "deny");
+    if (!writeFile("/proc/self/uid_map", plan.uid_map) || !writeFile("/proc/self/gid_map", plan.gid_map)) {
+        reportFailure("id map");
+        return false;
+    }
+
+    // The PID namespace applies to children only. This process stays behind
+    // as a proxy so the supervisor still sees the program's exit status.
+    pid_t pid = fork();
+    if (pid == -1) {
+        reportFailure("fork");
+        return false;
+    }
+    if (pid > 0) {
+        int status = 0;
+        while (waitpid(pid, &status, 0) == -1 && errno == EINTR) {
+        }
+        mirrorExitStatus(status);
+    }
+
+    // PID 1 of the new namespace; everything in it dies with us
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+
+    if (mount(nullptr, "/", nullptr, MS_REC | MS_PRIVATE, nullptr) != 0 ||
+        mount("tmpfs", plan.staging_root.c_str(), "tmpfs", MS_NOSUID | MS_NODEV, "size=1m,mode=0755") != 0) {
+        reportFailure("root mount");
+        return false;
+    }
+
+    for (const auto& entry : plan.root_entries) {
+        if (entry.is_symlink) {
+            if (symlink(entry.source.c_str(), entry.target.c_str()) != 0) {
+                reportFailure("symlink");
+                return false;
+            }
+            continue;
+        }
+        if (mkdir(entry.target.c_str(), 0755) != 0 ||
+            mount(entry.source.c_str(), entry.target.c_str(), nullptr, MS_BIND | MS_REC, nullptr) != 0 ||
+            !remountReadOnly(entry.target.c_str())) {
+            reportFailure("bind mount");
+            return false;
+        }
+    }
+
+    if (mkdir(plan.tmp_target.c_str(), 01777) != 0 ||
+        mount("tmpfs", plan.tmp_target.c_str(), "tmpfs", MS_NOSUID | MS_NODEV, plan.tmp_mount_options.c_str()) != 0) {
+        reportFailure("tmp mount");
+        return false;
+    }
+
+    // /proc needs an unobscured host /proc; programs mostly run fine without it
+    if (mkdir(plan.proc_target.c_str(), 0555) == 0) {
+        mount("proc", plan.proc_target.c_str(), "proc", MS_NOSUID | MS_NODEV | MS_NOEXEC, nullptr);
+    }
+
+    if (mkdir(plan.dev_target.c_str(), 0755) != 0) {
+        reportFailure("dev mkdir");
+        return false;
+    }
+    for (size_t i = 0; i < plan.device_targets.size(); ++i) {
+        int fd = open(plan.device_targets[i].c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0666);
+        if (fd >= 0) {
+            close(fd);
+        }
+        if (mount(plan.device_sources[i].c_str(), plan.device_targets[i].c_str(), nullptr, MS_BIND, nullptr) != 0) {
+            reportFailure("device bind");
+            return false;
+        }
+    }
+
+    if (chdir(plan.staging_root.c_str()) != 0 ||
+        syscall(SYS_pivot_root, ".", ".") != 0 ||
+        umount2(".", MNT_DETACH) != 0 ||
+        chdir("/") != 0) {
+        reportFailure("pivot_root");
+        return false;
+    }
+
+    if (mount(nullptr, "/", nullptr, MS_BIND | MS_REMOUNT | MS_RDONLY | MS_NOSUID | MS_NODEV, nullptr) != 0) {
+        reportFailure("root remount");
+        return false;
+    }
+
+    sethostname("sandbox", 7);
+    return true;
+}
+
+void Sandbox::applyResourceLimits(const SandboxLimits& limits, bool rlimit_memory) {
+    // setrlimit() only fails when raising a hard limit, in which case the
+    // inherited limit is already stricter than ours
+    if (limits.cpu_time_seconds > 0) {
+        // SIGXCPU at the soft limit, SIGKILL one second later
+        setLimit(RLIMIT_CPU, limits.cpu_time_seconds, limits.cpu_time_seconds + 1);
+    }
+    if (rlimit_memory && limits.memory_bytes > 0) {
+        setLimit(RLIMIT_AS, limits.memory_bytes, limits.memory_bytes);
+    }
+    setLimit(RLIMIT_FSIZE, limits.max_file_size_bytes, limits.max_file_size_bytes);
+    setLimit(RLIMIT_NOFILE, limits.max_open_files, limits.max_open_files);
+    setLimit(RLIMIT_CORE, 0, 0);
+}
+
+bool Sandbox::applyRestrictions(const Plan& plan) {
+    applyResourceLimits(plan.limits, plan.rlimit_memory);
+
+    // Root inside the user namespace must not regain capabilities on exec
+    if (prctl(PR_SET_SECUREBITS, SECBIT_NOROOT | SECBIT_NOROOT_LOCKED |
+                                 SECBIT_NO_SETUID_FIXUP | SECBIT_NO_SETUID_FIXUP_LOCKED) != 0) {
+        reportFailure("securebits");
+        return false;
+    }
+    struct __user_cap_header_struct header { _LINUX_CAPABILITY_VERSION_3, 0 };
+    struct __user_cap_data_struct data[2] {};
+    if (syscall(SYS_capset, &header, data) != 0) {
+        reportFailure("capset");
+        return false;
+    }
+
+    if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) != 0) {
+        reportFailure("no_new_privs");
+        return false;
+    }
+
+    if (!plan.seccomp_filter.empty()) {
+        struct sock_fprog program {
+            static_cast<unsigned short>(plan.seccomp_filter.size()),
+            const_cast<sock_filter*>(plan.seccomp_filter.data())
+        };
+        if (prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &program) != 0) {
+            reportFailure("seccomp");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::optional<std::string> Sandbox::createCgroup(const SandboxLimits& limits) {
+    std::string leaf = cgroup_root_ + "/run-" + std::to_string(getpid()) + "-" + std::to_string(cgroup_sequence_++);
+
+    std::error_code ec;
+    if (!std::filesystem::create_directory(leaf, ec)) {
+        Logger::getInstance().warning("Failed to create cgroup " + leaf + ": " + ec.message(), "Sandbox");
+        return std::nullopt;
+    }
+
+    auto set = [&leaf](const std::string& file, const std::string& value) {
+        std::ofstream(leaf + "/" + file) << value;
+    };
+    if (limits.memory_bytes > 0) {
+        set("memory.max", std::to_string(limits.memory_bytes));
+        set("memory.swap.max", "0");
+    }
+    set("pids.max", std::to_string(limits.max_processes));
+    // One CPU of bandwidth; total CPU time is capped by RLIMIT_CPU
+    set("cpu.max", "100000 100000");
+
+    return leaf;
+}
+
+CgroupUsage Sandbox::readCgroupUsage(const std::string& leaf) {
+    CgroupUsage usage;
+
+    // Flat keyed files: "key value" per line
+    auto readKeyed = [&leaf](const std::string& file, const std::function<void(const std::string&, long long)>& visit) {
+        std::ifstream stream(leaf + "/" + file);
+        std::string key;
+        long long value = 0;
+        while (stream >> key >> value) {
+            visit(key, value);
+        }
+    };
+
+    std::ifstream peak(leaf + "/memory.peak");
+    long long peak_bytes = 0;
+    if (peak >> peak_bytes) {
+        usage.peak_memory_kb = static_cast<long>(peak_bytes / 1024);
+    }
+
+    readKeyed("cpu.stat", [&usage](const std::string& key, long long value) {
+        if (key == "user_usec") usage.user_time_ms = static_cast<long>(value / 1000);
+        if (key == "system_usec") usage.system_time_ms = static_cast<long>(value / 1000);
+    });
+    readKeyed("memory.events", [&usage](const std::string& key, long long value) {
+        if (key == "oom_kill") usage.oom_kills = static_cast<long>(value);
+    });
+
+    // io.stat lines are "<major>:<minor> rbytes=N wbytes=N rios=N ..."
+    std::ifstream io(leaf + "/io.stat");
+    std::string token;
+    while (io >> token) {
+        if (token.rfind("rbytes=", 0) == 0) {
+            usage.io_read_bytes += std::stol(token.substr(7));
+        } else if (token.rfind("wbytes=", 0) == 0) {
+            usage.io_write_bytes += std::stol(token.substr(7));
+        }
+    }
+
+    return usage;
+}
+
+void Sandbox::removeCgroup(const std::string& leaf) {
+    for (int attempt = 0; attempt < 50; ++attempt) {
+        if (rmdir(leaf.c_str()) == 0 || errno == ENOENT) {
+            return;
+        }
+        if (errno != EBUSY) {
+            break;
+        }
+        // Namespace teardown is asynchronous; make sure nothing survived
+        std::ofstream(leaf + "/cgroup.kill") << "1";
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    Logger::getInstance().warning("Failed to remove cgroup " + leaf, "Sandbox");
+}
+
+bool Sandbox::setupCgroups(const std::string& cgroup_root) {
+    if (cgroup_root.empty()) {
+        return false;
+    }
+
+    auto readFile = [](const std::filesystem::path& path) {
+        std::ifstream file(path);
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        return buffer.str();
+    };
+    auto enable = [](const std::filesystem::path& directory) {
+        for (const char* controller : {"+memory", "+pids", "+cpu", "+io"}) {
+            std::ofstream(directory / "cgroup.subtree_control") << controller;
+        }
+    };
+
+    std::filesystem::path root(cgroup_root);
+    std::filesystem::path parent = root.parent_path();
+    std::string available = readFile(parent / "cgroup.controllers");
+    if (available.find("memory") == std::string::npos || available.find("pids") == std::string::npos) {
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(root, ec);
+    if (ec) {
+        return false;
+    }
+
+    // Leaves only get the controllers both ancestors delegate to them
+    enable(parent);
+    enable(root);
+
+    std::string delegated = readFile(root / "cgroup.subtree_control");
+    if (delegated.find("memory") == std::string::npos || delegated.find("pids") == std::string::npos) {
+        return false;
+    }
+
+    // Leaves left behind by a previous crash
+    for (const auto& entry : std::filesystem::directory_iterator(root, ec)) {
+        if (entry.is_directory() && entry.path().filename().string().rfind("run-", 0) == 0) {
+            removeCgroup(entry.path().string());
+        }
+    }
+
+    return true;
+}
+
+std::vector<sock_filter> Sandbox::buildSeccompFilter() {
+#if defined(__x86_64__)
+    constexpr uint32_t arch = AUDIT_ARCH_X86_64;
+#elif defined(__aarch64__)
+    constexpr uint32_t arch = AUDIT_ARCH_AARCH64;
+#else
+    return {};
+#endif
+
+#if defined(__x86_64__) || defined(__aarch64__)
+    const uint32_t deny = SECCOMP_RET_ERRNO | (EPERM & SECCOMP_RET_DATA);
+    const uint32_t namespace_flags = CLONE_NEWNS | CLONE_NEWCGROUP | CLONE_NEWUTS | CLONE_NEWIPC |
+                                     CLONE_NEWUSER | CLONE_NEWPID | CLONE_NEWNET;
+
+    // System calls a program has no business making inside the sandbox
+    const std::vector<long> denied = {
+        __NR_mount, __NR_umount2, __NR_pivot_root, __NR_chroot, __NR_ptrace,
+        __NR_process_vm_readv, __NR_process_vm_writev, __NR_kexec_load,
+        __NR_init_module, __NR_finit_module, __NR_delete_module, __NR_reboot,
+        __NR_swapon, __NR_swapoff, __NR_bpf, __NR_perf_event_open, __NR_unshare,
+        __NR_setns, __NR_keyctl, __NR_add_key, __NR_request_key, __NR_userfaultfd,
+        __NR_open_by_handle_at, __NR_name_to_handle_at, __NR_acct, __NR_settimeofday,
+        __NR_clock_settime, __NR_adjtimex, __NR_syslog, __NR_sethostname,
+        __NR_setdomainname, __NR_quotactl, __NR_fanotify_init, __NR_io_uring_setup,
+#ifdef __NR_kexec_file_load
+        __NR_kexec_file_load,
+#endif
+#ifdef __NR_fsopen
+        __NR_fsopen, __NR_fsmount, __NR_move_mount, __NR_open_tree, __NR_fspick,
+#endif
+#if defined(__x86_64__)
+        __NR_iopl, __NR_ioperm,
+#endif
+    };
+
+    std::vector<sock_filter> filter;
+    auto statement = [&filter](uint16_t code, uint32_t k) {
+        filter.push_back(BPF_STMT(code, k));
+    };
+    auto jump = [&filter](uint16_t code, uint32_t k, uint8_t jt, uint8_t jf) {
+        filter.push_back(BPF_JUMP(code, k, jt, jf));
+    };
+
+    statement(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, arch));
+    jump(BPF_JMP | BPF_JEQ | BPF_K, arch, 1, 0);
+    statement(BPF_RET | BPF_K, SECCOMP_RET_KILL_PROCESS);
+
+    statement(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, nr));
+#if defined(__x86_64__)
+    // x32 system calls would bypass every rule below
+    jump(BPF_JMP | BPF_JGE | BPF_K, 0x40000000, 0, 1);
+    statement(BPF_RET | BPF_K, deny);
+#endif
+
+    for (long number : denied) {
+        jump(BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>(number), 0, 1);
+        statement(BPF_RET | BPF_K, deny);
+    }
+
+    // clone3 passes its flags in memory seccomp cannot inspect; ENOSYS makes
+    // libc fall back to clone, whose flags are checked below
+    jump(BPF_JMP | BPF_JEQ | BPF_K, __NR_clone3, 0, 1);
+    statement(BPF_RET | BPF_K, SECCOMP_RET_ERRNO | (ENOSYS & SECCOMP_RET_DATA));
+
+    jump(BPF_JMP | BPF_JEQ | BPF_K, __NR_clone, 1, 0);
+    statement(BPF_RET | BPF_K, SECCOMP_RET_ALLOW);
+    statement(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, args[0]));
+    jump(BPF_JMP | BPF_JSET | BPF_K, namespace_flags, 0, 1);
+    statement(BPF_RET | BPF_K, deny);
+    statement(BPF_RET | BPF_K, SECCOMP_RET_ALLOW);
+
+    return filter;
+#endif
+}
+
+} // namespace cpp_mastery
@@ -0,0 +1,733 @@
+// File: cpp-engine/src/compiler/sandbox_pool.cpp
+// Extension: .cpp
+
+#include "compiler/sandbox_pool.hpp"
+#include "compiler/jit_runner.hpp"
+#include "utils/logger.hpp"
+
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+#include <cerrno>
+#include <cstring>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mount.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+namespace cpp_mastery {
+
+namespace {
+
+// Control protocol between the pool and a slot. Both ends are the same
+// binary, so the structs are sent as raw bytes.
+struct SlotRequest {
+    SandboxLimits limits;
+    int64_t timeout_ms = 0;
+    bool rlimit_memory = false;
+    bool jit = false;            // the first descriptor is a bitcode module, not an executable
+};
+
+struct SlotResponse {
+    int32_t status = 0;          // wait status of the program
+    int32_t error = 0;           // errno if the slot could not run it
+    struct rusage usage {};
+    int64_t wall_time_ms = 0;
+    bool timed_out = false;
+    bool retire = false;         // the slot could not be scrubbed and is exiting
+    bool jit_started = false;    // the module linked and main() was entered
+    char jit_error[256] = {};    // why a JIT run never started
+};
+
+// Executable (or module), stdin, stdout, stderr
+constexpr size_t kRequestFds = 4;
+constexpr char kReady = 'R';
+
+constexpr std::chrono::seconds kSlotStartTimeout{5};
+constexpr uint64_t kMaxRunsPerSlot = 256;
+
+// Slack on top of the run timeout before the pool stops trusting the slot
+// to enforce it itself
+constexpr std::chrono::seconds kTimeoutGrace{1};
+
+// Weight of the newest sample in the busy-slot moving average
+constexpr double kBusyAverageWeight = 0.2;
+
+// ---- Slot side; single-threaded, so ordinary calls are fine ----
+
+void serveRequest(const SlotRequest& request, const int* fds, const Sandbox::Plan& base,
+                  const sigset_t& child_signals, SlotResponse& response) {
+    Sandbox::Plan plan = base;
+    plan.limits = request.limits;
+    plan.rlimit_memory = request.rlimit_memory;
+    plan.executable_fd = fds[0];
+    char program_name[] = "main";
+    plan.argv = {program_name, nullptr};
+
+    // A JIT worker reports on this pipe whether its module linked
+    int jit_status[2] = {-1, -1};
+    if (request.jit && pipe2(jit_status, O_CLOEXEC | O_NONBLOCK) == -1) {
+        response.error = errno;
+        return;
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid == -1) {
+        response.error = errno;
+        if (request.jit) {
+            close(jit_status[0]);
+            close(jit_status[1]);
+        }
+        return;
+    }
+
+    if (pid == 0) {
+        setpgid(0, 0);
+        sigset_t empty_mask;
+        sigemptyset(&empty_mask);
+        sigprocmask(SIG_SETMASK, &empty_mask, nullptr);
+        dup2(fds[1], STDIN_FILENO);
+        dup2(fds[2], STDOUT_FILENO);
+        dup2(fds[3], STDERR_FILENO);
+        if (request.jit) {
+            // No exec follows, so close-on-exec protects nothing: the
+            // program must not inherit the control socket
+            close(SandboxPool::kControlFd);
+            close(jit_status[0]);
+            for (size_t i = 1; i < kRequestFds; ++i) {
+                close(fds[i]);
+            }
+        }
+        if (Sandbox::applyRestrictions(plan)) {
+            if (request.jit) {
+                _exit(JitRunner::run(fds[0], jit_status[1]));
+            }
+            fexecve(plan.executable_fd, plan.argv.data(), plan.envp.data());
+            const char message[] = "sandbox: fexecve failed\n";
+            [[maybe_unused]] ssize_t written = write(STDERR_FILENO, message, sizeof(message) - 1);
+        }
+        _exit(126);
+    }
+
+    if (request.jit) {
+        close(jit_status[1]);
+    }
+
+    auto deadline = start_time + std::chrono::milliseconds(request.timeout_ms);
+    int status = 0;
+    struct rusage usage {};
+    for (;;) {
+        pid_t done = wait4(pid, &status, WNOHANG, &usage);
+        if (done == pid || (done == -1 && errno != EINTR)) {
+            break;
+        }
+
+        if (request.timeout_ms <= 0) {
+            sigwaitinfo(&child_signals, nullptr);
+            continue;
+        }
+        auto remaining = deadline - std::chrono::steady_clock::now();
+        if (remaining <= std::chrono::nanoseconds::zero()) {
+            response.timed_out = true;
+            kill(-pid, SIGKILL);
+            kill(pid, SIGKILL);
+            while (wait4(pid, &status, 0, &usage) == -1 && errno == EINTR) {
+            }
+            break;
+        }
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(remaining);
+        struct timespec wait_time {
+            static_cast<time_t>(seconds.count()),
+            static_cast<long>(std::chrono::duration_cast<std::chrono::nanoseconds>(remaining - seconds).count())
+        };
+        sigtimedwait(&child_signals, nullptr, &wait_time);
+    }
+
+    response.status = status;
+    response.wall_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time).count();
+    response.usage = usage;
+
+    if (request.jit) {
+        char report[sizeof(response.jit_error)] = {};
+        ssize_t bytes = read(jit_status[0], report, sizeof(report) - 1);
+        close(jit_status[0]);
+        response.jit_started = bytes == 1 && report[0] == JitRunner::kStarted;
+        if (!response.jit_started) {
+            std::strncpy(response.jit_error, bytes > 0 ? report : "JIT worker exited before main()",
+                         sizeof(response.jit_error) - 1);
+        }
+    }
+}
+
+// Kill whatever the program left behind and start the next run with an empty /tmp
+bool scrubSlot(const Sandbox::Plan& base) {
+    kill(-1, SIGKILL);
+    for (;;) {
+        if (waitpid(-1, nullptr, 0) > 0 || errno == EINTR) {
+            continue;
+        }
+        break;
+    }
+
+    return umount2("/tmp", MNT_DETACH) == 0 &&
+           mount("tmpfs", "/tmp", "tmpfs", MS_NOSUID | MS_NODEV, base.tmp_mount_options.c_str()) == 0;
+}
+
+} // namespace
+
+struct SandboxPool::Slot {
+    pid_t pid = -1;
+    UniqueFd control;
+    std::future<ProcessResult> exit;
+    std::string cgroup_leaf;
+    size_t memory_bytes = 0;
+    uint64_t runs = 0;
+};
+
+SandboxPool::SandboxPool(Sandbox& sandbox, size_t min_slots, size_t max_slots)
+    : sandbox_(sandbox), min_slots_(min_slots), max_slots_(std::max(min_slots, max_slots)) {
+}
+
+SandboxPool::~SandboxPool() {
+    std::vector<std::shared_ptr<Slot>> idle;
+    std::vector<std::future<void>> maintenance;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shutting_down_ = true;
+        idle.swap(idle_);
+        maintenance.swap(maintenance_);
+    }
+    slot_available_.notify_all();
+
+    for (auto& task : maintenance) {
+        task.wait();
+    }
+    for (const auto& slot : idle) {
+        retire(slot);
+    }
+}
+
+bool SandboxPool::initialize(const SandboxLimits& limits) {
+    slot_limits_ = limits;
+
+    auto start_time = std::chrono::steady_clock::now();
+    replenish();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time).count();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Logger::getInstance().info("Sandbox pool started " + std::to_string(idle_.size()) + " slots in " +
+                               std::to_string(elapsed) + "ms (max " + std::to_string(max_slots_) + ")", "SandboxPool");
+    return !idle_.empty();
+}
+
+ProcessResult SandboxPool::run(const std::string& executable_path, std::string_view input,
+                               const SandboxLimits& limits, std::chrono::milliseconds timeout,
+                               OutputCallback on_output, std::shared_ptr<CancellationToken> cancellation) {
+    std::shared_ptr<Slot> slot = acquire();
+    if (!slot) {
+        fallbacks_++;
+        return sandbox_.run({executable_path}, limits, timeout, input, std::move(on_output),
+                            std::move(cancellation));
+    }
+
+    UniqueFd executable(open(executable_path.c_str(), O_RDONLY | O_CLOEXEC));
+    if (!executable.valid()) {
+        release(slot, true);
+        ProcessResult result;
+        result.exit_code = 127;
+        result.stderr = "Cannot open executable: " + executable_path;
+        return result;
+    }
+
+    auto result = dispatch(slot, std::move(executable), false, input, limits, timeout, on_output, cancellation, nullptr);
+    if (!result) {
+        fallbacks_++;
+        return sandbox_.run({executable_path}, limits, timeout, input, std::move(on_output),
+                            std::move(cancellation));
+    }
+    return *result;
+}
+
+std::optional<ProcessResult> SandboxPool::runBitcode(std::string_view bitcode, std::string_view input,
+                                                     const SandboxLimits& limits, std::chrono::milliseconds timeout,
+                                                     OutputCallback on_output,
+                                                     std::shared_ptr<CancellationToken> cancellation,
+                                                     std::string& unsupported_reason) {
+    std::shared_ptr<Slot> slot = acquire();
+    if (!slot) {
+        unsupported_reason = "No sandbox slot available";
+        return std::nullopt;
+    }
+
+    UniqueFd module = createInputFd(bitcode);
+    if (!module.valid()) {
+        release(slot, true);
+        unsupported_reason = "Failed to pass the module: " + std::string(std::strerror(errno));
+        return std::nullopt;
+    }
+
+    std::string jit_error;
+    auto result = dispatch(slot, std::move(module), true, input, limits, timeout, std::move(on_output),
+                           std::move(cancellation), &jit_error);
+    if (!result) {
+        unsupported_reason = "Sandbox slot unreachable";
+        return std::nullopt;
+    }
+    if (!jit_error.empty()) {
+        jit_unsupported_++;
+        unsupported_reason = jit_error;
+        return std::nullopt;
+    }
+    jit_runs_++;
+    return result;
+}
+
+std::optional<ProcessResult> SandboxPool::dispatch(const std::shared_ptr<Slot>& slot, UniqueFd payload, bool jit,
+                                                   std::string_view input, const SandboxLimits& limits,
+                                                   std::chrono::milliseconds timeout, OutputCallback on_output,
+                                                   std::shared_ptr<CancellationToken> cancellation,
+                                                   std::string* jit_error) {
+    ProcessResult result;
+
+    UniqueFd stdin_fd = createInputFd(input);
+    if (!stdin_fd.valid()) {
+        release(slot, true);
+        result.stderr = "Failed to prepare stdin: " + std::string(std::strerror(errno));
+        return result;
+    }
+
+    int stdout_pipe[2], stderr_pipe[2];
+    if (pipe2(stdout_pipe, O_CLOEXEC) == -1) {
+        release(slot, true);
+        result.stderr = "Failed to create stdout pipe: " + std::string(std::strerror(errno));
+        return result;
+    }
+    UniqueFd stdout_read(stdout_pipe[0]), stdout_write(stdout_pipe[1]);
+    if (pipe2(stderr_pipe, O_CLOEXEC) == -1) {
+        release(slot, true);
+        result.stderr = "Failed to create stderr pipe: " + std::string(std::strerror(errno));
+        return result;
+    }
+    UniqueFd stderr_read(stderr_pipe[0]), stderr_write(stderr_pipe[1]);
+
+    // The slot's cgroup was sized for the default limits; follow per-run overrides
+    if (!slot->cgroup_leaf.empty() && limits.memory_bytes != slot->memory_bytes) {
+        std::ofstream(slot->cgroup_leaf + "/memory.max")
+            << (limits.memory_bytes > 0 ? std::to_string(limits.memory_bytes) : "max");
+        slot->memory_bytes = limits.memory_bytes;
+    }
+
+    SlotRequest request;
+    request.limits = limits;
+    request.timeout_ms = timeout.count();
+    request.rlimit_memory = slot->cgroup_leaf.empty();
+    request.jit = jit;
+
+    int fds[kRequestFds] = {payload.get(), stdin_fd.get(), stdout_write.get(), stderr_write.get()};
+    alignas(cmsghdr) char control_buffer[CMSG_SPACE(sizeof(fds))] = {};
+    struct iovec iov { &request, sizeof(request) };
+    struct msghdr message {};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control_buffer;
+    message.msg_controllen = sizeof(control_buffer);
+    struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(fds));
+    std::memcpy(CMSG_DATA(header), fds, sizeof(fds));
+
+    // The slot's leaf outlives the run, so OOM kills are counted as a delta
+    long oom_kills_before = slot->cgroup_leaf.empty() ? 0 : Sandbox::readCgroupUsage(slot->cgroup_leaf).oom_kills;
+
+    auto start_time = std::chrono::steady_clock::now();
+    if (sendmsg(slot->control.get(), &message, MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(request))) {
+        Logger::getInstance().warning("Sandbox slot unreachable: " + std::string(std::strerror(errno)), "SandboxPool");
+        release(slot, false);
+        return std::nullopt;
+    }
+
+    // Only the program may hold the write ends, or the pipes never reach EOF
+    stdout_write.reset();
+    stderr_write.reset();
+    stdin_fd.reset();
+    payload.reset();
+
+    auto healthy = std::make_shared<bool>(false);
+    auto jit_report = std::make_shared<std::string>();
+
+    AttachOptions options;
+    options.stdout_fd = std::move(stdout_read);
+    options.stderr_fd = std::move(stderr_read);
+    options.status_fd = UniqueFd(fcntl(slot->control.get(), F_DUPFD_CLOEXEC, 0));
+    options.timeout = timeout + kTimeoutGrace;
+    options.max_output_bytes = limits.max_output_bytes;
+    options.on_output = std::move(on_output);
+    options.cancellation = std::move(cancellation);
+    options.on_status = [healthy, jit, jit_report](const std::string& record, ProcessResult& result) {
+        SlotResponse response;
+        if (record.size() != sizeof(response)) {
+            result.exit_code = -1;
+            result.stderr += "Malformed response from sandbox slot\n";
+            return;
+        }
+        std::memcpy(&response, record.data(), sizeof(response));
+        *healthy = !response.retire;
+        if (jit && !response.jit_started) {
+            *jit_report = response.jit_error;
+        }
+
+        if (response.error != 0) {
+            result.exit_code = -1;
+            result.stderr += "Sandbox slot failed: " + std::string(std::strerror(response.error)) + "\n";
+            return;
+        }
+        if (WIFEXITED(response.status)) {
+            result.exit_code = WEXITSTATUS(response.status);
+        } else if (WIFSIGNALED(response.status)) {
+            result.term_signal = WTERMSIG(response.status);
+            result.exit_code = 128 + result.term_signal;
+        }
+        applyResourceUsage(response.usage, result);
+        result.wall_time_ms = response.wall_time_ms;
+        result.timed_out = result.timed_out || response.timed_out;
+    };
+    // The slot missed its own deadline or the run was cancelled; take it
+    // down with everything inside
+    options.on_timeout = [pid = slot->pid]() {
+        kill(-pid, SIGKILL);
+    };
+
+    result = ProcessSupervisor::getInstance().attach(std::move(options)).get();
+    runs_++;
+    slot->runs++;
+    if (!slot->cgroup_leaf.empty()) {
+        result.oom_killed = Sandbox::readCgroupUsage(slot->cgroup_leaf).oom_kills > oom_kills_before;
+    }
+
+    if (!*healthy) {
+        Logger::getInstance().warning("Discarding sandbox slot after " + std::to_string(
+            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time).count()) +
+            "ms run", "SandboxPool");
+    }
+    release(slot, *healthy);
+    // A slot that never replied may have run the program; only its own
+    // report that main() was not reached makes the run safe to repeat
+    if (jit_error) {
+        *jit_error = *jit_report;
+    }
+    return result;
+}
+
+nlohmann::json SandboxPool::getStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    uint64_t acquisitions = acquisitions_.load();
+    double average_wait_ms = acquisitions > 0 ? total_wait_us_.load() / 1000.0 / acquisitions : 0.0;
+
+    return nlohmann::json{
+        {"enabled", true},
+        {"slots", {
+            {"total", total_slots_},
+            {"idle", idle_.size()},
+            {"busy", busy_slots_},
+            {"min", min_slots_},
+            {"max", max_slots_}
+        }},
+        {"busy_average", busy_average_},
+        {"wait_ms", {
+            {"average", average_wait_ms},
+            {"max", max_wait_us_.load() / 1000.0}
+        }},
+        {"runs", runs_.load()},
+        {"fallbacks", fallbacks_.load()},
+        {"jit_runs", jit_runs_.load()},
+        {"jit_unsupported", jit_unsupported_.load()},
+        {"slots_started", slots_started_.load()},
+        {"slots_retired", slots_retired_.load()},
+        {"start_failures", start_failures_.load()}
+    };
+}
+
+int SandboxPool::runSlot() {
+    // Our own binary, passed in only so the launcher could fexecve() it
+    close(kControlFd + 1);
+    fcntl(kControlFd, F_SETFD, FD_CLOEXEC);
+
+    // Programs run with the same uid as this process; without this they could
+    // open /proc/1/mem and take over the slot
+    prctl(PR_SET_DUMPABLE, 0);
+
+    sigset_t child_signals;
+    sigemptyset(&child_signals);
+    sigaddset(&child_signals, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &child_signals, nullptr);
+
+    const Sandbox::Plan base = Sandbox::restrictionPlan(SandboxLimits{}, false);
+
+    // Workers fork from here, so each JIT run starts with the target ready
+    JitRunner::initialize();
+
+    if (send(kControlFd, &kReady, 1, MSG_NOSIGNAL) != 1) {
+        return 1;
+    }
+
+    for (;;) {
+        SlotRequest request;
+        alignas(cmsghdr) char control_buffer[CMSG_SPACE(sizeof(int) * kRequestFds)];
+        struct iovec iov { &request, sizeof(request) };
+        struct msghdr message {};
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        message.msg_control = control_buffer;
+        message.msg_controllen = sizeof(control_buffer);
+
+        ssize_t bytes = recvmsg(kControlFd, &message, MSG_CMSG_CLOEXEC);
+        if (bytes == -1 && errno == EINTR) {
+            continue;
+        }
+        if (bytes <= 0) {
+            // The pool closed the socket: retire quietly
+            return bytes == 0 ? 0 : 1;
+        }
+
+        int fds[kRequestFds];
+        size_t fd_count = 0;
+        for (struct cmsghdr* header = CMSG_FIRSTHDR(&message); header != nullptr; header = CMSG_NXTHDR(&message, header)) {
+            if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS) {
+                continue;
+            }
+            size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            const unsigned char* data = CMSG_DATA(header);
+            for (size_t i = 0; i < count; ++i) {
+                int fd;
+                std::memcpy(&fd, data + i * sizeof(int), sizeof(int));
+                if (fd_count < kRequestFds) {
+                    fds[fd_count++] = fd;
+                } else {
+                    close(fd);
+                }
+            }
+        }
+
+        SlotResponse response;
+        if (bytes != static_cast<ssize_t>(sizeof(request)) || fd_count != kRequestFds || (message.msg_flags & MSG_CTRUNC)) {
+            response.error = EPROTO;
+        } else {
+            serveRequest(request, fds, base, child_signals, response);
+        }
+        for (size_t i = 0; i < fd_count; ++i) {
+            close(fds[i]);
+        }
+
+        response.retire = !scrubSlot(base);
+        if (send(kControlFd, &response, sizeof(response), MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(response)) ||
+            response.retire) {
+            return 1;
+        }
+    }
+}
+
+std::shared_ptr<SandboxPool::Slot> SandboxPool::startSlot() {
+    auto& logger = Logger::getInstance();
+
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets) != 0) {
+        start_failures_++;
+        logger.warning("Failed to create slot control socket: " + std::string(std::strerror(errno)), "SandboxPool");
+        return nullptr;
+    }
+    auto slot = std::make_shared<Slot>();
+    slot->control.reset(sockets[0]);
+    UniqueFd helper_end(sockets[1]);
+
+    UniqueFd executable(open("/proc/self/exe", O_RDONLY | O_CLOEXEC));
+    if (!executable.valid()) {
+        start_failures_++;
+        logger.warning("Cannot open /proc/self/exe: " + std::string(std::strerror(errno)), "SandboxPool");
+        return nullptr;
+    }
+
+    std::optional<std::string> leaf = sandbox_.cgroupsAvailable() ? sandbox_.createCgroup(slot_limits_) : std::nullopt;
+    slot->cgroup_leaf = leaf.value_or("");
+    slot->memory_bytes = slot_limits_.memory_bytes;
+
+    // The helper gets its control socket at kControlFd and its own binary
+    // right after it, which is what the isolated child fexecve()s
+    Sandbox::Plan plan = sandbox_.makePlan(slot_limits_, slot->cgroup_leaf);
+    plan.executable_fd = kControlFd + 1;
+    std::string program_name = "sandbox-slot";
+    std::string flag = kSlotFlag;
+    plan.argv = {program_name.data(), flag.data(), nullptr};
+
+    ProcessOptions options;
+    options.args = {"/proc/self/exe", kSlotFlag};
+    options.inherit_fds = {helper_end.get(), executable.get()};
+    options.max_output_bytes = 64 * 1024;
+    options.pre_exec = [&plan]() {
+        if (!Sandbox::enterIsolation(plan)) {
+            return false;
+        }
+        fexecve(plan.executable_fd, plan.argv.data(), plan.envp.data());
+        return false;
+    };
+
+    slot->exit = ProcessSupervisor::getInstance().spawn(options, &slot->pid);
+    helper_end.reset();
+    executable.reset();
+
+    struct pollfd ready_poll { slot->control.get(), POLLIN, 0 };
+    char ready = 0;
+    int polled = poll(&ready_poll, 1, static_cast<int>(std::chrono::milliseconds(kSlotStartTimeout).count()));
+    if (polled != 1 || recv(slot->control.get(), &ready, 1, 0) != 1 || ready != kReady) {
+        start_failures_++;
+        if (slot->pid > 0) {
+            kill(-slot->pid, SIGKILL);
+        }
+        ProcessResult exit = slot->exit.get();
+        logger.warning("Sandbox slot failed to start (exit code " + std::to_string(exit.exit_code) + "): " +
+                       exit.stderr.substr(0, 500), "SandboxPool");
+        if (!slot->cgroup_leaf.empty()) {
+            sandbox_.removeCgroup(slot->cgroup_leaf);
+        }
+        return nullptr;
+    }
+
+    slots_started_++;
+    return slot;
+}
+
+std::shared_ptr<SandboxPool::Slot> SandboxPool::acquire() {
+    auto start_time = std::chrono::steady_clock::now();
+    std::shared_ptr<Slot> slot;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!slot) {
+        if (shutting_down_) {
+            return nullptr;
+        }
+        if (!idle_.empty()) {
+            slot = std::move(idle_.back());
+            idle_.pop_back();
+        } else if (total_slots_ < max_slots_) {
+            // Grow: start a slot for this request outside the lock
+            total_slots_++;
+            lock.unlock();
+            slot = startSlot();
+            lock.lock();
+            if (!slot) {
+                total_slots_--;
+                slot_available_.notify_one();
+                return nullptr;
+            }
+        } else {
+            slot_available_.wait(lock);
+        }
+    }
+
+    busy_slots_++;
+    busy_average_ += kBusyAverageWeight * (static_cast<double>(busy_slots_) - busy_average_);
+    lock.unlock();
+
+    uint64_t waited = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+    acquisitions_++;
+    total_wait_us_ += waited;
+    uint64_t previous_max = max_wait_us_.load();
+    while (waited > previous_max && !max_wait_us_.compare_exchange_weak(previous_max, waited)) {
+    }
+
+    return slot;
+}
+
+void SandboxPool::release(std::shared_ptr<Slot> slot, bool healthy) {
+    bool keep = false;
+    bool shutting_down = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        busy_slots_--;
+        busy_average_ += kBusyAverageWeight * (static_cast<double>(busy_slots_) - busy_average_);
+
+        shutting_down = shutting_down_;
+        keep = healthy && !shutting_down && slot->runs < kMaxRunsPerSlot && idle_.size() < targetIdleSlots();
+        if (keep) {
+            idle_.push_back(slot);
+        } else {
+            total_slots_--;
+            if (!shutting_down) {
+                // Drop finished tasks so the list stays short
+                maintenance_.erase(std::remove_if(maintenance_.begin(), maintenance_.end(), [](const std::future<void>& task) {
+                    return task.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+                }), maintenance_.end());
+                maintenance_.push_back(std::async(std::launch::async, [this, slot]() {
+                    retire(slot);
+                    replenish();
+                }));
+            }
+        }
+    }
+    slot_available_.notify_one();
+
+    if (!keep && shutting_down) {
+        retire(slot);
+    }
+}
+
+void SandboxPool::retire(const std::shared_ptr<Slot>& slot) {
+    if (slot->pid > 0) {
+        kill(-slot->pid, SIGKILL);
+    }
+    slot->control.reset();
+    if (slot->exit.valid()) {
+        slot->exit.wait();
+    }
+    if (!slot->cgroup_leaf.empty()) {
+        sandbox_.removeCgroup(slot->cgroup_leaf);
+    }
+    slots_retired_++;
+}
+
+void SandboxPool::replenish() {
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (shutting_down_ || total_slots_ >= min_slots_) {
+                return;
+            }
+            total_slots_++;
+        }
+
+        std::shared_ptr<Slot> slot = startSlot();
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!slot) {
+            total_slots_--;
+            return;
+        }
+        if (shutting_down_) {
+            total_slots_--;
+            lock.unlock();
+            retire(slot);
+            return;
+        }
+        idle_.push_back(std::move(slot));
+        lock.unlock();
+        slot_available_.notify_one();
+    }
+}
+
+size_t SandboxPool::targetIdleSlots() const {
+    // Keep enough slots for the recent average load plus headroom; anything
+    // beyond that is retired as it comes back
+    size_t target = std::max(min_slots_, static_cast<size_t>(std::ceil(busy_average_ * 1.25)) + 1);
+    target = std::min(target, max_slots_);
+    return target > busy_slots_ ? target - busy_slots_ : 0;
+}
+
+} // namespace cpp_mastery
@@ -0,0 +1,548 @@
+// File: cpp-engine/src/compiler/wasm_runtime.cpp
+// Extension: .cpp
+
+#include "compiler/wasm_runtime.hpp"
+#include "compiler/compilation_cache.hpp"
+#include "utils/config.hpp"
+#include "utils/logger.hpp"
+
+#ifdef HAVE_WASMTIME
+#include <wasi.h>
+#include <wasmtime.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace cpp_mastery {
+
+namespace {
+
+// Epoch length; deadlines, cancellation and output size are checked once per tick
+constexpr std::chrono::milliseconds kEpochTick{1};
+
+long threadCpuTimeMs() {
+    timespec now{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return static_cast<long>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
+
+// Reads up to limit bytes (0 for all) of a memfd the program wrote
+std::string readOutput(int fd, size_t limit, bool& truncated) {
+    struct stat info{};
+    if (fstat(fd, &info) != 0) {
+        return "";
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    if (limit > 0 && size > limit) {
+        size = limit;
+        truncated = true;
+    }
+    std::string data(size, '\0');
+    size_t offset = 0;
+    while (offset < size) {
+        ssize_t bytes = pread(fd, data.data() + offset, size - offset, static_cast<off_t>(offset));
+        if (bytes <= 0) {
+            break;
+        }
+        offset += static_cast<size_t>(bytes);
+    }
+    data.resize(offset);
+    return data;
+}
+
+std::string fdPath(int fd) {
+    return "/proc/self/fd/" + std::to_string(fd);
+}
+
+} // namespace
+
+struct WasmRuntime::State {
+    size_t workers;
+    size_t module_cache_size;
+    bool ready = false;
+
+    std::atomic<uint64_t> runs{0};
+    std::atomic<uint64_t> traps{0};
+    std::atomic<uint64_t> out_of_fuel{0};
+    std::atomic<uint64_t> timeouts{0};
+    std::atomic<uint64_t> cache_hits{0};
+    std::atomic<uint64_t> cache_misses{0};
+    std::atomic<uint64_t> instantiations{0};
+    std::atomic<uint64_t> instantiate_us_total{0};
+    std::atomic<uint64_t> instantiate_us_max{0};
+
+#ifdef HAVE_WASMTIME
+    wasm_engine_t* engine = nullptr;
+    wasmtime_linker_t* linker = nullptr;
+
+    // Compiled modules by content hash, most recently used first
+    using ModulePtr = std::shared_ptr<wasmtime_module_t>;
+    std::mutex cache_mutex;
+    std::list<std::string> lru;
+    std::unordered_map<std::string, std::pair<ModulePtr, std::list<std::string>::iterator>> modules;
+
+    // Runs waiting for a worker
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::deque<std::packaged_task<ProcessResult()>> queue;
+    std::vector<std::thread> threads;
+    bool stopping = false;
+
+    // Advances the engine epoch every kEpochTick
+    std::thread ticker;
+    std::atomic<bool> ticking{false};
+
+    std::string compileModule(const std::string& module_path, ModulePtr& module);
+    ProcessResult execute(wasmtime_module_t* module, std::string_view input, const WasmLimits& limits,
+                          const std::shared_ptr<CancellationToken>& cancellation);
+    void workerLoop();
+    void tickerLoop();
+#endif
+};
+
+#ifdef HAVE_WASMTIME
+
+namespace {
+
+// Per-run state seen by the epoch callback
+struct RunContext {
+    std::chrono::steady_clock::time_point deadline;
+    bool has_deadline = false;
+    std::shared_ptr<CancellationToken> cancellation;
+    int stdout_fd = -1;
+    int stderr_fd = -1;
+    size_t max_output_bytes = 0;
+
+    bool timed_out = false;
+    bool cancelled = false;
+    bool output_exceeded = false;
+};
+
+bool exceedsOutput(int fd, size_t limit) {
+    struct stat info{};
+    return limit > 0 && fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) > limit;
+}
+
+wasmtime_error_t* onEpoch(wasmtime_context_t*, void* data, uint64_t* delta, wasmtime_update_deadline_kind_t* kind) {
+    auto* run = static_cast<RunContext*>(data);
+    if (run->cancellation && run->cancellation->cancelled()) {
+        run->cancelled = true;
+        return wasmtime_error_new("cancelled");
+    }
+    if (run->has_deadline && std::chrono::steady_clock::now() >= run->deadline) {
+        run->timed_out = true;
+        return wasmtime_error_new("time limit exceeded");
+    }
+    if (exceedsOutput(run->stdout_fd, run->max_output_bytes) || exceedsOutput(run->stderr_fd, run->max_output_bytes)) {
+        run->output_exceeded = true;
+        return wasmtime_error_new("output limit exceeded");
+    }
+    *delta = 1;
+    *kind = WASMTIME_UPDATE_DEADLINE_CONTINUE;
+    return nullptr;
+}
+
+std::string takeMessage(wasmtime_error_t* error) {
+    wasm_name_t message;
+    wasmtime_error_message(error, &message);
+    std::string text(message.data, message.size);
+    wasm_byte_vec_delete(&message);
+    wasmtime_error_delete(error);
+    return text;
+}
+
+std::string trapMessage(const wasm_trap_t* trap) {
+    wasm_message_t message;
+    wasm_trap_message(trap, &message);
+    std::string text(message.data, message.size);
+    wasm_byte_vec_delete(&message);
+    // wasm_message_t counts the terminating NUL
+    if (!text.empty() && text.back() == '\0') {
+        text.pop_back();
+    }
+    return text;
+}
+
+// Signal a native program would have died of for the same fault
+int trapSignal(wasmtime_trap_code_t code) {
+    switch (code) {
+        case WASMTIME_TRAP_CODE_OUT_OF_FUEL:
+            return SIGXCPU;
+        case WASMTIME_TRAP_CODE_UNREACHABLE_CODE_REACHED:
+            return SIGABRT;
+        case WASMTIME_TRAP_CODE_INTEGER_OVERFLOW:
+        case WASMTIME_TRAP_CODE_INTEGER_DIVISION_BY_ZERO:
+        case WASMTIME_TRAP_CODE_BAD_CONVERSION_TO_INTEGER:
+            return SIGFPE;
+        case WASMTIME_TRAP_CODE_INTERRUPT:
+            return SIGKILL;
+        default:
+            return SIGSEGV;
+    }
+}
+
+void setSignal(ProcessResult& result, int signal) {
+    result.term_signal = signal;
+    result.exit_code = 128 + signal;
+}
+
+} // namespace
+
+std::string WasmRuntime::State::compileModule(const std::string& module_path, ModulePtr& module) {
+    std::ifstream file(module_path, std::ios::binary);
+    if (!file.is_open()) {
+        return "Cannot read module " + module_path;
+    }
+    std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::string hash = CompilationCache::sha256Hex(bytes);
+
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto cached = modules.find(hash);
+        if (cached != modules.end()) {
+            lru.splice(lru.begin(), lru, cached->second.second);
+            module = cached->second.first;
+            cache_hits++;
+            return "";
+        }
+    }
+
+    // Compiled outside the lock; two misses on the same module both compile it
+    cache_misses++;
+    wasmtime_module_t* compiled = nullptr;
+    if (wasmtime_error_t* error = wasmtime_module_new(engine, reinterpret_cast<const uint8_t*>(bytes.data()),
+                                                      bytes.size(), &compiled)) {
+        return "Invalid module: " + takeMessage(error);
+    }
+    module = ModulePtr(compiled, wasmtime_module_delete);
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if (modules.find(hash) == modules.end()) {
+        lru.push_front(hash);
+        modules.emplace(hash, std::make_pair(module, lru.begin()));
+        if (modules.size() > module_cache_size) {
+            modules.erase(lru.back());
+            lru.pop_back();
+        }
+    }
+    return "";
+}
+
+ProcessResult WasmRuntime::State::execute(wasmtime_module_t* module, std::string_view input, const WasmLimits& limits,
+                                          const std::shared_ptr<CancellationToken>& cancellation) {
+    ProcessResult result;
+    auto start_time = std::chrono::steady_clock::now();
+
+    if (cancellation && cancellation->cancelled()) {
+        result.cancelled = true;
+        setSignal(result, SIGKILL);
+        return result;
+    }
+
+    UniqueFd stdin_fd = createInputFd(input);
+    UniqueFd stdout_fd(memfd_create("wasm-stdout", MFD_CLOEXEC));
+    UniqueFd stderr_fd(memfd_create("wasm-stderr", MFD_CLOEXEC));
+    if (!stdin_fd.valid() || !stdout_fd.valid() || !stderr_fd.valid()) {
+        result.stderr = "Cannot create the program's standard streams";
+        return result;
+    }
+
+    RunContext run;
+    run.has_deadline = limits.timeout.count() > 0;
+    run.deadline = start_time + limits.timeout;
+    run.cancellation = cancellation;
+    run.stdout_fd = stdout_fd.get();
+    run.stderr_fd = stderr_fd.get();
+    run.max_output_bytes = limits.max_output_bytes;
+
+    wasmtime_store_t* store = wasmtime_store_new(engine, nullptr, nullptr);
+    wasmtime_context_t* context = wasmtime_store_context(store);
+    wasmtime_store_limiter(store, limits.memory_bytes > 0 ? static_cast<int64_t>(limits.memory_bytes) : -1,
+                           -1, -1, -1, -1);
+    wasmtime_store_epoch_deadline_callback(store, onEpoch, &run, nullptr);
+    wasmtime_context_set_epoch_deadline(context, 1);
+
+    // Without a CPU limit the program still has to stop at the deadline
+    uint64_t fuel = limits.fuel > 0 ? limits.fuel : UINT64_MAX;
+    wasmtime_error_t* error = wasmtime_context_set_fuel(context, fuel);
+
+    // argv and the three standard streams; nothing of the file system is preopened
+    if (!error) {
+        wasi_config_t* wasi = wasi_config_new();
+        const char* argv[] = {"main"};
+        wasi_config_set_argv(wasi, 1, argv);
+        wasi_config_set_stdin_file(wasi, fdPath(stdin_fd.get()).c_str());
+        wasi_config_set_stdout_file(wasi, fdPath(stdout_fd.get()).c_str());
+        wasi_config_set_stderr_file(wasi, fdPath(stderr_fd.get()).c_str());
+        error = wasmtime_context_set_wasi(context, wasi);
+    }
+
+    wasm_trap_t* trap = nullptr;
+    wasmtime_instance_t instance;
+    long cpu_start = threadCpuTimeMs();
+    if (!error) {
+        auto instantiate_start = std::chrono::steady_clock::now();
+        error = wasmtime_linker_instantiate(linker, context, module, &instance, &trap);
+        auto instantiate_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - instantiate_start).count());
+        instantiations++;
+        instantiate_us_total += instantiate_us;
+        uint64_t previous = instantiate_us_max.load();
+        while (instantiate_us > previous && !instantiate_us_max.compare_exchange_weak(previous, instantiate_us)) {
+        }
+    }
+
+    bool instantiated = !error && !trap;
+    if (instantiated) {
+        wasmtime_extern_t start;
+        if (wasmtime_instance_export_get(context, &instance, "_start", 6, &start) && start.kind == WASMTIME_EXTERN_FUNC) {
+            error = wasmtime_func_call(context, &start.of.func, nullptr, 0, nullptr, 0, &trap);
+            wasmtime_extern_delete(&start);
+        } else {
+            result.stderr = "Module has no _start; was it linked as a WASI command?";
+        }
+    }
+    result.cpu_time_ms = threadCpuTimeMs() - cpu_start;
+    result.user_time_ms = result.cpu_time_ms;
+
+    // proc_exit() surfaces as an error carrying the status; anything else stopped the program
+    int exit_status = 0;
+    std::string failure;
+    if (error && wasmtime_error_exit_status(error, &exit_status)) {
+        result.exit_code = exit_status;
+        wasmtime_error_delete(error);
+    } else if (run.cancelled || run.timed_out || run.output_exceeded) {
+        result.cancelled = run.cancelled;
+        result.timed_out = run.timed_out;
+        result.output_truncated = run.output_exceeded;
+        setSignal(result, SIGKILL);
+        if (error) {
+            wasmtime_error_delete(error);
+        }
+        if (trap) {
+            wasm_trap_delete(trap);
+        }
+    } else if (trap) {
+        traps++;
+        wasmtime_trap_code_t code;
+        int signal = wasmtime_trap_code(trap, &code) ? trapSignal(code) : SIGSEGV;
+        if (signal == SIGXCPU) {
+            out_of_fuel++;
+        }
+        setSignal(result, signal);
+        failure = trapMessage(trap);
+        wasm_trap_delete(trap);
+    } else if (error) {
+        failure = takeMessage(error);
+        result.exit_code = -1;
+    } else if (instantiated && result.stderr.empty()) {
+        // _start returned without proc_exit(), which wasi-libc only does for exit code 0
+        result.exit_code = 0;
+    }
+    if (run.timed_out) {
+        timeouts++;
+    }
+
+    // Linear memory never shrinks, so its final size is the peak
+    if (instantiated) {
+        wasmtime_extern_t memory;
+        if (wasmtime_instance_export_get(context, &instance, "memory", 6, &memory)) {
+            if (memory.kind == WASMTIME_EXTERN_MEMORY) {
+                result.memory_usage_kb = static_cast<long>(wasmtime_memory_data_size(context, &memory.of.memory) / 1024);
+            }
+            wasmtime_extern_delete(&memory);
+        }
+    }
+    wasmtime_store_delete(store);
+
+    bool stdout_truncated = false;
+    bool stderr_truncated = false;
+    result.stdout = readOutput(stdout_fd.get(), limits.max_output_bytes, stdout_truncated);
+    std::string program_stderr = readOutput(stderr_fd.get(), limits.max_output_bytes, stderr_truncated);
+    result.output_truncated = result.output_truncated || stdout_truncated || stderr_truncated;
+    result.stderr = program_stderr + result.stderr;
+    if (!failure.empty()) {
+        result.stderr += (result.stderr.empty() || result.stderr.back() == '\n' ? "" : "\n") + failure + "\n";
+    }
+
+    result.wall_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time).count();
+    return result;
+}
+
+void WasmRuntime::State::workerLoop() {
+    for (;;) {
+        std::packaged_task<ProcessResult()> task;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_cv.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty()) {
+                return;
+            }
+            task = std::move(queue.front());
+            queue.pop_front();
+        }
+        task();
+    }
+}
+
+void WasmRuntime::State::tickerLoop() {
+    while (ticking) {
+        std::this_thread::sleep_for(kEpochTick);
+        wasmtime_engine_increment_epoch(engine);
+    }
+}
+
+#endif
+
+WasmRuntime::WasmRuntime(size_t workers, size_t module_cache_size)
+    : state_(std::make_unique<State>()) {
+    state_->workers = std::max<size_t>(1, workers);
+    state_->module_cache_size = std::max<size_t>(1, module_cache_size);
+}
+
+WasmRuntime::~WasmRuntime() {
+#ifdef HAVE_WASMTIME
+    {
+        std::lock_guard<std::mutex> lock(state_->queue_mutex);
+        state_->stopping = true;
+    }
+    state_->queue_cv.notify_all();
+    for (auto& thread : state_->threads) {
+        thread.join();
+    }
+    state_->ticking = false;
+    if (state_->ticker.joinable()) {
+        state_->ticker.join();
+    }
+    state_->modules.clear();
+    if (state_->linker) {
+        wasmtime_linker_delete(state_->linker);
+    }
+    if (state_->engine) {
+        wasm_engine_delete(state_->engine);
+    }
+#endif
+}
+
+bool WasmRuntime::initialize() {
+#ifdef HAVE_WASMTIME
+    wasm_config_t* config = wasm_config_new();
+    wasmtime_config_consume_fuel_set(config, true);
+    wasmtime_config_epoch_interruption_set(config, true);
+    state_->engine = wasm_engine_new_with_config(config);
+    if (!state_->engine) {
+        Logger::getInstance().error("Cannot create the Wasmtime engine", "WasmRuntime");
+        return false;
+    }
+
+    state_->linker = wasmtime_linker_new(state_->engine);
+    if (wasmtime_error_t* error = wasmtime_linker_define_wasi(state_->linker)) {
+        Logger::getInstance().error("Cannot define WASI imports: " + takeMessage(error), "WasmRuntime");
+        return false;
+    }
+
+    for (size_t i = 0; i < state_->workers; ++i) {
+        state_->threads.emplace_back([this] { state_->workerLoop(); });
+    }
+    state_->ticking = true;
+    state_->ticker = std::thread([this] { state_->tickerLoop(); });
+    state_->ready = true;
+
+    Logger::getInstance().info("WebAssembly runtime ready with " + std::to_string(state_->workers) + " workers",
+                               "WasmRuntime");
+    return true;
+#else
+    Logger::getInstance().warning("Engine built without Wasmtime; the wasm backend is unavailable", "WasmRuntime");
+    return false;
+#endif
+}
+
+ProcessResult WasmRuntime::run(const std::string& module_path, std::string_view input, const WasmLimits& limits,
+                               const OutputCallback& on_output, std::shared_ptr<CancellationToken> cancellation) {
+    ProcessResult result;
+    if (!state_->ready) {
+        result.stderr = "WebAssembly runtime not initialized";
+        return result;
+    }
+    state_->runs++;
+
+#ifdef HAVE_WASMTIME
+    State::ModulePtr module;
+    std::string error = state_->compileModule(module_path, module);
+    if (!error.empty()) {
+        result.stderr = error;
+        return result;
+    }
+
+    // The task owns copies of everything, so it outlives a caller that stopped waiting
+    std::packaged_task<ProcessResult()> task(
+        [state = state_.get(), module, input = std::string(input), limits, cancellation] {
+            return state->execute(module.get(), input, limits, cancellation);
+        });
+    std::future<ProcessResult> finished = task.get_future();
+    {
+        std::lock_guard<std::mutex> lock(state_->queue_mutex);
+        state_->queue.push_back(std::move(task));
+    }
+    state_->queue_cv.notify_one();
+    result = finished.get();
+#endif
+
+    if (on_output) {
+        if (!result.stdout.empty()) {
+            on_output(STDOUT_FILENO, result.stdout);
+        }
+        if (!result.stderr.empty()) {
+            on_output(STDERR_FILENO, result.stderr);
+        }
+        if (result.output_truncated) {
+            on_output(STDOUT_FILENO, std::string_view());
+        }
+    }
+    return result;
+}
+
+nlohmann::json WasmRuntime::getStatistics() const {
+    uint64_t instantiations = state_->instantiations.load();
+    return nlohmann::json{
+        {"enabled", state_->ready},
+        {"workers", state_->workers},
+        {"runs", state_->runs.load()},
+        {"traps", state_->traps.load()},
+        {"out_of_fuel", state_->out_of_fuel.load()},
+        {"timeouts", state_->timeouts.load()},
+        {"module_cache_hits", state_->cache_hits.load()},
+        {"module_cache_misses", state_->cache_misses.load()},
+        {"average_instantiate_us", instantiations ? state_->instantiate_us_total.load() / instantiations : 0},
+        {"max_instantiate_us", state_->instantiate_us_max.load()}
+    };
+}
+
+WasmLimits WasmRuntime::limitsFromConfig(const ExecutionConfig& config) {
+    WasmLimits limits;
+    limits.memory_bytes = static_cast<size_t>(config.max_memory_mb) * 1024 * 1024;
+    limits.fuel = static_cast<uint64_t>(std::max(0, config.max_cpu_time)) * config.wasm_fuel_per_second;
+    limits.timeout = std::chrono::seconds(config.execution_timeout);
+    limits.max_output_bytes = config.max_output_size;
+    return limits;
+}
+
+} // namespace cpp_mastery
@@ -16,6 +16,7 @@
 #include "analyzer/code_analyzer.hpp"
 #include "parser/ast_parser.hpp"
 #include "compiler/execution_engine.hpp"
+#include "compiler/sandbox_pool.hpp"
 
 // Global server instance for signal handling
 std::unique_ptr<cpp_mastery::Server> g_server = nullptr;
@@ -165,6 +166,12 @@ bool performHealthChecks() {
 
 // Main application entry point
 int main(int argc, char* argv[]) {
+    // Sandbox pool slots re-execute this binary; they must not touch the
+    // logger, configuration or anything else the server sets up
+    if (argc > 1 && std::string(argv[1]) == cpp_mastery::SandboxPool::kSlotFlag) {
+        return cpp_mastery::SandboxPool::runSlot();
+    }
+    
     try {
         // Initialize logging first
         auto& logger = cpp_mastery::Logger::getInstance();
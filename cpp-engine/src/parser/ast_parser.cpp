@@ -2,6 +2,8 @@
 // Extension: .cpp
 
 #include "parser/ast_parser.hpp"
+#include "parser/preamble_cache.hpp"
+#include "parser/source_file_system.hpp"
 #include "utils/logger.hpp"
 #include "utils/config.hpp"
 
@@ -12,18 +14,22 @@
 #include <clang/Frontend/ASTConsumers.h>
 #include <clang/Frontend/CompilerInstance.h>
 #include <clang/Frontend/FrontendActions.h>
+#include <clang/Frontend/TextDiagnosticPrinter.h>
+#include <clang/Frontend/Utils.h>
+#include <clang/Basic/IdentifierTable.h>
+#include <clang/Lex/Lexer.h>
 #include <clang/Lex/Preprocessor.h>
 #include <clang/Parse/ParseAST.h>
 #include <clang/Rewrite/Core/Rewriter.h>
 #include <clang/Tooling/CommonOptionsParser.h>
 #include <clang/Tooling/Tooling.h>
 
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/VirtualFileSystem.h>
 #include <llvm/Support/raw_ostream.h>
 #include <nlohmann/json.hpp>
 
-#include <fstream>
-#include <sstream>
-#include <filesystem>
+#include <algorithm>
 
 using json = nlohmann::json;
 using namespace clang;
@@ -35,6 +41,69 @@ namespace cpp_mastery {
 std::unique_ptr<ASTParser> ASTParser::instance_ = nullptr;
 std::mutex ASTParser::mutex_;
 
+namespace {
+
+// Name the parsed code is given; locations in the AST refer to it
+constexpr const char* kMainFile = "input.cpp";
+
+// Flags every parse uses; part of the preamble key
+const std::vector<std::string> kParseFlags = {
+    "-std=c++20",
+    "-I/usr/include",
+    "-I/usr/local/include"
+};
+
+// Language the token stream is lexed as; the same standard the parse uses
+const LangOptions& lexerOptions() {
+    static const LangOptions options = [] {
+        LangOptions lang;
+        lang.CPlusPlus = lang.CPlusPlus11 = lang.CPlusPlus14 = lang.CPlusPlus17 = lang.CPlusPlus20 = 1;
+        lang.LineComment = 1;
+        lang.Bool = 1;
+        lang.WChar = 1;
+        lang.Char8 = 1;
+        lang.Digraphs = 1;
+        lang.CXXOperatorNames = 1;
+        return lang;
+    }();
+    return options;
+}
+
+// Keywords of that language; only read after construction, so safe to share
+const IdentifierTable& keywordTable() {
+    static const IdentifierTable table(lexerOptions());
+    return table;
+}
+
+// Highlighting class of a raw token
+const char* tokenKind(const Token& token) {
+    switch (token.getKind()) {
+        case tok::raw_identifier: {
+            auto keyword = keywordTable().find(token.getRawIdentifier());
+            if (keyword != keywordTable().end() && keyword->getValue()->getTokenID() != tok::identifier) {
+                return "keyword";
+            }
+            return "identifier";
+        }
+        case tok::numeric_constant:
+            return "number";
+        case tok::char_constant:
+        case tok::wide_char_constant:
+        case tok::utf8_char_constant:
+        case tok::utf16_char_constant:
+        case tok::utf32_char_constant:
+            return "char";
+        case tok::comment:
+            return "comment";
+        case tok::unknown:
+            return "unknown";
+        default:
+            return tok::isStringLiteral(token.getKind()) ? "string" : "punctuation";
+    }
+}
+
+} // namespace
+
 class ASTVisitor : public RecursiveASTVisitor<ASTVisitor> {
 public:
     explicit ASTVisitor(ASTContext* context) : context_(context), json_ast_(json::object()) {}
@@ -257,30 +326,49 @@ private:
 
 class ASTConsumerImpl : public ASTConsumer {
 public:
-    explicit ASTConsumerImpl(ASTVisitor* visitor) : visitor_(visitor) {}
+    explicit ASTConsumerImpl(json& ast) : ast_(ast) {}
+
+    // Declarations deserialized from a preamble are not passed here, so
+    // the traversal below never loads the standard headers' declarations
+    bool HandleTopLevelDecl(DeclGroupRef group) override {
+        for (Decl* decl : group) {
+            top_level_decls_.push_back(decl);
+        }
+        return true;
+    }
 
     void HandleTranslationUnit(ASTContext& context) override {
-        visitor_->TraverseDecl(context.getTranslationUnitDecl());
+        ASTVisitor visitor(&context);
+        const SourceManager& sources = context.getSourceManager();
+        for (Decl* decl : top_level_decls_) {
+            if (sources.isInMainFile(decl->getLocation())) {
+                visitor.TraverseDecl(decl);
+            }
+        }
+        ast_ = visitor.getAST();
     }
 
 private:
-    ASTVisitor* visitor_;
+    json& ast_;
+    std::vector<Decl*> top_level_decls_;
 };
 
 class FrontendActionImpl : public ASTFrontendAction {
 public:
-    explicit FrontendActionImpl(ASTVisitor* visitor) : visitor_(visitor) {}
+    explicit FrontendActionImpl(json& ast) : ast_(ast) {}
 
     std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance& ci, StringRef file) override {
-        return std::make_unique<ASTConsumerImpl>(visitor_);
+        return std::make_unique<ASTConsumerImpl>(ast_);
     }
 
 private:
-    ASTVisitor* visitor_;
+    json& ast_;
 };
 
 ASTParser::ASTParser() : initialized_(false) {}
 
+ASTParser::~ASTParser() = default;
+
 ASTParser& ASTParser::getInstance() {
     std::lock_guard<std::mutex> lock(mutex_);
     if (instance_ == nullptr) {
@@ -301,8 +389,8 @@ bool ASTParser::initialize() {
     try {
         logger.info("Initializing AST parser...", "ASTParser");
         
-        // Test that Clang libraries are available
-        // This is a simple test to ensure linking is correct
+        size_t budget_mb = static_cast<size_t>(std::max(0, Config::getInstance().getAnalysisConfig().preamble_cache_mb));
+        preambles_ = std::make_unique<PreambleCache>(budget_mb * 1024 * 1024);
         initialized_ = true;
         
         logger.info("AST parser initialized successfully", "ASTParser");
@@ -328,82 +416,85 @@ ParseResult ASTParser::parse(const std::string& code, bool include_tokens) {
     auto start_time = std::chrono::high_resolution_clock::now();
 
     try {
-        // Generate unique filename for this parsing session
-        std::string session_id = generateSessionId();
-        std::string temp_file = "temp/" + session_id + ".cpp";
+        const std::string& clang_path = Config::getInstance().getCompilerConfig().clang_path;
         
-        // Create temp directory if it doesn't exist
-        std::filesystem::create_directories("temp");
+        // The driver turns the flags into a frontend invocation; clang_path
+        // locates Clang's builtin headers
+        std::vector<const char*> argv = {clang_path.c_str(), "-fsyntax-only", "-xc++"};
+        std::string flags;
+        for (const auto& flag : kParseFlags) {
+            argv.push_back(flag.c_str());
+            flags += flag + "\n";
+        }
+        argv.push_back(kMainFile);
+        
+        std::string diagnostics_text;
+        llvm::raw_string_ostream diagnostic_stream(diagnostics_text);
+        llvm::IntrusiveRefCntPtr<DiagnosticOptions> diagnostic_options = new DiagnosticOptions();
+        llvm::IntrusiveRefCntPtr<DiagnosticsEngine> diagnostics = CompilerInstance::createDiagnostics(
+            &*diagnostic_options, new TextDiagnosticPrinter(diagnostic_stream, &*diagnostic_options));
+        // The code is parsed from memory and system headers come from the
+        // shared in-memory cache; nothing is written to disk
+        llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> files = SourceFileSystem::forSource(kMainFile, code);
         
-        // Write code to temporary file
-        std::ofstream file(temp_file);
-        if (!file.is_open()) {
-            result.error_message = "Failed to create temporary file";
+        std::shared_ptr<CompilerInvocation> invocation = createInvocationFromCommandLine(argv, diagnostics, files);
+        if (!invocation) {
+            diagnostic_stream.flush();
+            result.error_message = "Invalid parser command line: " + diagnostics_text;
             return result;
         }
-        file << code;
-        file.close();
-
-        // Prepare arguments for Clang
-        std::vector<std::string> args = {
-            "ast-parser",
-            temp_file,
-            "--",
-            "-std=c++20",
-            "-I/usr/include",
-            "-I/usr/local/include"
-        };
-
-        // Convert to char* array
-        std::vector<const char*> argv;
-        for (const auto& arg : args) {
-            argv.push_back(arg.c_str());
+        
+        std::unique_ptr<llvm::MemoryBuffer> buffer = llvm::MemoryBuffer::getMemBufferCopy(code, kMainFile);
+        
+        // Reuse the parsed #include block when an earlier parse had the same one
+        auto preamble = preambles_->get(*invocation, *buffer, flags, files);
+        if (preamble) {
+            preamble->AddImplicitPreamble(*invocation, files, buffer.get());
+            // The buffer is now a remapped file, which the preprocessor frees
+            // once it is set up
+            buffer.release();
         }
-
-        // Create AST visitor
-        ASTVisitor visitor(nullptr);
-
-        // Run Clang tool
-        bool tool_result = runToolOnCode(
-            std::make_unique<FrontendActionImpl>(&visitor),
-            code,
-            temp_file
-        );
+        
+        CompilerInstance instance(preambles_->pchOperations());
+        instance.setInvocation(std::move(invocation));
+        // The driver asks for -disable-free, which would leak every AST
+        instance.getFrontendOpts().DisableFree = false;
+        instance.setDiagnostics(diagnostics.get());
+        instance.createFileManager(files);
+        
+        json ast = json::object();
+        FrontendActionImpl action(ast);
+        bool tool_result = instance.ExecuteAction(action);
+        diagnostic_stream.flush();
 
         auto end_time = std::chrono::high_resolution_clock::now();
         result.parse_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
 
         if (tool_result) {
             result.success = true;
-            result.ast_json = visitor.getAST();
+            result.ast_json = std::move(ast);
             
             // Add metadata
             result.ast_json["metadata"] = {
                 {"parse_time_ms", result.parse_time_ms},
-                {"source_file", temp_file},
+                {"source_file", kMainFile},
+                {"preamble_reused", preamble != nullptr},
                 {"timestamp", std::chrono::duration_cast<std::chrono::milliseconds>(
                     std::chrono::system_clock::now().time_since_epoch()).count()}
             };
 
             // Generate tokens if requested
             if (include_tokens) {
-                result.tokens = generateTokens(code);
+                result.tokens = tokensToJson(generateTokens(code));
             }
 
             logger.info("AST parsing completed successfully", "ASTParser");
         } else {
             result.success = false;
-            result.error_message = "Failed to parse AST";
+            result.error_message = "Failed to parse AST" + (diagnostics_text.empty() ? "" : ":\n" + diagnostics_text);
             logger.error("AST parsing failed", "ASTParser");
         }
 
-        // Clean up temporary file
-        try {
-            std::filesystem::remove(temp_file);
-        } catch (const std::exception& e) {
-            logger.warning("Failed to remove temporary file: " + std::string(e.what()), "ASTParser");
-        }
-
         return result;
 
     } catch (const std::exception& e) {
@@ -413,63 +504,94 @@ ParseResult ASTParser::parse(const std::string& code, bool include_tokens) {
     }
 }
 
-json ASTParser::generateTokens(const std::string& code) {
-    json tokens = json::array();
+std::vector<SourceToken> ASTParser::generateTokens(const std::string& code) const {
+    std::vector<SourceToken> tokens;
+    // Code averages a token every few bytes; one allocation for most inputs
+    tokens.reserve(code.size() / 4 + 16);
     
-    try {
-        // Simple tokenization - in a full implementation, this would use
-        // Clang's Lexer for proper tokenization
-        std::istringstream stream(code);
-        std::string line;
-        int line_number = 1;
-        
-        while (std::getline(stream, line)) {
-            // Basic keyword detection (simplified)
-            std::vector<std::string> keywords = {
-                "int", "char", "float", "double", "void", "bool",
-                "class", "struct", "enum", "namespace",
-                "if", "else", "while", "for", "do", "switch", "case", "break", "continue",
-                "return", "const", "static", "virtual", "override", "final",
-                "public", "private", "protected",
-                "#include", "#define", "#ifdef", "#endif"
-            };
-            
-            size_t pos = 0;
-            for (const auto& keyword : keywords) {
-                pos = 0;
-                while ((pos = line.find(keyword, pos)) != std::string::npos) {
-                    json token = {
-                        {"type", "keyword"},
-                        {"value", keyword},
-                        {"line", line_number},
-                        {"column", pos + 1}
-                    };
-                    tokens.push_back(token);
-                    pos += keyword.length();
-                }
+    // Raw mode needs no preprocessor, Sema or headers: directives and
+    // macros are lexed as the tokens they are spelled with
+    const char* begin = code.c_str();
+    Lexer lexer(SourceLocation(), lexerOptions(), begin, begin, begin + code.size());
+    lexer.SetCommentRetentionState(true);
+    
+    // Line and column are advanced incrementally, so the whole pass is linear
+    size_t position = 0;
+    uint32_t line = 1;
+    uint32_t column = 1;
+    auto emit = [&](const char* kind, size_t offset, size_t length) {
+        for (; position < offset; ++position) {
+            if (code[position] == '\n') {
+                line++;
+                column = 1;
+            } else {
+                column++;
             }
-            
-            line_number++;
         }
+        tokens.push_back(SourceToken{kind, static_cast<uint32_t>(offset), static_cast<uint32_t>(length), line, column});
+    };
+    
+    Token token;
+    bool in_directive = false;
+    while (true) {
+        lexer.LexFromRawLexer(token);
+        if (token.is(tok::eof)) {
+            break;
+        }
+        size_t length = token.getLength();
+        size_t offset = static_cast<size_t>(lexer.getBufferLocation() - begin) - length;
         
-    } catch (const std::exception& e) {
-        Logger::getInstance().warning("Token generation failed: " + std::string(e.what()), "ASTParser");
+        if (token.isAtStartOfLine()) {
+            in_directive = false;
+        }
+        if (token.is(tok::hash) && token.isAtStartOfLine()) {
+            // '#' and the directive name form one token, e.g. "#include"
+            Token name;
+            lexer.LexFromRawLexer(name);
+            if (name.is(tok::raw_identifier) && !name.isAtStartOfLine()) {
+                size_t end = static_cast<size_t>(lexer.getBufferLocation() - begin);
+                emit("directive", offset, end - offset);
+                in_directive = name.getRawIdentifier() == "include" || name.getRawIdentifier() == "include_next" ||
+                               name.getRawIdentifier() == "import";
+                continue;
+            }
+            emit("punctuation", offset, length);
+            token = name;
+            if (token.is(tok::eof)) {
+                break;
+            }
+            length = token.getLength();
+            offset = static_cast<size_t>(lexer.getBufferLocation() - begin) - length;
+        }
+        if (in_directive && token.is(tok::less)) {
+            // <header> is lexed as separate tokens; report it as one string
+            in_directive = false;
+            size_t end = code.find_first_of(">\n", offset);
+            if (end != std::string::npos && code[end] == '>') {
+                emit("string", offset, end + 1 - offset);
+                lexer.seek(static_cast<unsigned>(end + 1), false);
+                continue;
+            }
+        }
+        emit(tokenKind(token), offset, length);
     }
     
     return tokens;
 }
 
-std::string ASTParser::generateSessionId() {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<> dis(0, 15);
-    
-    std::string session_id;
-    for (int i = 0; i < 8; ++i) {
-        session_id += "0123456789abcdef"[dis(gen)];
+json ASTParser::tokensToJson(const std::vector<SourceToken>& tokens) {
+    json array = json::array();
+    for (const auto& token : tokens) {
+        array.push_back(json::array({token.kind, token.offset, token.length, token.line, token.column}));
     }
-    
-    return session_id;
+    return array;
+}
+
+json ASTParser::getStatistics() const {
+    return json{
+        {"preambles", preambles_ ? preambles_->getStatistics() : json{{"enabled", false}}},
+        {"headers", SourceFileSystem::shared()->getStatistics()}
+    };
 }
 
 bool ASTParser::validateSyntax(const std::string& code) {
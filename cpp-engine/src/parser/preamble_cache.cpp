@@ -0,0 +1,125 @@
+// File: cpp-engine/src/parser/preamble_cache.cpp
+// Extension: .cpp
+
+#include "parser/preamble_cache.hpp"
+#include "compiler/compilation_cache.hpp"
+#include "utils/logger.hpp"
+
+#include <clang/Basic/Diagnostic.h>
+#include <clang/Basic/DiagnosticOptions.h>
+#include <clang/Frontend/CompilerInvocation.h>
+#include <clang/Lex/PreprocessorOptions.h>
+#include <clang/Serialization/PCHContainerOperations.h>
+
+#include <chrono>
+
+namespace cpp_mastery {
+
+PreambleCache::PreambleCache(size_t budget_bytes)
+    : budget_bytes_(budget_bytes), pch_operations_(std::make_shared<clang::PCHContainerOperations>()) {
+}
+
+std::shared_ptr<const clang::PrecompiledPreamble> PreambleCache::get(const clang::CompilerInvocation& invocation,
+                                                                     const llvm::MemoryBuffer& main_file,
+                                                                     const std::string& flags,
+                                                                     llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> files) {
+    if (budget_bytes_ == 0) {
+        return nullptr;
+    }
+
+    clang::PreambleBounds bounds = clang::ComputePreambleBounds(*invocation.getLangOpts(), main_file.getMemBufferRef(), 0);
+    if (bounds.Size == 0) {
+        return nullptr;
+    }
+    std::string key = CompilationCache::sha256Hex(flags + '\0' + main_file.getBuffer().substr(0, bounds.Size).str());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto cached = entries_.find(key);
+        if (cached != entries_.end()) {
+            // Also false when a header it read has changed since it was built
+            if (cached->second.preamble->CanReuse(invocation, main_file.getMemBufferRef(), bounds, *files)) {
+                lru_.splice(lru_.begin(), lru_, cached->second.position);
+                hits_++;
+                return cached->second.preamble;
+            }
+            stale_++;
+            erase(cached);
+        }
+    }
+    misses_++;
+
+    // Built outside the lock; concurrent misses on one key each build it and the first is kept
+    auto start_time = std::chrono::steady_clock::now();
+    llvm::IntrusiveRefCntPtr<clang::DiagnosticOptions> diagnostic_options = new clang::DiagnosticOptions();
+    clang::IgnoringDiagConsumer ignore;
+    clang::DiagnosticsEngine diagnostics(
+        llvm::IntrusiveRefCntPtr<clang::DiagnosticIDs>(new clang::DiagnosticIDs()), &*diagnostic_options, &ignore, false);
+    clang::PreambleCallbacks callbacks;
+    auto built = clang::PrecompiledPreamble::Build(invocation, &main_file, bounds, diagnostics, files, pch_operations_,
+                                                   true, callbacks);
+    builds_++;
+    build_ms_total_ += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time).count());
+
+    if (!built || diagnostics.hasErrorOccurred()) {
+        build_failures_++;
+        if (!built) {
+            Logger::getInstance().warning("Preamble build failed: " + built.getError().message(), "PreambleCache");
+        }
+        return nullptr;
+    }
+
+    std::shared_ptr<const clang::PrecompiledPreamble> preamble =
+        std::make_shared<clang::PrecompiledPreamble>(std::move(*built));
+    insert(key, preamble);
+    return preamble;
+}
+
+void PreambleCache::insert(const std::string& key, std::shared_ptr<const clang::PrecompiledPreamble> preamble) {
+    size_t bytes = preamble->getSize();
+
+    // Still used by the parse that built it, just not kept
+    if (bytes > budget_bytes_) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entries_.count(key) > 0) {
+        return;
+    }
+    while (bytes_ + bytes > budget_bytes_ && !lru_.empty()) {
+        evictions_++;
+        erase(entries_.find(lru_.back()));
+    }
+    lru_.push_front(key);
+    entries_[key] = Entry{std::move(preamble), bytes, lru_.begin()};
+    bytes_ += bytes;
+}
+
+void PreambleCache::erase(std::unordered_map<std::string, Entry>::iterator entry) {
+    // Parses holding the preamble keep it alive until they finish
+    bytes_ -= entry->second.bytes;
+    lru_.erase(entry->second.position);
+    entries_.erase(entry);
+}
+
+nlohmann::json PreambleCache::getStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t builds = builds_.load();
+    return nlohmann::json{
+        {"enabled", budget_bytes_ > 0},
+        {"entries", entries_.size()},
+        {"bytes", bytes_},
+        {"budget_bytes", budget_bytes_},
+        {"hits", hits_.load()},
+        {"misses", misses_.load()},
+        {"stale", stale_.load()},
+        {"builds", builds},
+        {"build_failures", build_failures_.load()},
+        {"evictions", evictions_.load()},
+        {"average_build_ms", builds ? build_ms_total_.load() / builds : 0}
+    };
+}
+
+} // namespace cpp_mastery
@@ -0,0 +1,287 @@
+// File: cpp-engine/src/parser/source_file_system.cpp
+// Extension: .cpp
+
+#include "parser/source_file_system.hpp"
+
+#include <llvm/Support/MemoryBuffer.h>
+
+#include <mutex>
+
+namespace cpp_mastery {
+
+namespace {
+
+// Bytes of header contents the shared instance keeps
+constexpr size_t kSharedHeaderBytes = 128 * 1024 * 1024;
+
+// Paths the shared instance remembers as missing
+constexpr size_t kSharedMissingPaths = 64 * 1024;
+
+// How long the shared instance trusts an entry before it stats the file again
+constexpr std::chrono::milliseconds kSharedRevalidateAfter{2000};
+
+// A file whose contents are held by the cache
+class CachedFile : public llvm::vfs::File {
+public:
+    CachedFile(llvm::vfs::Status status, std::shared_ptr<const std::string> contents)
+        : status_(std::move(status)), contents_(std::move(contents)) {}
+
+    llvm::ErrorOr<llvm::vfs::Status> status() override {
+        return status_;
+    }
+
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> getBuffer(const llvm::Twine& name, int64_t, bool requires_null_terminator,
+                                                                 bool) override {
+        // std::string keeps a terminating NUL after the contents
+        return llvm::MemoryBuffer::getMemBuffer(*contents_, name.str(), requires_null_terminator);
+    }
+
+    std::error_code close() override {
+        return {};
+    }
+
+private:
+    llvm::vfs::Status status_;
+    std::shared_ptr<const std::string> contents_;
+};
+
+// Replaced, rewritten or touched files differ in one of these
+bool sameFile(const llvm::vfs::Status& a, const llvm::vfs::Status& b) {
+    return a.getUniqueID() == b.getUniqueID() && a.getSize() == b.getSize() &&
+           a.getLastModificationTime() == b.getLastModificationTime();
+}
+
+} // namespace
+
+SourceFileSystem::SourceFileSystem(llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> underlying,
+                                   std::vector<std::string> cached_prefixes, size_t max_bytes, size_t max_missing,
+                                   std::chrono::milliseconds revalidate_after)
+    : ProxyFileSystem(std::move(underlying)), cached_prefixes_(std::move(cached_prefixes)), max_bytes_(max_bytes),
+      max_missing_(max_missing), revalidate_after_(revalidate_after) {
+}
+
+llvm::IntrusiveRefCntPtr<SourceFileSystem> SourceFileSystem::shared() {
+    static llvm::IntrusiveRefCntPtr<SourceFileSystem> instance = llvm::makeIntrusiveRefCnt<SourceFileSystem>(
+        llvm::vfs::getRealFileSystem(),
+        std::vector<std::string>{"/usr/include/", "/usr/local/include/", "/usr/lib/"},
+        kSharedHeaderBytes, kSharedMissingPaths, kSharedRevalidateAfter);
+    return instance;
+}
+
+llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> SourceFileSystem::forSource(llvm::StringRef name, llvm::StringRef code) {
+    auto memory = llvm::makeIntrusiveRefCnt<llvm::vfs::InMemoryFileSystem>();
+    auto files = llvm::makeIntrusiveRefCnt<llvm::vfs::OverlayFileSystem>(shared());
+    // Pushing gives the layer the process working directory, which relative
+    // names added afterwards resolve against
+    files->pushOverlay(memory);
+    memory->addFile(name, 0, llvm::MemoryBuffer::getMemBufferCopy(code, name));
+    return files;
+}
+
+bool SourceFileSystem::cacheable(const std::string& path) const {
+    for (const auto& prefix : cached_prefixes_) {
+        if (path.compare(0, prefix.size(), prefix) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::optional<SourceFileSystem::Entry> SourceFileSystem::lookup(const std::string& path, bool& missing) {
+    auto now = Clock::now();
+    std::optional<Entry> held;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto entry = entries_.find(path);
+        if (entry != entries_.end()) {
+            if (now - entry->second.checked_at < revalidate_after_) {
+                return entry->second;
+            }
+            held = entry->second;
+        } else {
+            auto absent = missing_.find(path);
+            if (absent == missing_.end()) {
+                return std::nullopt;
+            }
+            if (now - absent->second.checked_at < revalidate_after_) {
+                missing = true;
+                return std::nullopt;
+            }
+        }
+    }
+
+    // Stale: one stat tells whether what is held still matches the disk
+    revalidations_++;
+    auto current = ProxyFileSystem::status(path);
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (held) {
+        auto entry = entries_.find(path);
+        if (current && entry != entries_.end() && sameFile(*current, entry->second.status)) {
+            entry->second.checked_at = now;
+            return entry->second;
+        }
+        if (entry != entries_.end()) {
+            forget(entry);
+            invalidations_++;
+        }
+        return std::nullopt;
+    }
+
+    auto absent = missing_.find(path);
+    if (!current && current.getError() == std::errc::no_such_file_or_directory) {
+        if (absent != missing_.end()) {
+            absent->second.checked_at = now;
+        }
+        missing = true;
+        return std::nullopt;
+    }
+    if (absent != missing_.end()) {
+        missing_order_.erase(absent->second.position);
+        missing_.erase(absent);
+        invalidations_++;
+    }
+    return std::nullopt;
+}
+
+void SourceFileSystem::remember(const std::string& path, const llvm::vfs::Status& status,
+                                std::shared_ptr<const std::string> contents) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto entry = entries_.find(path);
+    if (entry != entries_.end()) {
+        // Another thread got here first with the same file
+        if (sameFile(entry->second.status, status) && (entry->second.contents || !contents)) {
+            return;
+        }
+        forget(entry);
+    }
+    if (contents && bytes_ + contents->size() > max_bytes_) {
+        contents = nullptr;
+    }
+    if (contents) {
+        bytes_ += contents->size();
+    }
+    entries_.emplace(path, Entry{status, std::move(contents), Clock::now()});
+
+    auto absent = missing_.find(path);
+    if (absent != missing_.end()) {
+        missing_order_.erase(absent->second.position);
+        missing_.erase(absent);
+    }
+}
+
+void SourceFileSystem::rememberMissing(const std::string& path) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto entry = entries_.find(path);
+    if (entry != entries_.end()) {
+        forget(entry);
+    }
+
+    auto absent = missing_.find(path);
+    if (absent != missing_.end()) {
+        absent->second.checked_at = Clock::now();
+        return;
+    }
+    missing_order_.push_back(path);
+    missing_.emplace(path, Missing{Clock::now(), std::prev(missing_order_.end())});
+
+    // Oldest first; a probe that is still made is simply remembered again
+    while (missing_.size() > max_missing_) {
+        missing_.erase(missing_order_.front());
+        missing_order_.pop_front();
+    }
+}
+
+void SourceFileSystem::forget(std::unordered_map<std::string, Entry>::iterator entry) {
+    if (entry->second.contents) {
+        bytes_ -= entry->second.contents->size();
+    }
+    entries_.erase(entry);
+}
+
+llvm::ErrorOr<llvm::vfs::Status> SourceFileSystem::status(const llvm::Twine& path) {
+    std::string key = path.str();
+    if (!cacheable(key)) {
+        return ProxyFileSystem::status(path);
+    }
+
+    bool missing = false;
+    if (auto entry = lookup(key, missing)) {
+        status_hits_++;
+        return llvm::vfs::Status::copyWithNewName(entry->status, path);
+    }
+    if (missing) {
+        status_hits_++;
+        return std::make_error_code(std::errc::no_such_file_or_directory);
+    }
+    status_misses_++;
+
+    auto result = ProxyFileSystem::status(path);
+    if (result) {
+        remember(key, *result, nullptr);
+    } else if (result.getError() == std::errc::no_such_file_or_directory) {
+        rememberMissing(key);
+    }
+    return result;
+}
+
+llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>> SourceFileSystem::openFileForRead(const llvm::Twine& path) {
+    std::string key = path.str();
+    if (!cacheable(key)) {
+        return ProxyFileSystem::openFileForRead(path);
+    }
+
+    bool missing = false;
+    auto entry = lookup(key, missing);
+    if (entry && entry->contents) {
+        open_hits_++;
+        return std::make_unique<CachedFile>(llvm::vfs::Status::copyWithNewName(entry->status, path), entry->contents);
+    }
+    if (missing) {
+        open_hits_++;
+        return std::make_error_code(std::errc::no_such_file_or_directory);
+    }
+    open_misses_++;
+
+    auto file = ProxyFileSystem::openFileForRead(path);
+    if (!file) {
+        if (file.getError() == std::errc::no_such_file_or_directory) {
+            rememberMissing(key);
+        }
+        return file;
+    }
+    auto file_status = (*file)->status();
+    if (!file_status || !file_status->isRegularFile()) {
+        return file;
+    }
+    auto buffer = (*file)->getBuffer(path);
+    if (!buffer) {
+        return file;
+    }
+    auto contents = std::make_shared<const std::string>((*buffer)->getBuffer().str());
+
+    remember(key, *file_status, contents);
+    (*file)->close();
+    return std::make_unique<CachedFile>(llvm::vfs::Status::copyWithNewName(*file_status, path), contents);
+}
+
+nlohmann::json SourceFileSystem::getStatistics() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    size_t cached_files = 0;
+    for (const auto& [path, entry] : entries_) {
+        cached_files += entry.contents ? 1 : 0;
+    }
+    return nlohmann::json{
+        {"cached_files", cached_files},
+        {"cached_bytes", bytes_},
+        {"known_missing", missing_.size()},
+        {"status_hits", status_hits_.load()},
+        {"status_misses", status_misses_.load()},
+        {"open_hits", open_hits_.load()},
+        {"open_misses", open_misses_.load()},
+        {"revalidations", revalidations_.load()},
+        {"invalidations", invalidations_.load()}
+    };
+}
+
+} // namespace cpp_mastery
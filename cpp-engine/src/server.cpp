@@ -4,9 +4,14 @@
 #include "server.hpp"
 #include "utils/logger.hpp"
 #include "utils/config.hpp"
+#include "utils/workspace_manager.hpp"
 #include "analyzer/code_analyzer.hpp"
 #include "parser/ast_parser.hpp"
 #include "compiler/execution_engine.hpp"
+#include "compiler/admission_controller.hpp"
+#include "compiler/judge.hpp"
+#include "compiler/harness_registry.hpp"
+#include "compiler/job_manager.hpp"
 #include "visualizer/memory_visualizer.hpp"
 
 #include <nlohmann/json.hpp>
@@ -17,11 +22,265 @@
 #include <sstream>
 #include <regex>
 #include <iomanip>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <unistd.h>
 
 using json = nlohmann::json;
 
 namespace cpp_mastery {
 
+namespace {
+
+json executionResultToJson(const ExecutionResult& result) {
+    json response = {
+        {"success", result.success},
+        {"status", executionStatusToString(result.status)},
+        {"exit_code", result.exit_code},
+        {"stdout", result.stdout},
+        {"stderr", result.stderr},
+        {"mode", result.mode},
+        {"compilation_time_ms", result.compilation_time_ms},
+        {"execution_time_ms", result.execution_time_ms},
+        {"memory_usage_kb", result.memory_usage_kb},
+        {"cpu_time_ms", result.cpu_time_ms},
+        {"resources", {
+            {"user_time_ms", result.user_time_ms},
+            {"system_time_ms", result.system_time_ms},
+            {"voluntary_context_switches", result.voluntary_context_switches},
+            {"involuntary_context_switches", result.involuntary_context_switches},
+            {"io_read_bytes", result.io_read_bytes},
+            {"io_write_bytes", result.io_write_bytes}
+        }}
+    };
+    if (result.term_signal != 0) {
+        response["signal"] = result.term_signal;
+    }
+    if (!result.jit_fallback.empty()) {
+        response["jit_fallback"] = result.jit_fallback;
+    }
+    
+    if (!result.success) {
+        response["error"] = result.error_message;
+    }
+    
+    if (result.optimized) {
+        const auto& tier = *result.optimized;
+        response["optimized"] = {
+            {"optimization", tier.optimization},
+            {"success", tier.success},
+            {"status", executionStatusToString(tier.status)},
+            {"compilation_time_ms", tier.compilation_time_ms},
+            {"execution_time_ms", tier.execution_time_ms},
+            {"cpu_time_ms", tier.cpu_time_ms},
+            {"memory_usage_kb", tier.memory_usage_kb},
+            {"output_matches", tier.output_matches}
+        };
+        if (!tier.error_message.empty()) {
+            response["optimized"]["error"] = tier.error_message;
+        }
+    }
+    
+    return response;
+}
+
+// Fast-tier result of a tiered execution, sent before the optimized run finishes
+json fastTierEvent(const ExecutionResult& result) {
+    json event = executionResultToJson(result);
+    event["type"] = "fast_result";
+    return event;
+}
+
+json compilationResultToJson(const CompilationResult& result) {
+    return {
+        {"success", result.success},
+        {"executable_path", result.executable_path},
+        {"compilation_time_ms", result.compilation_time_ms},
+        {"warnings", result.warnings},
+        {"errors", result.errors},
+        {"compiler_output", result.compiler_output},
+        {"cache_hit", result.cache_hit},
+        {"linker", result.linker},
+        {"phases_ms", {
+            {"setup", result.phases.setup_ms},
+            {"harness", result.phases.harness_ms},
+            {"cache_lookup", result.phases.cache_lookup_ms},
+            {"coalesced_wait", result.phases.coalesced_wait_ms},
+            {"write_source", result.phases.write_source_ms},
+            {"compile", result.phases.compile_ms},
+            {"link", result.phases.link_ms},
+            {"cache_store", result.phases.cache_store_ms}
+        }}
+    };
+}
+
+json analysisToJson(const std::string& code, const std::string& analysis_type) {
+    auto result = CodeAnalyzer::getInstance().analyze(code, analysis_type);
+    return {
+        {"success", true},
+        {"analysis_type", analysis_type},
+        {"metrics", result.metrics},
+        {"issues", result.issues},
+        {"suggestions", result.suggestions},
+        {"complexity", result.complexity},
+        {"performance_hints", result.performance_hints}
+    };
+}
+
+// Fairness key for admission: the API key when one is sent, the peer address otherwise
+std::string admissionClientId(const httplib::Request& req) {
+    std::string api_key = req.get_header_value("X-API-Key");
+    return api_key.empty() ? "ip:" + req.remote_addr : "key:" + api_key;
+}
+
+AdmissionLane admissionLane(const httplib::Request& req) {
+    return admissionLaneFromString(req.get_header_value("X-Priority"));
+}
+
+// Length of the longest prefix that does not end inside a UTF-8 sequence
+size_t completeUtf8Prefix(const std::string& data) {
+    size_t size = data.size();
+    for (size_t back = 1; back <= 3 && back <= size; ++back) {
+        unsigned char byte = static_cast<unsigned char>(data[size - back]);
+        if ((byte & 0xC0) == 0x80) {
+            continue;  // continuation byte, keep looking for the lead
+        }
+        size_t length = (byte & 0xE0) == 0xC0 ? 2 : (byte & 0xF0) == 0xE0 ? 3 : (byte & 0xF8) == 0xF0 ? 4 : 1;
+        return length > back ? size - back : size;
+    }
+    return size;
+}
+
+/**
+ * @brief Turns program output chunks into stdout/stderr events
+ *
+ * Holds back a multi-byte character split across chunks so every event
+ * carries valid UTF-8. Thread-safe; events go to the sink in order.
+ */
+class OutputEvents {
+public:
+    explicit OutputEvents(std::function<void(const json&)> sink) : sink_(std::move(sink)) {}
+
+    // Empty data marks the stream as truncated
+    void append(int stream, std::string_view data) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::string& pending = stream == STDERR_FILENO ? pending_stderr_ : pending_stdout_;
+        const char* name = stream == STDERR_FILENO ? "stderr" : "stdout";
+        
+        if (data.empty()) {
+            flushLocked(name, pending, pending.size());
+            sink_({{"type", "truncated"}, {"stream", name}});
+            return;
+        }
+        
+        // Hold back a split multi-byte character until the rest arrives
+        pending.append(data);
+        flushLocked(name, pending, completeUtf8Prefix(pending));
+    }
+
+    void flush() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        flushLocked("stdout", pending_stdout_, pending_stdout_.size());
+        flushLocked("stderr", pending_stderr_, pending_stderr_.size());
+    }
+
+private:
+    void flushLocked(const char* name, std::string& pending, size_t length) {
+        if (length == 0) {
+            return;
+        }
+        sink_({{"type", name}, {"data", pending.substr(0, length)}});
+        pending.erase(0, length);
+    }
+
+    const std::function<void(const json&)> sink_;
+    std::mutex mutex_;
+    std::string pending_stdout_;
+    std::string pending_stderr_;
+};
+
+json compileEvent(const CompilationResult& compilation) {
+    return {
+        {"type", "compile"},
+        {"success", compilation.success},
+        {"warnings", compilation.warnings},
+        {"errors", compilation.errors},
+        {"cache_hit", compilation.cache_hit},
+        {"compilation_time_ms", compilation.compilation_time_ms}
+    };
+}
+
+/**
+ * @brief Events of one streamed execution
+ *
+ * The engine and supervisor threads push framed events; the connection
+ * thread pops them and writes them to the client. A slow client therefore
+ * never stalls the supervisor, and the queue stays bounded because each
+ * output stream is capped at max_output_size.
+ */
+class ExecutionStream {
+public:
+    explicit ExecutionStream(bool sse) : sse_(sse), output_([this](const json& event) { push(event); }) {}
+
+    void push(const json& event) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pushLocked(event);
+    }
+
+    void output(int stream, std::string_view data) {
+        output_.append(stream, data);
+    }
+
+    void flushOutput() {
+        output_.flush();
+    }
+
+    void finish(json result) {
+        output_.flush();
+        std::lock_guard<std::mutex> lock(mutex_);
+        result["type"] = "result";
+        pushLocked(result);
+        finished_ = true;
+        ready_.notify_all();
+    }
+
+    /**
+     * @brief Wait for the next batch of framed events
+     *
+     * @param chunk Receives every event queued so far
+     * @return false once the stream finished and everything was taken
+     */
+    bool next(std::string& chunk) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [this] { return !events_.empty() || finished_; });
+        
+        chunk.clear();
+        while (!events_.empty()) {
+            chunk += events_.front();
+            events_.pop_front();
+        }
+        return !chunk.empty();
+    }
+
+private:
+    void pushLocked(const json& event) {
+        std::string body = event.dump(-1, ' ', false, json::error_handler_t::replace);
+        events_.push_back(sse_ ? "data: " + body + "\n\n" : body + "\n");
+        ready_.notify_one();
+    }
+
+    const bool sse_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<std::string> events_;
+    bool finished_ = false;
+    OutputEvents output_;
+};
+
+} // namespace
+
 Server::Server(const std::string& host, int port)
     : host_(host), port_(port), running_(false) {
     server_ = std::make_unique<httplib::Server>();
@@ -38,6 +297,7 @@ bool Server::initialize() {
         setupRoutes();
         setupMiddleware();
         setupErrorHandlers();
+        cleanup_temp_files();
         
         logger.info("✅ Server initialized successfully");
         return true;
@@ -102,11 +362,62 @@ void Server::setupRoutes() {
     });
     
     // Code execution endpoint
+    server_->Post("/api/check", [this](const httplib::Request& req, httplib::Response& res) {
+        handleCheck(req, res);
+    });
+    
     server_->Post("/api/execute", [this](const httplib::Request& req, httplib::Response& res) {
         handleExecute(req, res);
     });
     
+    server_->Post("/api/execute/stream", [this](const httplib::Request& req, httplib::Response& res) {
+        handleExecuteStream(req, res);
+    });
+    
+    // Speculative compile of an editor draft into the compilation cache
+    server_->Post("/api/prewarm", [this](const httplib::Request& req, httplib::Response& res) {
+        handlePrewarm(req, res);
+    });
+    
+    // Asynchronous jobs: submit, poll, stream events, cancel
+    server_->Post("/api/jobs", [this](const httplib::Request& req, httplib::Response& res) {
+        handleJobSubmit(req, res);
+    });
+    
+    server_->Get(R"(/api/jobs/([0-9a-f]+))", [this](const httplib::Request& req, httplib::Response& res) {
+        handleJobStatus(req, res);
+    });
+    
+    server_->Get(R"(/api/jobs/([0-9a-f]+)/events)", [this](const httplib::Request& req, httplib::Response& res) {
+        handleJobEvents(req, res);
+    });
+    
+    server_->Post(R"(/api/jobs/([0-9a-f]+)/cancel)", [this](const httplib::Request& req, httplib::Response& res) {
+        handleJobCancel(req, res);
+    });
+    
+    server_->Delete(R"(/api/jobs/([0-9a-f]+))", [this](const httplib::Request& req, httplib::Response& res) {
+        handleJobCancel(req, res);
+    });
+    
     // Code analysis endpoint
+    server_->Post("/api/judge", [this](const httplib::Request& req, httplib::Response& res) {
+        handleJudge(req, res);
+    });
+    
+    // Exercise harnesses: shared test code prebuilt once per toolchain
+    server_->Post("/api/harness", [this](const httplib::Request& req, httplib::Response& res) {
+        handleHarnessRegister(req, res);
+    });
+    
+    server_->Get("/api/harness", [this](const httplib::Request& req, httplib::Response& res) {
+        handleHarnessList(req, res);
+    });
+    
+    server_->Delete(R"(/api/harness/([A-Za-z0-9._-]+))", [this](const httplib::Request& req, httplib::Response& res) {
+        handleHarnessRemove(req, res);
+    });
+    
     server_->Post("/api/analyze", [this](const httplib::Request& req, httplib::Response& res) {
         handleAnalyze(req, res);
     });
@@ -121,6 +432,11 @@ void Server::setupRoutes() {
         handleParse(req, res);
     });
     
+    // Token stream endpoint for syntax highlighting
+    server_->Post("/api/tokens", [this](const httplib::Request& req, httplib::Response& res) {
+        handleTokens(req, res);
+    });
+    
     // Code formatting endpoint
     server_->Post("/api/format", [this](const httplib::Request& req, httplib::Response& res) {
         handleFormat(req, res);
@@ -175,9 +491,11 @@ void Server::setupErrorHandlers() {
                 "/health",
                 "/api/compile",
                 "/api/execute", 
+                "/api/jobs",
                 "/api/analyze",
                 "/api/visualize",
                 "/api/parse",
+                "/api/tokens",
                 "/api/format",
                 "/api/metrics"
             }}
@@ -256,6 +574,9 @@ void Server::handleApiDocs(const httplib::Request& req, httplib::Response& res)
 <body>
     <h1>C++ Mastery Hub Engine API</h1>
     <p>Advanced C++ code analysis, compilation, and execution engine.</p>
+    <p>Compile and execute requests are admitted a bounded number at a time. Bulk clients should send
+       <code>X-Priority: batch</code>; when the queue is full the server answers 429 with a
+       <code>Retry-After</code> header.</p>
     
     <div class="endpoint">
         <div class="method">GET</div>
@@ -266,17 +587,105 @@ void Server::handleApiDocs(const httplib::Request& req, httplib::Response& res)
     <div class="endpoint">
         <div class="method">POST</div>
         <div class="path">/api/compile</div>
-        <p>Compile C++ code and return compilation results.</p>
+        <p>Compile C++ code and return compilation results. <code>options.compiler</code> is
+           <code>g++</code>, <code>clang++</code> or <code>clang-inprocess</code>, which compiles and links
+           inside the engine without starting clang++.</p>
         <p><strong>Body:</strong> <code>{"code": "string", "options": {...}}</code></p>
     </div>
     
+    <div class="endpoint">
+        <div class="method">POST</div>
+        <div class="path">/api/check</div>
+        <p>Run the compiler frontend only and return structured diagnostics (line, column, severity,
+           message, warning option). Stops after <code>options.max_errors</code> errors (default 10).</p>
+        <p><strong>Body:</strong> <code>{"code": "string", "options": {"compiler": "string", "standard": "string", "flags": [...], "max_errors": number}}</code></p>
+    </div>
+    
     <div class="endpoint">
         <div class="method">POST</div>
         <div class="path">/api/execute</div>
-        <p>Execute C++ code in a secure sandbox environment.</p>
+        <p>Execute C++ code in a secure sandbox environment. <code>options.tiered</code>
+           (<code>true</code> or <code>{"fast": "O0", "optimized": "O2"}</code>) is accepted by
+           <code>/api/execute/stream</code> and execute jobs only: the output comes from a fast build, sent as a
+           <code>fast_result</code> event as soon as it ran, while an optimized build compiles alongside; its run's
+           timings are returned under <code>optimized</code> in the final result. With <code>options.jit</code> a small snippet is run from LLVM bitcode by a JIT in a
+           sandbox slot (<code>"mode": "jit"</code>); otherwise, or when it cannot be, it is compiled and linked
+           as usual and <code>jit_fallback</code> says why. When the engine runs the <code>wasm</code> sandbox
+           backend, every submission is built for <code>wasm32-wasi</code> and run in the embedded WebAssembly
+           runtime; CPU limits are enforced as fuel and traps are reported like the matching signals.</p>
+        <p><strong>Body:</strong> <code>{"code": "string", "input": "string", "options": {...}}</code></p>
+    </div>
+    
+    <div class="endpoint">
+        <div class="method">POST</div>
+        <div class="path">/api/execute/stream</div>
+        <p>Execute C++ code and stream compile, stdout/stderr and result events as they happen.
+           Sends server-sent events when the request accepts <code>text/event-stream</code>,
+           newline-delimited JSON otherwise.</p>
         <p><strong>Body:</strong> <code>{"code": "string", "input": "string", "options": {...}}</code></p>
     </div>
     
+    <div class="endpoint">
+        <div class="method">POST</div>
+        <div class="path">/api/prewarm</div>
+        <p>Compile an editor draft in the background so a following execute request with the same code and
+           options starts from the compilation cache. Runs only in idle slots and is cancelled when a real
+           request needs the slot or a newer draft arrives for the same <code>session_id</code>
+           (or <code>X-Session-ID</code>). Answers 202 with a job id, or 204 when prewarming is off.</p>
+        <p><strong>Body:</strong> <code>{"code": "string", "options": {...}, "session_id": "string"}</code></p>
+    </div>
+    
+    <div class="endpoint">
+        <div class="method">POST</div>
+        <div class="path">/api/jobs</div>
+        <p>Start a compile, execute or analyze request in the background and answer 202 with its
+           <code>job_id</code>. The job queues for admission like the synchronous endpoints; finished
+           jobs are kept for <code>job_result_ttl_seconds</code>.</p>
+        <p><strong>Body:</strong> <code>{"type": "compile|execute|analyze", "code": "string", "input": "string", "options": {...}, "analysis_type": "string"}</code></p>
+    </div>
+    
+    <div class="endpoint">
+        <div class="method">GET</div>
+        <div class="path">/api/jobs/{id}</div>
+        <p>Job state (queued, running, succeeded, failed, cancelled), timestamps and, once finished, the result.</p>
+    </div>
+    
+    <div class="endpoint">
+        <div class="method">GET</div>
+        <div class="path">/api/jobs/{id}/events</div>
+        <p>Stream the job's state, compile, stdout/stderr and result events, numbered from 0. Server-sent
+           events carry the number as <code>id</code>, so reconnecting with <code>Last-Event-ID</code> resumes;
+           <code>?from=N</code> does the same for newline-delimited JSON.</p>
+    </div>
+    
+    <div class="endpoint">
+        <div class="method">POST</div>
+        <div class="path">/api/jobs/{id}/cancel</div>
+        <p>Cancel a job: leaves the admission queue or kills the compiler or program at once.
+           <code>DELETE /api/jobs/{id}</code> also cancels, and forgets the job.</p>
+    </div>
+    
+    <div class="endpoint">
+        <div class="method">POST</div>
+        <div class="path">/api/judge</div>
+        <p>Compile once and run the program against every test case in parallel, returning a verdict
+           (AC, WA, TLE, MLE, OLE, RE) and timings per case. <code>compare</code> is <code>tokens</code>
+           (default) or <code>exact</code>; case limits can only tighten the server's limits. <code>parallelism</code>
+           is capped at the sandbox pool size, and each case worker beyond the first waits for its own admission slot.</p>
+        <p><strong>Body:</strong> <code>{"code": "string", "cases": [{"input": "string", "expected_output": "string", "limits": {...}}], "compare": "string", "stop_on_first_failure": boolean, "parallelism": number, "options": {...}}</code></p>
+    </div>
+    
+    <div class="endpoint">
+        <div class="method">POST</div>
+        <div class="path">/api/harness</div>
+        <p>Register or replace an exercise harness: headers submissions may include and sources (test driver,
+           helpers) linked with every submission. The sources are compiled once per toolchain, so a compile,
+           execute or judge request with <code>options.harness</code> set to the id only compiles the submission
+           and links. Answers 201, or 422 with the compiler output when the harness does not build.
+           <code>GET /api/harness</code> lists harnesses; <code>DELETE /api/harness/{id}</code> removes one.</p>
+        <p><strong>Body:</strong> <code>{"id": "string", "headers": {"name.hpp": "string"}, "sources": {"name.cpp": "string"}}</code></p>
+    </div>
+    
     <div class="endpoint">
         <div class="method">POST</div>
         <div class="path">/api/analyze</div>
@@ -298,6 +707,13 @@ void Server::handleApiDocs(const httplib::Request& req, httplib::Response& res)
         <p><strong>Body:</strong> <code>{"code": "string", "include_tokens": boolean}</code></p>
     </div>
     
+    <div class="endpoint">
+        <div class="method">POST</div>
+        <div class="path">/api/tokens</div>
+        <p>Lex C++ code for syntax highlighting without parsing it. Returns <code>tokens</code> as <code>[kind, offset, length, line, column]</code> arrays.</p>
+        <p><strong>Body:</strong> <code>{"code": "string"}</code></p>
+    </div>
+    
     <div class="endpoint">
         <div class="method">POST</div>
         <div class="path">/api/format</div>
@@ -329,24 +745,88 @@ void Server::handleCompile(const httplib::Request& req, httplib::Response& res)
         std::string code = request_json["code"];
         json options = request_json.value("options", json::object());
         
+        auto admission = AdmissionController::getInstance().admit(admissionClientId(req), admissionLane(req));
+        if (!admission.admitted()) {
+            res.set_header("Retry-After", std::to_string(admission.retry_after.count()));
+            sendErrorResponse(res, 429, admission.reason);
+            return;
+        }
+        
         auto& executor = ExecutionEngine::getInstance();
         auto result = executor.compile(code, options);
         
+        json response = compilationResultToJson(result);
+        
+        // Nothing runs the executable after this request
+        executor.releaseCompilation(result);
+        
+        res.set_content(response.dump(2), "application/json");
+        
+    } catch (const json::parse_error& e) {
+        sendErrorResponse(res, 400, "Invalid JSON in request body");
+    } catch (const std::exception& e) {
+        sendErrorResponse(res, 500, "Compilation failed: " + std::string(e.what()));
+    }
+}
+
+void Server::handleCheck(const httplib::Request& req, httplib::Response& res) {
+    try {
+        auto request_json = json::parse(req.body);
+        
+        if (!request_json.contains("code")) {
+            sendErrorResponse(res, 400, "Missing 'code' field in request body");
+            return;
+        }
+        
+        std::string code = request_json["code"];
+        json options = request_json.value("options", json::object());
+        
+        auto admission = AdmissionController::getInstance().admit(admissionClientId(req), admissionLane(req));
+        if (!admission.admitted()) {
+            res.set_header("Retry-After", std::to_string(admission.retry_after.count()));
+            sendErrorResponse(res, 429, admission.reason);
+            return;
+        }
+        
+        auto result = ExecutionEngine::getInstance().checkSyntax(code, options);
+        
+        json diagnostics = json::array();
+        for (const auto& diagnostic : result.diagnostics) {
+            json entry = {
+                {"severity", diagnostic.severity},
+                {"line", diagnostic.line},
+                {"column", diagnostic.column},
+                {"message", diagnostic.message}
+            };
+            if (!diagnostic.file.empty()) {
+                entry["file"] = diagnostic.file;
+            }
+            if (!diagnostic.option.empty()) {
+                entry["option"] = diagnostic.option;
+            }
+            diagnostics.push_back(std::move(entry));
+        }
+        
         json response = {
             {"success", result.success},
-            {"executable_path", result.executable_path},
-            {"compilation_time_ms", result.compilation_time_ms},
-            {"warnings", result.warnings},
-            {"errors", result.errors},
-            {"compiler_output", result.compiler_output}
+            {"diagnostics", diagnostics},
+            {"error_count", result.error_count},
+            {"warning_count", result.warning_count},
+            {"truncated", result.truncated},
+            {"pch", result.pch_used},
+            {"check_time_ms", result.check_time_ms}
         };
         
-        res.set_content(response.dump(2), "application/json");
+        if (!result.error_message.empty()) {
+            response["error"] = result.error_message;
+        }
+        
+        res.set_content(response.dump(2, ' ', false, json::error_handler_t::replace), "application/json");
         
     } catch (const json::parse_error& e) {
         sendErrorResponse(res, 400, "Invalid JSON in request body");
     } catch (const std::exception& e) {
-        sendErrorResponse(res, 500, "Compilation failed: " + std::string(e.what()));
+        sendErrorResponse(res, 500, "Syntax check failed: " + std::string(e.what()));
     }
 }
 
@@ -363,32 +843,458 @@ void Server::handleExecute(const httplib::Request& req, httplib::Response& res)
         std::string input = request_json.value("input", "");
         json options = request_json.value("options", json::object());
         
+        // A tiered run's fast result is only worth having before the optimized
+        // one, which needs an endpoint that can send it early
+        if (ExecutionEngine::tierPolicyFrom(options).enabled) {
+            sendErrorResponse(res, 400, "options.tiered needs /api/execute/stream or an execute job");
+            return;
+        }
+        
+        auto admission = AdmissionController::getInstance().admit(admissionClientId(req), admissionLane(req));
+        if (!admission.admitted()) {
+            res.set_header("Retry-After", std::to_string(admission.retry_after.count()));
+            sendErrorResponse(res, 429, admission.reason);
+            return;
+        }
+        
         auto& executor = ExecutionEngine::getInstance();
         auto result = executor.execute(code, input, options);
         
-        json response = {
+        json response = executionResultToJson(result);
+        
+        res.set_content(response.dump(2), "application/json");
+        
+    } catch (const json::parse_error& e) {
+        sendErrorResponse(res, 400, "Invalid JSON in request body");
+    } catch (const std::exception& e) {
+        sendErrorResponse(res, 500, "Execution failed: " + std::string(e.what()));
+    }
+}
+
+void Server::handleExecuteStream(const httplib::Request& req, httplib::Response& res) {
+    json request_json;
+    try {
+        request_json = json::parse(req.body);
+    } catch (const json::parse_error& e) {
+        sendErrorResponse(res, 400, "Invalid JSON in request body");
+        return;
+    }
+    
+    if (!request_json.contains("code")) {
+        sendErrorResponse(res, 400, "Missing 'code' field in request body");
+        return;
+    }
+    
+    std::string code = request_json["code"];
+    std::string input = request_json.value("input", "");
+    json options = request_json.value("options", json::object());
+    
+    // Cancelled when the client goes away, which kills the run's process
+    // group and so frees its admission slot
+    auto cancellation = std::make_shared<CancellationToken>();
+    
+    auto admission = AdmissionController::getInstance().admit(admissionClientId(req), admissionLane(req), cancellation);
+    if (!admission.admitted()) {
+        res.set_header("Retry-After", std::to_string(admission.retry_after.count()));
+        sendErrorResponse(res, 429, admission.reason);
+        return;
+    }
+    
+    // Server-sent events for browsers, newline-delimited JSON otherwise
+    bool sse = req.get_header_value("Accept").find("text/event-stream") != std::string::npos;
+    auto stream = std::make_shared<ExecutionStream>(sse);
+    
+    // The run holds its admission until it finishes or is cancelled
+    std::thread([stream, cancellation, client_id = admissionClientId(req), ticket = std::move(admission.ticket),
+                 code = std::move(code), input = std::move(input), options = std::move(options)]() mutable {
+        ExecutionObserver observer;
+        observer.client_id = client_id;
+        observer.on_compiled = [stream](const CompilationResult& compilation) {
+            stream->push(compileEvent(compilation));
+        };
+        observer.on_output = [stream](int fd, std::string_view data) {
+            stream->output(fd, data);
+        };
+        // The optimized tier runs on a ticket of its own
+        observer.on_fast_result = [stream, &ticket](const ExecutionResult& result) {
+            stream->flushOutput();
+            stream->push(fastTierEvent(result));
+            ticket.release();
+        };
+        
+        try {
+            auto result = ExecutionEngine::getInstance().execute(code, input, options, observer, cancellation);
+            stream->finish(executionResultToJson(result));
+        } catch (const std::exception& e) {
+            stream->finish({
+                {"success", false},
+                {"status", executionStatusToString(ExecutionStatus::INTERNAL_ERROR)},
+                {"error", "Execution failed: " + std::string(e.what())}
+            });
+        }
+    }).detach();
+    
+    res.set_header("Cache-Control", "no-cache");
+    res.set_chunked_content_provider(
+        sse ? "text/event-stream" : "application/x-ndjson",
+        [stream, cancellation](size_t /*offset*/, httplib::DataSink& sink) {
+            std::string chunk;
+            if (!stream->next(chunk)) {
+                sink.done();
+                return true;
+            }
+            if (!sink.write(chunk.data(), chunk.size())) {
+                cancellation->cancel();
+                return false;
+            }
+            return true;
+        },
+        // Runs however the response ends; a no-op once the run has finished
+        [cancellation](bool /*success*/) {
+            cancellation->cancel();
+        });
+}
+
+void Server::handlePrewarm(const httplib::Request& req, httplib::Response& res) {
+    json request_json;
+    try {
+        request_json = json::parse(req.body);
+    } catch (const json::parse_error& e) {
+        sendErrorResponse(res, 400, "Invalid JSON in request body");
+        return;
+    }
+    
+    if (!request_json.contains("code") || !request_json["code"].is_string()) {
+        sendErrorResponse(res, 400, "Missing 'code' field in request body");
+        return;
+    }
+    
+    // Nothing to warm without the cache, and prewarming may be switched off
+    auto& config = Config::getInstance();
+    if (!config.getCacheConfig().enable_compilation_cache || config.getServerConfig().max_background_compiles == 0) {
+        res.status = 204;
+        return;
+    }
+    
+    // One draft per editor session; a newer draft cancels the older one
+    std::string client_id = admissionClientId(req);
+    std::string session = request_json.value("session_id", req.get_header_value("X-Session-ID"));
+    std::string supersede_key = "prewarm:" + client_id + ":" + session;
+    
+    auto work = [client_id, request = std::move(request_json)](Job& job) -> json {
+        // Only idle slots, and given up as soon as a real request needs one
+        auto admission = AdmissionController::getInstance().admit(client_id, AdmissionLane::BACKGROUND, job.cancellation());
+        if (!admission.admitted()) {
+            throw std::runtime_error(admission.reason);
+        }
+        job.markRunning();
+        
+        // Execute requests with the same code and options hit the cache, or
+        // wait for this compile if it is still running
+        auto& executor = ExecutionEngine::getInstance();
+        auto result = executor.compile(request["code"], request.value("options", json::object()), job.cancellation());
+        executor.releaseCompilation(result);
+        return {
             {"success", result.success},
-            {"exit_code", result.exit_code},
-            {"stdout", result.stdout},
-            {"stderr", result.stderr},
-            {"execution_time_ms", result.execution_time_ms},
-            {"memory_usage_kb", result.memory_usage_kb},
-            {"cpu_time_ms", result.cpu_time_ms}
+            {"cache_hit", result.cache_hit},
+            {"compilation_time_ms", result.compilation_time_ms}
         };
+    };
+    
+    auto job = JobManager::getInstance().submit("prewarm", std::move(work), supersede_key);
+    if (!job) {
+        res.set_header("Retry-After", "1");
+        sendErrorResponse(res, 429, "Too many jobs in progress");
+        return;
+    }
+    
+    res.status = 202;
+    res.set_header("Location", "/api/jobs/" + job->id());
+    res.set_content(job->snapshot().dump(2), "application/json");
+}
+
+void Server::handleJobSubmit(const httplib::Request& req, httplib::Response& res) {
+    json request_json;
+    try {
+        request_json = json::parse(req.body);
+    } catch (const json::parse_error& e) {
+        sendErrorResponse(res, 400, "Invalid JSON in request body");
+        return;
+    }
+    
+    std::string type = request_json.value("type", "");
+    if (type != "compile" && type != "execute" && type != "analyze") {
+        sendErrorResponse(res, 400, "'type' must be compile, execute or analyze");
+        return;
+    }
+    if (!request_json.contains("code") || !request_json["code"].is_string()) {
+        sendErrorResponse(res, 400, "Missing 'code' field in request body");
+        return;
+    }
+    
+    std::string client_id = admissionClientId(req);
+    AdmissionLane lane = admissionLane(req);
+    
+    // Runs on the job's thread; the token reaches the admission queue and every process started
+    auto work = [type, client_id, lane, request = std::move(request_json)](Job& job) -> json {
+        std::string code = request["code"];
+        
+        if (type == "analyze") {
+            // The analyzer's tools cannot be interrupted; a cancel discards their result
+            job.markRunning();
+            return analysisToJson(code, request.value("analysis_type", "full"));
+        }
+        
+        auto admission = AdmissionController::getInstance().admit(client_id, lane, job.cancellation());
+        if (!admission.admitted()) {
+            throw std::runtime_error(admission.reason);
+        }
+        job.markRunning();
+        
+        auto& executor = ExecutionEngine::getInstance();
+        json options = request.value("options", json::object());
+        if (type == "compile") {
+            auto result = executor.compile(code, options, job.cancellation());
+            executor.releaseCompilation(result);
+            return compilationResultToJson(result);
+        }
         
-        if (!result.success) {
+        OutputEvents output([&job](const json& event) { job.emit(event); });
+        ExecutionObserver observer;
+        observer.client_id = client_id;
+        observer.on_compiled = [&job](const CompilationResult& compilation) {
+            job.emit(compileEvent(compilation));
+        };
+        observer.on_output = [&output](int fd, std::string_view data) {
+            output.append(fd, data);
+        };
+        // The optimized tier runs on a ticket of its own
+        observer.on_fast_result = [&job, &output, &admission](const ExecutionResult& result) {
+            output.flush();
+            job.emit(fastTierEvent(result));
+            admission.ticket.release();
+        };
+        auto result = executor.execute(code, request.value("input", ""), options, observer, job.cancellation());
+        output.flush();
+        return executionResultToJson(result);
+    };
+    
+    auto job = JobManager::getInstance().submit(type, std::move(work));
+    if (!job) {
+        res.set_header("Retry-After", "1");
+        sendErrorResponse(res, 429, "Too many jobs in progress");
+        return;
+    }
+    
+    res.status = 202;
+    res.set_header("Location", "/api/jobs/" + job->id());
+    res.set_content(job->snapshot().dump(2), "application/json");
+}
+
+void Server::handleJobStatus(const httplib::Request& req, httplib::Response& res) {
+    auto job = JobManager::getInstance().find(req.matches[1]);
+    if (!job) {
+        sendErrorResponse(res, 404, "Unknown or expired job");
+        return;
+    }
+    res.set_content(job->snapshot().dump(2, ' ', false, json::error_handler_t::replace), "application/json");
+}
+
+void Server::handleJobEvents(const httplib::Request& req, httplib::Response& res) {
+    auto job = JobManager::getInstance().find(req.matches[1]);
+    if (!job) {
+        sendErrorResponse(res, 404, "Unknown or expired job");
+        return;
+    }
+    
+    // Resume after the last event the client saw
+    size_t from = 0;
+    try {
+        if (req.has_header("Last-Event-ID")) {
+            from = std::stoul(req.get_header_value("Last-Event-ID")) + 1;
+        } else if (req.has_param("from")) {
+            from = std::stoul(req.get_param_value("from"));
+        }
+    } catch (const std::exception& e) {
+        sendErrorResponse(res, 400, "Invalid event position");
+        return;
+    }
+    
+    bool sse = req.get_header_value("Accept").find("text/event-stream") != std::string::npos;
+    auto next = std::make_shared<size_t>(from);
+    
+    res.set_header("Cache-Control", "no-cache");
+    res.set_chunked_content_provider(
+        sse ? "text/event-stream" : "application/x-ndjson",
+        [job, sse, next](size_t /*offset*/, httplib::DataSink& sink) {
+            std::vector<json> events;
+            if (!job->waitForEvents(*next, std::chrono::seconds(15), events)) {
+                sink.done();
+                return true;
+            }
+            
+            // Nothing new for a while; a comment keeps proxies from closing the stream
+            std::string chunk = events.empty() && sse ? ": keep-alive\n\n" : "";
+            for (const auto& event : events) {
+                std::string body = event.dump(-1, ' ', false, json::error_handler_t::replace);
+                chunk += sse ? "id: " + std::to_string(*next) + "\ndata: " + body + "\n\n" : body + "\n";
+                (*next)++;
+            }
+            return chunk.empty() || sink.write(chunk.data(), chunk.size());
+        });
+}
+
+void Server::handleJobCancel(const httplib::Request& req, httplib::Response& res) {
+    auto job = JobManager::getInstance().cancel(req.matches[1], req.method == "DELETE");
+    if (!job) {
+        sendErrorResponse(res, 404, "Unknown or expired job");
+        return;
+    }
+    res.set_content(job->snapshot().dump(2, ' ', false, json::error_handler_t::replace), "application/json");
+}
+
+void Server::handleJudge(const httplib::Request& req, httplib::Response& res) {
+    try {
+        auto request_json = json::parse(req.body);
+        
+        if (!request_json.contains("code") || !request_json.contains("cases") || !request_json["cases"].is_array()) {
+            sendErrorResponse(res, 400, "Request body needs 'code' and a 'cases' array");
+            return;
+        }
+        
+        std::vector<JudgeCase> cases;
+        for (const auto& case_json : request_json["cases"]) {
+            JudgeCase test_case;
+            test_case.input = case_json.value("input", "");
+            test_case.expected_output = case_json.value("expected_output", "");
+            test_case.limits = case_json.value("limits", json::object());
+            cases.push_back(std::move(test_case));
+        }
+        
+        JudgeOptions options;
+        options.mode = OutputComparator::modeFromString(request_json.value("compare", "tokens"));
+        options.stop_on_first_failure = request_json.value("stop_on_first_failure", false);
+        options.parallelism = request_json.value("parallelism", 0);
+        options.client_id = admissionClientId(req);
+        options.compile_options = request_json.value("options", json::object());
+        
+        auto admission = AdmissionController::getInstance().admit(admissionClientId(req), admissionLane(req));
+        if (!admission.admitted()) {
+            res.set_header("Retry-After", std::to_string(admission.retry_after.count()));
+            sendErrorResponse(res, 429, admission.reason);
+            return;
+        }
+        
+        Judge judge(ExecutionEngine::getInstance());
+        auto result = judge.judge(request_json["code"], cases, options);
+        
+        json case_results = json::array();
+        for (size_t i = 0; i < result.cases.size(); ++i) {
+            const auto& case_result = result.cases[i];
+            json case_json = {
+                {"index", i},
+                {"verdict", verdictToString(case_result.verdict)},
+                {"status", executionStatusToString(case_result.status)},
+                {"exit_code", case_result.exit_code},
+                {"time_ms", case_result.time_ms},
+                {"cpu_time_ms", case_result.cpu_time_ms},
+                {"memory_kb", case_result.memory_kb},
+                {"output_preview", case_result.output_preview},
+                {"stderr_preview", case_result.stderr_preview}
+            };
+            if (case_result.term_signal != 0) {
+                case_json["signal"] = case_result.term_signal;
+            }
+            if (case_result.mismatch_offset) {
+                case_json["mismatch_offset"] = *case_result.mismatch_offset;
+            }
+            case_results.push_back(std::move(case_json));
+        }
+        
+        json response = {
+            {"success", result.verdict == Verdict::ACCEPTED},
+            {"verdict", verdictToString(result.verdict)},
+            {"passed", result.passed},
+            {"total", result.cases.size()},
+            {"total_time_ms", result.total_time_ms},
+            {"compilation", {
+                {"success", result.compilation.success},
+                {"compilation_time_ms", result.compilation.compilation_time_ms},
+                {"warnings", result.compilation.warnings},
+                {"errors", result.compilation.errors},
+                {"cache_hit", result.compilation.cache_hit}
+            }},
+            {"cases", case_results}
+        };
+        
+        if (!result.error_message.empty()) {
             response["error"] = result.error_message;
         }
         
-        res.set_content(response.dump(2), "application/json");
+        res.set_content(response.dump(2, ' ', false, json::error_handler_t::replace), "application/json");
         
     } catch (const json::parse_error& e) {
         sendErrorResponse(res, 400, "Invalid JSON in request body");
     } catch (const std::exception& e) {
-        sendErrorResponse(res, 500, "Execution failed: " + std::string(e.what()));
+        sendErrorResponse(res, 500, "Judging failed: " + std::string(e.what()));
     }
 }
 
+void Server::handleHarnessRegister(const httplib::Request& req, httplib::Response& res) {
+    try {
+        auto request_json = json::parse(req.body);
+        
+        if (!request_json.contains("id") || !request_json.contains("sources") || !request_json["sources"].is_object()) {
+            sendErrorResponse(res, 400, "Request body needs 'id' and a 'sources' object");
+            return;
+        }
+        
+        auto files = [&request_json](const char* field) {
+            std::vector<HarnessFile> parsed;
+            for (const auto& [name, content] : request_json.value(field, json::object()).items()) {
+                parsed.push_back({name, content.get<std::string>()});
+            }
+            return parsed;
+        };
+        std::vector<HarnessFile> headers = files("headers");
+        std::vector<HarnessFile> sources = files("sources");
+        
+        // Building the harness runs the compiler like any other compile
+        auto admission = AdmissionController::getInstance().admit(admissionClientId(req), admissionLane(req));
+        if (!admission.admitted()) {
+            res.set_header("Retry-After", std::to_string(admission.retry_after.count()));
+            sendErrorResponse(res, 429, admission.reason);
+            return;
+        }
+        
+        json response = ExecutionEngine::getInstance().registerHarness(request_json["id"], headers, sources);
+        res.status = response["success"].get<bool>() ? 201 : 422;
+        res.set_content(response.dump(2, ' ', false, json::error_handler_t::replace), "application/json");
+        
+    } catch (const json::parse_error& e) {
+        sendErrorResponse(res, 400, "Invalid JSON in request body");
+    } catch (const json::type_error& e) {
+        sendErrorResponse(res, 400, "Harness id and file contents must be strings");
+    } catch (const std::invalid_argument& e) {
+        sendErrorResponse(res, 400, e.what());
+    } catch (const std::exception& e) {
+        sendErrorResponse(res, 500, "Harness registration failed: " + std::string(e.what()));
+    }
+}
+
+void Server::handleHarnessList(const httplib::Request& req, httplib::Response& res) {
+    json response = {{"harnesses", ExecutionEngine::getInstance().listHarnesses()}};
+    res.set_content(response.dump(2), "application/json");
+}
+
+void Server::handleHarnessRemove(const httplib::Request& req, httplib::Response& res) {
+    if (!ExecutionEngine::getInstance().removeHarness(req.matches[1])) {
+        sendErrorResponse(res, 404, "Unknown harness");
+        return;
+    }
+    res.status = 204;
+}
+
 void Server::handleAnalyze(const httplib::Request& req, httplib::Response& res) {
     try {
         auto request_json = json::parse(req.body);
@@ -401,18 +1307,7 @@ void Server::handleAnalyze(const httplib::Request& req, httplib::Response& res)
         std::string code = request_json["code"];
         std::string analysis_type = request_json.value("analysis_type", "full");
         
-        auto& analyzer = CodeAnalyzer::getInstance();
-        auto result = analyzer.analyze(code, analysis_type);
-        
-        json response = {
-            {"success", true},
-            {"analysis_type", analysis_type},
-            {"metrics", result.metrics},
-            {"issues", result.issues},
-            {"suggestions", result.suggestions},
-            {"complexity", result.complexity},
-            {"performance_hints", result.performance_hints}
-        };
+        json response = analysisToJson(code, analysis_type);
         
         res.set_content(response.dump(2), "application/json");
         
@@ -488,6 +1383,38 @@ void Server::handleParse(const httplib::Request& req, httplib::Response& res) {
     }
 }
 
+void Server::handleTokens(const httplib::Request& req, httplib::Response& res) {
+    try {
+        auto request_json = json::parse(req.body);
+        
+        if (!request_json.contains("code")) {
+            sendErrorResponse(res, 400, "Missing 'code' field in request body");
+            return;
+        }
+        
+        std::string code = request_json["code"];
+        
+        auto start_time = std::chrono::steady_clock::now();
+        auto tokens = ASTParser::getInstance().generateTokens(code);
+        auto lex_time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start_time).count();
+        
+        json response = {
+            {"success", true},
+            {"tokens", ASTParser::tokensToJson(tokens)},
+            {"lex_time_us", lex_time_us}
+        };
+        
+        // Unindented: one line per number would dwarf the tokens themselves
+        res.set_content(response.dump(), "application/json");
+        
+    } catch (const json::parse_error& e) {
+        sendErrorResponse(res, 400, "Invalid JSON in request body");
+    } catch (const std::exception& e) {
+        sendErrorResponse(res, 500, "Tokenization failed: " + std::string(e.what()));
+    }
+}
+
 void Server::handleFormat(const httplib::Request& req, httplib::Response& res) {
     try {
         auto request_json = json::parse(req.body);
@@ -528,6 +1455,11 @@ void Server::handleMetrics(const httplib::Request& req, httplib::Response& res)
         {"memory_usage", getMemoryUsage()},
         {"cpu_usage", getCpuUsage()},
         {"disk_usage", getDiskUsage()},
+        {"execution_engine", ExecutionEngine::getInstance().getMetrics()},
+        {"admission", AdmissionController::getInstance().getStatistics()},
+        {"workspaces", WorkspaceManager::getInstance().getStatistics()},
+        {"jobs", JobManager::getInstance().getStatistics()},
+        {"parser", ASTParser::getInstance().getStatistics()},
         {"timestamp", std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count()}
     };
     
@@ -573,6 +1505,14 @@ double Server::getCpuUsage() {
     return 0.0; // TODO: Implement actual CPU usage detection
 }
 
+void Server::cleanup_temp_files() const {
+    // Deletion happens on the workspace manager's cleanup thread
+    size_t queued = WorkspaceManager::getInstance().reapOrphans();
+    if (queued > 0) {
+        Logger::getInstance().info("🧹 Queued " + std::to_string(queued) + " orphaned temp entries for removal");
+    }
+}
+
 json Server::getDiskUsage() {
     json disk_info = {
         {"total_gb", 0},
@@ -0,0 +1,42 @@
+// File: cpp-engine/src/utils/cancellation_token.cpp
+// Extension: .cpp
+
+#include "utils/cancellation_token.hpp"
+
+namespace cpp_mastery {
+
+void CancellationToken::cancel() {
+    std::map<Registration, Callback> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (cancelled_.exchange(true)) {
+            return;
+        }
+        callbacks.swap(callbacks_);
+    }
+
+    for (auto& [registration, callback] : callbacks) {
+        callback();
+    }
+}
+
+CancellationToken::Registration CancellationToken::onCancel(Callback callback) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!cancelled_.load()) {
+            Registration registration = next_registration_++;
+            callbacks_.emplace(registration, std::move(callback));
+            return registration;
+        }
+    }
+
+    callback();
+    return 0;
+}
+
+void CancellationToken::unregister(Registration registration) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    callbacks_.erase(registration);
+}
+
+} // namespace cpp_mastery
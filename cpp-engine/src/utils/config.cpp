@@ -8,6 +8,7 @@
 #include <iostream>
 #include <filesystem>
 #include <cstdlib>
+#include <algorithm>
 
 using json = nlohmann::json;
 
@@ -100,6 +101,15 @@ void Config::setDefaults() {
     server_config_.threads = std::thread::hardware_concurrency();
     server_config_.timeout_seconds = 30;
     server_config_.max_request_size = 10 * 1024 * 1024; // 10MB
+    server_config_.max_concurrent_executions = std::max(1u, std::thread::hardware_concurrency());
+    server_config_.max_queued_requests = 100;
+    server_config_.queue_timeout_seconds = 30;
+    server_config_.interactive_weight = 4;
+    server_config_.client_weights.clear();
+    server_config_.max_background_compiles = std::max(1u, std::thread::hardware_concurrency() / 4);
+    server_config_.workspace_root = "temp";
+    server_config_.workspace_pool_size = 8;
+    server_config_.job_result_ttl_seconds = 300;
     
     // Compiler configuration
     compiler_config_.compiler_path = "/usr/bin/g++";
@@ -109,6 +119,11 @@ void Config::setDefaults() {
     compiler_config_.optimization_level = "O2";
     compiler_config_.compilation_timeout = 30;
     compiler_config_.max_binary_size = 100 * 1024 * 1024; // 100MB
+    compiler_config_.enable_pch = true;
+    compiler_config_.linker = "auto";
+    compiler_config_.workspace_mode = "memory";
+    compiler_config_.memory_workspace_budget_mb = 256;
+    compiler_config_.wasi_clang_path = "/opt/wasi-sdk/bin/clang++";
     
     // Execution configuration
     execution_config_.sandbox_enabled = true;
@@ -117,6 +132,15 @@ void Config::setDefaults() {
     execution_config_.max_cpu_time = 5;
     execution_config_.max_output_size = 1024 * 1024; // 1MB
     execution_config_.docker_image = "cpp-sandbox:latest";
+    execution_config_.sandbox_backend = "native";
+    execution_config_.sandbox_rootfs = "/";
+    execution_config_.cgroup_root = "/sys/fs/cgroup/cpp-mastery";
+    execution_config_.sandbox_pool_min = 2;
+    execution_config_.sandbox_pool_max = 8;
+    execution_config_.enable_jit = false;
+    execution_config_.jit_max_source_bytes = 16 * 1024;
+    execution_config_.wasm_workers = std::max(1u, std::thread::hardware_concurrency());
+    execution_config_.wasm_fuel_per_second = 1000000000;
     
     // Analysis configuration
     analysis_config_.clang_tidy_path = "/usr/bin/clang-tidy";
@@ -125,6 +149,7 @@ void Config::setDefaults() {
     analysis_config_.max_file_size = 1024 * 1024; // 1MB
     analysis_config_.enable_performance_analysis = true;
     analysis_config_.enable_security_analysis = true;
+    analysis_config_.preamble_cache_mb = 256;
     
     // Logging configuration
     logging_config_.level = "INFO";
@@ -189,6 +214,14 @@ void Config::loadFromEnvironment() {
         }
     }
     
+    if (const char* env_concurrency = std::getenv("CPP_ENGINE_MAX_CONCURRENT")) {
+        try {
+            server_config_.max_concurrent_executions = std::stoul(env_concurrency);
+        } catch (...) {
+            Logger::getInstance().warning("Invalid CPP_ENGINE_MAX_CONCURRENT value, using default", "Config");
+        }
+    }
+    
     // Compiler configuration
     if (const char* env_compiler = std::getenv("CPP_ENGINE_COMPILER")) {
         compiler_config_.default_compiler = env_compiler;
@@ -198,11 +231,19 @@ void Config::loadFromEnvironment() {
         compiler_config_.cpp_standard = env_std;
     }
     
+    if (const char* env_workspace = std::getenv("CPP_ENGINE_WORKSPACE")) {
+        compiler_config_.workspace_mode = env_workspace;
+    }
+    
     // Execution configuration
     if (const char* env_sandbox = std::getenv("CPP_ENGINE_SANDBOX")) {
         execution_config_.sandbox_enabled = (std::string(env_sandbox) == "true");
     }
     
+    if (const char* env_backend = std::getenv("CPP_ENGINE_SANDBOX_BACKEND")) {
+        execution_config_.sandbox_backend = env_backend;
+    }
+    
     if (const char* env_timeout = std::getenv("CPP_ENGINE_TIMEOUT")) {
         try {
             execution_config_.execution_timeout = std::stoi(env_timeout);
@@ -241,6 +282,26 @@ bool Config::validate() {
         valid = false;
     }
     
+    if (server_config_.max_concurrent_executions < 1) {
+        Logger::getInstance().error("Invalid max concurrent executions: " + std::to_string(server_config_.max_concurrent_executions), "Config");
+        valid = false;
+    }
+    
+    if (server_config_.queue_timeout_seconds < 1 || server_config_.interactive_weight < 1) {
+        Logger::getInstance().error("Invalid admission queue settings", "Config");
+        valid = false;
+    }
+    
+    if (server_config_.job_result_ttl_seconds < 1) {
+        Logger::getInstance().error("Invalid job result TTL: " + std::to_string(server_config_.job_result_ttl_seconds), "Config");
+        valid = false;
+    }
+    
+    if (server_config_.workspace_root.empty()) {
+        Logger::getInstance().error("Workspace root must not be empty", "Config");
+        valid = false;
+    }
+    
     // Validate compiler paths
     if (!std::filesystem::exists(compiler_config_.compiler_path)) {
         Logger::getInstance().warning("Compiler not found: " + compiler_config_.compiler_path, "Config");
@@ -250,6 +311,16 @@ bool Config::validate() {
         Logger::getInstance().warning("Clang not found: " + compiler_config_.clang_path, "Config");
     }
     
+    if (compiler_config_.workspace_mode != "memory" && compiler_config_.workspace_mode != "disk") {
+        Logger::getInstance().error("Invalid workspace mode: " + compiler_config_.workspace_mode, "Config");
+        valid = false;
+    }
+    
+    if (compiler_config_.memory_workspace_budget_mb < 0) {
+        Logger::getInstance().error("Invalid memory workspace budget: " + std::to_string(compiler_config_.memory_workspace_budget_mb), "Config");
+        valid = false;
+    }
+    
     // Validate execution limits
     if (execution_config_.execution_timeout < 1 || execution_config_.execution_timeout > 300) {
         Logger::getInstance().error("Invalid execution timeout: " + std::to_string(execution_config_.execution_timeout), "Config");
@@ -261,6 +332,17 @@ bool Config::validate() {
         valid = false;
     }
     
+    if (execution_config_.sandbox_pool_min < 0 || execution_config_.sandbox_pool_max < execution_config_.sandbox_pool_min) {
+        Logger::getInstance().error("Invalid sandbox pool size: " + std::to_string(execution_config_.sandbox_pool_min) +
+                                    ".." + std::to_string(execution_config_.sandbox_pool_max), "Config");
+        valid = false;
+    }
+    
+    if (execution_config_.wasm_workers < 1) {
+        Logger::getInstance().error("Invalid wasm worker count: " + std::to_string(execution_config_.wasm_workers), "Config");
+        valid = false;
+    }
+    
     // Validate logging configuration
     LogLevel log_level = Logger::stringToLevel(logging_config_.level);
     if (logging_config_.level != Logger::levelToString(log_level)) {
@@ -280,6 +362,15 @@ json Config::toJson() const {
     config_json["server"]["threads"] = server_config_.threads;
     config_json["server"]["timeout_seconds"] = server_config_.timeout_seconds;
     config_json["server"]["max_request_size"] = server_config_.max_request_size;
+    config_json["server"]["max_concurrent_executions"] = server_config_.max_concurrent_executions;
+    config_json["server"]["max_queued_requests"] = server_config_.max_queued_requests;
+    config_json["server"]["queue_timeout_seconds"] = server_config_.queue_timeout_seconds;
+    config_json["server"]["interactive_weight"] = server_config_.interactive_weight;
+    config_json["server"]["client_weights"] = server_config_.client_weights;
+    config_json["server"]["max_background_compiles"] = server_config_.max_background_compiles;
+    config_json["server"]["workspace_root"] = server_config_.workspace_root;
+    config_json["server"]["workspace_pool_size"] = server_config_.workspace_pool_size;
+    config_json["server"]["job_result_ttl_seconds"] = server_config_.job_result_ttl_seconds;
     
     // Compiler configuration
     config_json["compiler"]["compiler_path"] = compiler_config_.compiler_path;
@@ -289,6 +380,11 @@ json Config::toJson() const {
     config_json["compiler"]["optimization_level"] = compiler_config_.optimization_level;
     config_json["compiler"]["compilation_timeout"] = compiler_config_.compilation_timeout;
     config_json["compiler"]["max_binary_size"] = compiler_config_.max_binary_size;
+    config_json["compiler"]["enable_pch"] = compiler_config_.enable_pch;
+    config_json["compiler"]["linker"] = compiler_config_.linker;
+    config_json["compiler"]["workspace_mode"] = compiler_config_.workspace_mode;
+    config_json["compiler"]["memory_workspace_budget_mb"] = compiler_config_.memory_workspace_budget_mb;
+    config_json["compiler"]["wasi_clang_path"] = compiler_config_.wasi_clang_path;
     
     // Execution configuration
     config_json["execution"]["sandbox_enabled"] = execution_config_.sandbox_enabled;
@@ -297,6 +393,15 @@ json Config::toJson() const {
     config_json["execution"]["max_cpu_time"] = execution_config_.max_cpu_time;
     config_json["execution"]["max_output_size"] = execution_config_.max_output_size;
     config_json["execution"]["docker_image"] = execution_config_.docker_image;
+    config_json["execution"]["sandbox_backend"] = execution_config_.sandbox_backend;
+    config_json["execution"]["sandbox_rootfs"] = execution_config_.sandbox_rootfs;
+    config_json["execution"]["cgroup_root"] = execution_config_.cgroup_root;
+    config_json["execution"]["sandbox_pool_min"] = execution_config_.sandbox_pool_min;
+    config_json["execution"]["sandbox_pool_max"] = execution_config_.sandbox_pool_max;
+    config_json["execution"]["enable_jit"] = execution_config_.enable_jit;
+    config_json["execution"]["jit_max_source_bytes"] = execution_config_.jit_max_source_bytes;
+    config_json["execution"]["wasm_workers"] = execution_config_.wasm_workers;
+    config_json["execution"]["wasm_fuel_per_second"] = execution_config_.wasm_fuel_per_second;
     
     // Analysis configuration
     config_json["analysis"]["clang_tidy_path"] = analysis_config_.clang_tidy_path;
@@ -305,6 +410,7 @@ json Config::toJson() const {
     config_json["analysis"]["max_file_size"] = analysis_config_.max_file_size;
     config_json["analysis"]["enable_performance_analysis"] = analysis_config_.enable_performance_analysis;
     config_json["analysis"]["enable_security_analysis"] = analysis_config_.enable_security_analysis;
+    config_json["analysis"]["preamble_cache_mb"] = analysis_config_.preamble_cache_mb;
     
     // Logging configuration
     config_json["logging"]["level"] = logging_config_.level;
@@ -340,6 +446,15 @@ bool Config::fromJson(const json& config_json) {
             if (server.contains("threads")) server_config_.threads = server["threads"];
             if (server.contains("timeout_seconds")) server_config_.timeout_seconds = server["timeout_seconds"];
             if (server.contains("max_request_size")) server_config_.max_request_size = server["max_request_size"];
+            if (server.contains("max_concurrent_executions")) server_config_.max_concurrent_executions = server["max_concurrent_executions"];
+            if (server.contains("max_queued_requests")) server_config_.max_queued_requests = server["max_queued_requests"];
+            if (server.contains("queue_timeout_seconds")) server_config_.queue_timeout_seconds = server["queue_timeout_seconds"];
+            if (server.contains("interactive_weight")) server_config_.interactive_weight = server["interactive_weight"];
+            if (server.contains("client_weights")) server_config_.client_weights = server["client_weights"].get<std::map<std::string, int>>();
+            if (server.contains("max_background_compiles")) server_config_.max_background_compiles = server["max_background_compiles"];
+            if (server.contains("workspace_root")) server_config_.workspace_root = server["workspace_root"];
+            if (server.contains("workspace_pool_size")) server_config_.workspace_pool_size = server["workspace_pool_size"];
+            if (server.contains("job_result_ttl_seconds")) server_config_.job_result_ttl_seconds = server["job_result_ttl_seconds"];
         }
         
         // Compiler configuration
@@ -352,6 +467,11 @@ bool Config::fromJson(const json& config_json) {
             if (compiler.contains("optimization_level")) compiler_config_.optimization_level = compiler["optimization_level"];
             if (compiler.contains("compilation_timeout")) compiler_config_.compilation_timeout = compiler["compilation_timeout"];
             if (compiler.contains("max_binary_size")) compiler_config_.max_binary_size = compiler["max_binary_size"];
+            if (compiler.contains("enable_pch")) compiler_config_.enable_pch = compiler["enable_pch"];
+            if (compiler.contains("linker")) compiler_config_.linker = compiler["linker"];
+            if (compiler.contains("workspace_mode")) compiler_config_.workspace_mode = compiler["workspace_mode"];
+            if (compiler.contains("memory_workspace_budget_mb")) compiler_config_.memory_workspace_budget_mb = compiler["memory_workspace_budget_mb"];
+            if (compiler.contains("wasi_clang_path")) compiler_config_.wasi_clang_path = compiler["wasi_clang_path"];
         }
         
         // Execution configuration
@@ -363,6 +483,15 @@ bool Config::fromJson(const json& config_json) {
             if (execution.contains("max_cpu_time")) execution_config_.max_cpu_time = execution["max_cpu_time"];
             if (execution.contains("max_output_size")) execution_config_.max_output_size = execution["max_output_size"];
             if (execution.contains("docker_image")) execution_config_.docker_image = execution["docker_image"];
+            if (execution.contains("sandbox_backend")) execution_config_.sandbox_backend = execution["sandbox_backend"];
+            if (execution.contains("sandbox_rootfs")) execution_config_.sandbox_rootfs = execution["sandbox_rootfs"];
+            if (execution.contains("cgroup_root")) execution_config_.cgroup_root = execution["cgroup_root"];
+            if (execution.contains("sandbox_pool_min")) execution_config_.sandbox_pool_min = execution["sandbox_pool_min"];
+            if (execution.contains("sandbox_pool_max")) execution_config_.sandbox_pool_max = execution["sandbox_pool_max"];
+            if (execution.contains("enable_jit")) execution_config_.enable_jit = execution["enable_jit"];
+            if (execution.contains("jit_max_source_bytes")) execution_config_.jit_max_source_bytes = execution["jit_max_source_bytes"];
+            if (execution.contains("wasm_workers")) execution_config_.wasm_workers = execution["wasm_workers"];
+            if (execution.contains("wasm_fuel_per_second")) execution_config_.wasm_fuel_per_second = execution["wasm_fuel_per_second"];
         }
         
         // Analysis configuration
@@ -374,6 +503,7 @@ bool Config::fromJson(const json& config_json) {
             if (analysis.contains("max_file_size")) analysis_config_.max_file_size = analysis["max_file_size"];
             if (analysis.contains("enable_performance_analysis")) analysis_config_.enable_performance_analysis = analysis["enable_performance_analysis"];
             if (analysis.contains("enable_security_analysis")) analysis_config_.enable_security_analysis = analysis["enable_security_analysis"];
+            if (analysis.contains("preamble_cache_mb")) analysis_config_.preamble_cache_mb = analysis["preamble_cache_mb"];
         }
         
         // Logging configuration
@@ -422,7 +552,7 @@ void Config::printConfiguration() const {
     logger.info("Threads: " + std::to_string(server_config_.threads), "Config");
     logger.info("Compiler: " + compiler_config_.default_compiler, "Config");
     logger.info("C++ Standard: " + compiler_config_.cpp_standard, "Config");
-    logger.info("Sandbox: " + std::string(execution_config_.sandbox_enabled ? "enabled" : "disabled"), "Config");
+    logger.info("Sandbox: " + std::string(execution_config_.sandbox_enabled ? "enabled (" + execution_config_.sandbox_backend + ")" : "disabled"), "Config");
     logger.info("Log Level: " + logging_config_.level, "Config");
     logger.info("========================", "Config");
 }
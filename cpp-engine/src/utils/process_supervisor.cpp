@@ -0,0 +1,857 @@
+// File: cpp-engine/src/utils/process_supervisor.cpp
+// Extension: .cpp
+
+#include "utils/process_supervisor.hpp"
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/timerfd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+namespace cpp_mastery {
+
+namespace {
+
+// epoll user data is (pid << 8) | kind, so a stale event can never reach a
+// child object that has already been freed
+enum WatchKind : uint64_t {
+    kWakeup = 0,
+    kTimer = 1,
+    kStdout = 2,
+    kStderr = 3,
+    kPidfd = 4,
+    kExecStatus = 5,
+    kStatus = 6
+};
+
+// Poll interval for exit detection when pidfd_open is unavailable
+constexpr int kPollIntervalMs = 10;
+
+// How long to keep draining after exit when something outside the process
+// group still holds the output pipes open
+constexpr std::chrono::milliseconds kDrainGrace{1000};
+
+constexpr size_t kReadChunk = 64 * 1024;
+
+// Inputs up to this size are written straight into a pipe; Linux pipes hold
+// 64KiB by default, and a partial write falls back to a memfd anyway
+constexpr size_t kPipeInputBytes = 64 * 1024;
+
+int pidfdOpen(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+// Descriptors opened elsewhere in the server without O_CLOEXEC (sockets,
+// log files) must not leak into compilers or user programs
+void closeInheritedDescriptors() {
+#ifdef SYS_close_range
+    if (syscall(SYS_close_range, 3U, ~0U, 4U /* CLOSE_RANGE_CLOEXEC */) == 0) {
+        return;
+    }
+#endif
+    struct rlimit limit {};
+    int max_fd = (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+                     ? static_cast<int>(limit.rlim_cur) : 4096;
+    for (int fd = 3; fd < max_fd; ++fd) {
+        int flags = fcntl(fd, F_GETFD);
+        if (flags != -1) {
+            fcntl(fd, F_SETFD, flags | FD_CLOEXEC);
+        }
+    }
+}
+
+bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL);
+    return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+bool writeAll(int fd, std::string_view data) {
+    while (!data.empty()) {
+        ssize_t written = write(fd, data.data(), data.size());
+        if (written == -1 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        data.remove_prefix(static_cast<size_t>(written));
+    }
+    return true;
+}
+
+} // namespace
+
+UniqueFd createInputFd(std::string_view data) {
+    if (data.empty()) {
+        return UniqueFd(open("/dev/null", O_RDONLY | O_CLOEXEC));
+    }
+
+    if (data.size() <= kPipeInputBytes) {
+        int fds[2];
+        if (pipe2(fds, O_CLOEXEC) == 0) {
+            UniqueFd read_end(fds[0]), write_end(fds[1]);
+            // Non-blocking so a pipe shrunk by pipe-user-pages-soft cannot stall us
+            if (setNonBlocking(write_end.get()) && writeAll(write_end.get(), data)) {
+                return read_end;
+            }
+        }
+    }
+
+    UniqueFd file(memfd_create("stdin", MFD_CLOEXEC | MFD_ALLOW_SEALING));
+    if (!file.valid()) {
+        file.reset(open("/tmp", O_TMPFILE | O_RDWR | O_CLOEXEC, 0600));
+    }
+    if (!file.valid() || !writeAll(file.get(), data) || lseek(file.get(), 0, SEEK_SET) != 0) {
+        return UniqueFd();
+    }
+    // The descriptor is writable; seal it so the program sees exactly the request's input
+    fcntl(file.get(), F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+    return file;
+}
+
+void applyResourceUsage(const struct rusage& usage, ProcessResult& result) {
+    // ru_inblock/ru_oublock count 512-byte blocks
+    constexpr long kBlockSize = 512;
+
+    result.user_time_ms = usage.ru_utime.tv_sec * 1000 + usage.ru_utime.tv_usec / 1000;
+    result.system_time_ms = usage.ru_stime.tv_sec * 1000 + usage.ru_stime.tv_usec / 1000;
+    result.cpu_time_ms = result.user_time_ms + result.system_time_ms;
+    result.memory_usage_kb = usage.ru_maxrss;
+    result.voluntary_context_switches = usage.ru_nvcsw;
+    result.involuntary_context_switches = usage.ru_nivcsw;
+    result.io_read_bytes = usage.ru_inblock * kBlockSize;
+    result.io_write_bytes = usage.ru_oublock * kBlockSize;
+}
+
+void UniqueFd::reset(int fd) {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+    fd_ = fd;
+}
+
+struct ProcessSupervisor::Child {
+    ChildId id = 0;
+    uint64_t serial = 0;
+    pid_t pid = -1;
+    bool attached = false;
+    UniqueFd status_fd;
+    std::function<void(const std::string&, ProcessResult&)> on_status;
+    std::function<void()> on_timeout;
+    OutputCallback on_output;
+    size_t stdout_bytes = 0;
+    size_t stderr_bytes = 0;
+    bool stdout_truncated = false;
+    bool stderr_truncated = false;
+    UniqueFd pidfd;
+    UniqueFd stdout_fd;
+    UniqueFd stderr_fd;
+    UniqueFd exec_status_fd;
+    std::string exec_status;
+    std::string program;
+    size_t max_output_bytes = 0;
+    std::chrono::milliseconds timeout{0};
+    std::chrono::steady_clock::time_point start_time;
+    std::chrono::steady_clock::time_point deadline;
+    bool has_deadline = false;
+    bool exited = false;
+    bool stop_requested = false;        // killed, or the helper was asked to stop it
+    std::shared_ptr<CancellationToken> cancellation;
+    CancellationToken::Registration cancel_registration = 0;
+    ProcessResult result;
+    std::promise<ProcessResult> promise;
+};
+
+// Initialize static members
+std::unique_ptr<ProcessSupervisor> ProcessSupervisor::instance_ = nullptr;
+std::mutex ProcessSupervisor::mutex_;
+
+ProcessSupervisor& ProcessSupervisor::getInstance() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (instance_ == nullptr) {
+        instance_ = std::unique_ptr<ProcessSupervisor>(new ProcessSupervisor());
+    }
+    return *instance_;
+}
+
+ProcessSupervisor::ProcessSupervisor()
+    : epoll_fd_(epoll_create1(EPOLL_CLOEXEC)),
+      wakeup_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      timer_fd_(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) {
+
+    if (!epoll_fd_.valid() || !wakeup_fd_.valid() || !timer_fd_.valid()) {
+        throw std::runtime_error("Failed to create process supervisor descriptors: " + std::string(std::strerror(errno)));
+    }
+
+    UniqueFd self(pidfdOpen(getpid()));
+    have_pidfd_ = self.valid();
+    if (!have_pidfd_) {
+        Logger::getInstance().warning("pidfd_open unavailable, polling for child exits", "ProcessSupervisor");
+    }
+
+    watch(wakeup_fd_.get(), 0, kWakeup);
+    watch(timer_fd_.get(), 0, kTimer);
+
+    thread_ = std::thread(&ProcessSupervisor::eventLoop, this);
+}
+
+ProcessSupervisor::~ProcessSupervisor() {
+    running_ = false;
+    uint64_t one = 1;
+    [[maybe_unused]] ssize_t written = write(wakeup_fd_.get(), &one, sizeof(one));
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    adoptPending();
+    for (auto& [id, child] : children_) {
+        if (!child->attached && !child->exited) {
+            kill(-child->pid, SIGKILL);
+            waitpid(child->pid, nullptr, 0);
+        }
+        child->result.exit_code = -1;
+        child->promise.set_value(std::move(child->result));
+    }
+}
+
+std::future<ProcessResult> ProcessSupervisor::spawn(const ProcessOptions& options, pid_t* pid_out) {
+    auto child = std::make_unique<Child>();
+    auto future = child->promise.get_future();
+
+    if (options.args.empty()) {
+        child->promise.set_value(std::move(child->result));
+        return future;
+    }
+
+    if (options.cancellation && options.cancellation->cancelled()) {
+        child->result.cancelled = true;
+        child->promise.set_value(std::move(child->result));
+        return future;
+    }
+
+    auto fail = [&](const std::string& what) {
+        spawn_failures_++;
+        child->result.stderr = what + ": " + std::strerror(errno);
+        Logger::getInstance().error(child->result.stderr, "ProcessSupervisor");
+        child->promise.set_value(std::move(child->result));
+        return std::move(future);
+    };
+
+    // Everything the child touches is prepared before fork(): after it only
+    // async-signal-safe calls are allowed
+    std::vector<char*> argv;
+    for (const auto& arg : options.args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+    const char* working_directory = options.working_directory.empty() ? nullptr : options.working_directory.c_str();
+    const std::vector<int>& inherit_fds = options.inherit_fds;
+
+    struct sigaction default_action {};
+    default_action.sa_handler = SIG_DFL;
+    sigset_t empty_mask;
+    sigemptyset(&empty_mask);
+
+    int stdout_pipe[2], stderr_pipe[2], error_pipe[2];
+    if (pipe2(stdout_pipe, O_CLOEXEC) == -1) {
+        return fail("Failed to create stdout pipe");
+    }
+    UniqueFd stdout_read(stdout_pipe[0]), stdout_write(stdout_pipe[1]);
+    if (pipe2(stderr_pipe, O_CLOEXEC) == -1) {
+        return fail("Failed to create stderr pipe");
+    }
+    UniqueFd stderr_read(stderr_pipe[0]), stderr_write(stderr_pipe[1]);
+    if (pipe2(error_pipe, O_CLOEXEC) == -1) {
+        return fail("Failed to create exec status pipe");
+    }
+    UniqueFd error_read(error_pipe[0]), error_write(error_pipe[1]);
+    UniqueFd stdin_fd = createInputFd(options.stdin_data);
+    if (!stdin_fd.valid()) {
+        return fail("Failed to prepare stdin");
+    }
+
+    // Replaced by the time of the exec once the status pipe reports it
+    child->start_time = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid == -1) {
+        return fail("Failed to fork");
+    }
+
+    if (pid == 0) {
+        // Child process: lead a fresh process group and undo the server's
+        // signal setup (SIGPIPE is ignored there, and that survives exec)
+        setpgid(0, 0);
+        sigprocmask(SIG_SETMASK, &empty_mask, nullptr);
+        sigaction(SIGPIPE, &default_action, nullptr);
+        closeInheritedDescriptors();
+
+        dup2(stdin_fd.get(), STDIN_FILENO);
+        dup2(stdout_write.get(), STDOUT_FILENO);
+        dup2(stderr_write.get(), STDERR_FILENO);
+
+        // Move inherited descriptors (and the status pipe) out of the way
+        // first so placing one at 3 + i cannot clobber anything still needed
+        int moved[16];
+        size_t inherit_count = std::min(inherit_fds.size(), sizeof(moved) / sizeof(moved[0]));
+        int error_fd = error_write.get();
+        if (inherit_count > 0) {
+            error_fd = fcntl(error_fd, F_DUPFD_CLOEXEC, static_cast<int>(3 + inherit_count));
+        }
+        for (size_t i = 0; i < inherit_count; ++i) {
+            moved[i] = fcntl(inherit_fds[i], F_DUPFD_CLOEXEC, static_cast<int>(3 + inherit_count));
+        }
+        for (size_t i = 0; i < inherit_count; ++i) {
+            dup2(moved[i], static_cast<int>(3 + i));
+        }
+
+        int error = 0;
+        if (working_directory && chdir(working_directory) != 0) {
+            error = errno;
+        } else if (options.pre_exec && !options.pre_exec()) {
+            _exit(126);
+        } else {
+            execvp(argv[0], argv.data());
+            error = errno;
+        }
+
+        [[maybe_unused]] ssize_t written = write(error_fd, &error, sizeof(error));
+        _exit(127);
+    }
+
+    // Parent process; set the group here as well so a timeout that fires
+    // before the child runs still reaches it
+    setpgid(pid, pid);
+    spawned_++;
+    active_++;
+
+    stdout_write.reset();
+    stderr_write.reset();
+    error_write.reset();
+
+    // The status pipe closes on exec, or carries errno if exec failed. It is
+    // read by the supervisor thread because a pre_exec hook may legitimately
+    // never exec (e.g. a PID-namespace proxy that waits for its own child).
+    setNonBlocking(stdout_read.get());
+    setNonBlocking(stderr_read.get());
+    setNonBlocking(error_read.get());
+
+    if (pid_out != nullptr) {
+        *pid_out = pid;
+    }
+    child->id = static_cast<ChildId>(pid);
+    child->pid = pid;
+    child->program = options.args[0];
+    child->stdout_fd = std::move(stdout_read);
+    child->stderr_fd = std::move(stderr_read);
+    child->exec_status_fd = std::move(error_read);
+    child->max_output_bytes = options.max_output_bytes;
+    child->on_output = options.on_output;
+    child->timeout = options.timeout;
+    if (have_pidfd_) {
+        child->pidfd.reset(pidfdOpen(pid));
+    }
+    watchCancellation(*child, options.cancellation);
+
+    enqueue(std::move(child));
+    return future;
+}
+
+std::future<ProcessResult> ProcessSupervisor::attach(AttachOptions options) {
+    auto child = std::make_unique<Child>();
+    auto future = child->promise.get_future();
+
+    child->id = next_attached_id_++;
+    child->attached = true;
+    child->program = "attached process";
+    child->start_time = std::chrono::steady_clock::now();
+    child->stdout_fd = std::move(options.stdout_fd);
+    child->stderr_fd = std::move(options.stderr_fd);
+    child->status_fd = std::move(options.status_fd);
+    child->max_output_bytes = options.max_output_bytes;
+    child->on_output = std::move(options.on_output);
+    child->timeout = options.timeout;
+    child->on_status = std::move(options.on_status);
+    child->on_timeout = std::move(options.on_timeout);
+    watchCancellation(*child, std::move(options.cancellation));
+
+    setNonBlocking(child->stdout_fd.get());
+    setNonBlocking(child->stderr_fd.get());
+    setNonBlocking(child->status_fd.get());
+
+    attached_++;
+    active_++;
+    enqueue(std::move(child));
+    return future;
+}
+
+void ProcessSupervisor::watchCancellation(Child& child, std::shared_ptr<CancellationToken> cancellation) {
+    child.serial = next_serial_++;
+    if (!cancellation) {
+        return;
+    }
+    // The callback may fire on any thread, before or after the child is
+    // adopted; it only queues a request for the supervisor thread
+    child.cancel_registration = cancellation->onCancel([this, id = child.id, serial = child.serial]() {
+        requestCancel(id, serial);
+    });
+    child.cancellation = std::move(cancellation);
+}
+
+void ProcessSupervisor::requestCancel(ChildId id, uint64_t serial) {
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        cancel_requests_.emplace_back(id, serial);
+    }
+    uint64_t one = 1;
+    [[maybe_unused]] ssize_t written = write(wakeup_fd_.get(), &one, sizeof(one));
+}
+
+void ProcessSupervisor::enqueue(std::unique_ptr<Child> child) {
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        pending_.push_back(std::move(child));
+    }
+    uint64_t one = 1;
+    [[maybe_unused]] ssize_t written = write(wakeup_fd_.get(), &one, sizeof(one));
+}
+
+ProcessResult ProcessSupervisor::run(const ProcessOptions& options) {
+    return spawn(options).get();
+}
+
+nlohmann::json ProcessSupervisor::getStatistics() const {
+    return nlohmann::json{
+        {"active", active_.load()},
+        {"spawned", spawned_.load()},
+        {"attached", attached_.load()},
+        {"spawn_failures", spawn_failures_.load()},
+        {"timeouts", timeouts_.load()},
+        {"cancellations", cancellations_.load()},
+        {"pidfd", have_pidfd_}
+    };
+}
+
+void ProcessSupervisor::eventLoop() {
+    epoll_event events[64];
+
+    while (running_) {
+        int timeout = polled_children_ > 0 ? kPollIntervalMs : -1;
+        int count = epoll_wait(epoll_fd_.get(), events, 64, timeout);
+        if (count == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            Logger::getInstance().error("epoll_wait failed: " + std::string(std::strerror(errno)), "ProcessSupervisor");
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            uint64_t kind = events[i].data.u64 & 0xff;
+            ChildId id = events[i].data.u64 >> 8;
+
+            if (kind == kWakeup) {
+                uint64_t value;
+                [[maybe_unused]] ssize_t bytes = read(wakeup_fd_.get(), &value, sizeof(value));
+                adoptPending();
+                continue;
+            }
+            if (kind == kTimer) {
+                uint64_t expirations;
+                [[maybe_unused]] ssize_t bytes = read(timer_fd_.get(), &expirations, sizeof(expirations));
+                expireDeadlines();
+                continue;
+            }
+
+            auto it = children_.find(id);
+            if (it == children_.end()) {
+                continue;
+            }
+            if (kind == kPidfd) {
+                reap(*it->second);
+            } else if (kind == kStatus) {
+                readStatus(*it->second);
+            } else {
+                drain(*it->second, static_cast<int>(kind));
+            }
+            finishIfDone(id);
+        }
+
+        if (polled_children_ > 0) {
+            std::vector<ChildId> ids;
+            for (const auto& [id, child] : children_) {
+                if (!child->attached && !child->exited && !child->pidfd.valid()) {
+                    ids.push_back(id);
+                }
+            }
+            for (ChildId id : ids) {
+                reap(*children_[id]);
+                finishIfDone(id);
+            }
+        }
+    }
+}
+
+void ProcessSupervisor::adoptPending() {
+    std::vector<std::unique_ptr<Child>> adopted;
+    std::vector<std::pair<ChildId, uint64_t>> cancels;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        adopted.swap(pending_);
+        cancels.swap(cancel_requests_);
+    }
+
+    bool deadlines_changed = false;
+    for (auto& child : adopted) {
+        ChildId id = child->id;
+
+        watch(child->stdout_fd.get(), id, kStdout);
+        watch(child->stderr_fd.get(), id, kStderr);
+        if (child->attached) {
+            watch(child->status_fd.get(), id, kStatus);
+        } else {
+            watch(child->exec_status_fd.get(), id, kExecStatus);
+            if (child->pidfd.valid()) {
+                watch(child->pidfd.get(), id, kPidfd);
+            } else {
+                polled_children_++;
+            }
+        }
+
+        if (child->timeout.count() > 0) {
+            child->deadline = child->start_time + child->timeout;
+            child->has_deadline = true;
+            deadlines_.emplace(child->deadline, id);
+            deadlines_changed = true;
+        }
+
+        // A request that arrived before the child itself was dropped below
+        if (child->cancellation && child->cancellation->cancelled()) {
+            cancels.emplace_back(id, child->serial);
+        }
+
+        children_[id] = std::move(child);
+    }
+
+    for (const auto& [id, serial] : cancels) {
+        auto it = children_.find(id);
+        if (it == children_.end() || it->second->serial != serial) {
+            continue;
+        }
+        Child& child = *it->second;
+        if (child.exited || child.stop_requested) {
+            continue;
+        }
+        child.result.cancelled = true;
+        cancellations_++;
+        stop(child);
+        deadlines_changed = true;
+    }
+
+    if (deadlines_changed) {
+        armTimer();
+    }
+}
+
+void ProcessSupervisor::watch(int fd, ChildId id, int kind) {
+    if (fd < 0) {
+        return;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = (id << 8) | static_cast<uint64_t>(kind);
+    if (epoll_ctl(epoll_fd_.get(), EPOLL_CTL_ADD, fd, &event) == -1) {
+        Logger::getInstance().error("epoll_ctl failed: " + std::string(std::strerror(errno)), "ProcessSupervisor");
+    }
+}
+
+void ProcessSupervisor::drain(Child& child, int kind) {
+    UniqueFd& fd = (kind == kStdout) ? child.stdout_fd : (kind == kStderr) ? child.stderr_fd : child.exec_status_fd;
+    std::string& output = (kind == kStdout) ? child.result.stdout : (kind == kStderr) ? child.result.stderr : child.exec_status;
+    size_t& received = (kind == kStdout) ? child.stdout_bytes : child.stderr_bytes;
+    bool& truncated = (kind == kStdout) ? child.stdout_truncated : child.stderr_truncated;
+    bool streamed = child.on_output && kind != kExecStatus;
+    int stream_fd = (kind == kStdout) ? STDOUT_FILENO : STDERR_FILENO;
+    char buffer[kReadChunk];
+
+    while (fd.valid()) {
+        ssize_t bytes = read(fd.get(), buffer, sizeof(buffer));
+        if (bytes > 0) {
+            size_t keep = static_cast<size_t>(bytes);
+            if (child.max_output_bytes > 0 && kind != kExecStatus) {
+                size_t room = child.max_output_bytes > received ? child.max_output_bytes - received : 0;
+                keep = std::min(keep, room);
+            }
+
+            if (keep > 0) {
+                if (streamed) {
+                    child.on_output(stream_fd, std::string_view(buffer, keep));
+                } else {
+                    output.append(buffer, keep);
+                }
+                received += keep;
+            }
+
+            if (keep < static_cast<size_t>(bytes) && !truncated) {
+                truncated = true;
+                child.result.output_truncated = true;
+                if (streamed) {
+                    child.on_output(stream_fd, std::string_view());
+                }
+                // Nothing more it writes is kept, so end the run now rather
+                // than let it spin until the deadline
+                if (!child.exited && !child.stop_requested) {
+                    stop(child);
+                    armTimer();
+                }
+            }
+            continue;
+        }
+        if (bytes == -1 && errno == EINTR) {
+            continue;
+        }
+        if (bytes == -1 && errno == EAGAIN) {
+            return;
+        }
+        // EOF or a read error; either way this stream is finished
+        closeStream(child, kind);
+        if (kind == kExecStatus && child.exec_status.empty()) {
+            markExecuted(child);
+        }
+    }
+}
+
+void ProcessSupervisor::closeStream(Child& child, int kind) {
+    UniqueFd& fd = (kind == kStdout) ? child.stdout_fd
+                 : (kind == kStderr) ? child.stderr_fd
+                 : (kind == kStatus) ? child.status_fd
+                 : child.exec_status_fd;
+    if (fd.valid()) {
+        epoll_ctl(epoll_fd_.get(), EPOLL_CTL_DEL, fd.get(), nullptr);
+        fd.reset();
+    }
+}
+
+void ProcessSupervisor::readStatus(Child& child) {
+    if (child.exited) {
+        return;
+    }
+
+    char record[4096];
+    ssize_t bytes;
+    do {
+        bytes = read(child.status_fd.get(), record, sizeof(record));
+    } while (bytes == -1 && errno == EINTR);
+    if (bytes == -1 && errno == EAGAIN) {
+        return;
+    }
+
+    // The record may carry a more precise wall time than ours
+    child.result.wall_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - child.start_time).count();
+    if (bytes > 0) {
+        if (child.on_status) {
+            child.on_status(std::string(record, static_cast<size_t>(bytes)), child.result);
+        }
+    } else {
+        child.result.exit_code = -1;
+        child.result.stderr += "Supervising process exited unexpectedly\n";
+    }
+
+    closeStream(child, kStatus);
+    markExited(child);
+}
+
+void ProcessSupervisor::reap(Child& child) {
+    if (child.exited) {
+        return;
+    }
+
+    // Kill leftovers in the group while the leader is still a zombie, so the
+    // group id cannot have been recycled yet
+    int status = 0;
+    struct rusage usage {};
+    siginfo_t info{};
+    if (waitid(P_PID, child.pid, &info, WEXITED | WNOHANG | WNOWAIT) == -1 || info.si_pid != child.pid) {
+        return;
+    }
+    kill(-child.pid, SIGKILL);
+    if (wait4(child.pid, &status, 0, &usage) != child.pid) {
+        return;
+    }
+
+    child.result.wall_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - child.start_time).count();
+    applyResourceUsage(usage, child.result);
+
+    if (WIFEXITED(status)) {
+        child.result.exit_code = WEXITSTATUS(status);
+    } else if (WIFSIGNALED(status)) {
+        child.result.term_signal = WTERMSIG(status);
+        child.result.exit_code = 128 + child.result.term_signal;
+    }
+
+    if (child.pidfd.valid()) {
+        epoll_ctl(epoll_fd_.get(), EPOLL_CTL_DEL, child.pidfd.get(), nullptr);
+        child.pidfd.reset();
+    } else {
+        polled_children_--;
+    }
+
+    markExited(child);
+}
+
+void ProcessSupervisor::markExecuted(Child& child) {
+    if (child.exited || child.stop_requested) {
+        return;
+    }
+
+    // Time the program alone: fork and the child's setup before exec
+    // (namespaces, cgroup, rlimits) count against neither the wall time
+    // nor the deadline
+    child.start_time = std::chrono::steady_clock::now();
+    if (child.has_deadline) {
+        deadlines_.erase({child.deadline, child.id});
+        child.deadline = child.start_time + child.timeout;
+        deadlines_.emplace(child.deadline, child.id);
+        armTimer();
+    }
+}
+
+void ProcessSupervisor::markExited(Child& child) {
+    child.exited = true;
+
+    if (child.has_deadline) {
+        deadlines_.erase({child.deadline, child.id});
+        child.has_deadline = false;
+    }
+
+    // Something that left the process group may still hold the pipes open;
+    // give it a short grace period rather than waiting forever
+    if (child.stdout_fd.valid() || child.stderr_fd.valid() || child.exec_status_fd.valid()) {
+        child.deadline = std::chrono::steady_clock::now() + kDrainGrace;
+        child.has_deadline = true;
+        deadlines_.emplace(child.deadline, child.id);
+    }
+    armTimer();
+}
+
+void ProcessSupervisor::expireDeadlines() {
+    auto now = std::chrono::steady_clock::now();
+
+    while (!deadlines_.empty() && deadlines_.begin()->first <= now) {
+        ChildId id = deadlines_.begin()->second;
+        deadlines_.erase(deadlines_.begin());
+
+        auto it = children_.find(id);
+        if (it == children_.end()) {
+            continue;
+        }
+        Child& child = *it->second;
+        child.has_deadline = false;
+
+        if (child.exited) {
+            for (int kind : {static_cast<int>(kStdout), static_cast<int>(kStderr), static_cast<int>(kExecStatus)}) {
+                drain(child, kind);
+                closeStream(child, kind);
+            }
+            finishIfDone(id);
+            continue;
+        }
+
+        if (child.stop_requested) {
+            if (child.attached) {
+                // The helper did not report back after being asked to stop
+                closeStream(child, kStatus);
+                child.result.exit_code = 128 + SIGKILL;
+                child.result.term_signal = SIGKILL;
+                markExited(child);
+                finishIfDone(id);
+            }
+            continue;
+        }
+
+        child.result.timed_out = true;
+        timeouts_++;
+        stop(child);
+    }
+
+    armTimer();
+}
+
+void ProcessSupervisor::stop(Child& child) {
+    child.stop_requested = true;
+    if (!child.attached) {
+        // Not reaped yet, so the group id cannot have been recycled
+        kill(-child.pid, SIGKILL);
+        return;
+    }
+
+    if (child.on_timeout) {
+        child.on_timeout();
+    }
+    // Give the helper a moment to report back before giving up on it
+    if (child.has_deadline) {
+        deadlines_.erase({child.deadline, child.id});
+    }
+    child.deadline = std::chrono::steady_clock::now() + kDrainGrace;
+    child.has_deadline = true;
+    deadlines_.emplace(child.deadline, child.id);
+}
+
+void ProcessSupervisor::armTimer() {
+    itimerspec spec{};
+    if (!deadlines_.empty()) {
+        auto since_epoch = deadlines_.begin()->first.time_since_epoch();
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(since_epoch);
+        spec.it_value.tv_sec = seconds.count();
+        spec.it_value.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch - seconds).count();
+        if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+            spec.it_value.tv_nsec = 1;
+        }
+    }
+    // steady_clock is CLOCK_MONOTONIC on Linux, so deadlines arm as absolute times
+    timerfd_settime(timer_fd_.get(), TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+void ProcessSupervisor::finishIfDone(ChildId id) {
+    auto it = children_.find(id);
+    if (it == children_.end()) {
+        return;
+    }
+    Child& child = *it->second;
+    if (!child.exited || child.stdout_fd.valid() || child.stderr_fd.valid() || child.exec_status_fd.valid()) {
+        return;
+    }
+
+    if (child.has_deadline) {
+        deadlines_.erase({child.deadline, id});
+    }
+    if (child.cancellation) {
+        child.cancellation->unregister(child.cancel_registration);
+    }
+    if (child.exec_status.size() >= sizeof(int)) {
+        int exec_error = 0;
+        std::memcpy(&exec_error, child.exec_status.data(), sizeof(exec_error));
+        child.result.stderr = "Failed to execute " + child.program + ": " + std::strerror(exec_error) + "\n" + child.result.stderr;
+    }
+    child.promise.set_value(std::move(child.result));
+    children_.erase(it);
+    active_--;
+}
+
+} // namespace cpp_mastery
@@ -0,0 +1,289 @@
+// File: cpp-engine/src/utils/workspace_manager.cpp
+// Extension: .cpp
+
+#include "utils/workspace_manager.hpp"
+#include "utils/config.hpp"
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <filesystem>
+#include <stdexcept>
+#include <signal.h>
+#include <unistd.h>
+
+namespace cpp_mastery {
+
+std::unique_ptr<WorkspaceManager> WorkspaceManager::instance_ = nullptr;
+std::mutex WorkspaceManager::instance_mutex_;
+
+namespace {
+
+// How long the cleanup thread backs off after failing to create a directory
+constexpr std::chrono::seconds kCreateRetryDelay{1};
+
+const std::string kInstancePrefix = "ws-";
+
+bool processAlive(pid_t pid) {
+    return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+// Owner of a ws-<pid> directory, or 0 for anything else
+pid_t ownerOf(const std::string& name) {
+    if (name.rfind(kInstancePrefix, 0) != 0 || name.size() == kInstancePrefix.size()) {
+        return 0;
+    }
+    std::string digits = name.substr(kInstancePrefix.size());
+    if (!std::all_of(digits.begin(), digits.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+        return 0;
+    }
+    try {
+        return static_cast<pid_t>(std::stol(digits));
+    } catch (const std::exception&) {
+        return 0;
+    }
+}
+
+// Remove a directory's contents but keep the directory itself
+bool scrub(const std::string& path) {
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(path, ec), end; !ec && it != end; it.increment(ec)) {
+        std::filesystem::remove_all(it->path(), ec);
+        if (ec) {
+            return false;
+        }
+    }
+    return !ec;
+}
+
+} // namespace
+
+Workspace& Workspace::operator=(Workspace&& other) noexcept {
+    if (this != &other) {
+        release();
+        manager_ = other.manager_;
+        path_ = std::move(other.path_);
+        other.manager_ = nullptr;
+    }
+    return *this;
+}
+
+std::string Workspace::detach() {
+    manager_ = nullptr;
+    return path_;
+}
+
+void Workspace::release() {
+    if (manager_) {
+        manager_->release(path_);
+        manager_ = nullptr;
+    }
+}
+
+WorkspaceManager& WorkspaceManager::getInstance() {
+    std::lock_guard<std::mutex> lock(instance_mutex_);
+    if (!instance_) {
+        const auto& config = Config::getInstance().getServerConfig();
+
+        WorkspacePolicy policy;
+        policy.root = config.workspace_root;
+        policy.pool_size = config.workspace_pool_size;
+
+        instance_ = std::make_unique<WorkspaceManager>(std::move(policy));
+    }
+    return *instance_;
+}
+
+WorkspaceManager::WorkspaceManager(WorkspacePolicy policy)
+    : policy_(std::move(policy)),
+      instance_dir_(policy_.root + "/" + kInstancePrefix + std::to_string(getpid())) {
+    std::filesystem::create_directories(policy_.root);
+
+    // A directory with our pid is from an earlier process that had the same
+    // pid, which is common in containers; move it aside before reusing the name
+    std::error_code ec;
+    if (std::filesystem::exists(instance_dir_, ec)) {
+        auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+        std::filesystem::rename(instance_dir_, policy_.root + "/stale-" + std::to_string(getpid()) +
+                                "-" + std::to_string(stamp), ec);
+    }
+
+    size_t orphans = reapOrphans();
+    std::filesystem::create_directories(instance_dir_);
+
+    thread_ = std::thread(&WorkspaceManager::cleanupLoop, this);
+
+    Logger::getInstance().info("Workspaces under " + instance_dir_ + ", pool of " +
+                               std::to_string(policy_.pool_size) + ", " + std::to_string(orphans) +
+                               " orphaned entries queued for removal", "WorkspaceManager");
+}
+
+WorkspaceManager::~WorkspaceManager() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_available_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    // Nothing is serving requests any more, so blocking is fine here
+    std::error_code ec;
+    std::filesystem::remove_all(instance_dir_, ec);
+    for (const auto& path : doomed_) {
+        std::filesystem::remove_all(path, ec);
+    }
+}
+
+Workspace WorkspaceManager::acquire() {
+    acquired_++;
+
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!idle_.empty()) {
+            path = std::move(idle_.back());
+            idle_.pop_back();
+        }
+    }
+
+    if (path.empty()) {
+        pool_misses_++;
+        path = createDirectory();
+        if (path.empty()) {
+            throw std::runtime_error("Failed to create workspace directory under " + instance_dir_);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        leased_.insert(path);
+    }
+    // The pool just shrank; let the cleanup thread top it up
+    work_available_.notify_one();
+    return Workspace(this, path);
+}
+
+void WorkspaceManager::release(const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (leased_.erase(path) == 0) {
+            return;
+        }
+        returned_.push_back(path);
+    }
+    work_available_.notify_one();
+}
+
+size_t WorkspaceManager::reapOrphans() {
+    std::vector<std::string> orphans;
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(policy_.root, ec), end; !ec && it != end; it.increment(ec)) {
+        // Our own ws-<pid> is skipped here too; the constructor moved any stale one aside
+        pid_t owner = ownerOf(it->path().filename().string());
+        if (owner > 0 && processAlive(owner)) {
+            continue;
+        }
+        orphans.push_back(it->path().string());
+    }
+
+    size_t queued = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& path : orphans) {
+            if (std::find(doomed_.begin(), doomed_.end(), path) == doomed_.end()) {
+                doomed_.push_back(std::move(path));
+                queued++;
+            }
+        }
+    }
+    if (queued > 0) {
+        work_available_.notify_one();
+    }
+    return queued;
+}
+
+std::string WorkspaceManager::createDirectory() {
+    std::string path = instance_dir_ + "/" + std::to_string(next_id_++);
+    std::error_code ec;
+    if (!std::filesystem::create_directory(path, ec) || ec) {
+        Logger::getInstance().warning("Failed to create workspace " + path + ": " + ec.message(), "WorkspaceManager");
+        return "";
+    }
+    return path;
+}
+
+void WorkspaceManager::cleanupLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        work_available_.wait(lock, [this] {
+            return stopping_ || !doomed_.empty() || !returned_.empty() || idle_.size() < policy_.pool_size;
+        });
+        if (stopping_) {
+            return;
+        }
+
+        std::error_code ec;
+        if (!doomed_.empty()) {
+            std::string path = doomed_.front();
+            lock.unlock();
+            std::filesystem::remove_all(path, ec);
+            lock.lock();
+            // Only now, so reapOrphans() does not queue it a second time meanwhile
+            doomed_.pop_front();
+            orphans_reaped_++;
+            continue;
+        }
+
+        if (!returned_.empty()) {
+            std::string path = std::move(returned_.front());
+            returned_.pop_front();
+            bool keep = idle_.size() < policy_.pool_size;
+            lock.unlock();
+            bool clean = keep && scrub(path);
+            if (!clean) {
+                std::filesystem::remove_all(path, ec);
+            }
+            lock.lock();
+            if (clean) {
+                idle_.push_back(std::move(path));
+                recycled_++;
+            } else {
+                discarded_++;
+            }
+            continue;
+        }
+
+        // Pool below target; prepare a directory ahead of demand
+        lock.unlock();
+        std::string path = createDirectory();
+        lock.lock();
+        if (!path.empty()) {
+            idle_.push_back(std::move(path));
+        } else {
+            work_available_.wait_for(lock, kCreateRetryDelay, [this] {
+                return stopping_ || !doomed_.empty() || !returned_.empty();
+            });
+        }
+    }
+}
+
+nlohmann::json WorkspaceManager::getStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return nlohmann::json{
+        {"directory", instance_dir_},
+        {"pool_size", policy_.pool_size},
+        {"idle", idle_.size()},
+        {"leased", leased_.size()},
+        {"pending_cleanup", returned_.size() + doomed_.size()},
+        {"acquired", acquired_.load()},
+        {"pool_misses", pool_misses_.load()},
+        {"recycled", recycled_.load()},
+        {"discarded", discarded_.load()},
+        {"orphans_reaped", orphans_reaped_.load()}
+    };
+}
+
+} // namespace cpp_mastery
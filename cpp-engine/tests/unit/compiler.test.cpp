@@ -0,0 +1,1366 @@
+// File: cpp-engine/tests/unit/compiler.test.cpp
+// Extension: .cpp
+// Location: cpp-engine/tests/unit/compiler.test.cpp
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <future>
+#include <tuple>
+#include <algorithm>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include "../../include/compiler/compilation_cache.hpp"
+#include "../../include/compiler/pch_pool.hpp"
+#include "../../include/compiler/harness_registry.hpp"
+#include "../../include/compiler/sandbox.hpp"
+#include "../../include/compiler/sandbox_pool.hpp"
+#include "../../include/compiler/wasm_runtime.hpp"
+#include "../../include/compiler/admission_controller.hpp"
+#include "../../include/compiler/judge.hpp"
+#include "../../include/compiler/job_manager.hpp"
+#include "../../include/compiler/inprocess_compiler.hpp"
+#include "../../include/parser/source_file_system.hpp"
+#include "../../include/utils/process_supervisor.hpp"
+#include "../../include/utils/workspace_manager.hpp"
+#include "../../include/utils/logger.hpp"
+#include "../../include/utils/config.hpp"
+// Tests of the Clang-backed parser build where Clang's headers are installed
+#if __has_include(<clang/Frontend/CompilerInstance.h>)
+#define HAVE_CLANG_FRONTEND
+#include "../../include/parser/ast_parser.hpp"
+#endif
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace cpp_mastery;
+using namespace testing;
+
+class CompilationCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        root = std::filesystem::temp_directory_path() / "cpp-engine-cache-test";
+        std::filesystem::remove_all(root);
+        std::filesystem::create_directories(root / "session");
+
+        config.enable_compilation_cache = true;
+        config.enable_analysis_cache = false;
+        config.cache_directory = (root / "cache").string();
+        config.max_cache_size_mb = 1;
+        config.cache_ttl_hours = 1;
+
+        cache = std::make_unique<CompilationCache>(config);
+        ASSERT_TRUE(cache->initialize());
+    }
+
+    void TearDown() override {
+        cache.reset();
+        std::filesystem::remove_all(root);
+    }
+
+    CompilationResult makeResult(const std::string& contents) {
+        std::string path = (root / "session" / "main").string();
+        std::ofstream(path) << contents;
+
+        CompilationResult result;
+        result.success = true;
+        result.executable_path = path;
+        result.warnings = {"main.cpp:1:1: warning: unused variable"};
+        return result;
+    }
+
+    std::filesystem::path root;
+    CacheConfig config;
+    std::unique_ptr<CompilationCache> cache;
+};
+
+TEST_F(CompilationCacheTest, Sha256MatchesKnownVectors) {
+    EXPECT_EQ(CompilationCache::sha256Hex(""),
+              "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    EXPECT_EQ(CompilationCache::sha256Hex("abc"),
+              "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+}
+
+TEST_F(CompilationCacheTest, KeyDependsOnEveryInput) {
+    CompilationKey base;
+    base.code = "int main() {}";
+    base.compiler_path = "/usr/bin/g++";
+    base.compiler_version = "g++ 12.2.0";
+    base.standard = "c++20";
+    base.optimization = "O2";
+
+    CompilationKey other_flags = base;
+    other_flags.extra_flags = {"-DNDEBUG"};
+    CompilationKey other_version = base;
+    other_version.compiler_version = "g++ 13.1.0";
+    CompilationKey other_standard = base;
+    other_standard.standard = "c++17";
+
+    std::string digest = CompilationCache::computeKey(base);
+    EXPECT_EQ(digest, CompilationCache::computeKey(base));
+    EXPECT_NE(digest, CompilationCache::computeKey(other_flags));
+    EXPECT_NE(digest, CompilationCache::computeKey(other_version));
+    EXPECT_NE(digest, CompilationCache::computeKey(other_standard));
+}
+
+TEST_F(CompilationCacheTest, StoreThenLookupMaterializesExecutable) {
+    CompilationKey key;
+    key.code = "int main() { return 0; }";
+    std::string digest = CompilationCache::computeKey(key);
+
+    std::string output = (root / "session" / "hit").string();
+    EXPECT_FALSE(cache->lookup(digest, output).has_value());
+
+    cache->store(digest, makeResult("binary"));
+
+    auto hit = cache->lookup(digest, output);
+    ASSERT_TRUE(hit.has_value());
+    EXPECT_TRUE(hit->success);
+    EXPECT_TRUE(hit->cache_hit);
+    EXPECT_EQ(hit->executable_path, output);
+    EXPECT_EQ(hit->warnings.size(), 1u);
+    EXPECT_TRUE(std::filesystem::exists(output));
+
+    auto stats = cache->getStatistics();
+    EXPECT_EQ(stats["hits"], 1);
+    EXPECT_EQ(stats["misses"], 1);
+}
+
+TEST_F(CompilationCacheTest, EvictsWhenOverSizeLimit) {
+    std::string large(700 * 1024, 'x');
+
+    CompilationKey first;
+    first.code = "first";
+    CompilationKey second;
+    second.code = "second";
+
+    cache->store(CompilationCache::computeKey(first), makeResult(large));
+    cache->store(CompilationCache::computeKey(second), makeResult(large));
+
+    auto stats = cache->getStatistics();
+    EXPECT_EQ(stats["entries"], 1);
+    EXPECT_GE(stats["evictions"].get<uint64_t>(), 1u);
+    EXPECT_LE(stats["size_bytes"].get<uint64_t>(), 1024u * 1024u);
+}
+
+TEST(PchPoolTest, LeadingSystemIncludesStopAtFirstCodeLine) {
+    std::string code = R"(// Lesson 3
+/* sorting
+   demo */
+#include <iostream>
+#  include <vector>
+#include "helper.hpp"
+#include <algorithm>
+int main() {}
+)";
+
+    EXPECT_THAT(PchPool::leadingSystemIncludes(code), ElementsAre("iostream", "vector"));
+    EXPECT_TRUE(PchPool::leadingSystemIncludes("#define N 10\n#include <iostream>\n").empty());
+}
+
+TEST(HarnessRegistryTest, BuildsEachToolchainOnceAndSurvivesRestart) {
+    auto root = std::filesystem::temp_directory_path() / "cpp-engine-harness-test";
+    std::filesystem::remove_all(root);
+
+    // Stands in for the compiler: writes the object unless the source asks to fail
+    std::atomic<int> compiles{0};
+    auto runner = [&compiles](const std::vector<std::string>& args, int) {
+        compiles++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        ProcessResult result;
+        std::ifstream source(args[1]);
+        std::string text((std::istreambuf_iterator<char>(source)), std::istreambuf_iterator<char>());
+        result.exit_code = text.find("FAIL") == std::string::npos ? 0 : 1;
+        if (result.exit_code == 0) {
+            std::ofstream(args[3]) << "object";
+        } else {
+            result.stderr = "error: FAIL";
+        }
+        return result;
+    };
+    auto command = [](const std::string& source, const std::string& object, const std::string& include_directory) {
+        return std::vector<std::string>{"cc", source, "-o", object, "-I", include_directory};
+    };
+
+    {
+        HarnessRegistry registry(root, runner, 10);
+        registry.initialize();
+
+        EXPECT_THROW(registry.stage("../escape", {}, {{"main.cpp", ""}}), std::invalid_argument);
+        EXPECT_THROW(registry.stage("ex", {}, {}), std::invalid_argument);
+
+        std::string digest = registry.stage("ex", {{"solution.hpp", "int f();"}}, {{"main.cpp", "int main() {}"}, {"util.cpp", ""}});
+        EXPECT_EQ(registry.stage("ex", {{"solution.hpp", "int f();"}}, {{"util.cpp", ""}, {"main.cpp", "int main() {}"}}), digest);
+        EXPECT_FALSE(registry.current("ex"));
+        registry.activate("ex", digest);
+        EXPECT_EQ(registry.current("ex"), digest);
+
+        // Concurrent submissions share one build
+        std::vector<std::thread> threads;
+        std::vector<HarnessBuild> builds(4);
+        for (size_t i = 0; i < builds.size(); ++i) {
+            threads.emplace_back([&, i] { builds[i] = registry.build("ex", digest, "tc1", command); });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        EXPECT_EQ(compiles.load(), 2);
+        for (const auto& build : builds) {
+            ASSERT_TRUE(build.success);
+            ASSERT_EQ(build.objects.size(), 2u);
+            EXPECT_TRUE(std::filesystem::exists(build.objects[0]));
+            EXPECT_TRUE(std::filesystem::exists(std::filesystem::path(build.include_directory) / "solution.hpp"));
+        }
+
+        // Another toolchain gets its own objects and cache key
+        HarnessBuild other = registry.build("ex", digest, "tc2", command);
+        EXPECT_EQ(compiles.load(), 4);
+        EXPECT_NE(other.digest, builds[0].digest);
+
+        // Failed builds are reported and retried rather than cached
+        std::string broken = registry.stage("ex", {}, {{"main.cpp", "FAIL"}});
+        EXPECT_FALSE(registry.build("ex", broken, "tc1", command).success);
+        HarnessBuild retried = registry.build("ex", broken, "tc1", command);
+        EXPECT_FALSE(retried.success);
+        EXPECT_THAT(retried.compiler_output, HasSubstr("error: FAIL"));
+        EXPECT_EQ(compiles.load(), 6);
+        EXPECT_EQ(registry.current("ex"), digest);
+    }
+
+    // A restarted registry finds the harness and its objects on disk
+    HarnessRegistry restarted(root, runner, 10);
+    restarted.initialize();
+    auto digest = restarted.current("ex");
+    ASSERT_TRUE(digest);
+    EXPECT_TRUE(restarted.build("ex", *digest, "tc1", command).success);
+    EXPECT_EQ(compiles.load(), 6);
+
+    EXPECT_TRUE(restarted.remove("ex"));
+    EXPECT_FALSE(restarted.current("ex"));
+    EXPECT_FALSE(std::filesystem::exists(root / "ex"));
+    std::filesystem::remove_all(root);
+}
+
+TEST(ProcessSupervisorTest, DrainsOutputLargerThanPipeBuffer) {
+    ProcessOptions options;
+    options.args = {"/bin/sh", "-c", "head -c 1000000 /dev/zero; echo done >&2"};
+    options.timeout = std::chrono::seconds(10);
+
+    ProcessResult result = ProcessSupervisor::getInstance().run(options);
+
+    EXPECT_EQ(result.exit_code, 0);
+    EXPECT_FALSE(result.timed_out);
+    EXPECT_EQ(result.stdout.size(), 1000000u);
+    EXPECT_EQ(result.stderr, "done\n");
+}
+
+TEST(ProcessSupervisorTest, TimeoutKillsWholeProcessGroup) {
+    ProcessOptions options;
+    options.args = {"/bin/sh", "-c", "sleep 30 & sleep 30"};
+    options.timeout = std::chrono::milliseconds(200);
+
+    auto start = std::chrono::steady_clock::now();
+    ProcessResult result = ProcessSupervisor::getInstance().run(options);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_TRUE(result.timed_out);
+    EXPECT_EQ(result.term_signal, SIGKILL);
+    EXPECT_LT(elapsed, std::chrono::seconds(5));
+}
+
+TEST(ProcessSupervisorTest, TimesProgramFromExec) {
+    ProcessOptions options;
+    options.args = {"/bin/sh", "-c", "sleep 0.2"};
+    options.timeout = std::chrono::milliseconds(400);
+    // Slow setup in the child before exec, as namespaces or a cgroup attach can be
+    options.pre_exec = []() {
+        usleep(300 * 1000);
+        return true;
+    };
+
+    ProcessResult result = ProcessSupervisor::getInstance().run(options);
+
+    EXPECT_EQ(result.exit_code, 0);
+    EXPECT_FALSE(result.timed_out);
+    EXPECT_GE(result.wall_time_ms, 150);
+    EXPECT_LT(result.wall_time_ms, 300);
+}
+
+TEST(ProcessSupervisorTest, OutputLimitKillsProcessGroup) {
+    ProcessOptions options;
+    options.args = {"/bin/sh", "-c", "yes & yes"};
+    options.timeout = std::chrono::seconds(30);
+    options.max_output_bytes = 4096;
+
+    auto start = std::chrono::steady_clock::now();
+    ProcessResult result = ProcessSupervisor::getInstance().run(options);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_TRUE(result.output_truncated);
+    EXPECT_FALSE(result.timed_out);
+    EXPECT_EQ(result.term_signal, SIGKILL);
+    EXPECT_EQ(result.stdout.size(), 4096u);
+    EXPECT_LT(elapsed, std::chrono::seconds(5));
+}
+
+TEST(ProcessSupervisorTest, CancellationKillsProcessGroup) {
+    auto token = std::make_shared<CancellationToken>();
+    ProcessOptions options;
+    options.args = {"/bin/sh", "-c", "sleep 30 & sleep 30"};
+    options.timeout = std::chrono::seconds(30);
+    options.cancellation = token;
+
+    auto start = std::chrono::steady_clock::now();
+    auto future = ProcessSupervisor::getInstance().spawn(options);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    token->cancel();
+    ProcessResult result = future.get();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_TRUE(result.cancelled);
+    EXPECT_FALSE(result.timed_out);
+    EXPECT_EQ(result.term_signal, SIGKILL);
+    EXPECT_LT(elapsed, std::chrono::seconds(5));
+
+    // A token cancelled up front keeps the process from starting
+    ProcessResult skipped = ProcessSupervisor::getInstance().run(options);
+    EXPECT_TRUE(skipped.cancelled);
+}
+
+TEST(ProcessSupervisorTest, RunsChildrenConcurrently) {
+    std::vector<std::future<ProcessResult>> children;
+    for (int i = 0; i < 50; ++i) {
+        ProcessOptions options;
+        options.args = {"/bin/sh", "-c", "sleep 0.2; echo " + std::to_string(i)};
+        options.timeout = std::chrono::seconds(10);
+        children.push_back(ProcessSupervisor::getInstance().spawn(options));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 50; ++i) {
+        ProcessResult result = children[i].get();
+        EXPECT_EQ(result.exit_code, 0);
+        EXPECT_EQ(result.stdout, std::to_string(i) + "\n");
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+TEST(ProcessSupervisorTest, DeliversSmallAndLargeStdin) {
+    ProcessOptions options;
+    options.args = {"/bin/sh", "-c", "wc -c; cat >/dev/null"};
+    options.timeout = std::chrono::seconds(10);
+
+    options.stdin_data = "hello\n";
+    ProcessResult small = ProcessSupervisor::getInstance().run(options);
+    EXPECT_EQ(small.exit_code, 0);
+    EXPECT_EQ(small.stdout, "6\n");
+
+    // Far beyond a pipe buffer, and echoed back while it is still being read
+    std::string large(8 * 1024 * 1024, 'x');
+    options.args = {"/bin/cat"};
+    options.stdin_data = large;
+    ProcessResult echoed = ProcessSupervisor::getInstance().run(options);
+    EXPECT_EQ(echoed.exit_code, 0);
+    EXPECT_EQ(echoed.stdout.size(), large.size());
+    EXPECT_FALSE(echoed.timed_out);
+}
+
+TEST(ProcessSupervisorTest, ReportsResourceUsage) {
+    ProcessOptions options;
+    options.args = {"/bin/sh", "-c", "i=0; while [ $i -lt 100000 ]; do i=$((i+1)); done"};
+    options.timeout = std::chrono::seconds(10);
+
+    ProcessResult result = ProcessSupervisor::getInstance().run(options);
+
+    EXPECT_EQ(result.exit_code, 0);
+    EXPECT_GT(result.cpu_time_ms, 0);
+    EXPECT_EQ(result.cpu_time_ms, result.user_time_ms + result.system_time_ms);
+    EXPECT_GT(result.memory_usage_kb, 0);
+    // Wall time starts at exec, CPU time includes the fork child before it
+    EXPECT_GE(result.wall_time_ms + 5, result.cpu_time_ms);
+    EXPECT_GT(result.voluntary_context_switches + result.involuntary_context_switches, 0);
+}
+
+TEST(ExecutionEngineClassifyTest, BlamesMemoryOnlyOnKernelEvidence) {
+    ExecutionConfig limits{};
+    limits.max_memory_mb = 64;
+    limits.max_cpu_time = 2;
+
+    ProcessResult spoofed;
+    spoofed.exit_code = 1;
+    spoofed.stderr = "terminate called after throwing an instance of 'std::bad_alloc'\n";
+    EXPECT_EQ(ExecutionEngine::classifyExit(spoofed, limits), ExecutionStatus::RUNTIME_ERROR);
+
+    ProcessResult aborted = spoofed;
+    aborted.exit_code = 128 + SIGABRT;
+    aborted.term_signal = SIGABRT;
+    EXPECT_EQ(ExecutionEngine::classifyExit(aborted, limits), ExecutionStatus::MEMORY_LIMIT_EXCEEDED);
+
+    ProcessResult killed;
+    killed.exit_code = 128 + SIGKILL;
+    killed.term_signal = SIGKILL;
+    killed.oom_killed = true;
+    EXPECT_EQ(ExecutionEngine::classifyExit(killed, limits), ExecutionStatus::MEMORY_LIMIT_EXCEEDED);
+
+    ProcessResult segfault;
+    segfault.exit_code = 128 + SIGSEGV;
+    segfault.term_signal = SIGSEGV;
+    segfault.memory_usage_kb = 60 * 1024;
+    EXPECT_EQ(ExecutionEngine::classifyExit(segfault, limits), ExecutionStatus::MEMORY_LIMIT_EXCEEDED);
+    segfault.memory_usage_kb = 1024;
+    EXPECT_EQ(ExecutionEngine::classifyExit(segfault, limits), ExecutionStatus::RUNTIME_ERROR);
+}
+
+TEST(ProcessSupervisorTest, StreamsOutputAndMarksTruncation) {
+    ProcessOptions options;
+    options.args = {"/bin/sh", "-c", "echo early >&2; exec cat /dev/zero"};
+    options.timeout = std::chrono::seconds(10);
+    options.max_output_bytes = 4096;
+
+    std::string streamed_stdout;
+    std::string streamed_stderr;
+    int truncation_markers = 0;
+    options.on_output = [&](int stream, std::string_view data) {
+        if (data.empty()) {
+            ++truncation_markers;
+        } else {
+            (stream == STDOUT_FILENO ? streamed_stdout : streamed_stderr).append(data);
+        }
+    };
+
+    ProcessResult result = ProcessSupervisor::getInstance().run(options);
+    EXPECT_EQ(result.term_signal, SIGKILL);
+    EXPECT_TRUE(result.output_truncated);
+    EXPECT_TRUE(result.stdout.empty());
+    EXPECT_EQ(streamed_stdout.size(), 4096u);
+    EXPECT_EQ(streamed_stderr, "early\n");
+    EXPECT_EQ(truncation_markers, 1);
+}
+
+TEST(ProcessSupervisorTest, ReportsMissingExecutable) {
+    ProcessOptions options;
+    options.args = {"/nonexistent/compiler"};
+
+    ProcessResult result = ProcessSupervisor::getInstance().run(options);
+
+    EXPECT_EQ(result.exit_code, 127);
+    EXPECT_THAT(result.stderr, HasSubstr("Failed to execute"));
+}
+
+TEST(SandboxTest, IsolatesFilesystemProcessesAndPrivileges) {
+    ExecutionConfig config;
+    config.max_memory_mb = 256;
+    config.max_cpu_time = 2;
+    config.max_output_size = 1024 * 1024;
+    config.sandbox_rootfs = "/";
+    config.cgroup_root = "";
+
+    auto& sandbox = Sandbox::getInstance();
+    if (!sandbox.initialize(config)) {
+        GTEST_SKIP() << "Namespaces unavailable: " << sandbox.getStatus().dump();
+    }
+
+    ProcessResult result = sandbox.run(
+        {"/bin/sh", "-c", "echo $$; touch /usr/x || echo ro; touch /tmp/x && echo rw; unshare -U true || echo denied"},
+        Sandbox::limitsFromConfig(config),
+        std::chrono::seconds(5)
+    );
+
+    EXPECT_EQ(result.exit_code, 0) << result.stderr;
+    EXPECT_EQ(result.stdout, "1\nro\nrw\ndenied\n");
+}
+
+TEST(SandboxPoolTest, ReusesSlotAndScrubsItBetweenRuns) {
+    ExecutionConfig config;
+    config.max_memory_mb = 256;
+    config.max_cpu_time = 2;
+    config.max_output_size = 1024 * 1024;
+    config.sandbox_rootfs = "/";
+    config.cgroup_root = "";
+
+    auto& sandbox = Sandbox::getInstance();
+    if (!sandbox.initialize(config)) {
+        GTEST_SKIP() << "Namespaces unavailable: " << sandbox.getStatus().dump();
+    }
+
+    SandboxPool pool(sandbox, 1, 1);
+    ASSERT_TRUE(pool.initialize(Sandbox::limitsFromConfig(config)));
+
+    // /bin/sh reads its script from stdin, which is all a slot hands over
+    auto runScript = [&](const std::string& script) {
+        return pool.run("/bin/sh", script, Sandbox::limitsFromConfig(config), std::chrono::seconds(5));
+    };
+
+    ProcessResult first = runScript("touch /tmp/marker; ls /tmp; sleep 30 & echo done\n");
+    EXPECT_EQ(first.exit_code, 0) << first.stderr;
+    EXPECT_EQ(first.stdout, "marker\ndone\n");
+    EXPECT_LT(first.wall_time_ms, 5000);
+
+    ProcessResult second = runScript("ls /tmp; echo next\n");
+    EXPECT_EQ(second.exit_code, 0) << second.stderr;
+    EXPECT_EQ(second.stdout, "next\n");
+
+    nlohmann::json statistics = pool.getStatistics();
+    EXPECT_EQ(statistics["runs"], 2);
+    EXPECT_EQ(statistics["slots_started"], 1);
+    EXPECT_EQ(statistics["fallbacks"], 0);
+}
+
+namespace {
+
+// Bitcode for `int main() { puts("hello"); return 3; }`, with the call
+// going to `callee` instead of puts
+std::string helloModule(const std::string& callee) {
+    llvm::LLVMContext context;
+    llvm::Module module("hello", context);
+    module.setTargetTriple(llvm::sys::getProcessTriple());
+    llvm::IRBuilder<> builder(context);
+    auto* print = llvm::Function::Create(llvm::FunctionType::get(builder.getInt32Ty(), {builder.getInt8PtrTy()}, false),
+                                         llvm::Function::ExternalLinkage, callee, module);
+    auto* entry = llvm::Function::Create(llvm::FunctionType::get(builder.getInt32Ty(), false),
+                                         llvm::Function::ExternalLinkage, "main", module);
+    builder.SetInsertPoint(llvm::BasicBlock::Create(context, "entry", entry));
+    builder.CreateCall(print, {builder.CreateGlobalStringPtr("hello")});
+    builder.CreateRet(builder.getInt32(3));
+
+    std::string bitcode;
+    llvm::raw_string_ostream stream(bitcode);
+    llvm::WriteBitcodeToFile(module, stream);
+    stream.flush();
+    return bitcode;
+}
+
+} // namespace
+
+TEST(SandboxPoolTest, RunsBitcodeAndRejectsUnlinkableModules) {
+    ExecutionConfig config;
+    config.max_memory_mb = 256;
+    config.max_cpu_time = 2;
+    config.max_output_size = 1024 * 1024;
+    config.sandbox_rootfs = "/";
+    config.cgroup_root = "";
+
+    auto& sandbox = Sandbox::getInstance();
+    if (!sandbox.initialize(config)) {
+        GTEST_SKIP() << "Namespaces unavailable: " << sandbox.getStatus().dump();
+    }
+
+    SandboxPool pool(sandbox, 1, 1);
+    ASSERT_TRUE(pool.initialize(Sandbox::limitsFromConfig(config)));
+
+    std::string reason;
+    auto ran = pool.runBitcode(helloModule("puts"), "", Sandbox::limitsFromConfig(config), std::chrono::seconds(5),
+                               nullptr, nullptr, reason);
+    ASSERT_TRUE(ran.has_value()) << reason;
+    EXPECT_EQ(ran->exit_code, 3) << ran->stderr;
+    EXPECT_EQ(ran->stdout, "hello\n");
+
+    // Nothing runs, so the caller can compile and link instead
+    auto unlinked = pool.runBitcode(helloModule("no_such_function"), "", Sandbox::limitsFromConfig(config),
+                                    std::chrono::seconds(5), nullptr, nullptr, reason);
+    EXPECT_FALSE(unlinked.has_value());
+    EXPECT_THAT(reason, HasSubstr("no_such_function"));
+
+    nlohmann::json statistics = pool.getStatistics();
+    EXPECT_EQ(statistics["jit_runs"], 1);
+    EXPECT_EQ(statistics["jit_unsupported"], 1);
+    EXPECT_EQ(statistics["slots_started"], 1);
+}
+
+TEST(WasmRuntimeTest, MapsLimitsAndRefusesRunsBeforeInitialize) {
+    ExecutionConfig config;
+    config.max_memory_mb = 64;
+    config.max_cpu_time = 3;
+    config.execution_timeout = 7;
+    config.max_output_size = 4096;
+    config.wasm_fuel_per_second = 1000;
+
+    WasmLimits limits = WasmRuntime::limitsFromConfig(config);
+    EXPECT_EQ(limits.memory_bytes, 64u * 1024 * 1024);
+    EXPECT_EQ(limits.fuel, 3000u);
+    EXPECT_EQ(limits.timeout, std::chrono::seconds(7));
+    EXPECT_EQ(limits.max_output_bytes, 4096u);
+
+    WasmRuntime runtime(1);
+    ProcessResult result = runtime.run("/nonexistent.wasm", "", limits, nullptr, nullptr);
+    EXPECT_NE(result.exit_code, 0);
+    EXPECT_FALSE(result.stderr.empty());
+    EXPECT_EQ(runtime.getStatistics()["runs"], 0);
+}
+
+namespace {
+
+void waitForQueued(const AdmissionController& controller, size_t expected) {
+    for (int i = 0; i < 500; ++i) {
+        auto lanes = controller.getStatistics()["lanes"];
+        size_t queued = 0;
+        for (const auto& lane : lanes) {
+            queued += lane["queued"].get<size_t>();
+        }
+        if (queued == expected) {
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    FAIL() << "queue never reached " << expected;
+}
+
+} // namespace
+
+TEST(AdmissionControllerTest, ServesClientsRoundRobinAndLanesByWeight) {
+    AdmissionPolicy policy;
+    policy.max_concurrent = 1;
+    policy.interactive_weight = 2;
+    AdmissionController controller(policy);
+
+    Admission holder = controller.admit("ip:holder", AdmissionLane::INTERACTIVE);
+    ASSERT_TRUE(holder.admitted());
+
+    std::mutex order_mutex;
+    std::vector<std::string> order;
+    std::vector<std::thread> threads;
+    size_t queued = 0;
+    auto submit = [&](std::string label, std::string client, AdmissionLane lane) {
+        threads.emplace_back([&, label, client, lane] {
+            Admission admission = controller.admit(client, lane);
+            ASSERT_TRUE(admission.admitted());
+            std::lock_guard<std::mutex> lock(order_mutex);
+            order.push_back(label);
+        });
+        waitForQueued(controller, ++queued);
+    };
+
+    submit("c1", "ip:c", AdmissionLane::BATCH);
+    submit("a1", "ip:a", AdmissionLane::INTERACTIVE);
+    submit("a2", "ip:a", AdmissionLane::INTERACTIVE);
+    submit("a3", "ip:a", AdmissionLane::INTERACTIVE);
+    submit("b1", "ip:b", AdmissionLane::INTERACTIVE);
+
+    holder.ticket.release();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_THAT(order, ElementsAre("a1", "b1", "c1", "a2", "a3"));
+    EXPECT_EQ(controller.getStatistics()["running"], 0);
+}
+
+TEST(AdmissionControllerTest, RejectsWhenQueueIsFull) {
+    AdmissionPolicy policy;
+    policy.max_concurrent = 1;
+    policy.max_queued = 1;
+    policy.queue_timeout = std::chrono::milliseconds(200);
+    AdmissionController controller(policy);
+
+    Admission holder = controller.admit("ip:a", AdmissionLane::INTERACTIVE);
+    ASSERT_TRUE(holder.admitted());
+
+    std::thread waiter([&] {
+        Admission timed_out = controller.admit("ip:b", AdmissionLane::INTERACTIVE);
+        EXPECT_FALSE(timed_out.admitted());
+    });
+    waitForQueued(controller, 1);
+
+    Admission rejected = controller.admit("ip:c", AdmissionLane::INTERACTIVE);
+    EXPECT_FALSE(rejected.admitted());
+    EXPECT_GE(rejected.retry_after.count(), 1);
+    waiter.join();
+
+    auto statistics = controller.getStatistics()["lanes"]["interactive"];
+    EXPECT_EQ(statistics["rejected_queue_full"], 1);
+    EXPECT_EQ(statistics["rejected_timeout"], 1);
+}
+
+TEST(AdmissionControllerTest, CancelledWaiterLeavesQueue) {
+    AdmissionPolicy policy;
+    policy.max_concurrent = 1;
+    AdmissionController controller(policy);
+
+    Admission holder = controller.admit("ip:a", AdmissionLane::INTERACTIVE);
+    ASSERT_TRUE(holder.admitted());
+
+    auto token = std::make_shared<CancellationToken>();
+    std::thread waiter([&] {
+        Admission cancelled = controller.admit("ip:b", AdmissionLane::BATCH, token);
+        EXPECT_FALSE(cancelled.admitted());
+        EXPECT_EQ(cancelled.reason, "Cancelled");
+    });
+    waitForQueued(controller, 1);
+    token->cancel();
+    waiter.join();
+
+    auto statistics = controller.getStatistics();
+    EXPECT_EQ(statistics["lanes"]["batch"]["queued"], 0);
+    EXPECT_EQ(statistics["lanes"]["batch"]["cancelled"], 1);
+}
+
+TEST(AdmissionControllerTest, BackgroundOnlyUsesIdleSlotsAndYields) {
+    AdmissionPolicy policy;
+    policy.max_concurrent = 2;
+    policy.max_background = 1;
+    AdmissionController controller(policy);
+
+    auto speculative = std::make_shared<CancellationToken>();
+    Admission background = controller.admit("ip:a", AdmissionLane::BACKGROUND, speculative);
+    ASSERT_TRUE(background.admitted());
+
+    // Capped at max_background even with a slot free
+    std::atomic<bool> second_admitted{false};
+    std::thread second([&] {
+        Admission queued = controller.admit("ip:b", AdmissionLane::BACKGROUND, std::make_shared<CancellationToken>());
+        second_admitted = queued.admitted();
+    });
+    waitForQueued(controller, 1);
+
+    Admission interactive = controller.admit("ip:c", AdmissionLane::INTERACTIVE);
+    ASSERT_TRUE(interactive.admitted());
+    EXPECT_FALSE(speculative->cancelled());
+
+    // No free slot: the running background ticket is cancelled to make room
+    Admission preempting;
+    std::thread waiter([&] {
+        preempting = controller.admit("ip:d", AdmissionLane::INTERACTIVE);
+    });
+    for (int i = 0; i < 500 && !speculative->cancelled(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    EXPECT_TRUE(speculative->cancelled());
+    background.ticket.release();
+    waiter.join();
+    EXPECT_TRUE(preempting.admitted());
+
+    EXPECT_EQ(controller.getStatistics()["preempted"], 1);
+    EXPECT_FALSE(second_admitted);
+
+    // Served once a slot frees up with nothing else waiting
+    interactive.ticket.release();
+    second.join();
+    EXPECT_TRUE(second_admitted);
+}
+
+TEST(JobManagerTest, CancelStopsRunningJob) {
+    JobPolicy policy;
+    JobManager manager(policy);
+
+    auto job = manager.submit("execute", [](Job& job) {
+        job.markRunning();
+        ProcessOptions options;
+        options.args = {"/bin/sleep", "30"};
+        options.timeout = std::chrono::seconds(30);
+        options.cancellation = job.cancellation();
+        ProcessResult result = ProcessSupervisor::getInstance().run(options);
+        return nlohmann::json{{"cancelled", result.cancelled}};
+    });
+    ASSERT_NE(job, nullptr);
+    EXPECT_EQ(manager.find(job->id()), job);
+
+    std::vector<nlohmann::json> events;
+    ASSERT_TRUE(job->waitForEvents(1, std::chrono::seconds(5), events));
+    EXPECT_EQ(events[0]["state"], "running");
+
+    auto start = std::chrono::steady_clock::now();
+    manager.cancel(job->id());
+    while (job->waitForEvents(2, std::chrono::seconds(5), events) && events.empty()) {
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+
+    auto snapshot = job->snapshot();
+    EXPECT_EQ(snapshot["state"], "cancelled");
+    EXPECT_EQ(snapshot["result"]["cancelled"], true);
+}
+
+TEST(JobManagerTest, NewerJobSupersedesOlder) {
+    JobManager manager(JobPolicy{});
+    auto wait_for_cancel = [](Job& job) {
+        std::promise<void> cancelled;
+        job.cancellation()->onCancel([&cancelled] { cancelled.set_value(); });
+        cancelled.get_future().wait_for(std::chrono::seconds(5));
+        return nlohmann::json::object();
+    };
+
+    auto first = manager.submit("prewarm", wait_for_cancel, "session");
+    auto other = manager.submit("prewarm", wait_for_cancel, "other session");
+    auto second = manager.submit("prewarm", wait_for_cancel, "session");
+    ASSERT_TRUE(first && other && second);
+
+    EXPECT_TRUE(first->cancellation()->cancelled());
+    EXPECT_FALSE(other->cancellation()->cancelled());
+    EXPECT_FALSE(second->cancellation()->cancelled());
+    EXPECT_EQ(manager.getStatistics()["superseded"], 1);
+}
+
+TEST(JudgeTest, ComparesChunkedOutputWithoutBuffering) {
+    auto compare = [](std::string_view expected, std::vector<std::string_view> chunks, OutputComparator::Mode mode) {
+        OutputComparator comparator(expected, mode);
+        for (auto chunk : chunks) {
+            comparator.feed(chunk);
+        }
+        return comparator.finish() ? -1 : static_cast<long>(*comparator.mismatchOffset());
+    };
+    using Mode = OutputComparator::Mode;
+
+    EXPECT_EQ(compare("1 2 3\n", {"1 ", "2", " 3\n"}, Mode::EXACT), -1);
+    EXPECT_EQ(compare("1 2 3\n", {"1 2 4\n"}, Mode::EXACT), 4);
+    EXPECT_EQ(compare("1 2\n", {"1 2\n", "extra"}, Mode::EXACT), 4);
+    EXPECT_EQ(compare("1 2\n", {"1 2"}, Mode::EXACT), 3);
+
+    // Tokens split across chunks, different spacing, trailing whitespace
+    EXPECT_EQ(compare("12 345\n", {"1", "2\n\n34", "5  \n"}, Mode::TOKENS), -1);
+    EXPECT_EQ(compare("12 345", {"12 34"}, Mode::TOKENS), 3);
+    EXPECT_EQ(compare("12 345", {"12 3456"}, Mode::TOKENS), 3);
+    EXPECT_EQ(compare("12 345", {"12 345 6"}, Mode::TOKENS), 7);
+    EXPECT_EQ(compare("", {" \n"}, Mode::TOKENS), -1);
+}
+
+TEST(JudgeTest, CaseLimitsOnlyTightenConfiguredLimits) {
+    ExecutionConfig base{};
+    base.execution_timeout = 10;
+    base.max_memory_mb = 512;
+    base.max_cpu_time = 0;
+
+    ExecutionConfig limits = Judge::effectiveLimits(base, {
+        {"execution_timeout", 2}, {"max_memory_mb", 4096}, {"max_cpu_time", 1}});
+    EXPECT_EQ(limits.execution_timeout, 2);
+    EXPECT_EQ(limits.max_memory_mb, 512);
+    EXPECT_EQ(limits.max_cpu_time, 1);
+
+    EXPECT_EQ(Judge::verdictFor(ExecutionStatus::OK, false), Verdict::WRONG_ANSWER);
+    EXPECT_EQ(Judge::verdictFor(ExecutionStatus::CPU_LIMIT_EXCEEDED, true), Verdict::TIME_LIMIT_EXCEEDED);
+
+    // Client parallelism never exceeds the pool or the case count
+    EXPECT_EQ(Judge::workerCount(1000, 1000, 8), 8u);
+    EXPECT_EQ(Judge::workerCount(0, 1000, 8), 8u);
+    EXPECT_EQ(Judge::workerCount(4, 2, 8), 2u);
+    EXPECT_EQ(Judge::workerCount(0, 0, 0), 1u);
+}
+
+TEST(SyntaxCheckTest, ParsesGccAndClangDiagnostics) {
+    std::string output =
+        "<stdin>: In function 'int main()':\n"
+        "<stdin>:3:17: warning: unused variable 'unused' [-Wunused-variable]\n"
+        "<stdin>:3:47: error: 'x' was not declared in this scope\n"
+        "/usr/include/c++/12/bits/stl_vector.h:10:5: note: candidate: 'void push_back()'\n"
+        "main.cpp:7:1: fatal error: too many errors emitted, stopping now [-ferror-limit=]\n"
+        "compilation terminated due to -fmax-errors=2.\n";
+
+    auto diagnostics = ExecutionEngine::parseDiagnostics(output);
+    ASSERT_EQ(diagnostics.size(), 4u);
+
+    EXPECT_EQ(diagnostics[0].severity, "warning");
+    EXPECT_EQ(diagnostics[0].file, "");
+    EXPECT_EQ(diagnostics[0].line, 3);
+    EXPECT_EQ(diagnostics[0].column, 17);
+    EXPECT_EQ(diagnostics[0].message, "unused variable 'unused'");
+    EXPECT_EQ(diagnostics[0].option, "-Wunused-variable");
+
+    EXPECT_EQ(diagnostics[1].severity, "error");
+    EXPECT_EQ(diagnostics[1].option, "");
+    EXPECT_EQ(diagnostics[2].severity, "note");
+    EXPECT_EQ(diagnostics[2].file, "/usr/include/c++/12/bits/stl_vector.h");
+    EXPECT_EQ(diagnostics[3].severity, "error");
+}
+
+TEST(LinkerSelectionTest, PicksALinkerThatLinksIntoMemory) {
+    std::string linker = ExecutionEngine::selectLinker("g++");
+    EXPECT_TRUE(linker.empty() || linker == "mold" || linker == "lld") << linker;
+
+    // Link into a memfd the way a memory workspace does, with whatever was picked
+    UniqueFd executable(memfd_create("main", MFD_CLOEXEC));
+    ASSERT_TRUE(executable.valid());
+    std::string path = "/proc/" + std::to_string(getpid()) + "/fd/" + std::to_string(executable.get());
+
+    ProcessOptions link;
+    link.args = {"g++", "-x", "c++", "-", "-o", path};
+    if (!linker.empty()) {
+        link.args.insert(link.args.begin() + 1, "-fuse-ld=" + linker);
+    }
+    link.stdin_data = "int main() { return 42; }\n";
+    link.timeout = std::chrono::seconds(60);
+    ProcessResult linked = ProcessSupervisor::getInstance().run(link);
+    ASSERT_EQ(linked.exit_code, 0) << linked.stderr;
+
+    UniqueFd readonly(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    ASSERT_TRUE(readonly.valid());
+    ASSERT_NE(dup3(readonly.get(), executable.get(), O_CLOEXEC), -1);
+
+    ProcessOptions run;
+    run.args = {path};
+    run.timeout = std::chrono::seconds(10);
+    EXPECT_EQ(ProcessSupervisor::getInstance().run(run).exit_code, 42);
+}
+
+TEST(TieredExecutionTest, ReadsTierPolicyFromOptions) {
+    EXPECT_FALSE(ExecutionEngine::tierPolicyFrom(nlohmann::json::object()).enabled);
+    EXPECT_FALSE(ExecutionEngine::tierPolicyFrom({{"tiered", false}}).enabled);
+
+    TierPolicy defaults = ExecutionEngine::tierPolicyFrom({{"tiered", true}});
+    EXPECT_TRUE(defaults.enabled);
+    EXPECT_EQ(defaults.fast, "O0");
+    EXPECT_EQ(defaults.optimized, "O2");
+
+    TierPolicy custom = ExecutionEngine::tierPolicyFrom({{"tiered", {{"optimized", "O3"}}}});
+    EXPECT_TRUE(custom.enabled);
+    EXPECT_EQ(custom.fast, "O0");
+    EXPECT_EQ(custom.optimized, "O3");
+
+    EXPECT_FALSE(ExecutionEngine::tierPolicyFrom({{"tiered", {{"enabled", false}}}}).enabled);
+}
+
+// Runs the shared engine without a sandbox, its directories under one temporary root
+class ExecutionEngineTest : public ::testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        root = std::filesystem::temp_directory_path() / ("cpp-engine-engine-test-" + std::to_string(getpid()));
+        std::filesystem::remove_all(root);
+        std::filesystem::create_directories(root);
+        ASSERT_TRUE(loadConfig());
+        ASSERT_TRUE(ExecutionEngine::getInstance().initialize());
+    }
+
+    static void TearDownTestSuite() {
+        std::filesystem::remove_all(root);
+    }
+
+    // Engine settings read per request can be changed between tests
+    static bool loadConfig(const nlohmann::json& compiler = nlohmann::json::object()) {
+        nlohmann::json config = {
+            {"server", {{"workspace_root", (root / "temp").string()}}},
+            {"compiler", {{"enable_pch", false}, {"workspace_mode", "memory"}, {"memory_workspace_budget_mb", 256}}},
+            {"execution", {{"sandbox_enabled", false}}},
+            {"cache", {{"cache_directory", (root / "cache").string()}}}
+        };
+        config["compiler"].update(compiler);
+        std::ofstream(root / "server.json") << config.dump();
+        return Config::getInstance().load((root / "server.json").string());
+    }
+
+    // Takes g++ a couple of seconds; the tag keeps each test's cache key apart
+    static std::string slowProgram(const std::string& tag) {
+        return "// " + tag + "\n#include <iostream>\n#include <regex>\n"
+               "int main() { std::cout << std::regex_match(\"aab\", std::regex(\"a+b\")) << \"\\n\"; }\n";
+    }
+
+    static std::vector<std::filesystem::path> workspaceEntries() {
+        std::vector<std::filesystem::path> entries;
+        if (std::filesystem::exists(root / "temp")) {
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(root / "temp")) {
+                entries.push_back(entry.path());
+            }
+        }
+        std::sort(entries.begin(), entries.end());
+        return entries;
+    }
+
+    static nlohmann::json coalescing() {
+        return ExecutionEngine::getInstance().getMetrics()["compile_coalescing"];
+    }
+
+    static bool waitForFlight() {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (coalescing()["in_flight"] == 0) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return true;
+    }
+
+    static inline std::filesystem::path root;
+};
+
+TEST_F(ExecutionEngineTest, CoalescesIdenticalConcurrentCompiles) {
+    auto& engine = ExecutionEngine::getInstance();
+    const std::string code = slowProgram("coalesce");
+    uint64_t coalesced = coalescing()["coalesced"];
+
+    constexpr int kRequests = 4;
+    std::vector<std::future<CompilationResult>> compiles;
+    for (int i = 0; i < kRequests; ++i) {
+        compiles.push_back(std::async(std::launch::async, [&engine, &code]() {
+            return engine.compile(code, nlohmann::json::object());
+        }));
+    }
+
+    int compiled = 0;
+    for (auto& compile : compiles) {
+        CompilationResult result = compile.get();
+        EXPECT_TRUE(result.success);
+        if (result.cache_hit) {
+            EXPECT_GT(result.phases.coalesced_wait_ms, 0);
+        } else {
+            compiled++;
+        }
+        engine.releaseCompilation(result);
+    }
+    EXPECT_EQ(compiled, 1);
+    EXPECT_EQ(coalescing()["coalesced"], coalesced + kRequests - 1);
+}
+
+TEST_F(ExecutionEngineTest, CancelledWaiterStopsWaitingForLeader) {
+    auto& engine = ExecutionEngine::getInstance();
+    const std::string code = slowProgram("cancel-waiter");
+
+    auto leader = std::async(std::launch::async, [&engine, &code]() {
+        return engine.compile(code, nlohmann::json::object());
+    });
+    ASSERT_TRUE(waitForFlight());
+    auto cancellation = std::make_shared<CancellationToken>();
+    auto waiter = std::async(std::launch::async, [&engine, &code, cancellation]() {
+        return engine.compile(code, nlohmann::json::object(), cancellation);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    cancellation->cancel();
+
+    ASSERT_EQ(waiter.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+    CompilationResult cancelled = waiter.get();
+    EXPECT_FALSE(cancelled.success);
+    EXPECT_THAT(cancelled.errors, Contains("Compilation cancelled"));
+    EXPECT_NE(leader.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+
+    CompilationResult compiled = leader.get();
+    EXPECT_TRUE(compiled.success);
+    engine.releaseCompilation(compiled);
+}
+
+TEST_F(ExecutionEngineTest, WaiterTakesOverAbandonedCompile) {
+    auto& engine = ExecutionEngine::getInstance();
+    const std::string code = slowProgram("takeover");
+    uint64_t abandoned = coalescing()["abandoned"];
+
+    auto cancellation = std::make_shared<CancellationToken>();
+    auto leader = std::async(std::launch::async, [&engine, &code, cancellation]() {
+        return engine.compile(code, nlohmann::json::object(), cancellation);
+    });
+    ASSERT_TRUE(waitForFlight());
+    auto waiter = std::async(std::launch::async, [&engine, &code]() {
+        return engine.compile(code, nlohmann::json::object());
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    cancellation->cancel();
+
+    EXPECT_FALSE(leader.get().success);
+    CompilationResult compiled = waiter.get();
+    EXPECT_TRUE(compiled.success);
+    EXPECT_FALSE(compiled.cache_hit);
+    EXPECT_GE(compiled.phases.coalesced_wait_ms, 150);
+    EXPECT_EQ(coalescing()["abandoned"], abandoned + 1);
+    engine.releaseCompilation(compiled);
+}
+
+TEST_F(ExecutionEngineTest, MemoryWorkspaceLeavesNothingOnDisk) {
+    auto& engine = ExecutionEngine::getInstance();
+    auto before = workspaceEntries();
+    uint64_t created = engine.getMetrics()["memory_workspaces"]["created"];
+
+    auto result = engine.execute("#include <cstdio>\nint main() { std::puts(\"in memory\"); }\n", "",
+                                 nlohmann::json::object());
+    EXPECT_TRUE(result.success) << result.error_message;
+    EXPECT_EQ(result.stdout, "in memory\n");
+    EXPECT_EQ(engine.getMetrics()["memory_workspaces"]["created"], created + 1);
+    EXPECT_EQ(workspaceEntries(), before);
+}
+
+TEST_F(ExecutionEngineTest, MemoryWorkspaceFallsBackToDiskOverBudget) {
+    auto& engine = ExecutionEngine::getInstance();
+    // Room for one compile's reservation, which a kept executable still eats into
+    ASSERT_TRUE(loadConfig({{"memory_workspace_budget_mb", 8}}));
+    uint64_t fallbacks = engine.getMetrics()["memory_workspaces"]["disk_fallbacks"];
+
+    CompilationResult held = engine.compile("int main() { return 1; }\n", nlohmann::json::object());
+    ASSERT_TRUE(held.success);
+    EXPECT_EQ(held.executable_path.rfind("/proc/", 0), 0u);
+
+    CompilationResult spilled = engine.compile("int main() { return 2; }\n", nlohmann::json::object());
+    ASSERT_TRUE(spilled.success);
+    EXPECT_EQ(spilled.executable_path.rfind((root / "temp").string(), 0), 0u);
+    EXPECT_EQ(engine.getMetrics()["memory_workspaces"]["disk_fallbacks"], fallbacks + 1);
+
+    engine.releaseCompilation(held);
+    engine.releaseCompilation(spilled);
+    CompilationResult released = engine.compile("int main() { return 3; }\n", nlohmann::json::object());
+    EXPECT_EQ(released.executable_path.rfind("/proc/", 0), 0u);
+    engine.releaseCompilation(released);
+    ASSERT_TRUE(loadConfig());
+}
+
+TEST_F(ExecutionEngineTest, CacheHitIsServedIntoSealedMemfd) {
+    auto& engine = ExecutionEngine::getInstance();
+    const std::string code = "#include <cstdio>\nint main() { std::puts(\"cached\"); }\n";
+    engine.releaseCompilation(engine.compile(code, nlohmann::json::object()));
+
+    CompilationResult hit = engine.compile(code, nlohmann::json::object());
+    ASSERT_TRUE(hit.success);
+    EXPECT_TRUE(hit.cache_hit);
+    ASSERT_EQ(hit.executable_path.rfind("/proc/", 0), 0u);
+
+    // seal() left a read-only descriptor at the number the path names
+    int fd = std::stoi(hit.executable_path.substr(hit.executable_path.rfind('/') + 1));
+    EXPECT_EQ(fcntl(fd, F_GETFL) & O_ACCMODE, O_RDONLY);
+
+    ProcessOptions run;
+    run.args = {hit.executable_path};
+    run.timeout = std::chrono::seconds(10);
+    ProcessResult ran = ProcessSupervisor::getInstance().run(run);
+    EXPECT_EQ(ran.exit_code, 0) << ran.stderr;
+    EXPECT_EQ(ran.stdout, "cached\n");
+    engine.releaseCompilation(hit);
+}
+
+TEST_F(ExecutionEngineTest, DeliversFastTierBeforeOptimizedRunFinishes) {
+    // Only the optimized build sleeps, so its run ends well after the fast one
+    const std::string code =
+        "#include <cstdio>\n#include <unistd.h>\n"
+        "int main() {\n#ifdef __OPTIMIZE__\n    usleep(500000);\n#endif\n    std::puts(\"done\");\n}\n";
+
+    std::chrono::steady_clock::time_point fast_at;
+    ExecutionObserver observer;
+    observer.on_fast_result = [&fast_at](const ExecutionResult& fast) {
+        EXPECT_TRUE(fast.success) << fast.error_message;
+        EXPECT_EQ(fast.stdout, "done\n");
+        EXPECT_FALSE(fast.optimized);
+        fast_at = std::chrono::steady_clock::now();
+    };
+
+    auto result = ExecutionEngine::getInstance().execute(code, "", {{"tiered", true}}, observer);
+    auto done_at = std::chrono::steady_clock::now();
+
+    ASSERT_TRUE(result.optimized);
+    EXPECT_TRUE(result.optimized->success) << result.optimized->error_message;
+    EXPECT_TRUE(result.optimized->output_matches);
+    EXPECT_GE(result.optimized->execution_time_ms, 500);
+    EXPECT_GE(done_at - fast_at, std::chrono::milliseconds(500));
+}
+
+TEST_F(ExecutionEngineTest, CompilesAndLinksInProcess) {
+    if (!std::filesystem::exists(Config::getInstance().getCompilerConfig().clang_path)) {
+        GTEST_SKIP() << "clang++ is not installed";
+    }
+    auto& engine = ExecutionEngine::getInstance();
+    const std::string code = "#include <cstdio>\nint main() { std::puts(\"hello\"); }\n";
+
+    auto result = engine.execute(code, "", {{"compiler", InProcessCompiler::kName}});
+    EXPECT_TRUE(result.success) << result.error_message;
+    EXPECT_EQ(result.stdout, "hello\n");
+
+#ifdef HAVE_LLD
+    // Linked by LLD inside the engine; a flag it rejects fails that link, not the engine
+    nlohmann::json lld = {{"compiler", InProcessCompiler::kName}, {"flags", {"-fuse-ld=lld"}}};
+    EXPECT_EQ(engine.execute(code, "", lld).stdout, "hello\n");
+
+    nlohmann::json rejected = lld;
+    rejected["flags"].push_back("-Wl,-m,no_such_emulation");
+    EXPECT_FALSE(engine.execute(code, "", rejected).success);
+
+    EXPECT_EQ(engine.execute("#include <cstdio>\nint main() { std::puts(\"again\"); }\n", "", lld).stdout, "again\n");
+#endif
+}
+
+TEST(WorkspaceManagerTest, RecyclesWorkspacesAndReapsOrphans) {
+    auto root = std::filesystem::temp_directory_path() / ("workspace_test_" + std::to_string(getpid()));
+    std::filesystem::remove_all(root);
+    // Left by a crashed process and by the old per-request layout
+    std::filesystem::create_directories(root / "ws-999999999" / "abc");
+    std::filesystem::create_directories(root / "0123abcd");
+
+    {
+        WorkspaceManager manager(WorkspacePolicy{root.string(), 2});
+
+        std::string first_path;
+        {
+            Workspace workspace = manager.acquire();
+            first_path = workspace.path();
+            std::ofstream(workspace.file("main.cpp")) << "int main() {}";
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (std::chrono::steady_clock::now() < deadline &&
+               (manager.getStatistics()["recycled"] < 1 || manager.getStatistics()["orphans_reaped"] < 2)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        EXPECT_EQ(manager.getStatistics()["recycled"], 1);
+        EXPECT_EQ(manager.getStatistics()["orphans_reaped"], 2);
+        EXPECT_FALSE(std::filesystem::exists(root / "ws-999999999"));
+        EXPECT_FALSE(std::filesystem::exists(root / "0123abcd"));
+
+        // Comes back from the pool, empty
+        Workspace again = manager.acquire();
+        EXPECT_TRUE(std::filesystem::is_empty(again.path()));
+        EXPECT_FALSE(std::filesystem::exists(std::filesystem::path(first_path) / "main.cpp"));
+
+        // Unknown paths are ignored
+        manager.release(root.string());
+        EXPECT_TRUE(std::filesystem::exists(root));
+    }
+
+    EXPECT_TRUE(std::filesystem::is_empty(root));
+    std::filesystem::remove_all(root);
+}
+
+TEST(SourceFileSystemTest, ServesCachedHeadersAndInMemorySource) {
+    auto root = std::filesystem::temp_directory_path() / ("vfs-test-" + std::to_string(getpid()));
+    std::filesystem::create_directories(root / "include");
+    std::string header = (root / "include" / "lesson.h").string();
+    std::string missing = (root / "include" / "absent.h").string();
+    std::ofstream(header) << "int lesson();\n";
+
+    auto files = llvm::makeIntrusiveRefCnt<SourceFileSystem>(
+        llvm::vfs::getRealFileSystem(), std::vector<std::string>{(root / "include").string() + "/"}, 1024 * 1024, 16,
+        std::chrono::hours(1));
+    ASSERT_TRUE(files->status(header));
+    ASSERT_TRUE(files->openFileForRead(header));
+    EXPECT_FALSE(files->status(missing));
+
+    // Lookups before revalidation never reach the disk, so these changes go unseen
+    std::filesystem::remove(header);
+    std::ofstream(missing) << "int absent();\n";
+
+    auto cached = files->openFileForRead(header);
+    ASSERT_TRUE(cached);
+    auto buffer = (*cached)->getBuffer(header);
+    ASSERT_TRUE(buffer);
+    EXPECT_EQ((*buffer)->getBuffer(), "int lesson();\n");
+    EXPECT_EQ((*cached)->status()->getName(), header);
+    EXPECT_FALSE(files->status(missing));
+
+    auto statistics = files->getStatistics();
+    EXPECT_EQ(statistics["cached_files"], 1);
+    EXPECT_EQ(statistics["known_missing"], 1);
+    EXPECT_EQ(statistics["open_hits"], 1);
+    EXPECT_EQ(statistics["status_hits"], 1);
+
+    // A request's source sits over the shared cache without touching the disk
+    auto request = SourceFileSystem::forSource("input.cpp", "#include <vector>\n");
+    auto source = request->openFileForRead("input.cpp");
+    ASSERT_TRUE(source);
+    EXPECT_EQ((*(*source)->getBuffer("input.cpp"))->getBuffer(), "#include <vector>\n");
+    EXPECT_FALSE(std::filesystem::exists("input.cpp"));
+
+    std::filesystem::remove_all(root);
+}
+
+#ifdef HAVE_CLANG_FRONTEND
+TEST(ASTParserTest, ReusesPreambleAcrossParses) {
+    auto& parser = ASTParser::getInstance();
+    ASSERT_TRUE(parser.initialize());
+    const std::string code = "#include <vector>\n\nint main() {\n    std::vector<int> v{1, 2};\n    return v.size();\n}\n";
+    uint64_t hits = parser.getStatistics()["preambles"]["hits"];
+
+    // Both parses hand the main buffer to the preprocessor through the preamble
+    ParseResult first = parser.parse(code);
+    ParseResult second = parser.parse(code);
+    ASSERT_TRUE(first.success) << first.error_message;
+    ASSERT_TRUE(second.success) << second.error_message;
+    EXPECT_TRUE(second.ast_json["metadata"]["preamble_reused"]);
+    EXPECT_EQ(parser.getStatistics()["preambles"]["hits"], hits + 1);
+
+    first.ast_json.erase("metadata");
+    second.ast_json.erase("metadata");
+    EXPECT_EQ(first.ast_json, second.ast_json);
+}
+
+TEST(ASTParserTest, LexesEveryTokenWithItsPosition) {
+    const std::string code = "#include <vector>\n/* two\n   lines */ int print = 42; // done\nauto s = \"text\";\n";
+
+    using Lexed = std::tuple<std::string, uint32_t, uint32_t, uint32_t, uint32_t>;
+    std::vector<Lexed> lexed;
+    for (const auto& token : ASTParser::getInstance().generateTokens(code)) {
+        lexed.emplace_back(token.kind, token.offset, token.length, token.line, token.column);
+    }
+
+    // One token for the directive and one for the header name; "print" holds no "int"
+    std::vector<Lexed> expected = {
+        {"directive", 0, 8, 1, 1},
+        {"string", 9, 8, 1, 10},
+        {"comment", 18, 18, 2, 1},
+        {"keyword", 37, 3, 3, 13},
+        {"identifier", 41, 5, 3, 17},
+        {"punctuation", 47, 1, 3, 23},
+        {"number", 49, 2, 3, 25},
+        {"punctuation", 51, 1, 3, 27},
+        {"comment", 53, 7, 3, 29},
+        {"keyword", 61, 4, 4, 1},
+        {"identifier", 66, 1, 4, 6},
+        {"punctuation", 68, 1, 4, 8},
+        {"string", 70, 6, 4, 10},
+        {"punctuation", 76, 1, 4, 16}
+    };
+    EXPECT_EQ(lexed, expected);
+}
+
+TEST(ASTParserTest, LexesAThousandLinesInMicroseconds) {
+    std::string code;
+    for (int i = 0; i < 1000; ++i) {
+        code += "    total += values[" + std::to_string(i) + "] * 2; // step\n";
+    }
+
+    auto& parser = ASTParser::getInstance();
+    std::vector<SourceToken> tokens;
+    auto best = std::chrono::steady_clock::duration::max();
+    for (int run = 0; run < 5; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        tokens = parser.generateTokens(code);
+        best = std::min(best, std::chrono::steady_clock::now() - start);
+    }
+    EXPECT_EQ(tokens.size(), 10000u);
+    EXPECT_LT(best, std::chrono::milliseconds(1));
+}
+#endif
+
+TEST(SourceFileSystemTest, RevalidatesEntriesAndBoundsMissingPaths) {
+    auto root = std::filesystem::temp_directory_path() / ("vfs-revalidate-test-" + std::to_string(getpid()));
+    std::filesystem::create_directories(root / "include");
+    std::string header = (root / "include" / "lesson.h").string();
+    std::string missing = (root / "include" / "absent.h").string();
+    std::ofstream(header) << "int lesson();\n";
+
+    // Every lookup is stale, so each one is checked against the disk
+    auto files = llvm::makeIntrusiveRefCnt<SourceFileSystem>(
+        llvm::vfs::getRealFileSystem(), std::vector<std::string>{(root / "include").string() + "/"}, 1024 * 1024, 2,
+        std::chrono::milliseconds(0));
+    ASSERT_TRUE(files->openFileForRead(header));
+    EXPECT_FALSE(files->status(missing));
+
+    // Unchanged files are still served from memory
+    auto cached = files->openFileForRead(header);
+    ASSERT_TRUE(cached);
+    EXPECT_EQ(files->getStatistics()["open_hits"], 1);
+
+    std::ofstream(header) << "int lesson(int day);\n";
+    std::ofstream(missing) << "int absent();\n";
+
+    auto changed = files->openFileForRead(header);
+    ASSERT_TRUE(changed);
+    EXPECT_EQ((*(*changed)->getBuffer(header))->getBuffer(), "int lesson(int day);\n");
+    EXPECT_TRUE(files->status(missing));
+    EXPECT_EQ(files->getStatistics()["invalidations"], 2);
+
+    // Only the newest missing paths are kept
+    for (const char* name : {"a.h", "b.h", "c.h"}) {
+        EXPECT_FALSE(files->status((root / "include" / name).string()));
+    }
+    EXPECT_EQ(files->getStatistics()["known_missing"], 2);
+
+    std::filesystem::remove_all(root);
+}
+
+// Main function for running all tests
+int main(int argc, char** argv) {
+    // Sandbox pool slots re-execute this binary
+    if (argc > 1 && std::string(argv[1]) == SandboxPool::kSlotFlag) {
+        return SandboxPool::runSlot();
+    }
+
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::InitGoogleMock(&argc, argv);
+
+    Logger::getInstance().setLevel(LogLevel::WARNING);
+
+    return RUN_ALL_TESTS();
+}